@@ -35,8 +35,10 @@
 #pragma once
 #include <optional>
 
+#include "spark_dsg/change_journal.h"
 #include "spark_dsg/edge_attributes.h"
 #include "spark_dsg/edge_container.h"
+#include "spark_dsg/flat_map.h"
 #include "spark_dsg/scene_graph_node.h"
 
 namespace spark_dsg {
@@ -86,10 +88,41 @@ class BaseLayer {
   virtual void getRemovedEdges(std::vector<EdgeKey>& removed_edges,
                                bool clear_removed) = 0;
 
+  /**
+   * @brief Get the journal of node and edge changes to the layer
+   */
+  inline const ChangeJournal& journal() const { return journal_; }
+
+  /**
+   * @brief Set how many changes the journal holds (recording is off until set)
+   * @param capacity maximum number of changes held (0 turns recording off)
+   */
+  inline void setJournalCapacity(size_t capacity) { journal_.setCapacity(capacity); }
+
+  /**
+   * @brief Get the net node and edge changes after a cursor and advance the cursor
+   *
+   * Unlike the getNew and getRemoved methods, this only visits the recorded changes
+   * and doesn't clear anything, so every consumer can keep its own cursor.
+   *
+   * @param cursor position of the consumer in the layer journal
+   * @returns net changes (marked incomplete if some were dropped before being read)
+   */
+  inline ChangeSet getChanges(ChangeJournal::Cursor& cursor) const {
+    std::vector<Change> changes;
+    ChangeSet result;
+    result.complete = journal_.read(cursor, changes);
+    result.merge(changes);
+    return result;
+  }
+
  protected:
   virtual EdgeContainer& edgeContainer() = 0;
 
   virtual bool removeNode(NodeId node_id) = 0;
+
+  //! record of every node and edge change to the layer
+  ChangeJournal journal_;
 };
 
 }  // namespace spark_dsg
@@ -127,6 +127,7 @@ enum class PackType : uint8_t {
   NIL = 0xc0,
   FALSE = 0xc2,
   TRUE = 0xc3,
+  BIN32 = 0xc6,
   FLOAT32 = 0xca,
   FLOAT64 = 0xcb,
   UINT8 = 0xcc,
@@ -33,6 +33,9 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <functional>
+#include <istream>
+
 #include "spark_dsg/attribute_factory.h"
 #include "spark_dsg/binary_serialization_utils.h"
 #include "spark_dsg/dynamic_scene_graph.h"
@@ -58,6 +61,9 @@ struct BinarySerializer {
 
   void startFixedArray(size_t length);
 
+  //! write a block of raw bytes
+  void writeBytes(const void* data, size_t num_bytes);
+
   void write_type(PackType type);
 
   template <typename T>
@@ -68,11 +74,38 @@ struct BinarySerializer {
   std::vector<uint8_t>* ref;
 };
 
+/**
+ * @brief Source of serialized data for streaming deserialization
+ *
+ * Copies up to max_bytes into the buffer and returns the number of bytes copied (0 once
+ * the source is exhausted)
+ */
+using ChunkReader = std::function<size_t(uint8_t* buffer, size_t max_bytes)>;
+
+//! read chunks from a stream (e.g., a file)
+ChunkReader streamChunkReader(std::istream& stream);
+
+//! read chunks from a file descriptor (e.g., a pipe or socket)
+ChunkReader fileDescriptorChunkReader(int fd);
+
+//! read chunks from a sequence of buffers (e.g., multipart messages) in order
+ChunkReader bufferChunkReader(std::vector<std::pair<const uint8_t*, size_t>> buffers);
+
 struct BinaryDeserializer {
+  static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 16;
+
   BinaryDeserializer(const uint8_t* const buffer, size_t length);
 
   explicit BinaryDeserializer(const std::vector<uint8_t>& buffer);
 
+  /**
+   * @brief Deserialize data that is read from the source as needed
+   *
+   * Only a window of the serialized data (roughly the chunk size) is kept in memory
+   */
+  explicit BinaryDeserializer(ChunkReader reader,
+                              size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
   void checkType(PackType type) const;
 
   void checkDynamicArray() const;
@@ -83,8 +116,11 @@ struct BinaryDeserializer {
 
   size_t readFixedArrayLength() const;
 
+  //! read the length of a block of raw bytes (the bytes follow at the current position)
+  size_t readBytesLength() const;
+
   inline PackType getCurrType() const {
-    if (pos >= buffer_length) {
+    if (pos >= buffer_length && !fill(1)) {
       throw std::out_of_range("attempt to read past end of buffer");
     }
 
@@ -99,16 +135,32 @@ struct BinaryDeserializer {
   template <typename T>
   const T* getReadPtr(size_t num_elements = 1) const {
     const size_t end_pos = sizeof(T) * num_elements + pos;
-    if (end_pos > buffer_length) {
+    if (end_pos > buffer_length && !fill(end_pos - pos)) {
       throw std::out_of_range("attempt to read past end of buffer");
     }
 
     return reinterpret_cast<const T*>(ref + pos);
   }
 
-  const uint8_t* const ref;
-  const size_t buffer_length;
+  //! whether or not all data has been read
+  bool atEnd() const { return pos >= buffer_length && !fill(1); }
+
+  //! current window of the data (the full buffer when not streaming)
+  mutable const uint8_t* ref;
+  mutable size_t buffer_length;
   mutable size_t pos;
+
+ private:
+  /**
+   * @brief Make at least num_bytes unread bytes available (when streaming)
+   *
+   * Invalidates pointers returned by getReadPtr
+   */
+  bool fill(size_t num_bytes) const;
+
+  ChunkReader reader_;
+  size_t chunk_size_ = 0;
+  mutable std::vector<uint8_t> window_;
 };
 
 struct BinaryConverter {
@@ -168,11 +220,50 @@ void BinarySerializer::write<SceneGraphEdge>(const SceneGraphEdge& edge);
 template <>
 void BinarySerializer::write<MeshEdge>(const MeshEdge& edge);
 
+//! write vertices with the legacy mesh layout (six floats per vertex)
 template <>
 void BinarySerializer::write<MeshVertices>(const MeshVertices& vertices);
 
+//! write faces with the legacy mesh layout (three integers per face)
 template <>
 void BinarySerializer::write<MeshFaces>(const MeshFaces& vertices);
 
+/**
+ * @brief Options for encoding a mesh
+ */
+struct MeshEncoding {
+  //! Quantize each vertex coordinate to this many bits within the mesh bounds (between
+  //! 1 and 16). Zero stores the coordinates as lossless floats. Quantizing implies
+  //! the compact layout
+  uint8_t position_bits = 0;
+  //! Use the compact layout, which readers that predate it cannot parse
+  bool compact = false;
+};
+
+/**
+ * @brief Write a mesh
+ *
+ * Meshes are written with the legacy layout (six floats per vertex followed by the
+ * face indices, dropping alpha) unless the encoding asks for the compact layout. The
+ * compact layout writes coordinates as one little-endian block per axis, colors as a
+ * block of RGBA bytes and face indices as a block of zigzag varints of the difference
+ * to the previous index. Meshes with non-finite coordinates are never quantized and
+ * vertices at the origin (which mark invalid vertices) are always restored exactly.
+ */
+void writeMesh(BinarySerializer& serializer,
+               const Mesh& mesh,
+               const MeshEncoding& encoding = {});
+
+/**
+ * @brief Read a mesh written with either the compact or the legacy layout
+ *
+ * The legacy layout is the vertices and faces written separately as PCL types
+ */
+Mesh::Ptr readMesh(const BinaryDeserializer& deserializer);
+
+//! write a mesh with the lossless compact layout
+template <>
+void BinarySerializer::write<Mesh>(const Mesh& mesh);
+
 }  // namespace serialization
 }  // namespace spark_dsg
@@ -0,0 +1,177 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "spark_dsg/edge_container.h"
+#include "spark_dsg/mesh_edge_index.h"
+#include "spark_dsg/scene_graph_types.h"
+
+namespace spark_dsg {
+
+enum class ChangeType {
+  NODE_ADDED,
+  NODE_REMOVED,
+  NODE_UPDATED,
+  EDGE_ADDED,
+  EDGE_REMOVED,
+  EDGE_UPDATED,
+  MESH_EDGE_ADDED,
+  MESH_EDGE_REMOVED,
+};
+
+/**
+ * @brief A single recorded modification of a graph
+ *
+ * Node changes only use the source field and mesh edge changes store the mesh vertex
+ * in the target field
+ */
+struct Change {
+  ChangeType type;
+  NodeId source;
+  NodeId target;
+
+  inline bool isNode() const {
+    return type == ChangeType::NODE_ADDED || type == ChangeType::NODE_REMOVED ||
+           type == ChangeType::NODE_UPDATED;
+  }
+
+  inline bool isMeshEdge() const {
+    return type == ChangeType::MESH_EDGE_ADDED || type == ChangeType::MESH_EDGE_REMOVED;
+  }
+};
+
+/**
+ * @brief Append-only log of the modifications of a layer or edge container
+ *
+ * Every change gets a sequence number. Consumers keep a cursor (the sequence number of
+ * the next change they have not seen) and read everything after it, so the cost of a
+ * read scales with the number of changes and not the size of the graph. Reading never
+ * modifies the journal, so any number of consumers can track changes independently.
+ *
+ * The journal only keeps the most recent changes (up to the capacity). Consumers that
+ * fall further behind are told that their view is incomplete. Recording is off until a
+ * capacity is set: changes made while it is off only advance the sequence numbers, so
+ * consumers with older cursors are still told that they missed something.
+ */
+class ChangeJournal {
+ public:
+  //! sequence number of a change
+  using Cursor = uint64_t;
+
+  //! capacity used when a consumer turns recording on without picking one
+  static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+  /**
+   * @brief Make a journal
+   * @param capacity maximum number of changes held (0 leaves recording off)
+   */
+  explicit ChangeJournal(size_t capacity = 0);
+
+  void recordNode(ChangeType type, NodeId node);
+
+  void recordEdge(ChangeType type, NodeId source, NodeId target);
+
+  //! sequence number of the oldest change still in the journal
+  inline Cursor begin() const { return offset_; }
+
+  //! sequence number of the next change that will be recorded
+  inline Cursor end() const { return offset_ + changes_.size(); }
+
+  //! number of changes currently held
+  inline size_t size() const { return changes_.size(); }
+
+  inline size_t capacity() const { return capacity_; }
+
+  //! whether or not changes are currently recorded
+  inline bool enabled() const { return capacity_ > 0; }
+
+  /**
+   * @brief Set the maximum number of changes held
+   *
+   * Shrinking drops the oldest changes and a capacity of 0 turns recording off (and
+   * drops every change).
+   */
+  void setCapacity(size_t capacity);
+
+  /**
+   * @brief Append every change after the cursor and advance the cursor to the end
+   * @param cursor position of the consumer in the journal
+   * @param changes changes to append to
+   * @returns false if changes after the cursor were already dropped
+   */
+  bool read(Cursor& cursor, std::vector<Change>& changes) const;
+
+  //! drop all changes (sequence numbers keep increasing)
+  void clear();
+
+ private:
+  size_t capacity_;
+  Cursor offset_ = 0;
+  std::deque<Change> changes_;
+};
+
+/**
+ * @brief Net effect of a sequence of changes
+ *
+ * Only the last change of every node or edge counts, so a node added and removed
+ * between two reads shows up as removed. Updates to a node or edge that is new since
+ * the last read only show up as new. All entries are sorted.
+ */
+struct ChangeSet {
+  std::vector<NodeId> new_nodes;
+  std::vector<NodeId> updated_nodes;
+  std::vector<NodeId> removed_nodes;
+  std::vector<EdgeKey> new_edges;
+  std::vector<EdgeKey> updated_edges;
+  std::vector<EdgeKey> removed_edges;
+  std::vector<MeshEdge> new_mesh_edges;
+  std::vector<MeshEdge> removed_mesh_edges;
+  //! false if some changes were dropped before they could be read
+  bool complete = true;
+
+  //! build the net effect of a list of changes
+  void merge(const std::vector<Change>& changes);
+
+  inline bool empty() const {
+    return new_nodes.empty() && updated_nodes.empty() && removed_nodes.empty() &&
+           new_edges.empty() && updated_edges.empty() && removed_edges.empty() &&
+           new_mesh_edges.empty() && removed_mesh_edges.empty();
+  }
+};
+
+}  // namespace spark_dsg
@@ -33,35 +33,19 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
-#include <pcl/PolygonMesh.h>
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
-
 #include <map>
 #include <memory>
 #include <type_traits>
 
+#include "spark_dsg/change_journal.h"
 #include "spark_dsg/dynamic_scene_graph_layer.h"
+#include "spark_dsg/mesh.h"
+#include "spark_dsg/mesh_blocks.h"
+#include "spark_dsg/mesh_edge_index.h"
 #include "spark_dsg/scene_graph_layer.h"
 
 namespace spark_dsg {
 
-/**
- * @brief Structure capturing node-edge relationship
- */
-struct MeshEdge {
-  NodeId source_node;
-  size_t mesh_vertex;
-
-  /**
-   * @brief initialize a mesh edge
-   * @param source_node Node in the scene graph
-   * @param mesh_vertex Mesh vertex that the edge points to
-   */
-  MeshEdge(NodeId source_node, size_t mesh_vertex)
-      : source_node(source_node), mesh_vertex(mesh_vertex) {}
-};
-
 /**
  * @brief Dynamic Scene Graph class
  *
@@ -84,16 +68,32 @@ class DynamicSceneGraph {
   //! Dynamic layer container
   using DynamicLayers = std::map<uint32_t, DynamicSceneGraphLayer::Ptr>;
   //! Underlying mesh type for lowest layer
-  using Mesh = pcl::PolygonMesh;
-  //! Underlying mesh vertex type
-  using MeshVertices = pcl::PointCloud<pcl::PointXYZRGBA>;
-  //! Underlying mesh triangle type
-  using MeshFaces = std::vector<pcl::Vertices>;
+  using Mesh = spark_dsg::Mesh;
+  //! PCL mesh vertex type (converted to and from the mesh)
+  using MeshVertices = Mesh::PclVertices;
+  //! PCL mesh triangle type (converted to and from the mesh)
+  using MeshFaces = Mesh::PclFaces;
   //! Mesh edge container type
-  using MeshEdges = std::map<size_t, MeshEdge>;
+  using MeshEdges = MeshEdgeIndex::Edges;
   //! Callback type
   using LayerVisitor = std::function<void(LayerKey, BaseLayer*)>;
 
+  /**
+   * @brief Position of a consumer in every change journal of the graph
+   *
+   * Journals of layers missing from the cursor are read from the start
+   */
+  struct ChangeCursor {
+    //! cursor per static layer
+    std::map<LayerId, ChangeJournal::Cursor> layers;
+    //! cursor per dynamic layer (by layer and then prefix)
+    std::map<LayerId, std::map<uint32_t, ChangeJournal::Cursor>> dynamic_layers;
+    //! cursor for the interlayer edges
+    ChangeJournal::Cursor interlayer = 0;
+    //! number of times the graph was cleared when the cursor was last advanced
+    size_t generation = 0;
+  };
+
   friend class SceneGraphLogger;
 
   /**
@@ -185,6 +185,24 @@ class DynamicSceneGraph {
    */
   bool addOrUpdateNode(LayerId layer_id, NodeId node_id, NodeAttributes::Ptr&& attrs);
 
+  /**
+   * @brief Reserve space for nodes that are about to be added to a layer
+   *
+   * @param layer_id layer the nodes will be added to
+   * @param num_nodes number of nodes to make room for
+   * @return true if the layer exists
+   */
+  bool reserveNodes(LayerId layer_id, size_t num_nodes);
+
+  /**
+   * @brief Reserve space for edges that are about to be added
+   *
+   * Edges with missing endpoints are ignored
+   *
+   * @param edges edges to make room for
+   */
+  void reserveEdges(const std::vector<EdgeKey>& edges);
+
   /**
    * @brief Add an edge to the graph
    *
@@ -221,6 +239,30 @@ class DynamicSceneGraph {
    */
   bool setNodeAttributes(NodeId node, NodeAttributes::Ptr&& attrs);
 
+  /**
+   * @brief Enable or disable the position cache of a static layer
+   * @param layer_id layer to enable the cache for
+   * @param enable whether or not to keep the cache
+   * @return Returns true if the layer exists
+   */
+  bool enablePositionCache(LayerId layer_id, bool enable = true);
+
+  /**
+   * @brief Enable or disable the spatial index of a static layer
+   * @param layer_id layer to enable the index for
+   * @param enable whether or not to keep the index
+   * @param cell_size grid cell size of the index
+   * @return Returns true if the layer exists
+   */
+  bool enableSpatialIndex(LayerId layer_id, bool enable = true, double cell_size = 1.0);
+
+  /**
+   * @brief Update the cached position of a node after modifying its attributes
+   * @param node Node ID to update
+   * @return Returns true if the node exists
+   */
+  bool refreshPosition(NodeId node);
+
   /**
    * @brief Set the attributes of an existing edge
    * @param source Source ID to set the attributes for
@@ -230,6 +272,22 @@ class DynamicSceneGraph {
    */
   bool setEdgeAttributes(NodeId source, NodeId target, EdgeAttributes::Ptr&& attrs);
 
+  /**
+   * @brief Record that the attributes of a node were modified in place
+   *
+   * Change consumers (e.g., GraphDeltaEncoder) only see attribute updates made through
+   * setNodeAttributes or reported here. Also refreshes the cached position of the node.
+   *
+   * @returns true if the node exists
+   */
+  bool markNodeUpdated(NodeId node);
+
+  /**
+   * @brief Record that the attributes of an edge were modified in place
+   * @returns true if the edge exists
+   */
+  bool markEdgeUpdated(NodeId source, NodeId target);
+
   /**
    * @brief Check whether the layer exists and is valid
    * @param layer_id Layer id to check
@@ -422,11 +480,22 @@ class DynamicSceneGraph {
   void initMesh();
 
   /**
-   * @brief Set mesh components individually
+   * @brief Set the mesh
    *
    * This removes any edges that point to vertices that no longer
    * exist (i.e. if the new mesh is smaller than the old mesh)
    *
+   * @param mesh New mesh (shared with the graph, resets the mesh if null)
+   * @param invalidate_all_edges Clear all existing mesh edges
+   */
+  void setMesh(const Mesh::Ptr& mesh, bool invalidate_all_edges = false);
+
+  /**
+   * @brief Set mesh components individually from PCL types
+   *
+   * The vertices and faces are converted to the native mesh representation. See
+   * setMesh(const Mesh::Ptr&, bool) for how mesh edges are handled.
+   *
    * @param vertices Mesh vertices
    * @param faces Mesh triangles
    * @param invalidate_all_edges Clear all existing mesh edges
@@ -435,6 +504,45 @@ class DynamicSceneGraph {
                const std::shared_ptr<MeshFaces>& faces,
                bool invalidate_all_edges = false);
 
+  /**
+   * @brief Set a mesh that is made of blocks
+   *
+   * See setMesh(const Mesh::Ptr&, bool) for how mesh edges are handled.
+   *
+   * @param mesh New mesh (shared with the graph)
+   * @param blocks Layout of the blocks in the mesh
+   * @param invalidate_all_edges Clear all existing mesh edges
+   */
+  void setMesh(const Mesh::Ptr& mesh,
+               const MeshBlocks& blocks,
+               bool invalidate_all_edges = false);
+
+  /**
+   * @brief Insert or replace a block of the mesh
+   *
+   * Creates an empty mesh if the graph doesn't have one. Vertices of a block keep their
+   * mesh indices as long as the block fits into the space it previously used. Mesh
+   * edges to a block that moves are remapped and mesh edges to vertices past the end
+   * of the block are removed. Only edges to the block are touched. A mesh that is
+   * shared (e.g., a pointer returned by mesh() that is still held elsewhere) is copied
+   * first, so holders of the previous mesh never see partial updates.
+   *
+   * @param index Spatial index of the block
+   * @param block Vertices and faces of the block (faces refer to the block vertices)
+   * @returns New version of the block
+   */
+  uint64_t upsertMeshBlock(const MeshBlocks::Index& index, const Mesh& block);
+
+  /**
+   * @brief Remove a block of the mesh and all mesh edges to it
+   *
+   * Shared meshes are copied first (see upsertMeshBlock)
+   *
+   * @param index Spatial index of the block
+   * @returns Returns true if the block existed
+   */
+  bool removeMeshBlock(const MeshBlocks::Index& index);
+
   /**
    * @brief Set mesh components directly from a polygon mesh
    * @note doesn't invalidate any edges
@@ -454,22 +562,36 @@ class DynamicSceneGraph {
   bool isMeshEmpty() const;
 
   /**
-   * @brief mesh getter
-   * @returns Return scene graph mesh
+   * @brief Get a copy of the mesh as a PCL polygon mesh
+   *
+   * Faces that only pad the block layout are dropped (see MeshBlocks::exportMesh)
+   *
+   * @returns Return scene graph mesh (empty if the graph has no mesh)
    */
   pcl::PolygonMesh getMesh() const;
 
   /**
-   * @brief Get mesh vertices pointer (may be invalid)
-   * @return Pointer to mesh vertices
+   * @brief Get a copy of the mesh vertices as a PCL point cloud
+   *
+   * Changes to the returned cloud are not applied to the graph
+   *
+   * @return Pointer to mesh vertices (null if the graph has no mesh)
+   * @deprecated use mesh() to read the mesh without converting it
    */
-  MeshVertices::Ptr getMeshVertices() const;
+  [[deprecated("returns a copy, use mesh() instead")]] MeshVertices::Ptr
+  getMeshVertices() const;
 
   /**
-   * @brief Get pointer to mesh faces (may be invalid)
-   * @returns Pointer to mesh faces
+   * @brief Get a copy of the mesh faces as PCL polygons
+   *
+   * Changes to the returned polygons are not applied to the graph. Every polygon
+   * allocates its own index vector.
+   *
+   * @returns Pointer to mesh faces (null if the graph has no mesh)
+   * @deprecated use mesh() to read the mesh without converting it
    */
-  std::shared_ptr<MeshFaces> getMeshFaces() const;
+  [[deprecated("returns a copy, use mesh() instead")]] std::shared_ptr<MeshFaces>
+  getMeshFaces() const;
 
   /**
    * @brief Get the mesh vertex position (if vaild)
@@ -492,6 +614,15 @@ class DynamicSceneGraph {
                       size_t mesh_vertex,
                       bool allow_invalid_mesh = false);
 
+  /**
+   * @brief Add many edges from other nodes to the mesh at once
+   * @param edges Edges to add (edges from missing nodes are skipped)
+   * @param allow_invalid_mesh Allow edge insertion even if the edge points to an
+   * invalid vertice
+   * @return Returns the number of edges that were added
+   */
+  size_t insertMeshEdges(const MeshEdges& edges, bool allow_invalid_mesh = false);
+
   /**
    * @brief check if an edge between a source node and a target mesh vertex exists
    * @param source Source node to check
@@ -502,7 +633,7 @@ class DynamicSceneGraph {
 
   /**
    * @brief Get all mesh edges
-   * @returns Mesh edges
+   * @returns Mesh edges (in no particular order)
    */
   const MeshEdges& getMeshEdges() const;
 
@@ -620,6 +751,48 @@ class DynamicSceneGraph {
    */
   std::vector<EdgeKey> getNewEdges(bool clear_new = false);
 
+  /**
+   * @brief Set how many changes every journal of the graph holds
+   *
+   * Change journals are off by default so that graphs without consumers don't pay for
+   * them. The capacity also applies to layers created later.
+   *
+   * @param capacity maximum number of changes held per journal (0 turns them off)
+   */
+  void setJournalCapacity(size_t capacity);
+
+  //! maximum number of changes held per journal (0 if journals are off)
+  inline size_t journalCapacity() const { return journal_capacity_; }
+
+  /**
+   * @brief Get a cursor pointing at the current end of every change journal
+   *
+   * Attaching a consumer this way turns the journals on (with
+   * ChangeJournal::DEFAULT_CAPACITY) if they are off. Cursors made before the journals
+   * were turned on report their next read as incomplete.
+   */
+  ChangeCursor getChangeCursor() const;
+
+  /**
+   * @brief Get the net changes to the graph after the cursor and advance the cursor
+   *
+   * Only visits the changes recorded since the cursor was last advanced, and doesn't
+   * modify any status tracking, so any number of consumers can track changes
+   * independently of each other and of getNewNodes and friends. The result is marked
+   * incomplete if some changes were dropped or the graph was cleared in the meantime.
+   *
+   * @param cursor position of the consumer
+   * @returns new, updated and removed nodes and edges and new and removed mesh edges
+   */
+  ChangeSet getChanges(ChangeCursor& cursor) const;
+
+  /**
+   * @brief Get the net changes to the graph after a cursor without advancing it
+   * @param epoch point to report changes from (e.g., when a message was last sent)
+   * @returns new, updated and removed nodes and edges and new and removed mesh edges
+   */
+  ChangeSet getChangesSince(const ChangeCursor& epoch) const;
+
   /**
    * @brief track which edges get used during a serialization update
    */
@@ -632,12 +805,19 @@ class DynamicSceneGraph {
 
   /**
    * @brief Clone the scene graph
+   *
+   * The clone shares the mesh with this graph until either graph updates a mesh block
+   * (see upsertMeshBlock)
+   *
    * @returns Copy of the scene graph
    */
   DynamicSceneGraph::Ptr clone() const;
 
   /**
    * @brief Save JSON graph representation to file
+   *
+   * Saves a binary GraphArchive instead if the filepath ends in ".sparkdsg"
+   *
    * @param filepath Filepath to save graph to
    * @param include_mesh Optionally encode mesh (defaults to true)
    */
@@ -650,13 +830,42 @@ class DynamicSceneGraph {
    */
   std::string serialize(bool include_mesh = false) const;
 
+  //! time (in seconds) spent in each phase of loading a graph
+  struct LoadTimings {
+    //! reading and parsing the file (or the header of a GraphArchive)
+    double parse = 0.0;
+    //! constructing node and edge attributes
+    double decode = 0.0;
+    //! inserting nodes into the graph
+    double nodes = 0.0;
+    //! inserting edges into the graph
+    double edges = 0.0;
+    //! reading and inserting the mesh and mesh edges
+    double mesh = 0.0;
+  };
+
   /**
-   * @brief parse graph from JSON file
+   * @brief parse graph from JSON file (or a binary GraphArchive)
    * @param filepath Path to JSON file to read
    * @returns Resulting parsed scene graph
    */
   static Ptr load(const std::string& filepath);
 
+  /**
+   * @brief parse graph from file, constructing attributes in parallel
+   *
+   * Attributes are independent of the graph structure and are constructed by a pool
+   * of threads before nodes and edges are inserted by a single thread
+   *
+   * @param filepath Path to JSON file (or GraphArchive) to read
+   * @param num_threads Number of threads to use (0 picks the hardware concurrency)
+   * @param timings Optional time spent in each phase
+   * @returns Resulting parsed scene graph
+   */
+  static Ptr load(const std::string& filepath,
+                  size_t num_threads,
+                  LoadTimings* timings = nullptr);
+
   /**
    * @brief parse graph from JSON string
    * @param contents JSON string to parse
@@ -664,6 +873,17 @@ class DynamicSceneGraph {
    */
   static Ptr deserialize(const std::string& contents);
 
+  /**
+   * @brief parse graph from JSON string, constructing attributes in parallel
+   * @param contents JSON string to parse
+   * @param num_threads Number of threads to use (0 picks the hardware concurrency)
+   * @param timings Optional time spent in each phase
+   * @returns Resulting parsed scene graph
+   */
+  static Ptr deserialize(const std::string& contents,
+                         size_t num_threads,
+                         LoadTimings* timings = nullptr);
+
   //! mesh layer id
   const LayerId mesh_layer_id;
 
@@ -710,24 +930,34 @@ class DynamicSceneGraph {
 
   void clearMeshEdgesForNode(NodeId node_id);
 
+  //! container that holds an existing edge
+  EdgeContainer& edgeContainer(NodeId source, NodeId target);
+
+  void remapMeshEdges(const MeshBlockInfo& previous, const MeshBlockInfo* current);
+
+  //! mesh that can be modified in place (copied first if anyone else shares it)
+  Mesh& writableMesh();
+
   void visitLayers(const LayerVisitor& cb);
 
- protected:
+  //! journals are consumer bookkeeping, so this is allowed on a const graph
+  void applyJournalCapacity(size_t capacity) const;
+
   Layers layers_;
   std::map<LayerId, DynamicLayers> dynamic_layers_;
 
-  std::map<NodeId, LayerKey> node_lookup_;
+  NodeLookup node_lookup_;
 
   EdgeContainer interlayer_edges_;
   EdgeContainer dynamic_interlayer_edges_;
+  mutable ChangeJournal interlayer_journal_;
+  mutable size_t journal_capacity_ = 0;
+  size_t generation_ = 0;
 
-  MeshVertices::Ptr mesh_vertices_;
-  std::shared_ptr<MeshFaces> mesh_faces_;
+  Mesh::Ptr mesh_;
+  MeshBlocks mesh_blocks_;
 
-  size_t next_mesh_edge_idx_;
-  MeshEdges mesh_edges_;
-  std::map<NodeId, std::map<size_t, size_t>> mesh_edges_node_lookup_;
-  std::map<size_t, std::map<NodeId, size_t>> mesh_edges_vertex_lookup_;
+  MeshEdgeIndex mesh_edges_;
 
  public:
   /**
@@ -738,7 +968,20 @@ class DynamicSceneGraph {
   /**
    * @brief constant iterator over mapping between nodes and layers
    */
-  inline const std::map<NodeId, LayerKey>& node_lookup() const { return node_lookup_; }
+  inline const NodeLookup& node_lookup() const { return node_lookup_; }
+
+  /**
+   * @brief mesh of the graph (may be null)
+   *
+   * Meshes with blocks contain padding faces on vertex 0 in the free ranges of the
+   * layout (use MeshBlocks::exportMesh to drop them)
+   */
+  inline const Mesh::Ptr& mesh() const { return mesh_; }
+
+  /**
+   * @brief layout of the blocks of the mesh (empty if the mesh has no blocks)
+   */
+  inline const MeshBlocks& meshBlocks() const { return mesh_blocks_; }
 
   /**
    * @brief constant iterator around the inter-layer edges
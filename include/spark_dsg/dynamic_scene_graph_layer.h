@@ -33,6 +33,8 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <map>
+
 #include "spark_dsg/base_layer.h"
 #include "spark_dsg/node_symbol.h"
 
@@ -102,7 +104,7 @@ class DynamicSceneGraphLayer : public BaseLayer {
   const LayerPrefix prefix;
 
   bool mergeLayer(const DynamicSceneGraphLayer& graph_layer,
-                  std::map<NodeId, LayerKey>* layer_lookup = nullptr,
+                  NodeLookup* layer_lookup = nullptr,
                   bool update_attributes = true);
 
   void getNewNodes(std::vector<NodeId>& new_nodes, bool clear_new) override;
@@ -33,15 +33,21 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
-#include <map>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <utility>
 #include <vector>
 
 #include "spark_dsg/edge_attributes.h"
+#include "spark_dsg/flat_map.h"
 #include "spark_dsg/node_symbol.h"
 #include "spark_dsg/scene_graph_types.h"
 
 namespace spark_dsg {
 
+class ChangeJournal;
+
 /**
  * @brief edge status
  *
@@ -78,6 +84,11 @@ struct SceneGraphEdge {
                   "info can only be downcast to a derived EdgeAttributes class");
     return dynamic_cast<Derived&>(*info);
   }
+
+  //! weight used by weighted searches (1.0 if the edge has no valid weight)
+  inline double searchWeight() const {
+    return info && info->weighted ? info->weight : 1.0;
+  }
 };
 
 struct EdgeKey {
@@ -103,15 +114,216 @@ inline std::ostream& operator<<(std::ostream& out, const EdgeKey& key) {
   return out << NodeSymbol(key.k1) << " -> " << NodeSymbol(key.k2);
 }
 
+template <>
+struct FlatHash<EdgeKey> {
+  inline uint64_t operator()(const EdgeKey& key) const {
+    return mixHash(mixHash(key.k1) ^ key.k2);
+  }
+};
+
+/**
+ * @brief Hashed storage for the edges of a graph
+ *
+ * Every edge key maps to a single entry in an open-addressing table that holds the
+ * edge (if it currently exists) and the status of the edge inline. Entries of removed
+ * edges are kept (without an edge) until the removal is reported. Edges are
+ * heap-allocated, so edge references stay valid until the edge is removed.
+ *
+ * Staleness is tracked with epochs: every edge records the epoch it was last accessed
+ * in, and existing edges are additionally kept in a list ordered by that epoch. Marking
+ * every edge as stale only advances the epoch and the stale edges are always a prefix
+ * of the list.
+ *
+ * Iteration yields pairs of (edge key, edge pointer) in insertion order. Use sorted()
+ * when a deterministic order by key is required (e.g., for serialization).
+ */
+class EdgeStore {
+ public:
+  using Edge = SceneGraphEdge;
+  //! pair-like view of a stored edge
+  using value_type = std::pair<EdgeKey, Edge*>;
+
+  //! an edge and its position in the access list
+  struct Record {
+    Record(NodeId source, NodeId target, EdgeAttributes::Ptr&& attrs, uint64_t epoch)
+        : edge(source, target, std::move(attrs)), epoch(epoch) {}
+
+    Edge edge;
+    //! last epoch the edge was accessed in
+    uint64_t epoch;
+    Record* prev = nullptr;
+    Record* next = nullptr;
+  };
+
+  struct Entry {
+    //! edge record (null if the edge was removed)
+    std::unique_ptr<Record> record;
+    //! history of the edge
+    EdgeStatus status = EdgeStatus::NEW;
+  };
+
+  using Table = FlatMap<EdgeKey, Entry>;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = EdgeStore::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() = default;
+
+    const_iterator(Table::const_iterator iter, Table::const_iterator end)
+        : iter_(iter), end_(end) {
+      update();
+    }
+
+    reference operator*() const { return *value_; }
+
+    pointer operator->() const { return &(*value_); }
+
+    const_iterator& operator++() {
+      ++iter_;
+      update();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator prev = *this;
+      ++(*this);
+      return prev;
+    }
+
+    bool operator==(const const_iterator& other) const { return iter_ == other.iter_; }
+
+    bool operator!=(const const_iterator& other) const { return iter_ != other.iter_; }
+
+   private:
+    void update() {
+      value_.reset();
+      while (iter_ != end_ && !iter_->second.record) {
+        ++iter_;
+      }
+
+      if (iter_ != end_) {
+        value_.emplace(iter_->first, &iter_->second.record->edge);
+      }
+    }
+
+    Table::const_iterator iter_;
+    Table::const_iterator end_;
+    std::optional<value_type> value_;
+  };
+
+  using iterator = const_iterator;
+
+  EdgeStore() = default;
+
+  EdgeStore(const EdgeStore& other) = delete;
+
+  EdgeStore& operator=(const EdgeStore& other) = delete;
+
+  EdgeStore(EdgeStore&& other) noexcept { swap(other); }
+
+  EdgeStore& operator=(EdgeStore&& other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  //! number of existing edges
+  inline size_t size() const { return num_edges_; }
+
+  inline bool empty() const { return num_edges_ == 0; }
+
+  inline bool contains(const EdgeKey& key) const { return find(key) != nullptr; }
+
+  inline size_t count(const EdgeKey& key) const { return contains(key) ? 1 : 0; }
+
+  /**
+   * @brief Make sure that the store can hold the requested number of edges without
+   * growing the lookup table
+   */
+  inline void reserve(size_t num_edges) { table_.reserve(num_edges); }
+
+  /**
+   * @brief Get a pointer to an edge
+   * @returns a pointer to the edge or nullptr if the edge does not exist
+   */
+  inline Edge* find(const EdgeKey& key) const {
+    const auto iter = table_.find(key);
+    return (iter == table_.end() || !iter->second.record) ? nullptr
+                                                          : &iter->second.record->edge;
+  }
+
+  /**
+   * @brief Get an edge with bounds checking
+   * @throws std::out_of_range if the edge does not exist
+   */
+  Edge& at(const EdgeKey& key) const;
+
+  /**
+   * @brief Construct an edge in place if it doesn't exist already
+   * @param source source of the edge
+   * @param target target of the edge
+   * @param attrs attributes of the edge (default attributes if null)
+   * @returns a pointer to the edge and whether or not the edge was added
+   */
+  std::pair<Edge*, bool> emplace(NodeId source,
+                                 NodeId target,
+                                 EdgeAttributes::Ptr&& attrs = nullptr);
+
+  /**
+   * @brief Get all existing edges ordered by key
+   */
+  std::vector<value_type> sorted() const;
+
+  const_iterator begin() const { return const_iterator(table_.begin(), table_.end()); }
+
+  const_iterator end() const { return const_iterator(table_.end(), table_.end()); }
+
+ private:
+  friend struct EdgeContainer;
+
+  void swap(EdgeStore& other) noexcept;
+
+  //! add a record to the back of the access list
+  void link(Record* record) const;
+
+  //! remove a record from the access list
+  void unlink(Record* record) const;
+
+  //! mark a record as accessed in the current epoch
+  inline void touch(Record* record) const {
+    if (record->epoch != epoch_) {
+      record->epoch = epoch_;
+      unlink(record);
+      link(record);
+    }
+  }
+
+  Table table_;
+  size_t num_edges_ = 0;
+  uint64_t epoch_ = 0;
+  // the access list is reordered by (const) edge accesses
+  mutable Record* head_ = nullptr;
+  mutable Record* tail_ = nullptr;
+};
+
 struct EdgeContainer {
   using Edge = SceneGraphEdge;
-  using Edges = std::map<EdgeKey, Edge>;
-  using EdgeStatusMap = std::map<EdgeKey, EdgeStatus>;
+  using Edges = EdgeStore;
 
   void insert(NodeId source, NodeId target, EdgeAttributes::Ptr&& edge_info);
 
   void remove(NodeId source, NodeId target);
 
+  //! replace the attributes of an existing edge
+  void update(NodeId source, NodeId target, EdgeAttributes::Ptr&& edge_info);
+
+  //! record that the attributes of an existing edge were modified in place
+  void markUpdated(NodeId source, NodeId target);
+
   void rewire(NodeId source, NodeId target, NodeId new_source, NodeId new_target);
 
   bool contains(NodeId source, NodeId target) const;
@@ -121,15 +333,11 @@ struct EdgeContainer {
   void reset();
 
   inline const Edge& get(NodeId source, NodeId target) const {
-    const EdgeKey key(source, target);
-    stale_edges[key] = false;
-    return edges.at(key);
+    return access(EdgeKey(source, target));
   }
 
   inline Edge& get(NodeId source, NodeId target) {
-    const EdgeKey key(source, target);
-    stale_edges[key] = false;
-    return edges.at(key);
+    return access(EdgeKey(source, target));
   }
 
   EdgeStatus getStatus(NodeId source, NodeId target) const;
@@ -138,11 +346,31 @@ struct EdgeContainer {
 
   void getNew(std::vector<EdgeKey>& new_edges, bool clear_new);
 
-  void setStale();
+  /**
+   * @brief Mark every existing edge as stale (constant time)
+   *
+   * Edges stop being stale once they are accessed via get()
+   */
+  inline void setStale() { ++edges.epoch_; }
+
+  /**
+   * @brief Check whether an existing edge hasn't been accessed since setStale
+   */
+  bool isStale(NodeId source, NodeId target) const;
+
+  /**
+   * @brief Get every existing edge that hasn't been accessed since setStale
+   *
+   * Only visits the stale edges (in order of last access)
+   */
+  void getStale(std::vector<EdgeKey>& stale_edges) const;
 
   Edges edges;
-  EdgeStatusMap edge_status;
-  mutable std::map<EdgeKey, bool> stale_edges;
+  //! optional journal that edge additions, updates and removals are recorded in
+  ChangeJournal* journal = nullptr;
+
+ private:
+  Edge& access(const EdgeKey& key) const;
 };
 
 }  // namespace spark_dsg
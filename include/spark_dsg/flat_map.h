@@ -0,0 +1,464 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "spark_dsg/scene_graph_types.h"
+
+namespace spark_dsg {
+
+/**
+ * @brief Finalizer from murmurhash3 to spread node ids across the table
+ *
+ * Node ids encode the category in the upper bits and a dense index in the lower bits,
+ * which clusters badly without mixing.
+ */
+inline uint64_t mixHash(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+template <typename Key, typename = void>
+struct FlatHash {
+  inline uint64_t operator()(const Key& key) const {
+    return mixHash(static_cast<uint64_t>(std::hash<Key>()(key)));
+  }
+};
+
+template <typename Key>
+struct FlatHash<Key, std::enable_if_t<std::is_integral<Key>::value>> {
+  inline uint64_t operator()(const Key& key) const {
+    return mixHash(static_cast<uint64_t>(key));
+  }
+};
+
+/**
+ * @brief Open-addressing hash map with a stable (insertion-ordered) iteration order
+ *
+ * Entries live in a dense vector in the order they were inserted and a separate
+ * linear-probing table of (entry index, hash tag) pairs is used for lookup. Erasing
+ * an entry leaves a hole in the dense vector (so iteration order and iterators to
+ * other entries are unaffected) and holes are compacted the next time the table
+ * grows or once holes outnumber entries. Insertion may invalidate iterators, similar
+ * to std::unordered_map.
+ */
+template <typename Key, typename Value, typename Hash = FlatHash<Key>>
+class FlatMap {
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<const Key, Value>;
+  using size_type = size_t;
+
+ private:
+  using Entry = std::optional<value_type>;
+  using Entries = std::vector<Entry>;
+
+  struct Slot {
+    uint32_t index;  // index into entries (plus one, zero is empty)
+    uint32_t tag;    // upper bits of the hash to avoid touching entries on misses
+  };
+
+  template <bool IsConst>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = FlatMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+    using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+    using EntriesPtr = std::conditional_t<IsConst, const Entries*, Entries*>;
+
+    Iterator() = default;
+
+    Iterator(EntriesPtr entries, size_t index) : entries_(entries), index_(index) {
+      skipHoles();
+    }
+
+    template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+    Iterator(const Iterator<OtherConst>& other)
+        : entries_(other.entries_), index_(other.index_) {}
+
+    reference operator*() const { return *(*entries_)[index_]; }
+
+    pointer operator->() const { return &(*(*entries_)[index_]); }
+
+    Iterator& operator++() {
+      ++index_;
+      skipHoles();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator prev = *this;
+      ++(*this);
+      return prev;
+    }
+
+    bool operator==(const Iterator& other) const { return index_ == other.index_; }
+
+    bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+
+   private:
+    friend class FlatMap;
+    friend class Iterator<!IsConst>;
+
+    void skipHoles() {
+      while (index_ < entries_->size() && !(*entries_)[index_]) {
+        ++index_;
+      }
+    }
+
+    EntriesPtr entries_ = nullptr;
+    size_t index_ = 0;
+  };
+
+ public:
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  FlatMap() = default;
+
+  FlatMap(std::initializer_list<value_type> values) {
+    reserve(values.size());
+    for (const auto& value : values) {
+      insert(value);
+    }
+  }
+
+  FlatMap(const FlatMap& other) = default;
+
+  FlatMap(FlatMap&& other) noexcept
+      : entries_(std::move(other.entries_)),
+        slots_(std::move(other.slots_)),
+        size_(other.size_) {
+    other.entries_.clear();
+    other.slots_.clear();
+    other.size_ = 0;
+  }
+
+  // entries hold const keys and can't be assigned element-wise
+  FlatMap& operator=(const FlatMap& other) {
+    if (this != &other) {
+      FlatMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  FlatMap& operator=(FlatMap&& other) noexcept {
+    if (this != &other) {
+      entries_ = std::move(other.entries_);
+      slots_ = std::move(other.slots_);
+      size_ = other.size_;
+      other.entries_.clear();
+      other.slots_.clear();
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  void swap(FlatMap& other) noexcept {
+    entries_.swap(other.entries_);
+    slots_.swap(other.slots_);
+    std::swap(size_, other.size_);
+  }
+
+  inline size_t size() const { return size_; }
+
+  inline bool empty() const { return size_ == 0; }
+
+  /**
+   * @brief Remove all entries (keeps the allocated table)
+   */
+  void clear() {
+    entries_.clear();
+    std::fill(slots_.begin(), slots_.end(), Slot{0, 0});
+    size_ = 0;
+  }
+
+  /**
+   * @brief Make sure that the map can hold the requested number of entries without
+   * growing the lookup table
+   */
+  void reserve(size_t num_entries) {
+    entries_.reserve(num_entries);
+    const size_t required = minCapacity(num_entries);
+    if (required > slots_.size()) {
+      rehash(required);
+    }
+  }
+
+  iterator begin() { return iterator(&entries_, 0); }
+
+  iterator end() { return iterator(&entries_, entries_.size()); }
+
+  const_iterator begin() const { return const_iterator(&entries_, 0); }
+
+  const_iterator end() const { return const_iterator(&entries_, entries_.size()); }
+
+  iterator find(const Key& key) {
+    const size_t index = lookup(key);
+    return index == npos ? end() : iterator(&entries_, index);
+  }
+
+  const_iterator find(const Key& key) const {
+    const size_t index = lookup(key);
+    return index == npos ? end() : const_iterator(&entries_, index);
+  }
+
+  inline size_t count(const Key& key) const { return lookup(key) == npos ? 0 : 1; }
+
+  inline bool contains(const Key& key) const { return lookup(key) != npos; }
+
+  Value& at(const Key& key) {
+    const size_t index = lookup(key);
+    if (index == npos) {
+      throw std::out_of_range("key not found in flat map");
+    }
+
+    return entries_[index]->second;
+  }
+
+  const Value& at(const Key& key) const {
+    const size_t index = lookup(key);
+    if (index == npos) {
+      throw std::out_of_range("key not found in flat map");
+    }
+
+    return entries_[index]->second;
+  }
+
+  Value& operator[](const Key& key) { return emplace(key).first->second; }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return emplace(value.first, value.second);
+  }
+
+  /**
+   * @brief Construct a value in place if the key does not exist
+   * @returns iterator to the entry and whether or not the entry was inserted
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(const Key& key, Args&&... args) {
+    const uint64_t hash = Hash()(key);
+    size_t index = lookup(key, hash);
+    if (index != npos) {
+      return {iterator(&entries_, index), false};
+    }
+
+    if (minCapacity(size_ + 1) > slots_.size()) {
+      rehash(minCapacity(size_ + 1));
+    } else if (hasExcessHoles()) {
+      rehash(slots_.size());
+    }
+
+    index = entries_.size();
+    entries_.emplace_back(std::in_place,
+                          std::piecewise_construct,
+                          std::forward_as_tuple(key),
+                          std::forward_as_tuple(std::forward<Args>(args)...));
+    placeSlot(hash, index);
+    ++size_;
+    return {iterator(&entries_, index), true};
+  }
+
+  /**
+   * @brief Remove an entry if it exists
+   * @returns number of entries removed
+   */
+  size_t erase(const Key& key) {
+    if (slots_.empty()) {
+      return 0;
+    }
+
+    const uint64_t hash = Hash()(key);
+    const size_t mask = slots_.size() - 1;
+    size_t pos = hash & mask;
+    while (slots_[pos].index != 0) {
+      const Slot& slot = slots_[pos];
+      if (slot.tag == tagFor(hash) && entries_[slot.index - 1]->first == key) {
+        entries_[slot.index - 1].reset();
+        removeSlot(pos);
+        --size_;
+        return 1;
+      }
+
+      pos = (pos + 1) & mask;
+    }
+
+    return 0;
+  }
+
+  /**
+   * @brief Remove the entry pointed to by the iterator
+   * @returns iterator to the next entry
+   */
+  iterator erase(const_iterator iter) {
+    const size_t index = iter.index_;
+    erase(iter->first);
+    return iterator(&entries_, index);
+  }
+
+  bool operator==(const FlatMap& other) const {
+    if (size_ != other.size_) {
+      return false;
+    }
+
+    for (const auto& [key, value] : *this) {
+      auto iter = other.find(key);
+      if (iter == other.end() || !(iter->second == value)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool operator!=(const FlatMap& other) const { return !(*this == other); }
+
+ private:
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  static inline uint32_t tagFor(uint64_t hash) { return hash >> 32; }
+
+  // keeps the load factor under 0.75 (linear probing degrades quickly past that)
+  static inline size_t minCapacity(size_t num_entries) {
+    size_t capacity = 8;
+    while (capacity * 3 < num_entries * 4) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  // holes left by erase are only reclaimed on rehash, so insert/erase churn at a
+  // constant size would otherwise grow the dense vector without bound
+  inline bool hasExcessHoles() const { return entries_.size() >= 2 * size_ + 16; }
+
+  inline size_t lookup(const Key& key) const { return lookup(key, Hash()(key)); }
+
+  size_t lookup(const Key& key, uint64_t hash) const {
+    if (slots_.empty()) {
+      return npos;
+    }
+
+    const uint32_t tag = tagFor(hash);
+    const size_t mask = slots_.size() - 1;
+    size_t pos = hash & mask;
+    while (slots_[pos].index != 0) {
+      const Slot& slot = slots_[pos];
+      if (slot.tag == tag && entries_[slot.index - 1]->first == key) {
+        return slot.index - 1;
+      }
+
+      pos = (pos + 1) & mask;
+    }
+
+    return npos;
+  }
+
+  void placeSlot(uint64_t hash, size_t index) {
+    const size_t mask = slots_.size() - 1;
+    size_t pos = hash & mask;
+    while (slots_[pos].index != 0) {
+      pos = (pos + 1) & mask;
+    }
+
+    slots_[pos] = {static_cast<uint32_t>(index + 1), tagFor(hash)};
+  }
+
+  // backward-shift deletion so that lookups never need tombstones
+  void removeSlot(size_t hole) {
+    const size_t mask = slots_.size() - 1;
+    size_t pos = hole;
+    while (true) {
+      pos = (pos + 1) & mask;
+      if (slots_[pos].index == 0) {
+        break;
+      }
+
+      const size_t home = Hash()(entries_[slots_[pos].index - 1]->first) & mask;
+      // distance from the home bucket to the candidate vs. to the hole
+      if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+        slots_[hole] = slots_[pos];
+        hole = pos;
+      }
+    }
+
+    slots_[hole] = {0, 0};
+  }
+
+  void rehash(size_t capacity) {
+    if (size_ != entries_.size()) {
+      Entries compacted;
+      compacted.reserve(std::max(entries_.capacity(), size_));
+      for (auto& entry : entries_) {
+        if (entry) {
+          compacted.emplace_back(std::move(entry));
+        }
+      }
+      entries_ = std::move(compacted);
+    }
+
+    slots_.assign(capacity, Slot{0, 0});
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      placeSlot(Hash()(entries_[i]->first), i);
+    }
+  }
+
+  Entries entries_;
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+};
+
+//! Lookup between node ids and the layer that contains the node
+using NodeLookup = FlatMap<NodeId, LayerKey>;
+
+}  // namespace spark_dsg
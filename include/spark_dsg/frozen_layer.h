@@ -0,0 +1,230 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "spark_dsg/flat_map.h"
+#include "spark_dsg/graph_utilities.h"
+#include "spark_dsg/scene_graph_types.h"
+
+namespace spark_dsg {
+
+class SceneGraphLayer;
+
+/**
+ * @brief Non-owning view over a contiguous array
+ */
+template <typename T>
+struct ArrayView {
+  const T* first = nullptr;
+  const T* last = nullptr;
+
+  inline const T* begin() const { return first; }
+  inline const T* end() const { return last; }
+  inline size_t size() const { return last - first; }
+  inline bool empty() const { return first == last; }
+  inline const T& operator[](size_t i) const { return first[i]; }
+};
+
+/**
+ * @brief Immutable compressed sparse row (CSR) snapshot of a layer's connectivity
+ *
+ * Nodes are remapped to dense indices in [0, numNodes()). The neighbors of node i are
+ * stored in [offsets[i], offsets[i + 1]) of the neighbor arrays, both as dense indices
+ * (for index-based algorithms) and as node ids (for the graph_utilities templates),
+ * with the edge weight stored at the same position. Each row is sorted by node id.
+ * Every undirected edge appears once per endpoint. The snapshot does not track later
+ * changes to the layer.
+ */
+class FrozenLayer {
+ public:
+  //! dense node index
+  using Index = uint32_t;
+  //! visitor over dense node indices
+  using IndexVisitor = std::function<void(Index)>;
+
+  /**
+   * @brief Build a snapshot of the current nodes and edges of a layer
+   */
+  explicit FrozenLayer(const SceneGraphLayer& layer);
+
+  //! ID of the layer the snapshot was taken from
+  const LayerId id;
+
+  inline size_t numNodes() const { return node_ids_.size(); }
+
+  //! number of undirected edges
+  inline size_t numEdges() const { return neighbors_.size() / 2; }
+
+  inline bool hasNode(NodeId node) const { return index_.contains(node); }
+
+  /**
+   * @brief Get the dense index of a node
+   * @throws std::out_of_range if the node isn't in the snapshot
+   */
+  inline Index index(NodeId node) const { return index_.at(node); }
+
+  inline NodeId nodeId(Index index) const { return node_ids_[index]; }
+
+  inline size_t degree(Index index) const {
+    return offsets_[index + 1] - offsets_[index];
+  }
+
+  //! neighbors of a node as dense indices
+  inline ArrayView<Index> neighbors(Index index) const {
+    return {neighbors_.data() + offsets_[index],
+            neighbors_.data() + offsets_[index + 1]};
+  }
+
+  //! neighbors of a node as node ids
+  inline ArrayView<NodeId> neighborIds(Index index) const {
+    return {neighbor_ids_.data() + offsets_[index],
+            neighbor_ids_.data() + offsets_[index + 1]};
+  }
+
+  //! edge weights aligned with neighbors (1.0 for unweighted edges)
+  inline ArrayView<double> weights(Index index) const {
+    return {weights_.data() + offsets_[index], weights_.data() + offsets_[index + 1]};
+  }
+
+  /**
+   * @brief Get the weight of an edge
+   *
+   * Binary searches the row of the source node. Prefer weights() when iterating over
+   * the neighbors of a node.
+   *
+   * @returns weight of the edge (if it exists)
+   */
+  std::optional<double> getWeight(NodeId source, NodeId target) const;
+
+  //! node ids in dense index order
+  inline const std::vector<NodeId>& nodeIds() const { return node_ids_; }
+
+  //! row offsets (numNodes() + 1 entries)
+  inline const std::vector<size_t>& offsets() const { return offsets_; }
+
+  /**
+   * @brief Breadth-first search over dense indices
+   *
+   * Uses the provided scratch buffers so repeated searches do not allocate. Visited
+   * flags are not cleared between calls (so that they can be shared between searches,
+   * e.g. for connected components). After the search, frontier holds every reached
+   * node in visiting order.
+   *
+   * @param root starting node index
+   * @param visitor called on every reached node index
+   * @param visited per-node visited flags (resized to numNodes() if needed)
+   * @param frontier scratch buffer for the search queue
+   */
+  void breadthFirstSearch(Index root,
+                          const IndexVisitor& visitor,
+                          std::vector<uint8_t>& visited,
+                          std::vector<Index>& frontier) const;
+
+  /**
+   * @brief Get the connected components of the snapshot
+   * @returns node ids of every component
+   */
+  std::vector<std::vector<NodeId>> getConnectedComponents() const;
+
+ private:
+  std::vector<NodeId> node_ids_;
+  FlatMap<NodeId, Index> index_;
+  std::vector<size_t> offsets_;
+  std::vector<Index> neighbors_;
+  std::vector<NodeId> neighbor_ids_;
+  std::vector<double> weights_;
+};
+
+namespace graph_utilities {
+
+/**
+ * @brief Edge type produced by the snapshot traits
+ */
+struct FrozenEdge {
+  NodeId source;
+  NodeId target;
+  double weight;
+};
+
+template <>
+struct graph_traits<FrozenLayer> {
+  using visitor = const std::function<void(const FrozenLayer&, NodeId)>&;
+  using node_valid_func = const std::function<bool(NodeId)>&;
+  using edge_valid_func = const std::function<bool(const FrozenEdge&)>&;
+
+  static inline ArrayView<NodeId> neighbors(const FrozenLayer& graph, NodeId node) {
+    return graph.neighborIds(graph.index(node));
+  }
+
+  static inline bool contains(const FrozenLayer& graph, NodeId node) {
+    return graph.hasNode(node);
+  }
+
+  static inline const std::vector<NodeId>& nodes(const FrozenLayer& graph) {
+    return graph.nodeIds();
+  }
+
+  static inline NodeId unwrap_node(NodeId node) { return node; }
+
+  static inline NodeId unwrap_node_id(NodeId node) { return node; }
+
+  static inline NodeId get_node(const FrozenLayer&, NodeId node) { return node; }
+
+  static inline FrozenEdge get_edge(const FrozenLayer& graph,
+                                    NodeId source,
+                                    NodeId target) {
+    return {source, target, graph.getWeight(source, target).value()};
+  }
+
+  static inline double edge_weight(const FrozenLayer& graph,
+                                   NodeId source,
+                                   NodeId target) {
+    return graph.getWeight(source, target).value();
+  }
+
+  //! edge weights aligned with neighbors(graph, node)
+  static inline ArrayView<double> neighbor_weights(const FrozenLayer& graph,
+                                                   NodeId node) {
+    return graph.weights(graph.index(node));
+  }
+};
+
+}  // namespace graph_utilities
+
+}  // namespace spark_dsg
@@ -33,13 +33,30 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <array>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string_view>
+
+#include "spark_dsg/binary_serializer.h"
 #include "spark_dsg/dynamic_scene_graph.h"
+#include "spark_dsg/flat_map.h"
 
 namespace spark_dsg {
 
+/**
+ * @brief Serialize a graph
+ * @param graph graph to serialize
+ * @param buffer buffer to append the serialized graph to
+ * @param include_mesh whether or not to serialize the mesh
+ * @param mesh_encoding how to encode the mesh (legacy layout by default)
+ */
 void writeGraph(const DynamicSceneGraph& graph,
                 std::vector<uint8_t>& buffer,
-                bool include_mesh = false);
+                bool include_mesh = false,
+                const serialization::MeshEncoding& mesh_encoding = {});
 
 DynamicSceneGraph::Ptr readGraph(const uint8_t* const buffer, size_t length);
 
@@ -47,6 +64,19 @@ inline DynamicSceneGraph::Ptr readGraph(const std::vector<uint8_t>& buffer) {
   return readGraph(buffer.data(), buffer.size());
 }
 
+/**
+ * @brief Read a graph from a source that is consumed in chunks
+ *
+ * Only a small window of the serialized graph is held in memory at a time (e.g., when
+ * reading from a file descriptor via serialization::fileDescriptorChunkReader)
+ */
+DynamicSceneGraph::Ptr readGraph(const serialization::ChunkReader& reader);
+
+/**
+ * @brief Read a graph serialized by writeGraph from a file without buffering it
+ */
+DynamicSceneGraph::Ptr readGraphFromFile(const std::string& filepath);
+
 bool updateGraph(DynamicSceneGraph& graph,
                  const uint8_t* const buffer,
                  size_t length,
@@ -58,4 +88,266 @@ inline bool updateGraph(DynamicSceneGraph& graph,
   return updateGraph(graph, buffer.data(), buffer.size(), remove_stale);
 }
 
+/**
+ * @brief Independent parts of a serialized graph
+ *
+ * Concatenating the sections in order gives the output of writeGraph
+ */
+enum class GraphSection : uint8_t { HEADER = 0, NODES = 1, EDGES = 2, MESH = 3 };
+
+inline constexpr size_t NUM_GRAPH_SECTIONS = 4;
+
+//! serialized sections (indexed by GraphSection)
+using GraphSectionBuffers = std::array<std::vector<uint8_t>, NUM_GRAPH_SECTIONS>;
+
+//! non-owning view of a serialized section
+struct GraphSectionView {
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+};
+
+//! views of every serialized section (indexed by GraphSection)
+using GraphSectionViews = std::array<GraphSectionView, NUM_GRAPH_SECTIONS>;
+
+/**
+ * @brief Serialize a graph into separate buffers per section
+ *
+ * Lets callers send or store the sections separately (e.g., as multipart messages)
+ * without first assembling one contiguous buffer
+ */
+void writeGraphSections(const DynamicSceneGraph& graph,
+                        GraphSectionBuffers& sections,
+                        bool include_mesh = false,
+                        const serialization::MeshEncoding& mesh_encoding = {});
+
+DynamicSceneGraph::Ptr readGraphSections(const GraphSectionViews& sections);
+
+bool updateGraphSections(DynamicSceneGraph& graph,
+                         const GraphSectionViews& sections,
+                         bool remove_stale = false);
+
+/**
+ * @brief Incremental binary serialization of a graph
+ *
+ * Each message only contains the nodes, edges and mesh edges that were added, updated
+ * or removed since the previous message, read from the change journals of the graph
+ * (which the encoder turns on), so the cost of a delta scales with the number of
+ * changes. Attributes modified in place are only sent once they are reported through
+ * DynamicSceneGraph::markNodeUpdated or markEdgeUpdated (or with the next keyframe).
+ * Every few messages (and whenever the journal can't account for all changes) the
+ * encoder writes a keyframe with the full graph so that receivers that joined late or
+ * missed a message can catch up. Meshes made of blocks (see MeshBlocks) only send the
+ * blocks that were added, updated or removed between keyframes.
+ */
+class GraphDeltaEncoder {
+ public:
+  /**
+   * @brief Make an encoder
+   * @param keyframe_interval number of messages between keyframes (0 to only send the
+   * first message as a keyframe)
+   */
+  explicit GraphDeltaEncoder(size_t keyframe_interval = 50);
+
+  /**
+   * @brief Serialize the changes to the graph since the last message
+   * @param graph graph to serialize (switching graphs triggers a keyframe)
+   * @param buffer buffer to append the message to
+   * @param include_mesh whether or not to send the mesh when it changes
+   * @returns true if the message is a keyframe
+   */
+  bool encode(const DynamicSceneGraph& graph,
+              std::vector<uint8_t>& buffer,
+              bool include_mesh = false);
+
+  //! make the next message a keyframe (e.g., when a new receiver connects)
+  inline void requestKeyframe() { force_keyframe_ = true; }
+
+  //! sequence number of the last message
+  inline uint64_t sequence() const { return sequence_; }
+
+ private:
+  void writeMeshPatch(const DynamicSceneGraph& graph,
+                      serialization::BinarySerializer& serializer);
+
+  size_t keyframe_interval_;
+  uint64_t sequence_ = 0;
+  uint64_t last_keyframe_ = 0;
+  bool force_keyframe_ = true;
+  const DynamicSceneGraph* graph_ = nullptr;
+  //! end of the journals when the last message was written
+  DynamicSceneGraph::ChangeCursor sent_epoch_;
+  uint64_t mesh_hash_ = 0;
+  //! block versions that receivers have (if the last mesh sent had blocks)
+  std::optional<std::map<MeshBlocks::Index, uint64_t>> mesh_block_versions_;
+  //! id of the mesh layout the block versions refer to
+  uint64_t mesh_layout_ = 0;
+  std::vector<uint8_t> scratch_;
+};
+
+struct GraphDeltaHeader {
+  //! whether or not the message contains the full graph
+  bool keyframe;
+  //! message sequence number (deltas apply on top of the previous message)
+  uint64_t sequence;
+  std::vector<LayerId> layer_ids;
+  LayerId mesh_layer_id;
+};
+
+/**
+ * @brief Read the header of a message produced by GraphDeltaEncoder
+ * @returns the header or nothing if the buffer doesn't contain a delta message
+ */
+std::optional<GraphDeltaHeader> readDeltaHeader(const uint8_t* const buffer,
+                                                size_t length);
+
+/**
+ * @brief Apply a message produced by GraphDeltaEncoder to a graph
+ *
+ * Keyframes always apply (removing anything not contained in the keyframe) while
+ * deltas only apply on top of the message right before them.
+ *
+ * @param graph graph to update
+ * @param sequence sequence number of the last message applied to the graph (updated
+ * when the message is applied)
+ * @returns false if the message doesn't apply to the graph (wait for a keyframe)
+ */
+bool applyDelta(DynamicSceneGraph& graph,
+                const uint8_t* const buffer,
+                size_t length,
+                uint64_t& sequence);
+
+inline bool applyDelta(DynamicSceneGraph& graph,
+                       const std::vector<uint8_t>& buffer,
+                       uint64_t& sequence) {
+  return applyDelta(graph, buffer.data(), buffer.size(), sequence);
+}
+
+/**
+ * @brief Memory-mapped graph file with lazily loaded layers
+ *
+ * Files start with a header (format version, layer ids and a table of sections)
+ * followed by separately serialized sections for every layer, every pair of layers
+ * with edges between them, the mesh edges of every layer and the mesh. Opening a file
+ * only reads the header. Layers are loaded into the graph the first time they are
+ * requested, along with the edges to any layers that were already loaded, and the mesh
+ * is only loaded when requested.
+ */
+class GraphArchive {
+ public:
+  using Ptr = std::unique_ptr<GraphArchive>;
+
+  //! format version written to the header
+  static constexpr uint32_t VERSION = 1;
+
+  //! extension that DynamicSceneGraph::save uses to pick the archive format
+  static constexpr std::string_view EXTENSION = ".sparkdsg";
+
+  enum class SectionType : uint8_t {
+    LAYER = 0,             //! nodes and edges of a layer
+    DYNAMIC_LAYER = 1,     //! nodes and edges of a dynamic layer
+    INTERLAYER_EDGES = 2,  //! edges between nodes of two layers
+    MESH_EDGES = 3,        //! mesh edges with sources in a layer
+    MESH = 4,              //! mesh vertices and faces
+  };
+
+  struct Section {
+    SectionType type;
+    LayerId layer;
+    //! second layer (interlayer edges) or layer prefix (dynamic layers)
+    LayerId other;
+    //! offset from the end of the header
+    uint64_t offset;
+    uint64_t length;
+  };
+
+  /**
+   * @brief Save a graph to a file that can be opened by GraphArchive
+   * @param graph Graph to save
+   * @param filepath Path to file to write
+   * @param include_mesh Optionally save mesh (defaults to true)
+   */
+  static void write(const DynamicSceneGraph& graph,
+                    const std::string& filepath,
+                    bool include_mesh = true);
+
+  //! check if a file is a graph archive (without opening it)
+  static bool isArchive(const std::string& filepath);
+
+  /**
+   * @brief Map a graph archive into memory and read the header
+   * @throws std::runtime_error if the file can't be mapped or isn't a valid archive
+   */
+  explicit GraphArchive(const std::string& filepath);
+
+  ~GraphArchive();
+
+  GraphArchive(const GraphArchive& other) = delete;
+
+  GraphArchive& operator=(const GraphArchive& other) = delete;
+
+  //! ids of every layer (static or dynamic) contained in the file
+  std::vector<LayerId> layers() const;
+
+  bool hasLayer(LayerId layer) const;
+
+  bool isLoaded(LayerId layer) const;
+
+  bool hasMesh() const;
+
+  inline const std::vector<Section>& sections() const { return sections_; }
+
+  //! graph containing everything loaded so far
+  inline const DynamicSceneGraph::Ptr& graph() const { return graph_; }
+
+  /**
+   * @brief Load the static and dynamic layers with the provided id
+   *
+   * Also loads mesh edges of the layer and edges to any loaded layer. Does nothing if
+   * the layer is already loaded.
+   *
+   * @returns false if the file doesn't contain the layer
+   */
+  bool loadLayer(LayerId layer);
+
+  //! get a static layer, loading it on first access
+  const SceneGraphLayer& getLayer(LayerId layer);
+
+  /**
+   * @brief Load the mesh on first access
+   * @returns false if the file doesn't contain a mesh
+   */
+  bool loadMesh();
+
+  /**
+   * @brief Load every layer (and optionally the mesh) and return the graph
+   *
+   * Sections are decoded by a pool of threads before a single thread inserts the
+   * contents into the graph
+   *
+   * @param include_mesh Whether or not to load the mesh
+   * @param num_threads Number of threads to use (0 picks the hardware concurrency)
+   * @param timings Optional time spent in each phase (added to the current values)
+   */
+  DynamicSceneGraph::Ptr load(bool include_mesh = true,
+                              size_t num_threads = 1,
+                              DynamicSceneGraph::LoadTimings* timings = nullptr);
+
+ private:
+  //! contents of a section that haven't been inserted into the graph yet
+  struct DecodedSection;
+
+  DecodedSection decodeSection(const Section& section) const;
+
+  void loadSection(const Section& section);
+
+  const uint8_t* data_ = nullptr;
+  size_t length_ = 0;
+  //! start of the sections (i.e., end of the header)
+  size_t data_offset_ = 0;
+  std::vector<Section> sections_;
+  std::set<LayerId> loaded_;
+  bool mesh_loaded_ = false;
+  DynamicSceneGraph::Ptr graph_;
+};
+
 }  // namespace spark_dsg
@@ -0,0 +1,126 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <chrono>
+#include <vector>
+
+#include "spark_dsg/dynamic_scene_graph.h"
+
+namespace spark_dsg {
+
+/**
+ * @brief Bulk insertion of nodes and edges into a scene graph
+ *
+ * Nodes and edges are buffered until the batch is committed. Committing checks the
+ * invariants of the whole batch at once (valid layers, unique nodes and edges, edges
+ * between existing nodes and at most one parent per node), reserves space for
+ * everything and then inserts the batch through DynamicSceneGraph::emplaceNode and
+ * DynamicSceneGraph::insertEdge. Meant for loading trusted data (e.g., deserializing
+ * a graph), where nodes usually arrive grouped by layer.
+ */
+class GraphBuilder {
+ public:
+  /**
+   * @brief Make a builder for a graph
+   * @param graph Graph to insert batches into (must outlive the builder)
+   */
+  explicit GraphBuilder(DynamicSceneGraph& graph);
+
+  /**
+   * @brief Reserve space for the next batch
+   */
+  void reserve(size_t num_nodes, size_t num_edges);
+
+  /**
+   * @brief Add a static node to the batch
+   */
+  void addNode(LayerId layer, NodeId node, NodeAttributes::Ptr&& attrs);
+
+  /**
+   * @brief Add a dynamic node to the batch (the prefix comes from the node id)
+   */
+  void addDynamicNode(LayerId layer,
+                      NodeId node,
+                      std::chrono::nanoseconds timestamp,
+                      NodeAttributes::Ptr&& attrs);
+
+  /**
+   * @brief Add an edge to the batch
+   *
+   * Edges can refer to nodes already in the graph or in the batch
+   */
+  void addEdge(NodeId source, NodeId target, EdgeAttributes::Ptr&& attrs = nullptr);
+
+  inline size_t numNodes() const { return nodes_.size(); }
+
+  inline size_t numEdges() const { return edges_.size(); }
+
+  /**
+   * @brief Check the batch and insert it into the graph
+   *
+   * Clears the batch once it has been inserted
+   *
+   * @throws std::runtime_error describing the first invalid node or edge (neither the
+   * graph nor the batch are modified)
+   */
+  void commit();
+
+ private:
+  struct PendingNode {
+    LayerKey key;
+    NodeId id;
+    std::chrono::nanoseconds timestamp;
+    NodeAttributes::Ptr attrs;
+  };
+
+  struct PendingEdge {
+    NodeId source;
+    NodeId target;
+    EdgeAttributes::Ptr attrs;
+  };
+
+  //! throw if inserting the batch would break any invariants of the graph
+  void check() const;
+
+  void insertNodes();
+
+  void insertEdges();
+
+  DynamicSceneGraph& graph_;
+  std::vector<PendingNode> nodes_;
+  std::vector<PendingEdge> edges_;
+};
+
+}  // namespace spark_dsg
@@ -35,8 +35,12 @@
 #pragma once
 #include <deque>
 #include <functional>
+#include <limits>
 #include <list>
+#include <numeric>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "spark_dsg/node_symbol.h"
 #include "spark_dsg/scene_graph_types.h"
@@ -45,6 +49,19 @@ namespace spark_dsg {
 namespace graph_utilities {
 
 // TODO(nathan) make inheritance work
+/**
+ * @brief Traits describing how to traverse a graph type
+ *
+ * neighbors(graph, node) must return a lightweight iterable over the neighbor ids
+ * (either a reference to existing storage or a cheap view). It is bound to a const
+ * reference for the duration of a single expansion step and never copied. All trait
+ * functions must be safe to call concurrently on a const graph (see
+ * parallel_components.h). Weighted searches (see shortest_paths.h) additionally use
+ * edge_weight(graph, source, target) and, for A*, position(graph, node). Graphs that
+ * store weights alongside their neighbors can also provide
+ * neighbor_weights(graph, node), an indexable view aligned with neighbors(), which
+ * weighted searches prefer over per-edge lookups.
+ */
 template <typename Graph>
 struct graph_traits {};
 
@@ -59,7 +76,7 @@ void breadthFirstSearch(const Graph& graph,
 
     callback_function(graph, curr_node);
 
-    auto neighbors = graph_traits<Graph>::neighbors(graph, curr_node);
+    const auto& neighbors = graph_traits<Graph>::neighbors(graph, curr_node);
     for (const auto& neighbor : neighbors) {
       if (seen.count(neighbor)) {
         continue;
@@ -83,7 +100,7 @@ void breadthFirstSearch(const Graph& graph,
 
     callback_function(graph, curr_node);
 
-    auto neighbors = graph_traits<Graph>::neighbors(graph, curr_node);
+    const auto& neighbors = graph_traits<Graph>::neighbors(graph, curr_node);
     for (const auto& neighbor : neighbors) {
       if (seen.count(neighbor)) {
         continue;
@@ -116,7 +133,7 @@ void breadthFirstSearch(const Graph& graph,
     }
 
     const typename CostMap::mapped_type new_cost = costs[curr_node] + 1;
-    auto neighbors = graph_traits<Graph>::neighbors(graph, curr_node);
+    const auto& neighbors = graph_traits<Graph>::neighbors(graph, curr_node);
     for (const auto& neighbor : neighbors) {
       if (!AllowEqual && costs.count(neighbor) && costs[neighbor] <= new_cost) {
         continue;
@@ -250,34 +267,47 @@ Components getMergedComponents(const std::vector<NodeSet>& unmerged_components)
     return components;
   }
 
-  std::unordered_set<size_t> added_components;
-  for (size_t i = 0; i < unmerged_components.size(); ++i) {
-    if (added_components.count(i)) {
-      continue;
+  // disjoint-set forest over the unmerged components: components that share any node
+  // end up with the same root
+  std::vector<size_t> parents(unmerged_components.size());
+  std::iota(parents.begin(), parents.end(), 0);
+  auto find_root = [&](size_t index) {
+    while (parents[index] != index) {
+      parents[index] = parents[parents[index]];
+      index = parents[index];
     }
+    return index;
+  };
 
-    NodeSet curr_component = unmerged_components.at(i);
-
-    for (size_t j = i + 1; j < unmerged_components.size(); ++j) {
-      if (added_components.count(j)) {
-        continue;
+  std::unordered_map<NodeId, size_t> node_owners;
+  for (size_t i = 0; i < unmerged_components.size(); ++i) {
+    for (const auto node : unmerged_components[i]) {
+      const auto iter = node_owners.emplace(node, i).first;
+      const size_t root_i = find_root(i);
+      const size_t root_other = find_root(iter->second);
+      if (root_i != root_other) {
+        // always link to the smaller index to keep the output order stable
+        parents[std::max(root_i, root_other)] = std::min(root_i, root_other);
       }
+    }
+  }
 
-      for (const auto node : unmerged_components[j]) {
-        if (curr_component.count(node)) {
-          added_components.insert(j);
-
-          curr_component.insert(unmerged_components.at(j).begin(),
-                                unmerged_components.at(j).end());
-          break;
-        }
-      }
+  constexpr size_t no_output = std::numeric_limits<size_t>::max();
+  std::vector<size_t> root_to_output(unmerged_components.size(), no_output);
+  std::vector<NodeSet> merged;
+  for (size_t i = 0; i < unmerged_components.size(); ++i) {
+    const size_t root = find_root(i);
+    if (root_to_output[root] == no_output) {
+      root_to_output[root] = merged.size();
+      merged.emplace_back();
     }
 
-    added_components.insert(i);
+    merged[root_to_output[root]].insert(unmerged_components[i].begin(),
+                                        unmerged_components[i].end());
+  }
 
-    std::vector<NodeId> new_component_vec(curr_component.begin(), curr_component.end());
-    components.push_back(new_component_vec);
+  for (const auto& component : merged) {
+    components.emplace_back(component.begin(), component.end());
   }
 
   return components;
@@ -333,7 +363,7 @@ void breadthFirstSearch(
 
     callback_function(graph, curr_id);
 
-    auto neighbors = graph_traits<Graph>::neighbors(graph, curr_id);
+    const auto& neighbors = graph_traits<Graph>::neighbors(graph, curr_id);
     for (const auto& neighbor : neighbors) {
       if (seen.count(neighbor)) {
         continue;
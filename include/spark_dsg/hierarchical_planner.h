@@ -0,0 +1,177 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <limits>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+#include "spark_dsg/dynamic_scene_graph.h"
+#include "spark_dsg/shortest_paths.h"
+
+namespace spark_dsg {
+
+/**
+ * @brief View of a layer that only allows searches through a subset of its nodes
+ */
+struct RestrictedLayer {
+  const SceneGraphLayer& layer;
+  //! nodes that searches may visit (every node of the layer if null)
+  const std::unordered_set<NodeId>* allowed = nullptr;
+  //! use the distance between node positions as edge weight instead of the edge weight
+  bool metric_weights = false;
+
+  inline bool allows(NodeId node) const {
+    return layer.hasNode(node) && (!allowed || allowed->count(node));
+  }
+};
+
+namespace graph_utilities {
+
+template <>
+struct graph_traits<RestrictedLayer> {
+  static inline const std::set<NodeId>& neighbors(const RestrictedLayer& graph,
+                                                  NodeId node) {
+    return graph.layer.nodes().at(node).siblings();
+  }
+
+  static inline bool contains(const RestrictedLayer& graph, NodeId node) {
+    return graph.allows(node);
+  }
+
+  //! infinite for neighbors outside of the allowed nodes
+  static inline double edge_weight(const RestrictedLayer& graph,
+                                   NodeId source,
+                                   NodeId target) {
+    if (graph.allowed && !graph.allowed->count(target)) {
+      return std::numeric_limits<double>::infinity();
+    }
+
+    if (graph.metric_weights) {
+      return (position(graph, source) - position(graph, target)).norm();
+    }
+
+    return graph.layer.edges().at(EdgeKey(source, target)).searchWeight();
+  }
+
+  static inline const Eigen::Vector3d& position(const RestrictedLayer& graph,
+                                                NodeId node) {
+    return graph.layer.nodes().at(node).attributes().position;
+  }
+};
+
+}  // namespace graph_utilities
+
+/**
+ * @brief Result of a hierarchical path query
+ */
+struct HierarchicalPath {
+  //! rooms from the room of the start to the room of the goal (empty for fallbacks)
+  std::vector<NodeId> rooms;
+  //! path through the place layer
+  graph_utilities::ShortestPath places;
+  //! whether the places path came from searching the full place layer
+  bool used_fallback = false;
+
+  inline bool empty() const { return places.empty(); }
+};
+
+/**
+ * @brief Settings for the hierarchical planner
+ */
+struct HierarchicalPlannerConfig {
+  //! layer to plan through
+  LayerId place_layer = DsgLayers::PLACES;
+  //! layer to restrict the search with
+  LayerId room_layer = DsgLayers::ROOMS;
+  //! use distances between room positions as room edge weights
+  bool metric_room_weights = true;
+  //! use distances between place positions as place edge weights (enables A*)
+  bool metric_place_weights = false;
+  //! also allow places from rooms up to this many hops away from the room path
+  size_t room_dilation = 0;
+  //! search the full place layer if the hierarchical search fails
+  bool fallback_to_flat = true;
+};
+
+/**
+ * @brief Path planner that uses the room layer to restrict searches over places
+ *
+ * A query first searches the room graph between the rooms that contain the start and
+ * goal places, and then searches the place layer using only the places that are
+ * children of the rooms along the room path (plus any neighboring places that don't
+ * belong to a room, e.g. doorways). If the start or goal don't have a room, the rooms
+ * aren't connected or the restricted search fails, the planner optionally falls back to
+ * searching the full place layer. The restricted path is not guaranteed to be optimal
+ * over the full place layer.
+ *
+ * Search buffers are kept between queries, so a planner should not be shared between
+ * threads.
+ */
+class HierarchicalPlanner {
+ public:
+  using Config = HierarchicalPlannerConfig;
+
+  explicit HierarchicalPlanner(const Config& config = Config());
+
+  /**
+   * @brief Plan a path between two places
+   * @param graph scene graph to plan in
+   * @param start starting place
+   * @param goal goal place
+   * @returns room path and place path (empty if no path was found)
+   */
+  HierarchicalPath plan(const DynamicSceneGraph& graph, NodeId start, NodeId goal);
+
+  //! Get the room that a place belongs to (if any)
+  std::optional<NodeId> getRoom(const DynamicSceneGraph& graph, NodeId place) const;
+
+  const Config config;
+
+ private:
+  graph_utilities::ShortestPath searchPlaces(const SceneGraphLayer& places,
+                                             const std::unordered_set<NodeId>* allowed,
+                                             NodeId start,
+                                             NodeId goal);
+
+  void collectPlaces(const DynamicSceneGraph& graph, const SceneGraphLayer& places);
+
+  graph_utilities::ShortestPathWorkspace room_workspace_;
+  graph_utilities::ShortestPathWorkspace place_workspace_;
+  std::unordered_set<NodeId> corridor_;
+  std::unordered_set<NodeId> allowed_places_;
+};
+
+}  // namespace spark_dsg
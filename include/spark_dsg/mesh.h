@@ -0,0 +1,220 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <pcl/PolygonMesh.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <Eigen/Dense>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace spark_dsg {
+
+/**
+ * @brief Compact triangle mesh
+ *
+ * Vertex positions are stored in separate x, y and z arrays, vertex colors are packed
+ * RGBA bytes and faces are a single flat buffer of vertex indices (three per
+ * triangle). Nothing is allocated per vertex or per face, and every array can be
+ * copied or serialized in bulk.
+ */
+class Mesh {
+ public:
+  using Ptr = std::shared_ptr<Mesh>;
+  using Pos = Eigen::Vector3f;
+  using Face = std::array<uint32_t, 3>;
+  using PclVertices = pcl::PointCloud<pcl::PointXYZRGBA>;
+  using PclFaces = std::vector<pcl::Vertices>;
+
+  //! Packed vertex color
+  struct Color {
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 255;
+
+    bool operator==(const Color& other) const;
+  };
+
+  Mesh() = default;
+
+  /**
+   * @brief Make a mesh that takes ownership of existing arrays
+   * @param x x coordinates of the vertices
+   * @param y y coordinates of the vertices
+   * @param z z coordinates of the vertices
+   * @param colors colors of the vertices
+   * @param indices vertex indices of the faces (three per face)
+   * @throws std::invalid_argument if the array sizes are inconsistent
+   */
+  Mesh(std::vector<float> x,
+       std::vector<float> y,
+       std::vector<float> z,
+       std::vector<Color> colors,
+       std::vector<uint32_t> indices);
+
+  /**
+   * @brief Number of vertices in the mesh
+   */
+  inline size_t numVertices() const { return x_.size(); }
+
+  /**
+   * @brief Number of triangles in the mesh
+   */
+  inline size_t numFaces() const { return indices_.size() / 3; }
+
+  /**
+   * @brief Check whether the mesh has neither vertices nor faces
+   */
+  bool empty() const;
+
+  /**
+   * @brief Remove all vertices and faces
+   */
+  void clear();
+
+  /**
+   * @brief Reserve space for vertices and faces
+   */
+  void reserve(size_t num_vertices, size_t num_faces);
+
+  /**
+   * @brief Resize the vertex arrays (new vertices are at the origin and black)
+   */
+  void resizeVertices(size_t num_vertices);
+
+  /**
+   * @brief Resize the face buffer (new faces point to vertex 0)
+   */
+  void resizeFaces(size_t num_faces);
+
+  /**
+   * @brief Add a vertex to the mesh
+   * @returns Index of the new vertex
+   */
+  size_t addVertex(const Pos& pos, const Color& color);
+
+  /**
+   * @brief Add a triangle to the mesh
+   * @returns Index of the new face
+   */
+  size_t addFace(const Face& face);
+
+  /**
+   * @brief Get the position of a vertex (not bounds checked)
+   */
+  inline Pos pos(size_t index) const { return Pos(x_[index], y_[index], z_[index]); }
+
+  /**
+   * @brief Set the position of a vertex (not bounds checked)
+   */
+  void setPos(size_t index, const Pos& pos);
+
+  /**
+   * @brief Get the color of a vertex (not bounds checked)
+   */
+  inline const Color& color(size_t index) const { return colors_[index]; }
+
+  /**
+   * @brief Set the color of a vertex (not bounds checked)
+   */
+  inline void setColor(size_t index, const Color& color) { colors_[index] = color; }
+
+  /**
+   * @brief Get the vertex indices of a triangle (not bounds checked)
+   */
+  Face face(size_t index) const;
+
+  /**
+   * @brief Set the vertex indices of a triangle (not bounds checked)
+   */
+  void setFace(size_t index, const Face& face);
+
+  //! x coordinates of all vertices
+  inline const std::vector<float>& xs() const { return x_; }
+  //! y coordinates of all vertices
+  inline const std::vector<float>& ys() const { return y_; }
+  //! z coordinates of all vertices
+  inline const std::vector<float>& zs() const { return z_; }
+  //! colors of all vertices
+  inline const std::vector<Color>& colors() const { return colors_; }
+  //! vertex indices of all faces (three per face)
+  inline const std::vector<uint32_t>& indices() const { return indices_; }
+
+  bool operator==(const Mesh& other) const;
+
+  /**
+   * @brief Make a mesh from PCL vertices and polygons
+   *
+   * Polygons with more than three vertices are split into a triangle fan and
+   * polygons with fewer than three vertices are dropped.
+   *
+   * @param vertices Mesh vertices
+   * @param faces Mesh polygons (optional)
+   */
+  static Mesh fromPcl(const PclVertices& vertices, const PclFaces* faces = nullptr);
+
+  /**
+   * @brief Make a mesh from a PCL polygon mesh
+   */
+  static Mesh fromPcl(const pcl::PolygonMesh& mesh);
+
+  /**
+   * @brief Copy the vertices into a PCL point cloud
+   */
+  PclVertices::Ptr toPclVertices() const;
+
+  /**
+   * @brief Copy the faces into PCL polygons (every polygon allocates its own indices)
+   */
+  std::shared_ptr<PclFaces> toPclFaces() const;
+
+  /**
+   * @brief Copy the mesh into a PCL polygon mesh
+   */
+  pcl::PolygonMesh toPcl() const;
+
+ private:
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<float> z_;
+  std::vector<Color> colors_;
+  std::vector<uint32_t> indices_;
+};
+
+}  // namespace spark_dsg
@@ -0,0 +1,186 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+
+#include "spark_dsg/mesh.h"
+
+namespace spark_dsg {
+
+/**
+ * @brief Where a block of the mesh is stored in the flat mesh
+ *
+ * Each block owns a contiguous range of vertices and a contiguous range of faces. The
+ * ranges can be larger than the block (capacity), in which case the unused vertices
+ * are at the origin and the unused faces are degenerate.
+ */
+struct MeshBlockInfo {
+  //! version of the block (unique across all blocks of the mesh)
+  uint64_t version = 0;
+  //! index of the first vertex of the block in the mesh
+  size_t vertex_offset = 0;
+  //! number of vertices reserved for the block
+  size_t vertex_capacity = 0;
+  //! number of vertices in the block
+  size_t num_vertices = 0;
+  //! index of the first face of the block in the mesh
+  size_t face_offset = 0;
+  //! number of faces reserved for the block
+  size_t face_capacity = 0;
+  //! number of faces in the block
+  size_t num_faces = 0;
+
+  bool operator==(const MeshBlockInfo& other) const;
+};
+
+/**
+ * @brief Layout of a mesh that is made of spatially indexed blocks
+ *
+ * Blocks are written into ranges of a flat mesh. A block keeps its ranges when it is
+ * updated with a mesh that fits into them, so vertex indices only change for blocks
+ * that outgrow their ranges. Freed ranges are reused by later blocks and free space at
+ * the end of the mesh is released. Vertices and faces before the first block (e.g.,
+ * from a mesh that was set before any blocks were added) are not managed by the
+ * layout.
+ */
+class MeshBlocks {
+ public:
+  //! spatial index of a block
+  using Index = std::array<int32_t, 3>;
+  using Blocks = std::map<Index, MeshBlockInfo>;
+
+  MeshBlocks() = default;
+
+  /**
+   * @brief Make a layout for a mesh that already has vertices and faces
+   * @param base_vertices number of vertices that don't belong to any block
+   * @param base_faces number of faces that don't belong to any block
+   */
+  MeshBlocks(size_t base_vertices, size_t base_faces);
+
+  //! whether or not the layout has any blocks
+  inline bool empty() const { return blocks_.empty(); }
+
+  //! number of blocks in the layout
+  inline size_t size() const { return blocks_.size(); }
+
+  //! all blocks in the layout
+  inline const Blocks& blocks() const { return blocks_; }
+
+  //! number of vertices that don't belong to any block
+  inline size_t baseVertices() const { return base_vertices_; }
+
+  //! number of faces that don't belong to any block
+  inline size_t baseFaces() const { return base_faces_; }
+
+  //! identifies the layout (copies share the id, every new layout gets a new one)
+  inline uint64_t id() const { return id_; }
+
+  /**
+   * @brief Get the layout of a block
+   * @returns layout of the block or nothing if the block doesn't exist
+   */
+  std::optional<MeshBlockInfo> getBlock(const Index& index) const;
+
+  /**
+   * @brief Write a block into the mesh
+   *
+   * Faces of the block refer to the vertices of the block (starting at 0). The block
+   * stays in its previous ranges if it fits, and otherwise moves to the first free
+   * ranges that are large enough.
+   *
+   * @param mesh flat mesh to write the block into
+   * @param index index of the block
+   * @param block vertices and faces of the block
+   * @param layout place the block at exactly this layout (with this version) instead
+   * @returns layout of the block
+   * @throws std::invalid_argument if the block refers to vertices it doesn't contain or
+   * doesn't fit into the requested layout
+   */
+  MeshBlockInfo upsert(Mesh& mesh,
+                       const Index& index,
+                       const Mesh& block,
+                       const MeshBlockInfo* layout = nullptr);
+
+  /**
+   * @brief Remove a block from the mesh
+   *
+   * The ranges of the block are cleared and can be reused by other blocks. The mesh
+   * shrinks if the ranges were at its end.
+   *
+   * @returns previous layout of the block or nothing if the block doesn't exist
+   */
+  std::optional<MeshBlockInfo> remove(Mesh& mesh, const Index& index);
+
+  /**
+   * @brief Add a block to the layout without writing it into the mesh
+   *
+   * Used to restore the layout of a mesh that already contains the block
+   */
+  void restore(const Index& index, const MeshBlockInfo& info);
+
+  /**
+   * @brief Copy a block out of the mesh (faces refer to the vertices of the block)
+   */
+  Mesh extract(const Mesh& mesh, const Index& index) const;
+
+  /**
+   * @brief Copy the mesh without the faces that pad the layout
+   *
+   * Free and unused face ranges hold faces on vertex 0 so that blocks can be rewritten
+   * in place. Only those faces are dropped, so vertex indices (and mesh edges) stay
+   * valid.
+   */
+  Mesh exportMesh(const Mesh& mesh) const;
+
+ private:
+  static uint64_t nextId();
+
+  void clearRanges(Mesh& mesh, const MeshBlockInfo& info) const;
+
+  //! release free space after the last block
+  void trim(Mesh& mesh) const;
+
+  uint64_t id_ = nextId();
+  size_t base_vertices_ = 0;
+  size_t base_faces_ = 0;
+  uint64_t last_version_ = 0;
+  Blocks blocks_;
+};
+
+}  // namespace spark_dsg
@@ -0,0 +1,198 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <Eigen/Dense>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "spark_dsg/mesh.h"
+
+namespace spark_dsg {
+
+/**
+ * @brief Bounding volume hierarchy over the triangles of a mesh
+ *
+ * The tree is built with a binned surface area heuristic and stored as a flat array of
+ * nodes (children of a node are adjacent). Leaves keep a copy of the corners of their
+ * triangles in leaf order, so queries only touch contiguous memory and don't need the
+ * mesh. Faces that repeat a vertex (e.g., the unused faces of mesh blocks) or refer to
+ * vertices past the end of the mesh are skipped.
+ *
+ * When vertices move, refit() updates the bounds without changing the tree (either for
+ * the whole mesh or only for the triangles of a set of vertices). When faces change the
+ * tree has to be rebuilt, which update() detects automatically.
+ */
+class MeshBvh {
+ public:
+  //! result of a query
+  struct Hit {
+    //! index of the triangle in the mesh
+    size_t face;
+    //! vertex indices of the triangle
+    Mesh::Face vertices;
+    //! vertex of the triangle closest to the point
+    size_t vertex;
+    //! point on the triangle
+    Eigen::Vector3d point;
+    //! distance to the query point (or along the ray)
+    double distance;
+  };
+
+  /**
+   * @brief Make an empty hierarchy
+   * @param max_leaf_size maximum number of triangles per leaf
+   */
+  explicit MeshBvh(size_t max_leaf_size = 4);
+
+  /**
+   * @brief Make a hierarchy over a mesh
+   * @param mesh mesh to build the hierarchy over
+   * @param max_leaf_size maximum number of triangles per leaf
+   */
+  explicit MeshBvh(const Mesh& mesh, size_t max_leaf_size = 4);
+
+  //! whether or not the hierarchy has any triangles
+  inline bool empty() const { return order_.empty(); }
+
+  //! number of triangles in the hierarchy
+  inline size_t numTriangles() const { return order_.size(); }
+
+  //! number of nodes in the hierarchy
+  inline size_t numNodes() const { return nodes_.size(); }
+
+  /**
+   * @brief Rebuild the hierarchy from scratch
+   */
+  void build(const Mesh& mesh);
+
+  /**
+   * @brief Update the bounds of every node after vertices moved
+   *
+   * The faces of the mesh must be the same as when the hierarchy was built
+   */
+  void refit(const Mesh& mesh);
+
+  /**
+   * @brief Update the bounds of the triangles of the given vertices (and their parents)
+   *
+   * The faces of the mesh must be the same as when the hierarchy was built
+   */
+  void refit(const Mesh& mesh, const std::vector<size_t>& vertices);
+
+  /**
+   * @brief Refit the hierarchy if the faces of the mesh are unchanged, otherwise
+   * rebuild it
+   * @returns true if the hierarchy was rebuilt
+   */
+  bool update(const Mesh& mesh);
+
+  /**
+   * @brief Find the closest point on the mesh
+   * @param point query point
+   * @param max_distance ignore triangles further away than this
+   * @returns the closest triangle (if any is within the maximum distance)
+   */
+  std::optional<Hit> closestPoint(
+      const Eigen::Vector3d& point,
+      double max_distance = std::numeric_limits<double>::infinity()) const;
+
+  /**
+   * @brief Find the first triangle hit by a ray (from either side)
+   * @param origin start of the ray
+   * @param direction direction of the ray (doesn't need to be normalized)
+   * @param max_distance maximum distance along the ray
+   * @returns the first triangle hit (if any)
+   */
+  std::optional<Hit> raycast(
+      const Eigen::Vector3d& origin,
+      const Eigen::Vector3d& direction,
+      double max_distance = std::numeric_limits<double>::infinity()) const;
+
+  /**
+   * @brief Find all triangles that overlap a sphere
+   * @param center center of the sphere
+   * @param radius radius of the sphere (inclusive)
+   * @param result closest points of the triangles to the center (appended to)
+   */
+  void sphereQuery(const Eigen::Vector3d& center,
+                   double radius,
+                   std::vector<Hit>& result) const;
+
+ private:
+  static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+  struct Node {
+    Eigen::Array3f min = Eigen::Array3f::Zero();
+    Eigen::Array3f max = Eigen::Array3f::Zero();
+    //! first child (inner nodes) or first triangle (leaves)
+    uint32_t start = 0;
+    //! number of triangles (0 for inner nodes)
+    uint32_t count = 0;
+  };
+
+  struct Triangle {
+    Eigen::Vector3f a;
+    Eigen::Vector3f b;
+    Eigen::Vector3f c;
+  };
+
+  void loadTriangle(const Mesh& mesh, uint32_t slot);
+
+  void fitLeaf(uint32_t node);
+
+  void fitInner(uint32_t node);
+
+  Hit makeHit(uint32_t slot, const Eigen::Vector3f& point, float distance) const;
+
+  size_t max_leaf_size_;
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> parents_;
+  //! mesh face, vertex indices and corners of every triangle in leaf order
+  std::vector<uint32_t> order_;
+  std::vector<Mesh::Face> indices_;
+  std::vector<Triangle> triangles_;
+  //! leaf of every triangle in leaf order
+  std::vector<uint32_t> leaves_;
+  //! triangles of every vertex (compressed rows)
+  std::vector<uint32_t> vertex_offsets_;
+  std::vector<uint32_t> vertex_triangles_;
+  //! faces the hierarchy was built from
+  size_t num_faces_ = 0;
+  uint64_t faces_hash_ = 0;
+};
+
+}  // namespace spark_dsg
@@ -0,0 +1,189 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "spark_dsg/flat_map.h"
+#include "spark_dsg/scene_graph_types.h"
+
+namespace spark_dsg {
+
+/**
+ * @brief Structure capturing node-edge relationship
+ */
+struct MeshEdge {
+  NodeId source_node;
+  size_t mesh_vertex;
+
+  /**
+   * @brief initialize a mesh edge
+   * @param source_node Node in the scene graph
+   * @param mesh_vertex Mesh vertex that the edge points to
+   */
+  MeshEdge(NodeId source_node, size_t mesh_vertex)
+      : source_node(source_node), mesh_vertex(mesh_vertex) {}
+
+  inline bool operator==(const MeshEdge& other) const {
+    return source_node == other.source_node && mesh_vertex == other.mesh_vertex;
+  }
+
+  inline bool operator<(const MeshEdge& other) const {
+    return source_node == other.source_node ? mesh_vertex < other.mesh_vertex
+                                            : source_node < other.source_node;
+  }
+};
+
+class ChangeJournal;
+
+/**
+ * @brief Bidirectional index of the edges between nodes and mesh vertices
+ *
+ * Edges are stored contiguously (removing an edge moves the last edge into its slot).
+ * Every node keeps a vector of its vertices sorted by vertex index, and a table indexed
+ * by vertex holds the start of a list of the edges to that vertex (threaded through
+ * the edge slots). The vertex table only covers the vertices of the mesh (see
+ * setNumVertices): edges to any other vertex (e.g., edges read before their mesh) keep
+ * their list in a sparse map instead, so that untrusted vertex indices never size an
+ * allocation.
+ */
+class MeshEdgeIndex {
+ public:
+  using Edges = std::vector<MeshEdge>;
+
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  //! number of edges
+  inline size_t size() const { return edges_.size(); }
+
+  //! whether or not there are any edges
+  inline bool empty() const { return edges_.empty(); }
+
+  //! all edges (in no particular order)
+  inline const Edges& edges() const { return edges_; }
+
+  //! check if an edge exists
+  bool contains(NodeId node, size_t vertex) const;
+
+  /**
+   * @brief Add an edge
+   * @returns true if the edge didn't already exist
+   */
+  bool insert(NodeId node, size_t vertex);
+
+  /**
+   * @brief Add many edges at once
+   *
+   * Edges are grouped by node so that every node merges all of its new vertices in a
+   * single pass. Duplicate and existing edges are skipped.
+   *
+   * @returns number of edges that were added
+   */
+  size_t insert(Edges edges);
+
+  /**
+   * @brief Remove an edge
+   * @returns true if the edge existed
+   */
+  bool erase(NodeId node, size_t vertex);
+
+  /**
+   * @brief Remove all edges of a node
+   * @returns number of edges that were removed
+   */
+  size_t eraseNode(NodeId node);
+
+  /**
+   * @brief Remove all edges to the vertices in [begin, end)
+   * @returns number of edges that were removed
+   */
+  size_t eraseVertices(size_t begin, size_t end = npos);
+
+  //! vertices a node has edges to (sorted)
+  std::vector<size_t> vertices(NodeId node) const;
+
+  //! nodes that have an edge to a vertex
+  std::vector<NodeId> nodes(size_t vertex) const;
+
+  //! all edges to the vertices in [begin, end)
+  Edges edgesInRange(size_t begin, size_t end = npos) const;
+
+  void reserve(size_t num_edges);
+
+  void clear();
+
+  /**
+   * @brief Set the number of vertices of the mesh that the edges point to
+   *
+   * Only changes how the edges are stored: edges to vertices past the end of the mesh
+   * are kept (until they are removed) but don't grow the vertex table.
+   */
+  void setNumVertices(size_t num_vertices);
+
+  //! set the journal that edge additions and removals are recorded in (optional)
+  inline void setJournal(ChangeJournal* journal) { journal_ = journal; }
+
+ private:
+  //! vertex and edge slot
+  using NodeEdges = std::vector<std::pair<size_t, size_t>>;
+
+  size_t append(NodeId node, size_t vertex);
+
+  //! first edge to a vertex (nullptr if the vertex doesn't have any edges)
+  const size_t* findHead(size_t vertex) const;
+
+  //! first edge to a vertex (npos and added to the index if it doesn't exist)
+  size_t& head(size_t vertex);
+
+  void unlinkVertex(size_t slot);
+
+  void removeSlot(size_t slot, bool update_node);
+
+  Edges edges_;
+  //! next edge to the same vertex for every edge slot
+  std::vector<size_t> next_;
+  //! first edge to every vertex of the mesh (up to the last vertex with an edge)
+  std::vector<size_t> vertex_heads_;
+  //! first edge to every vertex outside of the mesh that has an edge
+  std::map<size_t, size_t> sparse_heads_;
+  size_t num_vertices_ = 0;
+  FlatMap<NodeId, NodeEdges> node_edges_;
+  ChangeJournal* journal_ = nullptr;
+};
+
+}  // namespace spark_dsg
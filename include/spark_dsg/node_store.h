@@ -0,0 +1,237 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <array>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "spark_dsg/flat_map.h"
+#include "spark_dsg/scene_graph_node.h"
+
+namespace spark_dsg {
+
+/**
+ * @brief Slab-backed storage for the nodes of a layer
+ *
+ * Nodes are constructed in place inside fixed-size chunks so that a layer needs one
+ * allocation per chunk instead of one allocation per node, and iterating over the
+ * layer walks contiguous memory. Every node occupies a slot that stays valid until the
+ * node is removed (node references and handles are never invalidated by inserting or
+ * removing other nodes). Slots of removed nodes are reused by later insertions.
+ *
+ * Iteration yields pairs of (node id, node pointer) in ascending id order, matching the
+ * std::map of unique pointers that this replaces (so `->second->` still works). The
+ * order is kept in a sorted array of (id, handle) pairs; node ids are typically
+ * inserted in increasing order, which makes maintaining it an append. Removing a node
+ * only marks its entry, so removing nodes never invalidates iterators to other nodes.
+ * Unlike std::map, at() returns a reference to the node instead of the pointer.
+ */
+class NodeStore {
+ public:
+  using Node = SceneGraphNode;
+  //! stable handle to a node (the slot index of the node)
+  using Handle = size_t;
+  //! pair-like view of a stored node
+  using value_type = std::pair<NodeId, Node*>;
+
+  static constexpr Handle INVALID_HANDLE = std::numeric_limits<size_t>::max();
+  //! number of nodes per allocated chunk
+  static constexpr size_t CHUNK_SIZE = 256;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = NodeStore::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() = default;
+
+    const_iterator(const NodeStore* store, size_t position);
+
+    reference operator*() const { return *value_; }
+
+    pointer operator->() const { return &(*value_); }
+
+    const_iterator& operator++();
+
+    const_iterator operator++(int) {
+      const_iterator prev = *this;
+      ++(*this);
+      return prev;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return position_ == other.position_;
+    }
+
+    bool operator!=(const const_iterator& other) const {
+      return position_ != other.position_;
+    }
+
+   private:
+    void update();
+
+    const NodeStore* store_ = nullptr;
+    //! position in the sorted order of the store
+    size_t position_ = 0;
+    std::optional<value_type> value_;
+  };
+
+  using iterator = const_iterator;
+
+  NodeStore() = default;
+
+  NodeStore(const NodeStore& other) = delete;
+
+  NodeStore& operator=(const NodeStore& other) = delete;
+
+  NodeStore(NodeStore&& other) = default;
+
+  NodeStore& operator=(NodeStore&& other) = default;
+
+  inline size_t size() const { return index_.size(); }
+
+  inline bool empty() const { return index_.empty(); }
+
+  inline size_t count(NodeId node_id) const { return index_.count(node_id); }
+
+  inline bool contains(NodeId node_id) const { return index_.contains(node_id); }
+
+  /**
+   * @brief Number of slots currently allocated (including empty slots)
+   */
+  inline size_t capacity() const { return chunks_.size() * CHUNK_SIZE; }
+
+  /**
+   * @brief Allocate enough chunks to hold the requested number of nodes
+   */
+  void reserve(size_t num_nodes);
+
+  /**
+   * @brief Remove all nodes (and release all chunks)
+   */
+  void clear();
+
+  /**
+   * @brief Construct a node in place
+   * @param node_id id of the node to construct
+   * @param layer_id layer of the node to construct
+   * @param attrs attributes of the node
+   * @returns a pointer to the node and whether or not the node was added
+   */
+  std::pair<Node*, bool> emplace(NodeId node_id,
+                                 LayerId layer_id,
+                                 Node::AttributesPtr&& attrs);
+
+  /**
+   * @brief Move an existing node into the store
+   *
+   * Only the base SceneGraphNode part of the node is stored
+   *
+   * @param node node to move into the store
+   * @returns a pointer to the node and whether or not the node was added
+   */
+  std::pair<Node*, bool> insert(Node&& node);
+
+  /**
+   * @brief Remove a node if it exists
+   * @returns number of nodes removed
+   */
+  size_t erase(NodeId node_id);
+
+  /**
+   * @brief Get a stable handle to a node
+   * @returns the handle to the node or INVALID_HANDLE if the node does not exist
+   */
+  Handle handle(NodeId node_id) const;
+
+  /**
+   * @brief Get a node by handle (no bounds or validity checking)
+   */
+  inline Node& operator[](Handle handle) const { return *slot(handle); }
+
+  /**
+   * @brief Get a pointer to a node if the handle refers to a valid node
+   */
+  Node* get(Handle handle) const;
+
+  /**
+   * @brief Get a pointer to a node
+   * @returns a pointer to the node or nullptr if the node does not exist
+   */
+  Node* find(NodeId node_id) const;
+
+  /**
+   * @brief Get a node with bounds checking
+   * @throws std::out_of_range if the node does not exist
+   */
+  Node& at(NodeId node_id) const;
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+
+  const_iterator end() const { return const_iterator(this, order_.size()); }
+
+ private:
+  using Slot = std::optional<Node>;
+  using Chunk = std::array<Slot, CHUNK_SIZE>;
+
+  inline Slot& slot(Handle handle) const {
+    return (*chunks_[handle / CHUNK_SIZE])[handle % CHUNK_SIZE];
+  }
+
+  Handle nextSlot();
+
+  void addToOrder(NodeId node_id, Handle handle);
+
+  void removeFromOrder(NodeId node_id);
+
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  FlatMap<NodeId, Handle> index_;
+  std::vector<Handle> free_slots_;
+  //! (id, handle) pairs sorted by id (removed nodes have INVALID_HANDLE)
+  std::vector<std::pair<NodeId, Handle>> order_;
+  //! number of removed entries in order_
+  size_t num_removed_ = 0;
+  //! one past the highest slot that has ever been used
+  Handle end_slot_ = 0;
+};
+
+}  // namespace spark_dsg
@@ -0,0 +1,291 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "spark_dsg/flat_map.h"
+#include "spark_dsg/graph_utilities.h"
+
+namespace spark_dsg {
+namespace graph_utilities {
+
+/**
+ * @brief Lock-free disjoint-set forest over dense indices
+ *
+ * Roots are always linked to the smaller root, so concurrent unions can't form cycles.
+ * Finds use path halving.
+ */
+class ConcurrentDisjointSet {
+ public:
+  using Index = uint32_t;
+
+  explicit ConcurrentDisjointSet(size_t size) : parents_(size) {
+    for (size_t i = 0; i < size; ++i) {
+      parents_[i].store(i, std::memory_order_relaxed);
+    }
+  }
+
+  inline size_t size() const { return parents_.size(); }
+
+  Index find(Index index) {
+    while (true) {
+      Index parent = parents_[index].load(std::memory_order_relaxed);
+      if (parent == index) {
+        return index;
+      }
+
+      const Index grandparent = parents_[parent].load(std::memory_order_relaxed);
+      if (grandparent != parent) {
+        // failure just means that somebody else shortened the path already
+        parents_[index].compare_exchange_weak(
+            parent, grandparent, std::memory_order_relaxed);
+      }
+
+      index = grandparent;
+    }
+  }
+
+  void unite(Index a, Index b) {
+    while (true) {
+      a = find(a);
+      b = find(b);
+      if (a == b) {
+        return;
+      }
+
+      if (a < b) {
+        std::swap(a, b);
+      }
+
+      Index expected = a;
+      if (parents_[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) {
+        return;
+      }
+    }
+  }
+
+ private:
+  std::vector<std::atomic<Index>> parents_;
+};
+
+/**
+ * @brief Run a function over [0, num_items) split into contiguous blocks
+ *
+ * Exceptions thrown by any block are rethrown (the first one) once all blocks finish
+ *
+ * @param num_items number of items to process
+ * @param num_threads number of threads to use (0 picks the hardware concurrency)
+ * @param func called once per block as func(start, end)
+ * @param min_items_per_thread smallest block worth spawning a thread for
+ */
+template <typename Func>
+void parallelFor(size_t num_items,
+                 size_t num_threads,
+                 const Func& func,
+                 size_t min_items_per_thread = 1024) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // avoid spawning threads for tiny inputs
+  min_items_per_thread = std::max<size_t>(min_items_per_thread, 1);
+  num_threads = std::min(num_threads, num_items / min_items_per_thread + 1);
+  num_threads = std::min(num_threads, std::max<size_t>(num_items, 1));
+  if (num_threads <= 1) {
+    func(0, num_items);
+    return;
+  }
+
+  const size_t block_size = (num_items + num_threads - 1) / num_threads;
+  std::vector<std::exception_ptr> errors(num_threads);
+  const auto run_block = [&](size_t t) {
+    const size_t start = std::min(num_items, t * block_size);
+    const size_t end = std::min(num_items, start + block_size);
+    try {
+      func(start, end);
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < num_threads; ++t) {
+    workers.emplace_back(run_block, t);
+  }
+
+  run_block(0);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+namespace detail {
+
+template <typename Graph, typename NodeValid, typename EdgeValid>
+Components parallelComponents(const Graph& graph,
+                              const NodeValid& node_valid,
+                              const EdgeValid& edge_valid,
+                              size_t num_threads) {
+  using traits = graph_traits<Graph>;
+  using Index = ConcurrentDisjointSet::Index;
+
+  std::vector<NodeId> node_ids;
+  FlatMap<NodeId, Index> index;
+  for (const auto& node_container : traits::nodes(graph)) {
+    const NodeId node_id = traits::unwrap_node_id(node_container);
+    index.emplace(node_id, node_ids.size());
+    node_ids.push_back(node_id);
+  }
+
+  const size_t num_nodes = node_ids.size();
+  std::vector<uint8_t> valid(num_nodes, 1);
+  parallelFor(num_nodes, num_threads, [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; ++i) {
+      valid[i] = node_valid(node_ids[i]);
+    }
+  });
+
+  ConcurrentDisjointSet components(num_nodes);
+  parallelFor(num_nodes, num_threads, [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; ++i) {
+      if (!valid[i]) {
+        continue;
+      }
+
+      for (const auto neighbor : traits::neighbors(graph, node_ids[i])) {
+        const Index j = index.at(neighbor);
+        // each undirected edge is handled once (from its smaller endpoint)
+        if (j <= i || !valid[j] || !edge_valid(node_ids[i], neighbor)) {
+          continue;
+        }
+
+        components.unite(i, j);
+      }
+    }
+  });
+
+  std::vector<Index> roots(num_nodes);
+  parallelFor(num_nodes, num_threads, [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; ++i) {
+      roots[i] = components.find(i);
+    }
+  });
+
+  // roots are the smallest index in each component, so output order follows the
+  // order of the first node of each component
+  constexpr Index no_output = std::numeric_limits<Index>::max();
+  std::vector<Index> root_to_output(num_nodes, no_output);
+  Components result;
+  for (size_t i = 0; i < num_nodes; ++i) {
+    if (!valid[i]) {
+      continue;
+    }
+
+    auto& output = root_to_output[roots[i]];
+    if (output == no_output) {
+      output = result.size();
+      result.emplace_back();
+    }
+
+    result[output].push_back(node_ids[i]);
+  }
+
+  return result;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Get all connected components of a graph using parallel union-find
+ *
+ * Node ids and neighbors are read concurrently from multiple threads, so the graph
+ * must not be modified while this runs.
+ *
+ * @param graph graph to get the components of
+ * @param num_threads number of threads to use (0 picks the hardware concurrency)
+ * @returns node ids of every component
+ */
+template <typename Graph>
+Components getConnectedComponentsParallel(const Graph& graph, size_t num_threads = 0) {
+  return detail::parallelComponents(
+      graph,
+      [](NodeId) { return true; },
+      [](NodeId, NodeId) { return true; },
+      num_threads);
+}
+
+/**
+ * @brief Get the connected components of a graph formed by valid nodes and edges using
+ * parallel union-find
+ *
+ * Equivalent to the serial getConnectedComponents with node and edge predicates (up to
+ * the order of the components). The predicates are called concurrently from multiple
+ * threads and must be thread-safe.
+ *
+ * @param graph graph to get the components of
+ * @param node_valid whether or not a node should be included
+ * @param edge_valid whether or not an edge should be traversed
+ * @param num_threads number of threads to use (0 picks the hardware concurrency)
+ * @returns node ids of every component
+ */
+template <typename Graph>
+Components getConnectedComponentsParallel(
+    const Graph& graph,
+    const typename graph_traits<Graph>::node_valid_func& node_valid,
+    const typename graph_traits<Graph>::edge_valid_func& edge_valid,
+    size_t num_threads = 0) {
+  using traits = graph_traits<Graph>;
+  return detail::parallelComponents(
+      graph,
+      [&](NodeId node) { return node_valid(traits::get_node(graph, node)); },
+      [&](NodeId source, NodeId target) {
+        return edge_valid(traits::get_edge(graph, source, target));
+      },
+      num_threads);
+}
+
+}  // namespace graph_utilities
+}  // namespace spark_dsg
@@ -0,0 +1,114 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <Eigen/Dense>
+#include <vector>
+
+#include "spark_dsg/node_store.h"
+
+namespace spark_dsg {
+
+/**
+ * @brief Structure-of-arrays mirror of the node positions of a layer
+ *
+ * Positions are stored in separate x, y and z arrays that are aligned with the slots
+ * of the layer's NodeStore. Empty slots hold NaN coordinates, which fail every
+ * comparison, so queries are branch-free passes over the arrays that the compiler can
+ * vectorize.
+ */
+class PositionCache {
+ public:
+  using Handle = NodeStore::Handle;
+
+  PositionCache() = default;
+
+  /**
+   * @brief Make a cache containing the current positions of all nodes in the store
+   */
+  explicit PositionCache(const NodeStore& nodes);
+
+  /**
+   * @brief Set the cached position of the node in the provided slot
+   */
+  void update(Handle handle, NodeId node, const Eigen::Vector3d& position);
+
+  /**
+   * @brief Clear the provided slot
+   */
+  void remove(Handle handle);
+
+  /**
+   * @brief Clear all slots
+   */
+  void clear();
+
+  /**
+   * @brief Get the cached position of the node in the provided slot (NaN if empty)
+   */
+  Eigen::Vector3d position(Handle handle) const;
+
+  /**
+   * @brief Number of slots in the cache (including empty slots)
+   */
+  inline size_t numSlots() const { return ids_.size(); }
+
+  /**
+   * @brief Find all nodes within a radius of a point
+   * @param center center of the query
+   * @param radius maximum euclidean distance to the center (inclusive)
+   * @param result ids of the nodes inside the query (appended to)
+   */
+  void radiusQuery(const Eigen::Vector3d& center,
+                   double radius,
+                   std::vector<NodeId>& result) const;
+
+  /**
+   * @brief Find all nodes inside an axis-aligned box
+   * @param min minimum corner of the box (inclusive)
+   * @param max maximum corner of the box (inclusive)
+   * @param result ids of the nodes inside the query (appended to)
+   */
+  void boxQuery(const Eigen::Vector3d& min,
+                const Eigen::Vector3d& max,
+                std::vector<NodeId>& result) const;
+
+ private:
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> z_;
+  std::vector<NodeId> ids_;
+};
+
+}  // namespace spark_dsg
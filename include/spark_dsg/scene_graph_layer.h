@@ -38,10 +38,30 @@
 #include <vector>
 
 #include "spark_dsg/base_layer.h"
+#include "spark_dsg/frozen_layer.h"
 #include "spark_dsg/graph_utilities.h"
+#include "spark_dsg/node_store.h"
+#include "spark_dsg/position_cache.h"
+#include "spark_dsg/spatial_index.h"
 
 namespace spark_dsg {
 
+/**
+ * @brief Nodes reached by a bounded multi-source breadth-first search
+ *
+ * All vectors are aligned and in visiting order (seeds first).
+ */
+struct LayerNeighborhood {
+  //! reached nodes
+  std::vector<NodeId> nodes;
+  //! number of hops from the closest seed
+  std::vector<uint32_t> hops;
+  //! seed that reached the node first
+  std::vector<NodeId> sources;
+
+  inline size_t size() const { return nodes.size(); }
+};
+
 /**
  * @brief A layer in the scene graph (which is a graph itself)
  *
@@ -58,7 +78,7 @@ class SceneGraphLayer : public BaseLayer {
   //! node type of the layer
   using Node = SceneGraphNode;
   //! node container for the layer
-  using Nodes = std::map<NodeId, Node::Ptr>;
+  using Nodes = NodeStore;
   //! type tracking the status of nodes
   using NodeCheckup = std::map<NodeId, NodeStatus>;
   //! edge type for the layer
@@ -165,7 +185,7 @@ class SceneGraphLayer : public BaseLayer {
    */
   bool mergeLayer(const SceneGraphLayer& other,
                   const std::map<NodeId, NodeId>& previous_merges,
-                  std::map<NodeId, LayerKey>* layer_lookup = nullptr,
+                  NodeLookup* layer_lookup = nullptr,
                   bool update_attributes = true);
 
   /**
@@ -183,6 +203,88 @@ class SceneGraphLayer : public BaseLayer {
    */
   Eigen::Vector3d getPosition(NodeId node) const;
 
+  /**
+   * @brief Enable or disable the structure-of-arrays cache of node positions
+   *
+   * The cache is kept in sync when nodes are added, removed, merged or have their
+   * attributes replaced through the layer or the scene graph. Modifying the position
+   * of a node in place (through the attributes reference) requires calling
+   * refreshPosition.
+   *
+   * @param enable whether or not to keep the cache
+   */
+  void enablePositionCache(bool enable = true);
+
+  /**
+   * @brief Check whether the layer is keeping a position cache
+   */
+  inline bool hasPositionCache() const { return position_cache_ != nullptr; }
+
+  /**
+   * @brief Enable or disable the spatial index over node positions
+   *
+   * The index is kept in sync in the same way as the position cache.
+   *
+   * @param enable whether or not to keep the index
+   * @param cell_size grid cell size of the index (changing it rebuilds the index)
+   */
+  void enableSpatialIndex(bool enable = true, double cell_size = 1.0);
+
+  /**
+   * @brief Check whether the layer is keeping a spatial index
+   */
+  inline bool hasSpatialIndex() const { return spatial_index_ != nullptr; }
+
+  /**
+   * @brief Update the cached position (for the position cache and spatial index) of a
+   * node from the node attributes
+   * @param node node to update
+   * @returns true if the node exists
+   */
+  bool refreshPosition(NodeId node);
+
+  /**
+   * @brief Get the nodes closest to a point
+   *
+   * Uses the spatial index if enabled and otherwise checks every node.
+   *
+   * @param point query point
+   * @param k maximum number of nodes to return
+   * @returns up to k node ids in order of increasing distance
+   */
+  std::vector<NodeId> getNearestNodes(const Eigen::Vector3d& point, size_t k) const;
+
+  /**
+   * @brief Get the node closest to a point (if the layer is not empty)
+   */
+  std::optional<NodeId> getNearestNode(const Eigen::Vector3d& point) const;
+
+  /**
+   * @brief Get all nodes within a radius of a point
+   *
+   * Uses the spatial index or position cache if enabled and otherwise checks every
+   * node.
+   *
+   * @param center center of the query
+   * @param radius maximum distance to the center (inclusive)
+   * @returns ids of the nodes inside the radius (in no particular order)
+   */
+  std::vector<NodeId> getNodesInRadius(const Eigen::Vector3d& center,
+                                       double radius) const;
+
+  /**
+   * @brief Get all nodes inside an axis-aligned box
+   *
+   * Uses the spatial index or position cache if enabled and otherwise checks every
+   * node.
+   *
+   * @param min minimum corner of the box (inclusive)
+   * @param max maximum corner of the box (inclusive)
+   * @returns ids of the nodes inside the box (in no particular order)
+   */
+  std::vector<NodeId> getNodesInBox(const Eigen::Vector3d& min,
+                                    const Eigen::Vector3d& max) const;
+
   /**
    * @brief Get node ids of newly inserted nodes
    */
@@ -214,6 +316,12 @@ class SceneGraphLayer : public BaseLayer {
    */
   virtual SceneGraphLayer::Ptr clone() const;
 
+  /**
+   * @brief Get an immutable CSR snapshot of the layer connectivity for read-heavy
+   * traversal (see FrozenLayer)
+   */
+  FrozenLayer freeze() const;
+
   //! ID of the layer
   const LayerId id;
 
@@ -232,6 +340,20 @@ class SceneGraphLayer : public BaseLayer {
   std::unordered_set<NodeId> getNeighborhood(const std::unordered_set<NodeId>& nodes,
                                              size_t num_hops = 1) const;
 
+  /**
+   * @brief Get every node within a number of hops of any seed in a single pass
+   *
+   * Seeds that aren't in the layer are ignored. Every node is expanded at most once,
+   * no matter how many seeds overlap. Ties between seeds at the same distance are
+   * broken by seed order.
+   *
+   * @param seeds Nodes to start from
+   * @param num_hops Maximum number of hops from a seed
+   * @returns reached nodes with their hop distance and closest seed
+   */
+  LayerNeighborhood searchNeighborhood(const std::vector<NodeId>& seeds,
+                                       size_t num_hops = 1) const;
+
   std::string serializeLayer(const std::unordered_set<NodeId>& nodes) const;
 
   std::unique_ptr<Edges> deserializeLayer(const std::string& info);
@@ -241,13 +363,13 @@ class SceneGraphLayer : public BaseLayer {
  protected:
   void reset();
 
-  void fillNeighborhoodForNode(NodeId node,
-                               size_t num_hops,
-                               std::unordered_set<NodeId>& result,
-                               std::map<NodeId, size_t>& costs) const;
-
   inline EdgeContainer& edgeContainer() override { return edges_; }
 
+  /**
+   * @brief drop a node from the position cache and spatial index before removal
+   */
+  void untrackNode(NodeId node_id);
+
   /**
    * @brief remove a node if it exists
    * @param node_id node to remove
@@ -267,13 +389,22 @@ class SceneGraphLayer : public BaseLayer {
    * @brief add a node to the layer
    *
    * Checks that the layer id matches the current layer, that the node
-   * is not null and the node doesn't already exist
+   * is not null and the node doesn't already exist. The node is moved into the
+   * layer's node storage (only the base SceneGraphNode is kept).
    *
    * @param node to add
    * @returns true if the node was added successfully
    */
   bool insertNode(Node::Ptr&& node);
 
+  /**
+   * @brief replace the attributes of an existing node
+   * @param node_id node to update
+   * @param attrs new node attributes
+   * @returns true if the node exists
+   */
+  bool setNodeAttributes(NodeId node_id, NodeAttributes::Ptr&& attrs);
+
   /**
    * @brief merge a node into the other if both nodes exist
    * @param node_from node to merge into the other and remove
@@ -290,6 +421,10 @@ class SceneGraphLayer : public BaseLayer {
   NodeCheckup nodes_status_;
   //! internal edge container
   EdgeContainer edges_;
+  //! optional mirror of node positions
+  std::unique_ptr<PositionCache> position_cache_;
+  //! optional spatial index of node positions
+  std::unique_ptr<SpatialIndex> spatial_index_;
 
  public:
   /**
@@ -332,6 +467,8 @@ class IsolatedSceneGraphLayer : public SceneGraphLayer {
 
   using SceneGraphLayer::mergeNodes;
 
+  using SceneGraphLayer::setNodeAttributes;
+
   static SPtr fromBson(const std::string& contents);
 
   static SPtr readFromJson(const std::string& contents);
@@ -345,8 +482,9 @@ struct graph_traits<SceneGraphLayer> {
   using node_valid_func = const std::function<bool(const SceneGraphNode&)>&;
   using edge_valid_func = const std::function<bool(const SceneGraphEdge&)>&;
 
-  static inline std::set<NodeId> neighbors(const SceneGraphLayer& graph, NodeId node) {
-    return graph.getNode(node)->get().siblings();
+  static inline const std::set<NodeId>& neighbors(const SceneGraphLayer& graph,
+                                                  NodeId node) {
+    return graph.nodes().at(node).siblings();
   }
 
   static inline bool contains(const SceneGraphLayer& graph, NodeId node) {
@@ -369,13 +507,26 @@ struct graph_traits<SceneGraphLayer> {
 
   static inline const SceneGraphNode& get_node(const SceneGraphLayer& graph,
                                                NodeId node) {
-    return graph.getNode(node).value();
+    return graph.nodes().at(node);
   }
 
+  // reads the edge directly (getEdge marks edges as not stale, which isn't safe to do
+  // from multiple threads)
   static inline const SceneGraphEdge& get_edge(const SceneGraphLayer& graph,
                                                NodeId source,
                                                NodeId target) {
-    return graph.getEdge(source, target).value();
+    return graph.edges().at(EdgeKey(source, target));
+  }
+
+  static inline double edge_weight(const SceneGraphLayer& graph,
+                                   NodeId source,
+                                   NodeId target) {
+    return graph.edges().at(EdgeKey(source, target)).searchWeight();
+  }
+
+  static inline const Eigen::Vector3d& position(const SceneGraphLayer& graph,
+                                                NodeId node) {
+    return graph.nodes().at(node).attributes().position;
   }
 };
 
@@ -41,6 +41,7 @@
 #include <nlohmann/json.hpp>
 
 #include "spark_dsg/bounding_box.h"
+#include "spark_dsg/mesh.h"
 #include "spark_dsg/node_attributes.h"
 
 namespace nlohmann {
@@ -126,4 +127,8 @@ void to_json(nlohmann::json& j, const NearestVertexInfo& b);
 
 void from_json(const nlohmann::json& j, NearestVertexInfo& b);
 
+void to_json(nlohmann::json& j, const Mesh& mesh);
+
+void from_json(const nlohmann::json& j, Mesh& mesh);
+
 }  // namespace spark_dsg
@@ -0,0 +1,368 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "spark_dsg/flat_map.h"
+#include "spark_dsg/graph_utilities.h"
+
+namespace spark_dsg {
+namespace graph_utilities {
+
+/**
+ * @brief Result of a single-target shortest path query
+ */
+struct ShortestPath {
+  //! nodes along the path (from a source to the target), empty if no path exists
+  std::vector<NodeId> nodes;
+  //! total edge weight of the path (infinite if no path exists)
+  double cost = std::numeric_limits<double>::infinity();
+
+  inline bool empty() const { return nodes.empty(); }
+};
+
+/**
+ * @brief Scratch buffers for weighted searches
+ *
+ * Keeping a workspace around between queries lets repeated searches reuse the label
+ * table and the queue instead of reallocating them. After a search, the workspace holds
+ * the search tree (costs and parents of every reached node) until the next search.
+ */
+class ShortestPathWorkspace {
+ public:
+  struct Label {
+    //! best known cost from any source
+    double cost;
+    //! predecessor along the best known path (the node itself for sources)
+    NodeId parent;
+    //! whether the cost is final
+    bool settled;
+  };
+
+  //! queue entry: (cost + heuristic, cost, node)
+  struct QueueEntry {
+    double priority;
+    double cost;
+    NodeId node;
+
+    inline bool operator>(const QueueEntry& other) const {
+      return priority > other.priority;
+    }
+  };
+
+  //! Reset the workspace for a new search (keeps allocated memory)
+  inline void clear() {
+    labels.clear();
+    queue.clear();
+  }
+
+  //! Whether a node was reached by the last search
+  inline bool reached(NodeId node) const { return labels.contains(node); }
+
+  //! Whether the cost of a node is final
+  inline bool settled(NodeId node) const {
+    const auto iter = labels.find(node);
+    return iter != labels.end() && iter->second.settled;
+  }
+
+  //! Cost of a node from the last search (infinite if the node was not reached)
+  inline double cost(NodeId node) const {
+    const auto iter = labels.find(node);
+    return iter == labels.end() ? std::numeric_limits<double>::infinity()
+                                : iter->second.cost;
+  }
+
+  /**
+   * @brief Walk the search tree back from a node
+   * @returns nodes from the closest source to the node (empty if not reached)
+   */
+  std::vector<NodeId> path(NodeId node) const {
+    std::vector<NodeId> nodes;
+    auto iter = labels.find(node);
+    while (iter != labels.end()) {
+      nodes.push_back(node);
+      if (iter->second.parent == node) {
+        break;
+      }
+
+      node = iter->second.parent;
+      iter = labels.find(node);
+    }
+
+    std::reverse(nodes.begin(), nodes.end());
+    return nodes;
+  }
+
+  FlatMap<NodeId, Label> labels;
+  std::vector<QueueEntry> queue;
+};
+
+/**
+ * @brief Stops a search when it returns true for a settled node (and its final cost)
+ */
+using SearchTermination = std::function<bool(NodeId, double)>;
+
+/**
+ * @brief Estimate of the remaining cost from a node to the goal
+ */
+using SearchHeuristic = std::function<double(NodeId)>;
+
+namespace detail {
+
+// looks up the weight of every edge out of a node
+template <typename Graph, typename = void>
+struct NeighborWeights {
+  NeighborWeights(const Graph& graph, NodeId source) : graph(graph), source(source) {}
+
+  inline double operator()(size_t, NodeId target) const {
+    return graph_traits<Graph>::edge_weight(graph, source, target);
+  }
+
+  const Graph& graph;
+  const NodeId source;
+};
+
+// reads weights stored alongside the neighbors (by position) when the graph has them
+template <typename Graph>
+struct NeighborWeights<Graph,
+                       std::void_t<decltype(graph_traits<Graph>::neighbor_weights(
+                           std::declval<const Graph&>(), NodeId()))>> {
+  NeighborWeights(const Graph& graph, NodeId source)
+      : weights(graph_traits<Graph>::neighbor_weights(graph, source)) {}
+
+  inline double operator()(size_t index, NodeId) const { return weights[index]; }
+
+  const decltype(graph_traits<Graph>::neighbor_weights(std::declval<const Graph&>(),
+                                                       NodeId())) weights;
+};
+
+template <typename Graph>
+void bestFirstSearch(const Graph& graph,
+                     const std::vector<NodeId>& sources,
+                     const SearchHeuristic& heuristic,
+                     const SearchTermination& should_stop,
+                     double max_cost,
+                     ShortestPathWorkspace& workspace) {
+  using traits = graph_traits<Graph>;
+  using Entry = ShortestPathWorkspace::QueueEntry;
+
+  workspace.clear();
+  auto& labels = workspace.labels;
+  auto& queue = workspace.queue;
+  const auto compare = std::greater<Entry>();
+  const auto estimate = [&](NodeId node) { return heuristic ? heuristic(node) : 0.0; };
+
+  for (const auto source : sources) {
+    if (!traits::contains(graph, source) || labels.contains(source)) {
+      continue;
+    }
+
+    labels.emplace(source, ShortestPathWorkspace::Label{0.0, source, false});
+    queue.push_back({estimate(source), 0.0, source});
+    std::push_heap(queue.begin(), queue.end(), compare);
+  }
+
+  while (!queue.empty()) {
+    std::pop_heap(queue.begin(), queue.end(), compare);
+    const Entry curr = queue.back();
+    queue.pop_back();
+
+    auto& curr_label = labels.at(curr.node);
+    if (curr_label.settled || curr.cost > curr_label.cost) {
+      continue;  // stale queue entry
+    }
+
+    curr_label.settled = true;
+    if (should_stop && should_stop(curr.node, curr.cost)) {
+      return;
+    }
+
+    const auto& neighbors = traits::neighbors(graph, curr.node);
+    const NeighborWeights<Graph> weights(graph, curr.node);
+    size_t neighbor_index = 0;
+    for (const auto& neighbor : neighbors) {
+      const double weight = weights(neighbor_index++, neighbor);
+      if (weight < 0.0) {
+        throw std::invalid_argument("negative edge weight between " +
+                                    NodeSymbol(curr.node).getLabel() + " and " +
+                                    NodeSymbol(neighbor).getLabel());
+      }
+
+      const double new_cost = curr.cost + weight;
+      if (std::isinf(weight) || new_cost > max_cost) {
+        continue;
+      }
+
+      // note that the emplace may invalidate curr_label
+      auto iter = labels.find(neighbor);
+      if (iter == labels.end()) {
+        labels.emplace(neighbor,
+                       ShortestPathWorkspace::Label{new_cost, curr.node, false});
+      } else if (!iter->second.settled && new_cost < iter->second.cost) {
+        iter->second.cost = new_cost;
+        iter->second.parent = curr.node;
+      } else {
+        continue;
+      }
+
+      queue.push_back({new_cost + estimate(neighbor), new_cost, neighbor});
+      std::push_heap(queue.begin(), queue.end(), compare);
+    }
+  }
+}
+
+}  // namespace detail
+
+/**
+ * @brief Multi-source Dijkstra search over edge weights
+ *
+ * Every reached node ends up in the workspace with its cost from the closest source
+ * and its parent in the search tree. Edge weights must be non-negative, and infinite
+ * weights mark edges that can't be traversed.
+ *
+ * @throws std::invalid_argument if the search reaches an edge with a negative weight
+ *
+ * @param graph graph to search
+ * @param sources nodes to start from (with cost 0, missing nodes are ignored)
+ * @param workspace scratch buffers that hold the search tree afterwards
+ * @param should_stop optional callback to end the search early once a node is settled
+ * @param max_cost don't expand paths that cost more than this
+ */
+template <typename Graph>
+void dijkstra(const Graph& graph,
+              const std::vector<NodeId>& sources,
+              ShortestPathWorkspace& workspace,
+              const SearchTermination& should_stop = {},
+              double max_cost = std::numeric_limits<double>::infinity()) {
+  detail::bestFirstSearch(graph, sources, {}, should_stop, max_cost, workspace);
+}
+
+/**
+ * @brief Get the heuristic for A* using the straight-line distance to a goal node
+ *
+ * The heuristic is only consistent (and A* only returns optimal paths) if every edge
+ * weight is at least the distance between the node positions.
+ */
+template <typename Graph>
+SearchHeuristic euclideanHeuristic(const Graph& graph, NodeId goal) {
+  using traits = graph_traits<Graph>;
+  const auto goal_pos = traits::position(graph, goal);
+  return [&graph, goal_pos](NodeId node) {
+    return (traits::position(graph, node) - goal_pos).norm();
+  };
+}
+
+/**
+ * @brief Find the lowest-cost path from any of the sources to a target
+ *
+ * Runs A* if a heuristic is provided and Dijkstra otherwise. The search stops as soon
+ * as the target is settled. Settled nodes are never reopened, so the heuristic must be
+ * consistent (h(u) <= w(u, v) + h(v) for every edge and h(target) = 0), not just
+ * admissible, for the returned path to be optimal.
+ *
+ * @param graph graph to search
+ * @param sources nodes to start from
+ * @param target node to reach
+ * @param workspace scratch buffers (reused between queries)
+ * @param heuristic optional consistent estimate of the remaining cost to the target
+ * @returns path and cost (empty path if the target can't be reached)
+ * @throws std::invalid_argument if the search reaches an edge with a negative weight
+ */
+template <typename Graph>
+ShortestPath shortestPath(const Graph& graph,
+                          const std::vector<NodeId>& sources,
+                          NodeId target,
+                          ShortestPathWorkspace& workspace,
+                          const SearchHeuristic& heuristic = {}) {
+  ShortestPath result;
+  if (!graph_traits<Graph>::contains(graph, target)) {
+    return result;
+  }
+
+  detail::bestFirstSearch(
+      graph,
+      sources,
+      heuristic,
+      [target](NodeId node, double) { return node == target; },
+      std::numeric_limits<double>::infinity(),
+      workspace);
+  if (!workspace.settled(target)) {
+    return result;
+  }
+
+  result.nodes = workspace.path(target);
+  result.cost = workspace.cost(target);
+  return result;
+}
+
+/**
+ * @brief Find the lowest-cost path between two nodes
+ *
+ * Convenience overload that allocates a fresh workspace.
+ */
+template <typename Graph>
+ShortestPath shortestPath(const Graph& graph,
+                          NodeId source,
+                          NodeId target,
+                          const SearchHeuristic& heuristic = {}) {
+  ShortestPathWorkspace workspace;
+  return shortestPath(graph, {source}, target, workspace, heuristic);
+}
+
+/**
+ * @brief Find the lowest-cost path between two nodes with A* using node positions
+ */
+template <typename Graph>
+ShortestPath aStar(const Graph& graph,
+                   NodeId source,
+                   NodeId target,
+                   ShortestPathWorkspace& workspace) {
+  if (!graph_traits<Graph>::contains(graph, target)) {
+    return {};
+  }
+
+  return shortestPath(
+      graph, {source}, target, workspace, euclideanHeuristic(graph, target));
+}
+
+}  // namespace graph_utilities
+}  // namespace spark_dsg
@@ -0,0 +1,149 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <Eigen/Dense>
+#include <optional>
+#include <vector>
+
+#include "spark_dsg/flat_map.h"
+#include "spark_dsg/scene_graph_types.h"
+
+namespace spark_dsg {
+
+/**
+ * @brief Uniform hash grid over node positions
+ *
+ * Nodes are bucketed by the grid cell that contains their position and cells are
+ * stored sparsely in a hash map, so memory only scales with the number of occupied
+ * cells. Insertions, moves and removals are O(1). Queries only touch the cells that
+ * overlap the query region (or every occupied cell if that is cheaper). The cell size
+ * should be on the order of the typical query radius / node spacing.
+ */
+class SpatialIndex {
+ public:
+  /**
+   * @brief Make an empty index
+   * @param cell_size side length of the grid cells
+   */
+  explicit SpatialIndex(double cell_size = 1.0);
+
+  //! side length of the grid cells
+  inline double cellSize() const { return cell_size_; }
+
+  //! number of nodes in the index
+  inline size_t size() const { return node_cells_.size(); }
+
+  //! number of occupied grid cells
+  inline size_t numCells() const { return cells_.size(); }
+
+  inline bool contains(NodeId node) const { return node_cells_.contains(node); }
+
+  /**
+   * @brief Add a node or update the position of a node already in the index
+   */
+  void update(NodeId node, const Eigen::Vector3d& position);
+
+  /**
+   * @brief Remove a node from the index
+   * @returns true if the node was in the index
+   */
+  bool remove(NodeId node);
+
+  /**
+   * @brief Remove all nodes from the index
+   */
+  void clear();
+
+  /**
+   * @brief Find the nodes closest to a point
+   * @param point query point
+   * @param k maximum number of nodes to return
+   * @returns up to k node ids in order of increasing distance
+   */
+  std::vector<NodeId> knnQuery(const Eigen::Vector3d& point, size_t k) const;
+
+  /**
+   * @brief Find the node closest to a point
+   * @returns the closest node (if the index is not empty)
+   */
+  std::optional<NodeId> nearest(const Eigen::Vector3d& point) const;
+
+  /**
+   * @brief Find all nodes within a radius of a point
+   * @param center center of the query
+   * @param radius maximum distance to the center (inclusive)
+   * @param result ids of the nodes inside the query (appended to)
+   */
+  void radiusQuery(const Eigen::Vector3d& center,
+                   double radius,
+                   std::vector<NodeId>& result) const;
+
+  /**
+   * @brief Find all nodes inside an axis-aligned box
+   * @param min minimum corner of the box (inclusive)
+   * @param max maximum corner of the box (inclusive)
+   * @param result ids of the nodes inside the query (appended to)
+   */
+  void boxQuery(const Eigen::Vector3d& min,
+                const Eigen::Vector3d& max,
+                std::vector<NodeId>& result) const;
+
+ private:
+  using CellIndex = Eigen::Array3i;
+  using CellKey = uint64_t;
+
+  struct Entry {
+    NodeId node;
+    double x;
+    double y;
+    double z;
+  };
+
+  using Cell = std::vector<Entry>;
+
+  CellIndex cellIndex(const Eigen::Vector3d& point) const;
+
+  static CellKey cellKey(const CellIndex& index);
+
+  // calls visitor for every occupied cell overlapping [min, max]
+  template <typename Visitor>
+  void visitCells(const CellIndex& min, const CellIndex& max, Visitor&& visitor) const;
+
+  double cell_size_;
+  FlatMap<CellKey, Cell> cells_;
+  FlatMap<NodeId, CellKey> node_cells_;
+};
+
+}  // namespace spark_dsg
@@ -33,17 +33,44 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <chrono>
+#include <string>
+
 #include "spark_dsg/dynamic_scene_graph.h"
 
 namespace spark_dsg {
 
 class ZmqSender {
  public:
-  ZmqSender(const std::string& url, size_t num_threads);
+  /**
+   * @brief Make a sender
+   * @param url url to bind to
+   * @param num_threads number of zmq io threads
+   * @param keyframe_interval send incremental updates with a full keyframe every this
+   * many messages (0 sends the full graph every time)
+   * @param multipart send full graphs as one frame per serialized section (header,
+   * nodes, edges and mesh) instead of a single frame
+   *
+   * Multipart messages are delivered atomically, so receivers still get every section
+   * at once; splitting only avoids copying the sections into one contiguous buffer.
+   * Incremental updates are always sent as a single frame, so multipart cannot be
+   * combined with a keyframe interval.
+   *
+   * @throws std::invalid_argument if both multipart and keyframe_interval are set
+   */
+  ZmqSender(const std::string& url,
+            size_t num_threads,
+            size_t keyframe_interval = 0,
+            bool multipart = false);
 
   ~ZmqSender();
 
-  void send(const DynamicSceneGraph& graph);
+  /**
+   * @brief Serialize and publish the graph
+   *
+   * Serialized buffers are handed to zmq without copying
+   */
+  void send(const DynamicSceneGraph& graph, bool include_mesh = false);
 
  private:
   struct Detail;
@@ -53,14 +80,58 @@ class ZmqSender {
 
 class ZmqReceiver {
  public:
-  ZmqReceiver(const std::string& url, size_t num_threads);
+  //! receive statistics (only tracked in async mode)
+  struct Stats {
+    //! number of messages received
+    size_t num_received = 0;
+    //! number of messages skipped because a later message replaced the graph
+    size_t num_dropped = 0;
+    //! number of graphs published
+    size_t num_published = 0;
+    //! number of messages that could not be received or applied
+    size_t num_failed = 0;
+    //! description of the most recent failure
+    std::string last_error;
+    //! time between receiving messages and publishing the resulting graph
+    std::chrono::nanoseconds last_latency{0};
+    std::chrono::nanoseconds max_latency{0};
+    std::chrono::nanoseconds total_latency{0};
+  };
+
+  /**
+   * @brief Make a receiver
+   * @param url url to connect to
+   * @param num_threads number of zmq io threads
+   * @param async receive and deserialize on a background thread
+   *
+   * In async mode, messages are applied to a private graph. Every completed update is
+   * published by swapping the pointer returned by graph(), and published graphs are
+   * never modified. The previously published graph is reused as the private graph by
+   * applying the same messages again (it is only copied if a consumer still holds
+   * it). Messages that fail to deserialize are counted in the stats and the receiver
+   * waits for the next full graph or keyframe. When messages queue up, only the newest
+   * one that replaces the graph (and any deltas after it) are deserialized.
+   */
+  ZmqReceiver(const std::string& url, size_t num_threads, bool async = false);
 
   ~ZmqReceiver();
 
+  /**
+   * @brief Wait for a new graph
+   *
+   * Receives and deserializes the next message, or in async mode, waits until the
+   * background thread publishes a new graph.
+   *
+   * @returns true if the graph changed
+   * @throws std::exception if the message cannot be applied (synchronous mode only);
+   * the graph is dropped until the next full graph or keyframe arrives
+   */
   bool recv(size_t timeout_ms);
 
   DynamicSceneGraph::Ptr graph() const;
 
+  Stats stats() const;
+
  private:
   struct Detail;
 
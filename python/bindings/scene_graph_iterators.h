@@ -44,7 +44,7 @@ class NodeIter {
   NodeIter(const SceneGraphLayer::Nodes& container)
       : curr_iter_(container.begin()), end_iter_(container.end()) {}
 
-  const SceneGraphLayer::Node* operator*() const { return curr_iter_->second.get(); }
+  const SceneGraphLayer::Node* operator*() const { return curr_iter_->second; }
 
   NodeIter& operator++() {
     ++curr_iter_;
@@ -89,7 +89,7 @@ class EdgeIter {
   EdgeIter(const SceneGraphLayer::Edges& container)
       : curr_iter_(container.begin()), end_iter_(container.end()) {}
 
-  const SceneGraphLayer::Edge* operator*() const { return &(curr_iter_->second); }
+  const SceneGraphLayer::Edge* operator*() const { return curr_iter_->second; }
 
   EdgeIter& operator++() {
     ++curr_iter_;
@@ -174,9 +174,9 @@ class GlobalEdgeIter {
 
   const SceneGraphEdge* operator*() const {
     if (started_interlayer_) {
-      return &curr_interlayer_iter_->second;
+      return curr_interlayer_iter_->second;
     } else {
-      return &curr_edge_iter_->second;
+      return curr_edge_iter_->second;
     }
   }
 
@@ -53,8 +53,6 @@ using namespace py::literals;
 
 using namespace spark_dsg;
 
-PYBIND11_MAKE_OPAQUE(std::map<size_t, MeshEdge>);
-
 template <typename Scalar>
 struct Quaternion {
   Quaternion() : w(1.0f), x(0.0f), y(0.0f), z(0.0f) {}
@@ -507,7 +505,13 @@ PYBIND11_MODULE(_dsg_bindings, module) {
              bool include_mesh) { graph.save(filepath, include_mesh); },
           "filepath"_a,
           "include_mesh"_a = true)
-      .def_static("load", &DynamicSceneGraph::load)
+      .def_static(
+          "load",
+          [](const std::string& filepath, size_t num_threads) {
+            return DynamicSceneGraph::load(filepath, num_threads);
+          },
+          "filepath"_a,
+          "num_threads"_a = 1)
       .def_property(
           "layers",
           [](const DynamicSceneGraph& graph) {
@@ -558,36 +562,36 @@ PYBIND11_MODULE(_dsg_bindings, module) {
            [](const DynamicSceneGraph& G, py::object) { return G.clone(); })
       .def("get_mesh_vertices",
            [](const DynamicSceneGraph& G) {
-             auto vertices = G.getMeshVertices();
-             if (!vertices) {
+             const auto mesh = G.mesh();
+             if (!mesh) {
                return Eigen::MatrixXd();
              }
 
-             Eigen::MatrixXd to_return(6, vertices->size());
-             for (size_t i = 0; i < vertices->size(); ++i) {
-               const auto& point = vertices->at(i);
-               to_return(0, i) = point.x;
-               to_return(1, i) = point.y;
-               to_return(2, i) = point.z;
-               to_return(3, i) = point.r / 255.0;
-               to_return(4, i) = point.g / 255.0;
-               to_return(5, i) = point.b / 255.0;
+             Eigen::MatrixXd to_return(6, mesh->numVertices());
+             for (size_t i = 0; i < mesh->numVertices(); ++i) {
+               const auto& color = mesh->color(i);
+               to_return(0, i) = mesh->xs()[i];
+               to_return(1, i) = mesh->ys()[i];
+               to_return(2, i) = mesh->zs()[i];
+               to_return(3, i) = color.r / 255.0;
+               to_return(4, i) = color.g / 255.0;
+               to_return(5, i) = color.b / 255.0;
              }
              return to_return;
            })
       .def("get_mesh_faces",
            [](const DynamicSceneGraph& G) {
-             auto faces = G.getMeshFaces();
-             if (!faces) {
+             const auto mesh = G.mesh();
+             if (!mesh) {
                return Eigen::MatrixXi();
              }
 
-             Eigen::MatrixXi to_return(3, faces->size());
-             for (size_t i = 0; i < faces->size(); ++i) {
-               const auto& face = faces->at(i);
-               to_return(0, i) = face.vertices.at(0);
-               to_return(1, i) = face.vertices.at(1);
-               to_return(2, i) = face.vertices.at(2);
+             Eigen::MatrixXi to_return(3, mesh->numFaces());
+             for (size_t i = 0; i < mesh->numFaces(); ++i) {
+               const auto face = mesh->face(i);
+               to_return(0, i) = face[0];
+               to_return(1, i) = face[1];
+               to_return(2, i) = face[2];
              }
              return to_return;
            })
@@ -599,20 +603,17 @@ PYBIND11_MODULE(_dsg_bindings, module) {
                throw std::invalid_argument(ss.str());
              }
 
-             DynamicSceneGraph::MeshVertices::Ptr vertices(
-                 new DynamicSceneGraph::MeshVertices());
+             auto mesh = G.mesh() ? std::make_shared<Mesh>(*G.mesh())
+                                  : std::make_shared<Mesh>();
+             mesh->resizeVertices(points.cols());
              for (int i = 0; i < points.cols(); ++i) {
-               pcl::PointXYZRGBA point;
-               point.x = points(0, i);
-               point.y = points(1, i);
-               point.z = points(2, i);
-               point.r = static_cast<uint8_t>(points(3, i) * 255);
-               point.g = static_cast<uint8_t>(points(4, i) * 255);
-               point.b = static_cast<uint8_t>(points(5, i) * 255);
-               point.a = 255;
-               vertices->push_back(point);
+               mesh->setPos(i, points.block<3, 1>(0, i).cast<float>());
+               mesh->setColor(i,
+                              {static_cast<uint8_t>(points(3, i) * 255),
+                               static_cast<uint8_t>(points(4, i) * 255),
+                               static_cast<uint8_t>(points(5, i) * 255)});
              }
-             G.setMesh(vertices, G.getMeshFaces(), false);
+             G.setMesh(mesh, false);
            })
       .def("set_mesh_faces",
            [](DynamicSceneGraph& G, const Eigen::MatrixXd& indices) {
@@ -622,16 +623,16 @@ PYBIND11_MODULE(_dsg_bindings, module) {
                throw std::invalid_argument(ss.str());
              }
 
-             std::shared_ptr<DynamicSceneGraph::MeshFaces> faces(
-                 new DynamicSceneGraph::MeshFaces());
+             auto mesh = G.mesh() ? std::make_shared<Mesh>(*G.mesh())
+                                  : std::make_shared<Mesh>();
+             mesh->resizeFaces(indices.cols());
              for (int i = 0; i < indices.cols(); ++i) {
-               pcl::Vertices face;
-               face.vertices.push_back(indices(0, i));
-               face.vertices.push_back(indices(1, i));
-               face.vertices.push_back(indices(2, i));
-               faces->push_back(face);
+               mesh->setFace(i,
+                             {static_cast<uint32_t>(indices(0, i)),
+                              static_cast<uint32_t>(indices(1, i)),
+                              static_cast<uint32_t>(indices(2, i))});
              }
-             G.setMesh(G.getMeshVertices(), faces, false);
+             G.setMesh(mesh, false);
            })
       .def("insert_mesh_edge",
            &DynamicSceneGraph::insertMeshEdge,
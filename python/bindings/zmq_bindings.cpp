@@ -44,12 +44,36 @@ namespace py = pybind11;
 #if INCLUDE_ZMQ()
 void add_zmq_bindings(pybind11::module_& module) {
   py::class_<ZmqSender>(module, "DsgSender")
-      .def(py::init<const std::string&, size_t>(), "url"_a, "num_threads"_a = 1)
-      .def("send", &ZmqSender::send);
+      .def(py::init<const std::string&, size_t, size_t, bool>(),
+           "url"_a,
+           "num_threads"_a = 1,
+           "keyframe_interval"_a = 0,
+           "multipart"_a = false)
+      .def("send", &ZmqSender::send, "graph"_a, "include_mesh"_a = false);
+
+  py::class_<ZmqReceiver::Stats>(module, "DsgReceiverStats")
+      .def_readonly("num_received", &ZmqReceiver::Stats::num_received)
+      .def_readonly("num_dropped", &ZmqReceiver::Stats::num_dropped)
+      .def_readonly("num_published", &ZmqReceiver::Stats::num_published)
+      .def_readonly("num_failed", &ZmqReceiver::Stats::num_failed)
+      .def_readonly("last_error", &ZmqReceiver::Stats::last_error)
+      .def_property_readonly(
+          "last_latency_s",
+          [](const ZmqReceiver::Stats& stats) {
+            return std::chrono::duration<double>(stats.last_latency).count();
+          })
+      .def_property_readonly(
+          "max_latency_s", [](const ZmqReceiver::Stats& stats) {
+            return std::chrono::duration<double>(stats.max_latency).count();
+          });
 
   py::class_<ZmqReceiver>(module, "DsgReceiver")
-      .def(py::init<const std::string&, size_t>(), "url"_a, "num_threads"_a = 1)
-      .def("recv", &ZmqReceiver::recv)
+      .def(py::init<const std::string&, size_t, bool>(),
+           "url"_a,
+           "num_threads"_a = 1,
+           "async_recv"_a = false)
+      .def("recv", &ZmqReceiver::recv, py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly("stats", &ZmqReceiver::stats)
       .def_property_readonly("graph", [](const ZmqReceiver& receiver) {
         if (!receiver.graph()) {
           throw pybind11::value_error("no graph received yet");
@@ -34,6 +34,12 @@
  * -------------------------------------------------------------------------- */
 #include "spark_dsg/binary_serializer.h"
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
 #include <iomanip>
 
 #include "spark_dsg/logging.h"
@@ -51,6 +57,7 @@ std::ostream& operator<<(std::ostream& out, PackType type) {
     SHOW_CASE(out, PackType::NIL);
     SHOW_CASE(out, PackType::FALSE);
     SHOW_CASE(out, PackType::TRUE);
+    SHOW_CASE(out, PackType::BIN32);
     SHOW_CASE(out, PackType::FLOAT32);
     SHOW_CASE(out, PackType::FLOAT64);
     SHOW_CASE(out, PackType::UINT8);
@@ -94,6 +101,19 @@ void BinarySerializer::startFixedArray(size_t length) {
   writeWord(*ref, static_cast<uint32_t>(length));
 }
 
+void BinarySerializer::writeBytes(const void* data, size_t num_bytes) {
+  if (num_bytes > std::numeric_limits<uint32_t>::max()) {
+    THROW_SERIALIZATION_ERROR("cannot serialize bytes: "
+                              << num_bytes << " > "
+                              << std::numeric_limits<uint32_t>::max());
+  }
+
+  ref->push_back(static_cast<uint8_t>(PackType::BIN32));
+  writeWord(*ref, static_cast<uint32_t>(num_bytes));
+  const auto bytes = static_cast<const uint8_t*>(data);
+  ref->insert(ref->end(), bytes, bytes + num_bytes);
+}
+
 void BinarySerializer::write_type(PackType type) {
   ref->push_back(static_cast<uint8_t>(type));
 }
@@ -104,6 +124,82 @@ BinaryDeserializer::BinaryDeserializer(const uint8_t* const buffer, size_t size)
 BinaryDeserializer::BinaryDeserializer(const std::vector<uint8_t>& buffer)
     : BinaryDeserializer(buffer.data(), buffer.size()) {}
 
+BinaryDeserializer::BinaryDeserializer(ChunkReader reader, size_t chunk_size)
+    : ref(nullptr),
+      buffer_length(0),
+      pos(0),
+      reader_(std::move(reader)),
+      chunk_size_(std::max<size_t>(chunk_size, 1)) {}
+
+bool BinaryDeserializer::fill(size_t num_bytes) const {
+  if (!reader_) {
+    return false;
+  }
+
+  // drop everything that was already read
+  window_.erase(window_.begin(), window_.begin() + std::min(pos, window_.size()));
+  pos = 0;
+
+  while (window_.size() < num_bytes) {
+    const auto prev_size = window_.size();
+    window_.resize(prev_size + std::max(chunk_size_, num_bytes - prev_size));
+    const auto capacity = window_.size() - prev_size;
+    const auto num_read = reader_(window_.data() + prev_size, capacity);
+    window_.resize(prev_size + num_read);
+    if (!num_read) {
+      break;
+    }
+  }
+
+  ref = window_.data();
+  buffer_length = window_.size();
+  return buffer_length >= num_bytes;
+}
+
+ChunkReader streamChunkReader(std::istream& stream) {
+  return [&stream](uint8_t* buffer, size_t max_bytes) -> size_t {
+    stream.read(reinterpret_cast<char*>(buffer), max_bytes);
+    return stream.gcount();
+  };
+}
+
+ChunkReader fileDescriptorChunkReader(int fd) {
+  return [fd](uint8_t* buffer, size_t max_bytes) -> size_t {
+    while (true) {
+      const auto num_read = ::read(fd, buffer, max_bytes);
+      if (num_read >= 0) {
+        return num_read;
+      }
+
+      if (errno != EINTR) {
+        THROW_SERIALIZATION_ERROR("failed to read: " << std::strerror(errno));
+      }
+    }
+  };
+}
+
+ChunkReader bufferChunkReader(std::vector<std::pair<const uint8_t*, size_t>> buffers) {
+  size_t index = 0;
+  size_t offset = 0;
+  return [buffers = std::move(buffers), index, offset](uint8_t* buffer,
+                                                       size_t max_bytes) mutable {
+    size_t num_read = 0;
+    while (num_read < max_bytes && index < buffers.size()) {
+      const auto& [data, length] = buffers[index];
+      const auto to_copy = std::min(max_bytes - num_read, length - offset);
+      std::memcpy(buffer + num_read, data + offset, to_copy);
+      num_read += to_copy;
+      offset += to_copy;
+      if (offset == length) {
+        ++index;
+        offset = 0;
+      }
+    }
+
+    return num_read;
+  };
+}
+
 void BinaryDeserializer::checkType(PackType type) const {
   const auto ref_type = getCurrType();
   if (type != ref_type) {
@@ -163,6 +259,19 @@ size_t BinaryDeserializer::readFixedArrayLength() const {
   return static_cast<size_t>(length);
 }
 
+size_t BinaryDeserializer::readBytesLength() const {
+  const auto ref_type = getCurrType();
+  if (ref_type != PackType::BIN32) {
+    THROW_SERIALIZATION_ERROR("type mismatch: expecting BIN32 but got " << ref_type);
+  }
+
+  ++pos;
+  uint32_t length;
+  readWord(getReadPtr<uint32_t>(), length);
+  pos += sizeof(length);
+  return static_cast<size_t>(length);
+}
+
 BinaryConverter::BinaryConverter(BinarySerializer* serializer)
     : serializer_(serializer) {
   serializer_->writeArrayStart();
@@ -253,5 +362,339 @@ void BinarySerializer::write<MeshFaces>(const MeshFaces& faces) {
   }
 }
 
+namespace {
+
+enum class MeshFormat : uint8_t { RAW = 1, QUANTIZED = 2 };
+
+static_assert(sizeof(Mesh::Color) == 4, "colors must be packed");
+
+// writes values as a block of little-endian words
+template <typename Word, typename T>
+void writeBlock(BinarySerializer& serializer, const std::vector<T>& values) {
+  static_assert(sizeof(Word) == sizeof(T), "word size must match value size");
+  if (!NeedEndianSwap()) {
+    serializer.writeBytes(values.data(), sizeof(T) * values.size());
+    return;
+  }
+
+  std::vector<uint8_t> bytes;
+  bytes.reserve(sizeof(T) * values.size());
+  for (const auto& value : values) {
+    writeWord(bytes, reinterpret_cast<const Word&>(value));
+  }
+  serializer.writeBytes(bytes.data(), bytes.size());
+}
+
+// reads a block of raw bytes holding exactly num_values values
+template <typename T>
+void readBytes(const BinaryDeserializer& deserializer,
+               size_t num_values,
+               std::vector<T>& values) {
+  const auto num_bytes = deserializer.readBytesLength();
+  if (num_bytes != sizeof(T) * num_values) {
+    THROW_SERIALIZATION_ERROR("block size mismatch: " << num_bytes << " != "
+                                                      << sizeof(T) * num_values);
+  }
+
+  values.resize(num_values);
+  if (num_bytes) {
+    std::memcpy(values.data(), deserializer.getReadPtr<uint8_t>(num_bytes), num_bytes);
+  }
+
+  deserializer.pos += num_bytes;
+}
+
+template <typename Word, typename T>
+void readBlock(const BinaryDeserializer& deserializer,
+               size_t num_values,
+               std::vector<T>& values) {
+  static_assert(sizeof(Word) == sizeof(T), "word size must match value size");
+  readBytes(deserializer, num_values, values);
+  if (NeedEndianSwap()) {
+    for (auto& value : values) {
+      const Word word = reinterpret_cast<const Word&>(value);
+      readWord(&word, reinterpret_cast<Word&>(value));
+    }
+  }
+}
+
+void writeIndices(BinarySerializer& serializer, const std::vector<uint32_t>& indices) {
+  std::vector<uint8_t> bytes;
+  bytes.reserve(2 * indices.size());
+  int64_t prev = 0;
+  for (const auto index : indices) {
+    const int64_t delta = static_cast<int64_t>(index) - prev;
+    prev = index;
+    // zigzag encoding keeps small negative differences small
+    uint64_t value = (static_cast<uint64_t>(delta) << 1) ^ (delta < 0 ? ~0ull : 0ull);
+    while (value >= 0x80) {
+      bytes.push_back(static_cast<uint8_t>(value) | 0x80);
+      value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+  }
+
+  serializer.writeBytes(bytes.data(), bytes.size());
+}
+
+void readIndices(const BinaryDeserializer& deserializer,
+                 size_t num_indices,
+                 std::vector<uint32_t>& indices) {
+  const auto num_bytes = deserializer.readBytesLength();
+  if (num_indices > num_bytes) {
+    THROW_SERIALIZATION_ERROR("face index block too small: " << num_bytes << " < "
+                                                              << num_indices);
+  }
+
+  const auto bytes = deserializer.getReadPtr<uint8_t>(num_bytes);
+  indices.resize(num_indices);
+
+  size_t offset = 0;
+  int64_t prev = 0;
+  for (size_t i = 0; i < num_indices; ++i) {
+    uint64_t value = 0;
+    for (size_t shift = 0;; shift += 7) {
+      if (offset >= num_bytes || shift > 63) {
+        THROW_SERIALIZATION_ERROR("invalid face index encoding");
+      }
+
+      const auto byte = bytes[offset++];
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        break;
+      }
+    }
+
+    prev += static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    indices[i] = static_cast<uint32_t>(prev);
+  }
+
+  if (offset != num_bytes) {
+    THROW_SERIALIZATION_ERROR("face index block has " << num_bytes - offset
+                                                      << " trailing bytes");
+  }
+
+  deserializer.pos += num_bytes;
+}
+
+bool getBounds(const Mesh& mesh, Eigen::Vector3f& min, Eigen::Vector3f& max) {
+  min.setConstant(std::numeric_limits<float>::max());
+  max.setConstant(std::numeric_limits<float>::lowest());
+  const std::vector<float>* axes[3] = {&mesh.xs(), &mesh.ys(), &mesh.zs()};
+  for (size_t axis = 0; axis < 3; ++axis) {
+    for (const auto value : *axes[axis]) {
+      if (!std::isfinite(value)) {
+        return false;
+      }
+
+      min(axis) = std::min(min(axis), value);
+      max(axis) = std::max(max(axis), value);
+    }
+  }
+
+  return true;
+}
+
+Mesh::Ptr readLegacyMesh(const BinaryDeserializer& deserializer) {
+  size_t num_vertices = deserializer.readFixedArrayLength() / 6;
+  std::vector<float> x(num_vertices);
+  std::vector<float> y(num_vertices);
+  std::vector<float> z(num_vertices);
+  std::vector<Mesh::Color> colors(num_vertices);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    deserializer.read(x[i]);
+    deserializer.read(y[i]);
+    deserializer.read(z[i]);
+    float r;
+    deserializer.read(r);
+    float g;
+    deserializer.read(g);
+    float b;
+    deserializer.read(b);
+
+    colors[i].r = static_cast<uint8_t>(255.0f * r);
+    colors[i].g = static_cast<uint8_t>(255.0f * g);
+    colors[i].b = static_cast<uint8_t>(255.0f * b);
+  }
+
+  size_t num_indices = 3 * (deserializer.readFixedArrayLength() / 3);
+  std::vector<uint32_t> indices(num_indices);
+  for (auto& index : indices) {
+    deserializer.read(index);
+  }
+
+  return std::make_shared<Mesh>(std::move(x),
+                                std::move(y),
+                                std::move(z),
+                                std::move(colors),
+                                std::move(indices));
+}
+
+void writeLegacyMesh(BinarySerializer& serializer, const Mesh& mesh) {
+  serializer.startFixedArray(6 * mesh.numVertices());
+  for (size_t i = 0; i < mesh.numVertices(); ++i) {
+    const auto& color = mesh.colors()[i];
+    serializer.write(mesh.xs()[i]);
+    serializer.write(mesh.ys()[i]);
+    serializer.write(mesh.zs()[i]);
+    serializer.write(color.r / 255.0f);
+    serializer.write(color.g / 255.0f);
+    serializer.write(color.b / 255.0f);
+  }
+
+  serializer.startFixedArray(mesh.indices().size());
+  for (const auto index : mesh.indices()) {
+    serializer.write(index);
+  }
+}
+
+}  // namespace
+
+void writeMesh(BinarySerializer& serializer,
+               const Mesh& mesh,
+               const MeshEncoding& encoding) {
+  if (encoding.position_bits > 16) {
+    throw std::invalid_argument("mesh positions can be quantized to at most 16 bits");
+  }
+
+  if (!encoding.compact && encoding.position_bits == 0) {
+    writeLegacyMesh(serializer, mesh);
+    return;
+  }
+
+  Eigen::Vector3f min;
+  Eigen::Vector3f max;
+  const bool quantize = encoding.position_bits > 0 && mesh.numVertices() > 0 &&
+                        getBounds(mesh, min, max);
+
+  const auto format = quantize ? MeshFormat::QUANTIZED : MeshFormat::RAW;
+  serializer.write(static_cast<uint8_t>(format));
+  serializer.write(static_cast<uint64_t>(mesh.numVertices()));
+  serializer.write(static_cast<uint64_t>(mesh.numFaces()));
+  if (!quantize) {
+    writeBlock<uint32_t>(serializer, mesh.xs());
+    writeBlock<uint32_t>(serializer, mesh.ys());
+    writeBlock<uint32_t>(serializer, mesh.zs());
+  } else {
+    serializer.write(encoding.position_bits);
+    for (size_t axis = 0; axis < 3; ++axis) {
+      serializer.write(min(axis));
+      serializer.write(max(axis));
+    }
+
+    const float levels = (1u << encoding.position_bits) - 1;
+    const std::vector<float>* axes[3] = {&mesh.xs(), &mesh.ys(), &mesh.zs()};
+    std::vector<uint16_t> quantized(mesh.numVertices());
+    for (size_t axis = 0; axis < 3; ++axis) {
+      const float range = max(axis) - min(axis);
+      const float scale = range > 0.0f ? levels / range : 0.0f;
+      const auto& values = *axes[axis];
+      for (size_t i = 0; i < values.size(); ++i) {
+        const auto offset = values[i] - min(axis);
+        quantized[i] = static_cast<uint16_t>(std::lround(offset * scale));
+      }
+      writeBlock<uint16_t>(serializer, quantized);
+    }
+
+    // vertices at the origin mark invalid vertices, so they are kept exact
+    std::vector<uint32_t> origin_vertices;
+    for (size_t i = 0; i < mesh.numVertices(); ++i) {
+      if (mesh.xs()[i] == 0.0f && mesh.ys()[i] == 0.0f && mesh.zs()[i] == 0.0f) {
+        origin_vertices.push_back(i);
+      }
+    }
+
+    serializer.write(static_cast<uint64_t>(origin_vertices.size()));
+    writeIndices(serializer, origin_vertices);
+  }
+
+  serializer.writeBytes(mesh.colors().data(), sizeof(Mesh::Color) * mesh.numVertices());
+  writeIndices(serializer, mesh.indices());
+}
+
+Mesh::Ptr readMesh(const BinaryDeserializer& deserializer) {
+  if (deserializer.getCurrType() == PackType::ARR32) {
+    return readLegacyMesh(deserializer);
+  }
+
+  uint8_t format;
+  deserializer.read(format);
+  if (format != static_cast<uint8_t>(MeshFormat::RAW) &&
+      format != static_cast<uint8_t>(MeshFormat::QUANTIZED)) {
+    THROW_SERIALIZATION_ERROR("unknown mesh format: " << static_cast<int>(format));
+  }
+
+  uint64_t num_vertices;
+  deserializer.read(num_vertices);
+  uint64_t num_faces;
+  deserializer.read(num_faces);
+
+  std::vector<float> axes[3];
+  if (format == static_cast<uint8_t>(MeshFormat::RAW)) {
+    for (auto& values : axes) {
+      readBlock<uint32_t>(deserializer, num_vertices, values);
+    }
+  } else {
+    uint8_t bits;
+    deserializer.read(bits);
+    if (bits == 0 || bits > 16) {
+      THROW_SERIALIZATION_ERROR("invalid mesh quantization: "
+                                << static_cast<int>(bits));
+    }
+
+    float bounds[6];
+    for (auto& bound : bounds) {
+      deserializer.read(bound);
+    }
+
+    const float levels = (1u << bits) - 1;
+    std::vector<uint16_t> quantized;
+    for (size_t axis = 0; axis < 3; ++axis) {
+      readBlock<uint16_t>(deserializer, num_vertices, quantized);
+      const float min = bounds[2 * axis];
+      const float step = (bounds[2 * axis + 1] - min) / levels;
+      auto& values = axes[axis];
+      values.resize(num_vertices);
+      for (size_t i = 0; i < num_vertices; ++i) {
+        values[i] = min + step * quantized[i];
+      }
+    }
+
+    uint64_t num_origin_vertices;
+    deserializer.read(num_origin_vertices);
+    if (num_origin_vertices > num_vertices) {
+      THROW_SERIALIZATION_ERROR("too many origin vertices: "
+                                << num_origin_vertices << " > " << num_vertices);
+    }
+
+    std::vector<uint32_t> origin_vertices;
+    readIndices(deserializer, num_origin_vertices, origin_vertices);
+    for (const auto vertex : origin_vertices) {
+      if (vertex >= num_vertices) {
+        THROW_SERIALIZATION_ERROR("invalid origin vertex: " << vertex);
+      }
+
+      for (auto& values : axes) {
+        values[vertex] = 0.0f;
+      }
+    }
+  }
+
+  std::vector<Mesh::Color> colors;
+  readBytes(deserializer, num_vertices, colors);
+  std::vector<uint32_t> indices;
+  readIndices(deserializer, 3 * num_faces, indices);
+  return std::make_shared<Mesh>(std::move(axes[0]),
+                                std::move(axes[1]),
+                                std::move(axes[2]),
+                                std::move(colors),
+                                std::move(indices));
+}
+
+template <>
+void BinarySerializer::write<Mesh>(const Mesh& mesh) {
+  writeMesh(*this, mesh, {0, true});
+}
+
 }  // namespace serialization
 }  // namespace spark_dsg
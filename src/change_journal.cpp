@@ -0,0 +1,183 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/change_journal.h"
+
+#include <algorithm>
+#include <map>
+
+namespace spark_dsg {
+
+ChangeJournal::ChangeJournal(size_t capacity) : capacity_(capacity) {}
+
+void ChangeJournal::setCapacity(size_t capacity) {
+  capacity_ = capacity;
+  while (changes_.size() > capacity_) {
+    changes_.pop_front();
+    ++offset_;
+  }
+}
+
+void ChangeJournal::recordNode(ChangeType type, NodeId node) {
+  recordEdge(type, node, node);
+}
+
+void ChangeJournal::recordEdge(ChangeType type, NodeId source, NodeId target) {
+  if (!capacity_) {
+    ++offset_;  // nothing is held, but older cursors still need to see a gap
+    return;
+  }
+
+  if (changes_.size() == capacity_) {
+    changes_.pop_front();
+    ++offset_;
+  }
+
+  changes_.push_back({type, source, target});
+}
+
+bool ChangeJournal::read(Cursor& cursor, std::vector<Change>& changes) const {
+  // a cursor past the end belongs to an older journal (e.g., before a layer was reset)
+  const bool complete = cursor >= offset_ && cursor <= end();
+  const auto start = complete ? cursor - offset_ : 0;
+  changes.insert(changes.end(), changes_.begin() + start, changes_.end());
+  cursor = end();
+  return complete;
+}
+
+void ChangeJournal::clear() {
+  offset_ = end();
+  changes_.clear();
+}
+
+namespace {
+
+enum class NetChange { ADDED, UPDATED, REMOVED };
+
+inline void apply(NetChange& state, ChangeType type, bool exists) {
+  switch (type) {
+    case ChangeType::NODE_ADDED:
+    case ChangeType::EDGE_ADDED:
+    case ChangeType::MESH_EDGE_ADDED:
+      state = NetChange::ADDED;
+      break;
+    case ChangeType::NODE_REMOVED:
+    case ChangeType::EDGE_REMOVED:
+    case ChangeType::MESH_EDGE_REMOVED:
+      state = NetChange::REMOVED;
+      break;
+    case ChangeType::NODE_UPDATED:
+    case ChangeType::EDGE_UPDATED:
+      // updates to something added since the last read are part of the addition
+      state = exists && state == NetChange::ADDED ? NetChange::ADDED
+                                                  : NetChange::UPDATED;
+      break;
+  }
+}
+
+template <typename Key>
+void mergeInto(const std::map<Key, NetChange>& changes,
+               std::vector<Key>& added,
+               std::vector<Key>* updated,
+               std::vector<Key>& removed) {
+  std::vector<std::pair<Key, NetChange>> states(changes.begin(), changes.end());
+  for (auto& [key, state] : states) {
+    // still new to consumers that haven't seen the previous result yet
+    if (state == NetChange::UPDATED &&
+        std::binary_search(added.begin(), added.end(), key)) {
+      state = NetChange::ADDED;
+    }
+  }
+
+  // merged entries replace earlier results for the same key
+  const auto erase = [&](std::vector<Key>& vec) {
+    vec.erase(std::remove_if(vec.begin(),
+                             vec.end(),
+                             [&](const auto& key) { return changes.count(key); }),
+              vec.end());
+  };
+  erase(added);
+  erase(removed);
+  if (updated) {
+    erase(*updated);
+  }
+
+  for (const auto& [key, state] : states) {
+    switch (state) {
+      case NetChange::ADDED:
+        added.push_back(key);
+        break;
+      case NetChange::UPDATED:
+        updated->push_back(key);
+        break;
+      case NetChange::REMOVED:
+        removed.push_back(key);
+        break;
+    }
+  }
+
+  std::sort(added.begin(), added.end());
+  std::sort(removed.begin(), removed.end());
+  if (updated) {
+    std::sort(updated->begin(), updated->end());
+  }
+}
+
+}  // namespace
+
+void ChangeSet::merge(const std::vector<Change>& changes) {
+  std::map<NodeId, NetChange> nodes;
+  std::map<EdgeKey, NetChange> edges;
+  std::map<MeshEdge, NetChange> mesh_edges;
+  for (const auto& change : changes) {
+    if (change.isNode()) {
+      auto [iter, added] = nodes.emplace(change.source, NetChange::UPDATED);
+      apply(iter->second, change.type, !added);
+    } else if (change.isMeshEdge()) {
+      const MeshEdge key(change.source, change.target);
+      auto [iter, added] = mesh_edges.emplace(key, NetChange::UPDATED);
+      apply(iter->second, change.type, !added);
+    } else {
+      const EdgeKey key(change.source, change.target);
+      auto [iter, added] = edges.emplace(key, NetChange::UPDATED);
+      apply(iter->second, change.type, !added);
+    }
+  }
+
+  mergeInto(nodes, new_nodes, &updated_nodes, removed_nodes);
+  mergeInto(edges, new_edges, &updated_edges, removed_edges);
+  mergeInto<MeshEdge>(mesh_edges, new_mesh_edges, nullptr, removed_mesh_edges);
+}
+
+}  // namespace spark_dsg
@@ -34,10 +34,6 @@
  * -------------------------------------------------------------------------- */
 #include "spark_dsg/dynamic_scene_graph.h"
 
-#include <pcl/conversions.h>
-
-#include <list>
-
 #include "spark_dsg/edge_attributes.h"
 #include "spark_dsg/logging.h"
 
@@ -70,7 +66,10 @@ DynamicSceneGraph::DynamicSceneGraph(LayerId mesh_layer_id)
     : DynamicSceneGraph(getDefaultLayerIds(), mesh_layer_id) {}
 
 DynamicSceneGraph::DynamicSceneGraph(const LayerIds& layer_ids, LayerId mesh_layer_id)
-    : mesh_layer_id(mesh_layer_id), layer_ids(layer_ids), next_mesh_edge_idx_(0) {
+    : mesh_layer_id(mesh_layer_id), layer_ids(layer_ids) {
+  interlayer_edges_.journal = &interlayer_journal_;
+  dynamic_interlayer_edges_.journal = &interlayer_journal_;
+  mesh_edges_.setJournal(&interlayer_journal_);
   if (layer_ids.empty()) {
     throw std::domain_error("scene graph cannot be initialized without layers");
   }
@@ -83,6 +82,10 @@ DynamicSceneGraph::DynamicSceneGraph(const LayerIds& layer_ids, LayerId mesh_lay
 }
 
 void DynamicSceneGraph::clear() {
+  if (!layers_.empty()) {
+    ++generation_;  // invalidates existing change cursors (not when constructing)
+  }
+
   layers_.clear();
   dynamic_layers_.clear();
 
@@ -90,14 +93,17 @@ void DynamicSceneGraph::clear() {
 
   interlayer_edges_.reset();
   dynamic_interlayer_edges_.reset();
+  interlayer_journal_.clear();
 
-  mesh_vertices_.reset();
-  mesh_faces_.reset();
+  mesh_.reset();
+  mesh_blocks_ = MeshBlocks();
+  mesh_edges_.setNumVertices(0);
 
   clearMeshEdges();
 
   for (const auto& id : layer_ids) {
     layers_[id] = std::make_unique<SceneGraphLayer>(id);
+    layers_[id]->setJournalCapacity(journal_capacity_);
   }
 }
 
@@ -111,8 +117,9 @@ bool DynamicSceneGraph::createDynamicLayer(LayerId layer, LayerPrefix layer_pref
     dynamic_layers_[layer] = DynamicLayers();
   }
 
-  dynamic_layers_[layer].emplace(
-      layer_prefix, std::make_unique<DynamicSceneGraphLayer>(layer, layer_prefix));
+  auto new_layer = std::make_unique<DynamicSceneGraphLayer>(layer, layer_prefix);
+  new_layer->setJournalCapacity(journal_capacity_);
+  dynamic_layers_[layer].emplace(layer_prefix, std::move(new_layer));
   return true;
 }
 
@@ -226,8 +233,7 @@ bool DynamicSceneGraph::addOrUpdateNode(LayerId layer_id,
 
   auto iter = node_lookup_.find(node_id);
   if (iter != node_lookup_.end()) {
-    getNodePtr(node_id, iter->second)->attributes_ = std::move(attrs);
-    return true;
+    return setNodeAttributes(node_id, std::move(attrs));
   }
 
   const bool successful = layers_[layer_id]->emplaceNode(node_id, std::move(attrs));
@@ -238,6 +244,31 @@ bool DynamicSceneGraph::addOrUpdateNode(LayerId layer_id,
   return successful;
 }
 
+bool DynamicSceneGraph::reserveNodes(LayerId layer_id, size_t num_nodes) {
+  auto iter = layers_.find(layer_id);
+  if (iter == layers_.end()) {
+    return false;
+  }
+
+  auto& nodes = iter->second->nodes_;
+  nodes.reserve(nodes.size() + num_nodes);
+  node_lookup_.reserve(node_lookup_.size() + num_nodes);
+  return true;
+}
+
+void DynamicSceneGraph::reserveEdges(const std::vector<EdgeKey>& edges) {
+  std::map<EdgeContainer*, size_t> num_new_edges;
+  for (const auto& edge : edges) {
+    if (node_lookup_.count(edge.k1) && node_lookup_.count(edge.k2)) {
+      ++num_new_edges[&edgeContainer(edge.k1, edge.k2)];
+    }
+  }
+
+  for (const auto& [container, num_edges] : num_new_edges) {
+    container->edges.reserve(container->edges.size() + num_edges);
+  }
+}
+
 bool DynamicSceneGraph::insertEdge(NodeId source,
                                    NodeId target,
                                    EdgeAttributes::Ptr&& edge_info,
@@ -291,10 +322,66 @@ bool DynamicSceneGraph::setNodeAttributes(NodeId node, NodeAttributes::Ptr&& att
     return false;
   }
 
+  if (!iter->second.dynamic) {
+    // static layers keep their position cache in sync
+    return layers_.at(iter->second.layer)->setNodeAttributes(node, std::move(attrs));
+  }
+
   getNodePtr(node, iter->second)->attributes_ = std::move(attrs);
+  layerFromKey(iter->second).journal_.recordNode(ChangeType::NODE_UPDATED, node);
+  return true;
+}
+
+bool DynamicSceneGraph::markNodeUpdated(NodeId node) {
+  auto iter = node_lookup_.find(node);
+  if (iter == node_lookup_.end()) {
+    return false;
+  }
+
+  auto& layer = layerFromKey(iter->second);
+  layer.journal_.recordNode(ChangeType::NODE_UPDATED, node);
+  if (!iter->second.dynamic) {
+    layers_.at(iter->second.layer)->refreshPosition(node);
+  }
+
+  return true;
+}
+
+bool DynamicSceneGraph::enablePositionCache(LayerId layer_id, bool enable) {
+  auto iter = layers_.find(layer_id);
+  if (iter == layers_.end()) {
+    return false;
+  }
+
+  iter->second->enablePositionCache(enable);
   return true;
 }
 
+bool DynamicSceneGraph::enableSpatialIndex(LayerId layer_id,
+                                           bool enable,
+                                           double cell_size) {
+  auto iter = layers_.find(layer_id);
+  if (iter == layers_.end()) {
+    return false;
+  }
+
+  iter->second->enableSpatialIndex(enable, cell_size);
+  return true;
+}
+
+bool DynamicSceneGraph::refreshPosition(NodeId node) {
+  auto iter = node_lookup_.find(node);
+  if (iter == node_lookup_.end()) {
+    return false;
+  }
+
+  if (iter->second.dynamic) {
+    return true;  // dynamic layers don't cache positions
+  }
+
+  return layers_.at(iter->second.layer)->refreshPosition(node);
+}
+
 bool DynamicSceneGraph::setEdgeAttributes(NodeId source,
                                           NodeId target,
                                           EdgeAttributes::Ptr&& attrs) {
@@ -302,21 +389,31 @@ bool DynamicSceneGraph::setEdgeAttributes(NodeId source,
     return false;
   }
 
+  edgeContainer(source, target).update(source, target, std::move(attrs));
+  return true;
+}
+
+bool DynamicSceneGraph::markEdgeUpdated(NodeId source, NodeId target) {
+  if (!hasEdge(source, target)) {
+    return false;
+  }
+
+  edgeContainer(source, target).markUpdated(source, target);
+  return true;
+}
+
+EdgeContainer& DynamicSceneGraph::edgeContainer(NodeId source, NodeId target) {
   // defer to layers if it is a intralayer edge
   const auto& source_key = node_lookup_.at(source);
   const auto& target_key = node_lookup_.at(target);
   if (source_key == target_key) {
-    layerFromKey(source_key).edgeContainer().get(source, target).info =
-        std::move(attrs);
-    return true;
+    return layerFromKey(source_key).edgeContainer();
   }
 
   if (source_key.dynamic || target_key.dynamic) {
-    dynamic_interlayer_edges_.get(source, target).info = std::move(attrs);
-    return true;
+    return dynamic_interlayer_edges_;
   } else {
-    interlayer_edges_.get(source, target).info = std::move(attrs);
-    return true;
+    return interlayer_edges_;
   }
 }
 
@@ -507,7 +604,7 @@ size_t DynamicSceneGraph::numDynamicLayers() const {
 
 size_t DynamicSceneGraph::numNodes(bool include_mesh) const {
   return numStaticNodes() + numDynamicNodes() +
-         ((mesh_vertices_ == nullptr || !include_mesh) ? 0 : mesh_vertices_->size());
+         ((mesh_ == nullptr || !include_mesh) ? 0 : mesh_->numVertices());
 }
 
 size_t DynamicSceneGraph::numStaticNodes() const {
@@ -573,101 +670,163 @@ Eigen::Vector3d DynamicSceneGraph::getPosition(NodeId node) const {
 }
 
 void DynamicSceneGraph::initMesh() {
-  DynamicSceneGraph::MeshVertices fake_vertices;
-  pcl::PolygonMesh fake_mesh;
-  pcl::toPCLPointCloud2(fake_vertices, fake_mesh.cloud);
+  mesh_ = std::make_shared<Mesh>();
+  mesh_blocks_ = MeshBlocks();
+}
 
-  setMeshDirectly(fake_mesh);
+void DynamicSceneGraph::setMesh(const Mesh::Ptr& mesh, bool invalidate_all_edges) {
+  // vertices and faces set directly don't belong to any block
+  setMesh(mesh,
+          mesh ? MeshBlocks(mesh->numVertices(), mesh->numFaces()) : MeshBlocks(),
+          invalidate_all_edges);
 }
 
-void DynamicSceneGraph::setMesh(const MeshVertices::Ptr& vertices,
-                                const std::shared_ptr<MeshFaces>& faces,
+void DynamicSceneGraph::setMesh(const Mesh::Ptr& mesh,
+                                const MeshBlocks& blocks,
                                 bool invalidate_all_edges) {
-  if (!vertices) {
+  if (!mesh) {
     SG_LOG(INFO) << "received empty mesh. resetting all mesh edges" << std::endl;
-    mesh_vertices_.reset();
-    mesh_faces_.reset();
+    mesh_.reset();
+    mesh_blocks_ = MeshBlocks();
     clearMeshEdges();
+    mesh_edges_.setNumVertices(0);
     return;
   }
 
-  mesh_faces_ = faces;
-  mesh_vertices_ = vertices;
+  mesh_ = mesh;
+  mesh_blocks_ = blocks;
+  mesh_edges_.setNumVertices(mesh_->numVertices());
 
   if (invalidate_all_edges) {
     clearMeshEdges();
     return;
   }
 
-  size_t max_vertex = mesh_vertices_->size();
-  std::list<MeshEdge> invalid_edges;
-  for (const auto& vertex_map_pair : mesh_edges_vertex_lookup_) {
-    const size_t vertex_id = vertex_map_pair.first;
-    if (vertex_id < max_vertex) {
-      continue;
-    }
+  mesh_edges_.eraseVertices(mesh_->numVertices());
+}
 
-    for (const auto& node_edge_pair : mesh_edges_vertex_lookup_.at(vertex_id)) {
-      invalid_edges.push_back(mesh_edges_.at(node_edge_pair.second));
-    }
+void DynamicSceneGraph::setMesh(const MeshVertices::Ptr& vertices,
+                                const std::shared_ptr<MeshFaces>& faces,
+                                bool invalidate_all_edges) {
+  if (!vertices) {
+    setMesh(Mesh::Ptr(), invalidate_all_edges);
+    return;
   }
 
-  for (const auto edge : invalid_edges) {
-    removeMeshEdge(edge.source_node, edge.mesh_vertex);
-  }
+  setMesh(std::make_shared<Mesh>(Mesh::fromPcl(*vertices, faces.get())),
+          invalidate_all_edges);
 }
 
 void DynamicSceneGraph::setMeshDirectly(const pcl::PolygonMesh& mesh) {
-  mesh_vertices_.reset(new MeshVertices());
-  pcl::fromPCLPointCloud2(mesh.cloud, *mesh_vertices_);
+  mesh_ = std::make_shared<Mesh>(Mesh::fromPcl(mesh));
+  mesh_blocks_ = MeshBlocks(mesh_->numVertices(), mesh_->numFaces());
+  mesh_edges_.setNumVertices(mesh_->numVertices());
+}
+
+uint64_t DynamicSceneGraph::upsertMeshBlock(const MeshBlocks::Index& index,
+                                            const Mesh& block) {
+  const auto previous = mesh_blocks_.getBlock(index);
+  const auto info = mesh_blocks_.upsert(writableMesh(), index, block);
+  mesh_edges_.setNumVertices(mesh_->numVertices());
+  if (previous) {
+    remapMeshEdges(*previous, &info);
+  }
 
-  mesh_faces_.reset(new MeshFaces(mesh.polygons.begin(), mesh.polygons.end()));
+  return info.version;
 }
 
-bool DynamicSceneGraph::hasMesh() const {
-  return mesh_vertices_ != nullptr && mesh_faces_ != nullptr;
+bool DynamicSceneGraph::removeMeshBlock(const MeshBlocks::Index& index) {
+  if (!mesh_ || !mesh_blocks_.getBlock(index)) {
+    return false;
+  }
+
+  const auto previous = mesh_blocks_.remove(writableMesh(), index);
+  mesh_edges_.setNumVertices(mesh_->numVertices());
+  remapMeshEdges(*previous, nullptr);
+  return true;
 }
 
-bool DynamicSceneGraph::isMeshEmpty() const {
-  if (!hasMesh()) {
-    return true;
+Mesh& DynamicSceneGraph::writableMesh() {
+  if (!mesh_) {
+    initMesh();
+  } else if (mesh_.use_count() > 1) {
+    mesh_ = std::make_shared<Mesh>(*mesh_);
+  }
+
+  return *mesh_;
+}
+
+void DynamicSceneGraph::remapMeshEdges(const MeshBlockInfo& previous,
+                                       const MeshBlockInfo* current) {
+  const auto begin = previous.vertex_offset;
+  const auto end = begin + previous.vertex_capacity;
+  if (current && current->vertex_offset == begin) {
+    // vertices didn't move
+    mesh_edges_.eraseVertices(begin + current->num_vertices, end);
+    return;
+  }
+
+  // remove everything before inserting in case the old and new ranges overlap
+  auto edges = mesh_edges_.edgesInRange(begin, end);
+  mesh_edges_.eraseVertices(begin, end);
+  if (!current) {
+    return;
   }
 
-  return mesh_vertices_->empty() && mesh_faces_->empty();
+  MeshEdges moved;
+  for (const auto& edge : edges) {
+    const auto local_vertex = edge.mesh_vertex - begin;
+    if (local_vertex < current->num_vertices) {
+      moved.emplace_back(edge.source_node, current->vertex_offset + local_vertex);
+    }
+  }
+
+  mesh_edges_.insert(std::move(moved));
 }
 
+bool DynamicSceneGraph::hasMesh() const { return mesh_ != nullptr; }
+
+bool DynamicSceneGraph::isMeshEmpty() const { return !mesh_ || mesh_->empty(); }
+
 pcl::PolygonMesh DynamicSceneGraph::getMesh() const {
-  pcl::PolygonMesh mesh;
-  pcl::toPCLPointCloud2(*mesh_vertices_, mesh.cloud);
-  mesh.polygons = *mesh_faces_;
-  return mesh;
-};
+  if (!mesh_) {
+    return pcl::PolygonMesh();
+  }
 
-MeshVertices::Ptr DynamicSceneGraph::getMeshVertices() const { return mesh_vertices_; }
+  return mesh_blocks_.empty() ? mesh_->toPcl() : mesh_blocks_.exportMesh(*mesh_).toPcl();
+}
+
+MeshVertices::Ptr DynamicSceneGraph::getMeshVertices() const {
+  return mesh_ ? mesh_->toPclVertices() : nullptr;
+}
 
 std::shared_ptr<MeshFaces> DynamicSceneGraph::getMeshFaces() const {
-  return mesh_faces_;
+  if (!mesh_) {
+    return nullptr;
+  }
+
+  return mesh_blocks_.empty() ? mesh_->toPclFaces()
+                              : mesh_blocks_.exportMesh(*mesh_).toPclFaces();
 }
 
 std::optional<Eigen::Vector3d> DynamicSceneGraph::getMeshPosition(
     size_t idx, bool check_invalid) const {
-  if (!mesh_vertices_) {
+  if (!mesh_) {
     return std::nullopt;
   }
 
-  if (idx >= mesh_vertices_->size()) {
+  if (idx >= mesh_->numVertices()) {
     return std::nullopt;
   }
 
-  const pcl::PointXYZRGBA& point = mesh_vertices_->at(idx);
+  const auto point = mesh_->pos(idx);
 
   // TODO(nathan) this is awkward, but probably fine in the short term
-  if (check_invalid && point.x == 0.0f && point.y == 0.0f && point.z == 0.0f) {
+  if (check_invalid && point.x() == 0.0f && point.y() == 0.0f && point.z() == 0.0f) {
     return std::nullopt;
   }
 
-  Eigen::Vector3d pos(point.x, point.y, point.z);
-  return pos;
+  return point.cast<double>();
 }
 
 bool DynamicSceneGraph::insertMeshEdge(NodeId source,
@@ -678,7 +837,7 @@ bool DynamicSceneGraph::insertMeshEdge(NodeId source,
   }
 
   if (!allow_invalid_mesh) {
-    if (!mesh_vertices_ || mesh_vertex >= mesh_vertices_->size()) {
+    if (!mesh_ || mesh_vertex >= mesh_->numVertices()) {
       return false;
     }
   }
@@ -687,83 +846,46 @@ bool DynamicSceneGraph::insertMeshEdge(NodeId source,
     return false;
   }
 
-  mesh_edges_.emplace(std::piecewise_construct,
-                      std::forward_as_tuple(next_mesh_edge_idx_),
-                      std::forward_as_tuple(source, mesh_vertex));
-  mesh_edges_node_lookup_[source][mesh_vertex] = next_mesh_edge_idx_;
-  mesh_edges_vertex_lookup_[mesh_vertex][source] = next_mesh_edge_idx_;
-  next_mesh_edge_idx_++;
-  return true;
+  return mesh_edges_.insert(source, mesh_vertex);
 }
 
-bool DynamicSceneGraph::hasMeshEdge(NodeId source, size_t mesh_vertex) const {
-  if (!mesh_edges_node_lookup_.count(source)) {
-    return false;
-  }
+size_t DynamicSceneGraph::insertMeshEdges(const MeshEdges& edges,
+                                          bool allow_invalid_mesh) {
+  const size_t num_vertices = mesh_ ? mesh_->numVertices() : 0;
+  MeshEdges valid_edges;
+  valid_edges.reserve(edges.size());
+  for (const auto& edge : edges) {
+    if (!allow_invalid_mesh && edge.mesh_vertex >= num_vertices) {
+      continue;
+    }
 
-  if (!mesh_edges_node_lookup_.at(source).count(mesh_vertex)) {
-    return false;
+    if (hasNode(edge.source_node)) {
+      valid_edges.push_back(edge);
+    }
   }
 
-  return true;
+  return mesh_edges_.insert(std::move(valid_edges));
 }
 
-const MeshEdges& DynamicSceneGraph::getMeshEdges() const { return mesh_edges_; }
-
-std::vector<size_t> DynamicSceneGraph::getMeshConnectionIndices(NodeId node) const {
-  std::vector<size_t> to_return;
-  if (!mesh_edges_node_lookup_.count(node)) {
-    return to_return;
-  }
+bool DynamicSceneGraph::hasMeshEdge(NodeId source, size_t mesh_vertex) const {
+  return mesh_edges_.contains(source, mesh_vertex);
+}
 
-  for (const auto& id_edge_pair : mesh_edges_node_lookup_.at(node)) {
-    to_return.push_back(id_edge_pair.first);
-  }
+const MeshEdges& DynamicSceneGraph::getMeshEdges() const { return mesh_edges_.edges(); }
 
-  return to_return;
+std::vector<size_t> DynamicSceneGraph::getMeshConnectionIndices(NodeId node) const {
+  return mesh_edges_.vertices(node);
 }
 
 bool DynamicSceneGraph::removeMeshEdge(NodeId source, size_t mesh_vertex) {
-  if (!hasMeshEdge(source, mesh_vertex)) {
-    return false;
-  }
-
-  mesh_edges_.erase(mesh_edges_node_lookup_.at(source).at(mesh_vertex));
-
-  mesh_edges_node_lookup_.at(source).erase(mesh_vertex);
-  if (mesh_edges_node_lookup_.at(source).empty()) {
-    mesh_edges_node_lookup_.erase(source);
-  }
-
-  mesh_edges_vertex_lookup_.at(mesh_vertex).erase(source);
-  if (mesh_edges_vertex_lookup_.at(mesh_vertex).empty()) {
-    mesh_edges_vertex_lookup_.erase(mesh_vertex);
-  }
-
-  next_mesh_edge_idx_++;
-  return true;
+  return mesh_edges_.erase(source, mesh_vertex);
 }
 
 void DynamicSceneGraph::invalidateMeshVertex(size_t index) {
-  if (!mesh_edges_vertex_lookup_.count(index)) {
-    return;
-  }
-
-  std::list<NodeId> nodes;
-  for (const auto& node_edge_pair : mesh_edges_vertex_lookup_[index]) {
-    nodes.push_back(node_edge_pair.first);
-  }
-
-  for (const auto& node : nodes) {
-    removeMeshEdge(node, index);
-  }
+  mesh_edges_.eraseVertices(index, index + 1);
 }
 
-void DynamicSceneGraph::clearMeshEdges() {
-  mesh_edges_.clear();
-  mesh_edges_node_lookup_.clear();
-  mesh_edges_vertex_lookup_.clear();
-}
+void DynamicSceneGraph::clearMeshEdges() { mesh_edges_.clear(); }
 
 bool DynamicSceneGraph::mergeNodes(NodeId node_from, NodeId node_to) {
   if (!hasNode(node_from) || !hasNode(node_to)) {
@@ -780,7 +902,7 @@ bool DynamicSceneGraph::mergeNodes(NodeId node_from, NodeId node_to) {
     return false;  // Cannot merge nodes of different layers
   }
 
-  Node* node = layers_[info.layer]->nodes_.at(node_from).get();
+  Node* node = &layers_[info.layer]->nodes_.at(node_from);
 
   // Remove parent
   if (node->hasParent()) {
@@ -793,15 +915,14 @@ bool DynamicSceneGraph::mergeNodes(NodeId node_from, NodeId node_to) {
     rewireInterlayerEdge(node_from, node_to, target);
   }
 
-  auto edge_iter = mesh_edges_node_lookup_.find(node_from);
-  if (edge_iter != mesh_edges_node_lookup_.end()) {
-    for (const auto& id_edge_pair : edge_iter->second) {
-      // we always assume that a mesh edge can be invalid (as it was alread added)
-      insertMeshEdge(node_to, id_edge_pair.first, true);
-    }
+  // we always assume that a mesh edge can be invalid (as it was alread added)
+  MeshEdges merged_edges;
+  for (const auto vertex : mesh_edges_.vertices(node_from)) {
+    merged_edges.emplace_back(node_to, vertex);
   }
 
   clearMeshEdgesForNode(node_from);
+  insertMeshEdges(merged_edges, true);
 
   // TODO(nathan) dynamic merge
   layers_[info.layer]->mergeNodes(node_from, node_to);
@@ -821,13 +942,15 @@ bool DynamicSceneGraph::updateFromLayer(SceneGraphLayer& other_layer,
   for (auto& id_node_pair : other_layer.nodes_) {
     if (internal_layer.hasNode(id_node_pair.first)) {
       // just copy the attributes (prior edge information should be preserved)
-      internal_layer.nodes_[id_node_pair.first]->attributes_ =
-          std::move(id_node_pair.second->attributes_);
+      internal_layer.setNodeAttributes(id_node_pair.first,
+                                       std::move(id_node_pair.second->attributes_));
     } else {
       // we need to let the scene graph know about new nodes
       node_lookup_[id_node_pair.first] = internal_layer.id;
-      internal_layer.nodes_[id_node_pair.first] = std::move(id_node_pair.second);
+      internal_layer.nodes_.insert(std::move(*id_node_pair.second));
       internal_layer.nodes_status_[id_node_pair.first] = NodeStatus::NEW;
+      internal_layer.journal_.recordNode(ChangeType::NODE_ADDED, id_node_pair.first);
+      internal_layer.refreshPosition(id_node_pair.first);
     }
   }
 
@@ -838,10 +961,10 @@ bool DynamicSceneGraph::updateFromLayer(SceneGraphLayer& other_layer,
     return true;
   }
 
-  for (auto& id_edge_pair : *edges) {
-    auto& edge = id_edge_pair.second;
+  for (const auto& id_edge_pair : *edges) {
+    auto& edge = *id_edge_pair.second;
     if (internal_layer.hasEdge(edge.source, edge.target)) {
-      internal_layer.edges_.edges.at(id_edge_pair.first).info = std::move(edge.info);
+      internal_layer.edges_.update(edge.source, edge.target, std::move(edge.info));
       continue;
     }
 
@@ -900,7 +1023,7 @@ bool DynamicSceneGraph::mergeGraph(const DynamicSceneGraph& other,
   }
 
   for (const auto& id_edge_pair : other.interlayer_edges()) {
-    const auto& edge = id_edge_pair.second;
+    const auto& edge = *id_edge_pair.second;
     NodeId new_source = getMergedId(edge.source, previous_merges);
     NodeId new_target = getMergedId(edge.target, previous_merges);
     if (new_source == new_target) {
@@ -911,7 +1034,7 @@ bool DynamicSceneGraph::mergeGraph(const DynamicSceneGraph& other,
   }
 
   for (const auto& id_edge_pair : other.dynamic_interlayer_edges()) {
-    const auto& edge = id_edge_pair.second;
+    const auto& edge = *id_edge_pair.second;
     NodeId new_source = getMergedId(edge.source, previous_merges);
     NodeId new_target = getMergedId(edge.target, previous_merges);
     if (new_source == new_target) {
@@ -930,11 +1053,7 @@ bool DynamicSceneGraph::mergeGraph(const DynamicSceneGraph& other,
   }
 
   // TODO(nathan) this doesn't handle merges
-  for (const auto& id_mesh_edge : other.mesh_edges_) {
-    insertMeshEdge(id_mesh_edge.second.source_node,
-                   id_mesh_edge.second.mesh_vertex,
-                   allow_invalid_mesh);
-  }
+  insertMeshEdges(other.getMeshEdges(), allow_invalid_mesh);
 
   // TODO(Yun) check the other mesh info (faces, vertices etc. )
   return true;
@@ -993,6 +1112,76 @@ std::vector<EdgeKey> DynamicSceneGraph::getNewEdges(bool clear_new) {
   return to_return;
 }
 
+void DynamicSceneGraph::setJournalCapacity(size_t capacity) {
+  applyJournalCapacity(capacity);
+}
+
+void DynamicSceneGraph::applyJournalCapacity(size_t capacity) const {
+  journal_capacity_ = capacity;
+  interlayer_journal_.setCapacity(capacity);
+  for (const auto& [layer_id, layer] : layers_) {
+    layer->setJournalCapacity(capacity);
+  }
+
+  for (const auto& [layer_id, layers] : dynamic_layers_) {
+    for (const auto& [prefix, layer] : layers) {
+      layer->setJournalCapacity(capacity);
+    }
+  }
+}
+
+DynamicSceneGraph::ChangeCursor DynamicSceneGraph::getChangeCursor() const {
+  if (!journal_capacity_) {
+    applyJournalCapacity(ChangeJournal::DEFAULT_CAPACITY);
+  }
+
+  ChangeCursor cursor;
+  cursor.generation = generation_;
+  cursor.interlayer = interlayer_journal_.end();
+  for (const auto& [layer_id, layer] : layers_) {
+    cursor.layers[layer_id] = layer->journal().end();
+  }
+
+  for (const auto& [layer_id, layers] : dynamic_layers_) {
+    for (const auto& [prefix, layer] : layers) {
+      cursor.dynamic_layers[layer_id][prefix] = layer->journal().end();
+    }
+  }
+
+  return cursor;
+}
+
+ChangeSet DynamicSceneGraph::getChangesSince(const ChangeCursor& epoch) const {
+  ChangeCursor cursor = epoch;
+  return getChanges(cursor);
+}
+
+ChangeSet DynamicSceneGraph::getChanges(ChangeCursor& cursor) const {
+  ChangeSet result;
+  if (cursor.generation != generation_) {
+    // journals were replaced when the graph was cleared
+    result.complete = false;
+    cursor = ChangeCursor();
+    cursor.generation = generation_;
+  }
+
+  std::vector<Change> changes;
+  for (const auto& [layer_id, layer] : layers_) {
+    result.complete &= layer->journal().read(cursor.layers[layer_id], changes);
+  }
+
+  for (const auto& [layer_id, layers] : dynamic_layers_) {
+    auto& layer_cursors = cursor.dynamic_layers[layer_id];
+    for (const auto& [prefix, layer] : layers) {
+      result.complete &= layer->journal().read(layer_cursors[prefix], changes);
+    }
+  }
+
+  result.complete &= interlayer_journal_.read(cursor.interlayer, changes);
+  result.merge(changes);
+  return result;
+}
+
 void DynamicSceneGraph::markEdgesAsStale() {
   for (auto& id_layer_pair : layers_) {
     id_layer_pair.second->edges_.setStale();
@@ -1045,7 +1234,7 @@ DynamicSceneGraph::Ptr DynamicSceneGraph::clone() const {
 
   for (const auto& id_layer_pair : layers_) {
     for (const auto& id_edge_pair : id_layer_pair.second->edges()) {
-      const auto& edge = id_edge_pair.second;
+      const auto& edge = *id_edge_pair.second;
       to_return->insertEdge(edge.source, edge.target, edge.info->clone());
     }
   }
@@ -1053,34 +1242,29 @@ DynamicSceneGraph::Ptr DynamicSceneGraph::clone() const {
   for (const auto& id_layer_group : dynamic_layers_) {
     for (const auto& prefix_layer_pair : id_layer_group.second) {
       for (const auto& id_edge_pair : prefix_layer_pair.second->edges()) {
-        const auto& edge = id_edge_pair.second;
+        const auto& edge = *id_edge_pair.second;
         to_return->insertEdge(edge.source, edge.target, edge.info->clone());
       }
     }
   }
 
   for (const auto& id_edge_pair : interlayer_edges()) {
-    const auto& edge = id_edge_pair.second;
+    const auto& edge = *id_edge_pair.second;
     to_return->insertEdge(edge.source, edge.target, edge.info->clone());
   }
 
   for (const auto& id_edge_pair : dynamic_interlayer_edges()) {
-    const auto& edge = id_edge_pair.second;
+    const auto& edge = *id_edge_pair.second;
     to_return->insertEdge(edge.source, edge.target, edge.info->clone());
   }
 
-  if (mesh_vertices_) {
-    to_return->mesh_vertices_.reset(new MeshVertices(*mesh_vertices_));
-  }
-  if (mesh_faces_) {
-    to_return->mesh_faces_ = std::make_shared<MeshFaces>(*mesh_faces_);
-  }
-
-  for (const auto& id_edge_pair : mesh_edges_) {
-    const auto& edge = id_edge_pair.second;
-    to_return->insertMeshEdge(edge.source_node, edge.mesh_vertex, true);
-  }
+  // the mesh is copied on the first write to either graph (see writableMesh)
+  to_return->mesh_ = mesh_;
+  to_return->mesh_blocks_ = mesh_blocks_;
 
+  // every node was copied, so the edges are still valid
+  to_return->mesh_edges_ = mesh_edges_;
+  to_return->mesh_edges_.setJournal(&to_return->interlayer_journal_);
   return to_return;
 }
 
@@ -1102,7 +1286,7 @@ SceneGraphNode* DynamicSceneGraph::getNodePtr(NodeId node, const LayerKey& info)
     const auto idx = NodeSymbol(node).categoryId();
     return dynamic_layers_.at(info.layer).at(info.prefix)->nodes_.at(idx).get();
   } else {
-    return layers_.at(info.layer)->nodes_.at(node).get();
+    return &layers_.at(info.layer)->nodes_.at(node);
   }
 }
 
@@ -1265,24 +1449,15 @@ void DynamicSceneGraph::rewireInterlayerEdge(NodeId source,
 }
 
 void DynamicSceneGraph::removeStaleEdges(EdgeContainer& edges) {
-  for (const auto& edge_key_pair : edges.stale_edges) {
-    if (edge_key_pair.second) {
-      removeEdge(edge_key_pair.first.k1, edge_key_pair.first.k2);
-    }
+  std::vector<EdgeKey> stale_edges;
+  edges.getStale(stale_edges);
+  for (const auto& key : stale_edges) {
+    removeEdge(key.k1, key.k2);
   }
 }
 
 void DynamicSceneGraph::clearMeshEdgesForNode(NodeId node_id) {
-  if (mesh_edges_node_lookup_.count(node_id)) {
-    std::list<size_t> mesh_edge_targets_to_remove;
-    for (const auto& vertex_edge_pair : mesh_edges_node_lookup_.at(node_id)) {
-      mesh_edge_targets_to_remove.push_back(vertex_edge_pair.first);
-    }
-
-    for (const auto& vertex : mesh_edge_targets_to_remove) {
-      removeMeshEdge(node_id, vertex);
-    }
-  }
+  mesh_edges_.eraseNode(node_id);
 }
 
 void DynamicSceneGraph::visitLayers(const LayerVisitor& cb) {
@@ -43,10 +43,12 @@ using EdgeRef = DynamicSceneGraphLayer::EdgeRef;
 using NodeRef = DynamicSceneGraphLayer::NodeRef;
 
 DynamicSceneGraphLayer::DynamicSceneGraphLayer(LayerId layer, LayerPrefix node_prefix)
-    : id(layer), prefix(node_prefix), next_node_(0) {}
+    : id(layer), prefix(node_prefix), next_node_(0) {
+  edges_.journal = &journal_;
+}
 
 bool DynamicSceneGraphLayer::mergeLayer(const DynamicSceneGraphLayer& other,
-                                        std::map<NodeId, LayerKey>* layer_lookup,
+                                        NodeLookup* layer_lookup,
                                         bool update_attributes) {
   LayerKey layer_key{id, prefix};
   Eigen::Vector3d last_update_delta = Eigen::Vector3d::Zero();
@@ -65,6 +67,7 @@ bool DynamicSceneGraphLayer::mergeLayer(const DynamicSceneGraphLayer& other,
       // Update node attributes (except for position)
       nodes_[i]->attributes_ = other_node.attributes_->clone();
       nodes_[i]->attributes_->position = node_position;
+      journal_.recordNode(ChangeType::NODE_UPDATED, nodes_[i]->id);
     } else {
       emplaceNode(other_node.timestamp, other_node.attributes_->clone(), false);
       nodes_.back()->attributes_->position += last_update_delta;
@@ -75,7 +78,7 @@ bool DynamicSceneGraphLayer::mergeLayer(const DynamicSceneGraphLayer& other,
   }
 
   for (const auto& id_edge_pair : other.edges()) {
-    const auto& edge = id_edge_pair.second;
+    const auto& edge = *id_edge_pair.second;
     if (hasEdge(edge.source, edge.target)) {
       // TODO(nathan) clone attributes
       continue;
@@ -98,6 +101,7 @@ bool DynamicSceneGraphLayer::emplaceNode(std::chrono::nanoseconds stamp,
   times_.insert(stamp.count());
   nodes_.emplace_back(std::make_unique<Node>(new_id, id, std::move(attrs), stamp));
   node_status_[nodes_.size() - 1] = NodeStatus::NEW;
+  journal_.recordNode(ChangeType::NODE_ADDED, new_id);
 
   // TODO(nathan) track newest time and don't add edge if node is older than that.
   // TODO(nathan) handle incorrect time ordering better
@@ -129,6 +133,7 @@ bool DynamicSceneGraphLayer::emplaceNodeAtIndex(std::chrono::nanoseconds stamp,
   times_.insert(stamp.count());
   nodes_[index] = std::make_unique<Node>(new_id, id, std::move(attrs), stamp);
   node_status_[index] = NodeStatus::NEW;
+  journal_.recordNode(ChangeType::NODE_ADDED, new_id);
   return true;
 }
 
@@ -268,6 +273,7 @@ bool DynamicSceneGraphLayer::removeNode(NodeId node) {
 
   // TODO(nathan) this is slightly brittle, maybe consider std::map instead
   node_status_[index] = NodeStatus::DELETED;
+  journal_.recordNode(ChangeType::NODE_REMOVED, node);
   times_.erase(nodes_.at(index)->timestamp.count());
   nodes_[index].reset();
   return true;
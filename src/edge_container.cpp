@@ -34,6 +34,11 @@
  * -------------------------------------------------------------------------- */
 #include "spark_dsg/edge_container.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+#include "spark_dsg/change_journal.h"
+
 namespace spark_dsg {
 
 SceneGraphEdge::SceneGraphEdge(NodeId source, NodeId target, AttrPtr&& info)
@@ -43,31 +48,131 @@ SceneGraphEdge::~SceneGraphEdge() = default;
 
 using Edge = EdgeContainer::Edge;
 
+Edge& EdgeStore::at(const EdgeKey& key) const {
+  auto edge = find(key);
+  if (!edge) {
+    throw std::out_of_range("edge does not exist");
+  }
+
+  return *edge;
+}
+
+std::pair<Edge*, bool> EdgeStore::emplace(NodeId source,
+                                          NodeId target,
+                                          EdgeAttributes::Ptr&& attrs) {
+  auto& entry = table_[EdgeKey(source, target)];
+  if (entry.record) {
+    return {&entry.record->edge, false};
+  }
+
+  if (!attrs) {
+    attrs = std::make_unique<EdgeAttributes>();
+  }
+
+  entry.record = std::make_unique<Record>(source, target, std::move(attrs), epoch_);
+  entry.status = EdgeStatus::NEW;
+  link(entry.record.get());
+  ++num_edges_;
+  return {&entry.record->edge, true};
+}
+
+std::vector<EdgeStore::value_type> EdgeStore::sorted() const {
+  std::vector<value_type> result(begin(), end());
+  std::sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.first < rhs.first;
+  });
+  return result;
+}
+
+void EdgeStore::swap(EdgeStore& other) noexcept {
+  table_.swap(other.table_);
+  std::swap(num_edges_, other.num_edges_);
+  std::swap(epoch_, other.epoch_);
+  std::swap(head_, other.head_);
+  std::swap(tail_, other.tail_);
+}
+
+void EdgeStore::link(Record* record) const {
+  record->prev = tail_;
+  record->next = nullptr;
+  if (tail_) {
+    tail_->next = record;
+  } else {
+    head_ = record;
+  }
+
+  tail_ = record;
+}
+
+void EdgeStore::unlink(Record* record) const {
+  if (record->prev) {
+    record->prev->next = record->next;
+  } else {
+    head_ = record->next;
+  }
+
+  if (record->next) {
+    record->next->prev = record->prev;
+  } else {
+    tail_ = record->prev;
+  }
+
+  record->prev = nullptr;
+  record->next = nullptr;
+}
+
 void EdgeContainer::insert(NodeId source,
                            NodeId target,
                            EdgeAttributes::Ptr&& edge_info) {
-  auto attrs = (edge_info == nullptr) ? std::make_unique<EdgeAttributes>()
-                                      : std::move(edge_info);
-
-  edges.emplace(std::piecewise_construct,
-                std::forward_as_tuple(source, target),
-                std::forward_as_tuple(source, target, std::move(attrs)));
-  edge_status[EdgeKey(source, target)] = EdgeStatus::NEW;
+  const auto [edge, added] = edges.emplace(source, target, std::move(edge_info));
+  if (!added) {
+    edges.table_.at(EdgeKey(source, target)).status = EdgeStatus::NEW;
+  } else if (journal) {
+    journal->recordEdge(ChangeType::EDGE_ADDED, source, target);
+  }
 }
 
 void EdgeContainer::remove(NodeId source, NodeId target) {
-  const EdgeKey key(source, target);
-  edge_status.at(key) = EdgeStatus::DELETED;
-  edges.erase(key);
+  auto& entry = edges.table_.at(EdgeKey(source, target));
+  entry.status = EdgeStatus::DELETED;
+  if (entry.record) {
+    edges.unlink(entry.record.get());
+    entry.record.reset();
+    --edges.num_edges_;
+    if (journal) {
+      journal->recordEdge(ChangeType::EDGE_REMOVED, source, target);
+    }
+  }
+}
+
+void EdgeContainer::update(NodeId source,
+                           NodeId target,
+                           EdgeAttributes::Ptr&& edge_info) {
+  get(source, target).info = std::move(edge_info);
+  markUpdated(source, target);
+}
+
+void EdgeContainer::markUpdated(NodeId source, NodeId target) {
+  if (journal) {
+    journal->recordEdge(ChangeType::EDGE_UPDATED, source, target);
+  }
 }
 
 bool EdgeContainer::contains(NodeId source, NodeId target) const {
-  return edges.count(EdgeKey(source, target));
+  return edges.contains(EdgeKey(source, target));
 }
 
 void EdgeContainer::reset() {
-  edges.clear();
-  edge_status.clear();
+  if (journal) {
+    for (const auto& [key, edge] : edges) {
+      journal->recordEdge(ChangeType::EDGE_REMOVED, key.k1, key.k2);
+    }
+  }
+
+  edges.table_.clear();
+  edges.num_edges_ = 0;
+  edges.head_ = nullptr;
+  edges.tail_ = nullptr;
 }
 
 void EdgeContainer::rewire(NodeId source,
@@ -75,52 +180,75 @@ void EdgeContainer::rewire(NodeId source,
                            NodeId new_source,
                            NodeId new_target) {
   auto attrs = get(source, target).info->clone();
-  edge_status.at(EdgeKey(source, target)) = EdgeStatus::MERGED;
+  edges.table_.at(EdgeKey(source, target)).status = EdgeStatus::MERGED;
   remove(source, target);
   insert(new_source, new_target, std::move(attrs));
 }
 
+Edge& EdgeContainer::access(const EdgeKey& key) const {
+  const auto iter = edges.table_.find(key);
+  if (iter == edges.table_.end() || !iter->second.record) {
+    throw std::out_of_range("edge does not exist");
+  }
+
+  auto record = iter->second.record.get();
+  edges.touch(record);
+  return record->edge;
+}
+
 EdgeStatus EdgeContainer::getStatus(NodeId source, NodeId target) const {
-  const auto iter = edge_status.find(EdgeKey(source, target));
-  return (iter == edge_status.end()) ? EdgeStatus::NONEXISTENT : iter->second;
+  const auto iter = edges.table_.find(EdgeKey(source, target));
+  return (iter == edges.table_.end()) ? EdgeStatus::NONEXISTENT : iter->second.status;
 }
 
 void EdgeContainer::getNew(std::vector<EdgeKey>& new_edges, bool clear_new) {
-  auto iter = edge_status.begin();
-  while (iter != edge_status.end()) {
-    if (iter->second == EdgeStatus::NEW) {
-      new_edges.push_back(iter->first);
+  const size_t prev_size = new_edges.size();
+  for (auto& [key, entry] : edges.table_) {
+    if (entry.status == EdgeStatus::NEW) {
+      new_edges.push_back(key);
       if (clear_new) {
-        iter->second = EdgeStatus::VISIBLE;
+        entry.status = EdgeStatus::VISIBLE;
       }
     }
-
-    ++iter;
   }
+
+  std::sort(new_edges.begin() + prev_size, new_edges.end());
 }
 
 void EdgeContainer::getRemoved(std::vector<EdgeKey>& removed_edges,
                                bool clear_removed) {
-  auto iter = edge_status.begin();
-  while (iter != edge_status.end()) {
-    if (iter->second != EdgeStatus::DELETED) {
-      ++iter;
-      continue;
+  const size_t prev_size = removed_edges.size();
+  for (const auto& [key, entry] : edges.table_) {
+    if (entry.status == EdgeStatus::DELETED) {
+      removed_edges.push_back(key);
     }
+  }
 
-    removed_edges.push_back(iter->first);
-    if (clear_removed) {
-      iter = edge_status.erase(iter);
-    } else {
-      ++iter;
-    }
+  std::sort(removed_edges.begin() + prev_size, removed_edges.end());
+  if (!clear_removed) {
+    return;
   }
+
+  for (auto iter = removed_edges.begin() + prev_size; iter != removed_edges.end();
+       ++iter) {
+    edges.table_.erase(*iter);
+  }
+}
+
+bool EdgeContainer::isStale(NodeId source, NodeId target) const {
+  const auto iter = edges.table_.find(EdgeKey(source, target));
+  if (iter == edges.table_.end() || !iter->second.record) {
+    return false;
+  }
+
+  return iter->second.record->epoch < edges.epoch_;
 }
 
-void EdgeContainer::setStale() {
-  stale_edges.clear();
-  for (const auto& key_edge_pair : edges) {
-    stale_edges[key_edge_pair.first] = true;
+void EdgeContainer::getStale(std::vector<EdgeKey>& stale_edges) const {
+  // the list is ordered by epoch, so the stale edges are all at the front
+  for (auto record = edges.head_; record && record->epoch < edges.epoch_;
+       record = record->next) {
+    stale_edges.emplace_back(record->edge.source, record->edge.target);
   }
 }
 
@@ -0,0 +1,130 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/frozen_layer.h"
+
+#include <algorithm>
+
+#include "spark_dsg/scene_graph_layer.h"
+
+namespace spark_dsg {
+
+FrozenLayer::FrozenLayer(const SceneGraphLayer& layer) : id(layer.id) {
+  const size_t num_nodes = layer.numNodes();
+  node_ids_.reserve(num_nodes);
+  index_.reserve(num_nodes);
+  for (const auto& id_node_pair : layer.nodes()) {
+    index_.emplace(id_node_pair.first, node_ids_.size());
+    node_ids_.push_back(id_node_pair.first);
+  }
+
+  offsets_.reserve(num_nodes + 1);
+  offsets_.push_back(0);
+  neighbors_.reserve(2 * layer.numEdges());
+  neighbor_ids_.reserve(2 * layer.numEdges());
+  weights_.reserve(2 * layer.numEdges());
+  for (const auto& id_node_pair : layer.nodes()) {
+    const auto source = id_node_pair.first;
+    for (const auto target : id_node_pair.second->siblings()) {
+      neighbors_.push_back(index_.at(target));
+      neighbor_ids_.push_back(target);
+      weights_.push_back(layer.getEdge(source, target)->get().searchWeight());
+    }
+
+    offsets_.push_back(neighbors_.size());
+  }
+}
+
+std::optional<double> FrozenLayer::getWeight(NodeId source, NodeId target) const {
+  auto iter = index_.find(source);
+  if (iter == index_.end()) {
+    return std::nullopt;
+  }
+
+  // rows are filled from the (ordered) sibling sets and so are sorted by id
+  const auto neighbors = neighborIds(iter->second);
+  const auto pos = std::lower_bound(neighbors.begin(), neighbors.end(), target);
+  if (pos == neighbors.end() || *pos != target) {
+    return std::nullopt;
+  }
+
+  return weights_[offsets_[iter->second] + (pos - neighbors.begin())];
+}
+
+void FrozenLayer::breadthFirstSearch(Index root,
+                                     const IndexVisitor& visitor,
+                                     std::vector<uint8_t>& visited,
+                                     std::vector<Index>& frontier) const {
+  visited.resize(numNodes(), 0);
+  frontier.clear();
+  frontier.push_back(root);
+  visited[root] = 1;
+
+  // the frontier vector doubles as the queue (nodes are never re-added)
+  for (size_t head = 0; head < frontier.size(); ++head) {
+    const Index curr = frontier[head];
+    visitor(curr);
+    for (const auto neighbor : neighbors(curr)) {
+      if (visited[neighbor]) {
+        continue;
+      }
+
+      visited[neighbor] = 1;
+      frontier.push_back(neighbor);
+    }
+  }
+}
+
+std::vector<std::vector<NodeId>> FrozenLayer::getConnectedComponents() const {
+  std::vector<std::vector<NodeId>> components;
+  std::vector<uint8_t> visited(numNodes(), 0);
+  std::vector<Index> frontier;
+  frontier.reserve(numNodes());
+  for (Index i = 0; i < numNodes(); ++i) {
+    if (visited[i]) {
+      continue;
+    }
+
+    breadthFirstSearch(i, [](Index) {}, visited, frontier);
+    auto& component = components.emplace_back();
+    component.reserve(frontier.size());
+    for (const auto index : frontier) {
+      component.push_back(node_ids_[index]);
+    }
+  }
+
+  return components;
+}
+
+}  // namespace spark_dsg
@@ -34,7 +34,20 @@
  * -------------------------------------------------------------------------- */
 #include "spark_dsg/graph_binary_serialization.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <tuple>
+
 #include "spark_dsg/binary_serializer.h"
+#include "spark_dsg/graph_builder.h"
+#include "spark_dsg/parallel_components.h"
 
 namespace spark_dsg {
 
@@ -43,6 +56,11 @@ using serialization::BinaryDeserializer;
 using serialization::BinaryEdgeFactory;
 using serialization::BinaryNodeFactory;
 using serialization::BinarySerializer;
+using serialization::MeshEncoding;
+using serialization::readMesh;
+
+//! formats without older readers always use the compact mesh layout
+const MeshEncoding COMPACT_MESH{0, true};
 
 template <>
 std::unique_ptr<AttributeFactory<NodeAttributes, BinaryConverter>>
@@ -52,159 +70,313 @@ template <>
 std::unique_ptr<AttributeFactory<EdgeAttributes, BinaryConverter>>
     AttributeFactory<EdgeAttributes, BinaryConverter>::s_instance_ = nullptr;
 
-void insertNode(const BinaryDeserializer& deserializer, DynamicSceneGraph& graph) {
-  deserializer.checkFixedArrayLength(3);
+//! node record shared by streamed graphs, deltas and archive sections
+struct NodeRecord {
   LayerId layer;
-  deserializer.read(layer);
-  NodeId node;
-  deserializer.read(node);
+  NodeId id;
+  //! only set for dynamic nodes
+  std::optional<std::chrono::nanoseconds> timestamp;
+  NodeAttributes::Ptr attrs;
+};
+
+//! edge record shared by streamed graphs, deltas and archive sections
+struct EdgeRecord {
+  NodeId source;
+  NodeId target;
+  EdgeAttributes::Ptr attrs;
+};
+
+//! read the fields of a node record that precede the attributes
+NodeRecord readNodeKey(const BinaryDeserializer& deserializer, bool is_dynamic) {
+  deserializer.checkFixedArrayLength(is_dynamic ? 4 : 3);
+  NodeRecord record;
+  deserializer.read(record.layer);
+  deserializer.read(record.id);
+  if (is_dynamic) {
+    std::chrono::nanoseconds::rep timestamp_ns;
+    deserializer.read(timestamp_ns);
+    record.timestamp = std::chrono::nanoseconds(timestamp_ns);
+  }
+
+  return record;
+}
 
+NodeRecord readNodeRecord(const BinaryDeserializer& deserializer, bool is_dynamic) {
+  auto record = readNodeKey(deserializer, is_dynamic);
   BinaryConverter converter(&deserializer);
-  graph.emplaceNode(layer, node, BinaryNodeFactory::get_default().create(converter));
+  record.attrs = BinaryNodeFactory::get_default().create(converter);
   converter.finalize();
+  return record;
 }
 
-std::optional<NodeId> updateNode(const BinaryDeserializer& deserializer,
-                                 DynamicSceneGraph& graph) {
+//! read the fields of an edge record that precede the attributes
+EdgeRecord readEdgeKey(const BinaryDeserializer& deserializer) {
   deserializer.checkFixedArrayLength(3);
-  LayerId layer;
-  deserializer.read(layer);
-  NodeId node;
-  deserializer.read(node);
+  EdgeRecord record;
+  deserializer.read(record.source);
+  deserializer.read(record.target);
+  return record;
+}
 
-  BinaryConverter conv(&deserializer);
-  const auto node_opt = graph.getNode(node);
-  if (node_opt) {
-    BinaryNodeFactory::get_default().update(conv, node_opt->get().attributes());
+EdgeRecord readEdgeRecord(const BinaryDeserializer& deserializer) {
+  auto record = readEdgeKey(deserializer);
+  BinaryConverter converter(&deserializer);
+  record.attrs = BinaryEdgeFactory::get_default().create(converter);
+  converter.finalize();
+  return record;
+}
+
+MeshEdge readMeshEdgeRecord(const BinaryDeserializer& deserializer) {
+  deserializer.checkFixedArrayLength(2);
+  NodeId source;
+  deserializer.read(source);
+  size_t vertex;
+  deserializer.read(vertex);
+  return {source, vertex};
+}
+
+void addNode(GraphBuilder& builder, NodeRecord&& record) {
+  if (record.timestamp) {
+    builder.addDynamicNode(
+        record.layer, record.id, *record.timestamp, std::move(record.attrs));
   } else {
-    graph.emplaceNode(layer, node, BinaryNodeFactory::get_default().create(conv));
+    builder.addNode(record.layer, record.id, std::move(record.attrs));
   }
-  conv.finalize();
-  return node_opt ? std::optional<NodeId>(node_opt->get().id) : std::nullopt;
 }
 
-void insertDynamicNode(const BinaryDeserializer& deserializer,
-                       DynamicSceneGraph& graph) {
-  deserializer.checkFixedArrayLength(4);
-  LayerId layer_id;
-  deserializer.read(layer_id);
-  NodeId node_id;
-  deserializer.read(node_id);
-  std::chrono::nanoseconds::rep timestamp_ns;
-  deserializer.read(timestamp_ns);
+void addEdge(GraphBuilder& builder, EdgeRecord&& record) {
+  builder.addEdge(record.source, record.target, std::move(record.attrs));
+}
 
-  BinaryConverter converter(&deserializer);
-  graph.emplacePrevDynamicNode(layer_id,
-                               node_id,
-                               std::chrono::nanoseconds(timestamp_ns),
-                               BinaryNodeFactory::get_default().create(converter));
-  converter.finalize();
+void insertNode(const BinaryDeserializer& deserializer, GraphBuilder& builder) {
+  addNode(builder, readNodeRecord(deserializer, false));
 }
 
-std::optional<NodeId> updateDynamicNode(const BinaryDeserializer& deserializer,
-                                        DynamicSceneGraph& graph) {
-  deserializer.checkFixedArrayLength(4);
-  LayerId layer;
-  deserializer.read(layer);
-  NodeId node;
-  deserializer.read(node);
-  std::chrono::nanoseconds::rep timestamp_ns_value;
-  deserializer.read(timestamp_ns_value);
-  std::chrono::nanoseconds timestamp_ns(timestamp_ns_value);
+void insertDynamicNode(const BinaryDeserializer& deserializer, GraphBuilder& builder) {
+  addNode(builder, readNodeRecord(deserializer, true));
+}
 
+std::optional<NodeId> updateNode(const BinaryDeserializer& deserializer,
+                                 DynamicSceneGraph& graph,
+                                 bool is_dynamic) {
+  auto record = readNodeKey(deserializer, is_dynamic);
   BinaryConverter conv(&deserializer);
-  const auto node_opt = graph.getNode(node);
+  const auto node_opt = graph.getNode(record.id);
   if (node_opt) {
     BinaryNodeFactory::get_default().update(conv, node_opt->get().attributes());
+    graph.markNodeUpdated(record.id);
+  } else if (record.timestamp) {
+    graph.emplacePrevDynamicNode(record.layer,
+                                 record.id,
+                                 *record.timestamp,
+                                 BinaryNodeFactory::get_default().create(conv));
   } else {
-    graph.emplacePrevDynamicNode(
-        layer, node, timestamp_ns, BinaryNodeFactory::get_default().create(conv));
+    graph.emplaceNode(
+        record.layer, record.id, BinaryNodeFactory::get_default().create(conv));
   }
   conv.finalize();
   return node_opt ? std::optional<NodeId>(node_opt->get().id) : std::nullopt;
 }
 
-void insertEdge(const BinaryDeserializer& deserializer, DynamicSceneGraph& graph) {
-  deserializer.checkFixedArrayLength(3);
-  NodeId source;
-  deserializer.read(source);
-  NodeId target;
-  deserializer.read(target);
+std::optional<NodeId> updateNode(const BinaryDeserializer& deserializer,
+                                 DynamicSceneGraph& graph) {
+  return updateNode(deserializer, graph, false);
+}
 
-  BinaryConverter conv(&deserializer);
-  graph.insertEdge(source, target, BinaryEdgeFactory::get_default().create(conv));
-  conv.finalize();
+std::optional<NodeId> updateDynamicNode(const BinaryDeserializer& deserializer,
+                                        DynamicSceneGraph& graph) {
+  return updateNode(deserializer, graph, true);
 }
 
-void updateEdge(const BinaryDeserializer& deserializer, DynamicSceneGraph& graph) {
-  deserializer.checkFixedArrayLength(3);
-  NodeId source;
-  deserializer.read(source);
-  NodeId target;
-  deserializer.read(target);
+void insertEdge(const BinaryDeserializer& deserializer, GraphBuilder& builder) {
+  addEdge(builder, readEdgeRecord(deserializer));
+}
 
+void updateEdge(const BinaryDeserializer& deserializer, DynamicSceneGraph& graph) {
+  const auto record = readEdgeKey(deserializer);
   BinaryConverter conv(&deserializer);
-  const auto edge_opt = graph.getEdge(source, target);
+  const auto edge_opt = graph.getEdge(record.source, record.target);
   if (edge_opt) {
     BinaryEdgeFactory::get_default().update(conv, edge_opt->get().attributes());
+    graph.markEdgeUpdated(record.source, record.target);
   } else {
     // always force parents to switch
-    graph.insertEdge(
-        source, target, BinaryEdgeFactory::get_default().create(conv), true);
+    graph.insertEdge(record.source,
+                     record.target,
+                     BinaryEdgeFactory::get_default().create(conv),
+                     true);
   }
   conv.finalize();
 }
 
-void insertMeshEdge(const BinaryDeserializer& deserializer, DynamicSceneGraph& graph) {
-  deserializer.checkFixedArrayLength(2);
-  NodeId source;
-  deserializer.read(source);
-  size_t target;
-  deserializer.read(target);
-  graph.insertMeshEdge(source, target, true);
+void insertMeshEdges(const BinaryDeserializer& deserializer, DynamicSceneGraph& graph) {
+  DynamicSceneGraph::MeshEdges edges;
+  deserializer.checkDynamicArray();
+  while (!deserializer.isDynamicArrayEnd()) {
+    edges.push_back(readMeshEdgeRecord(deserializer));
+  }
+
+  graph.insertMeshEdges(edges, true);
+}
+
+void writeBlockInfo(BinarySerializer& serializer,
+                    const MeshBlocks::Index& index,
+                    const MeshBlockInfo& info) {
+  serializer.startFixedArray(10);
+  serializer.write(index[0]);
+  serializer.write(index[1]);
+  serializer.write(index[2]);
+  serializer.write(info.version);
+  serializer.write(info.vertex_offset);
+  serializer.write(info.vertex_capacity);
+  serializer.write(info.num_vertices);
+  serializer.write(info.face_offset);
+  serializer.write(info.face_capacity);
+  serializer.write(info.num_faces);
+}
+
+MeshBlocks::Index readBlockInfo(const BinaryDeserializer& deserializer,
+                                MeshBlockInfo& info) {
+  deserializer.checkFixedArrayLength(10);
+  MeshBlocks::Index index;
+  deserializer.read(index[0]);
+  deserializer.read(index[1]);
+  deserializer.read(index[2]);
+  deserializer.read(info.version);
+  deserializer.read(info.vertex_offset);
+  deserializer.read(info.vertex_capacity);
+  deserializer.read(info.num_vertices);
+  deserializer.read(info.face_offset);
+  deserializer.read(info.face_capacity);
+  deserializer.read(info.num_faces);
+  return index;
+}
+
+// meshes without blocks are written as is, otherwise the layout comes first
+void writeMeshValue(BinarySerializer& serializer,
+                    const DynamicSceneGraph& graph,
+                    const MeshEncoding& encoding = {}) {
+  const auto& blocks = graph.meshBlocks();
+  if (blocks.empty()) {
+    serialization::writeMesh(serializer, *graph.mesh(), encoding);
+    return;
+  }
+
+  // readers of the legacy layout don't know about blocks, so only the used faces go
+  if (!encoding.compact && encoding.position_bits == 0) {
+    serialization::writeMesh(serializer, blocks.exportMesh(*graph.mesh()), encoding);
+    return;
+  }
+
+  serializer.writeArrayStart();
+  serializer.write(blocks.baseVertices());
+  serializer.write(blocks.baseFaces());
+  serializer.writeArrayStart();
+  for (const auto& [index, info] : blocks.blocks()) {
+    writeBlockInfo(serializer, index, info);
+  }
+  serializer.writeArrayEnd();
+  serialization::writeMesh(serializer, *graph.mesh(), encoding);
+  serializer.writeArrayEnd();
+}
+
+Mesh::Ptr readMeshValue(const BinaryDeserializer& deserializer, MeshBlocks& blocks) {
+  if (deserializer.getCurrType() != serialization::PackType::ARRXX) {
+    auto mesh = readMesh(deserializer);
+    blocks = MeshBlocks(mesh->numVertices(), mesh->numFaces());
+    return mesh;
+  }
+
+  deserializer.checkDynamicArray();
+  size_t base_vertices;
+  deserializer.read(base_vertices);
+  size_t base_faces;
+  deserializer.read(base_faces);
+  blocks = MeshBlocks(base_vertices, base_faces);
+
+  deserializer.checkDynamicArray();
+  while (!deserializer.isDynamicArrayEnd()) {
+    MeshBlockInfo info;
+    const auto index = readBlockInfo(deserializer, info);
+    blocks.restore(index, info);
+  }
+
+  auto mesh = readMesh(deserializer);
+  if (!deserializer.isDynamicArrayEnd()) {
+    throw std::domain_error("mesh blocks are missing array end");
+  }
+
+  return mesh;
 }
 
 void insertMesh(const BinaryDeserializer& deserializer, DynamicSceneGraph& graph) {
-  size_t num_vertices = deserializer.readFixedArrayLength() / 6;
-  MeshVertices::Ptr vertices(new MeshVertices());
-  vertices->resize(num_vertices);
-  for (size_t i = 0; i < num_vertices; ++i) {
-    auto& point = vertices->at(i);
-    deserializer.read(point.x);
-    deserializer.read(point.y);
-    deserializer.read(point.z);
-    float r;
-    deserializer.read(r);
-    float g;
-    deserializer.read(g);
-    float b;
-    deserializer.read(b);
-
-    point.r = static_cast<uint8_t>(255.0f * r);
-    point.g = static_cast<uint8_t>(255.0f * g);
-    point.b = static_cast<uint8_t>(255.0f * b);
-  }
-
-  size_t num_faces = deserializer.readFixedArrayLength() / 3;
-  std::shared_ptr<MeshFaces> faces(new MeshFaces(num_faces));
-  for (size_t i = 0; i < num_faces; ++i) {
-    auto& face = faces->at(i);
-    face.vertices.resize(3);
-    deserializer.read(face.vertices[0]);
-    deserializer.read(face.vertices[1]);
-    deserializer.read(face.vertices[2]);
-  }
-
-  graph.setMesh(vertices, faces, false);
+  MeshBlocks blocks;
+  auto mesh = readMeshValue(deserializer, blocks);
+  graph.setMesh(mesh, blocks, false);
 }
 
-void writeGraph(const DynamicSceneGraph& graph,
-                std::vector<uint8_t>& buffer,
-                bool include_mesh) {
-  BinarySerializer serializer(&buffer);
+// blocks are written at the layout of the sender, so mesh edges are left as is
+void applyMeshPatch(const BinaryDeserializer& deserializer, DynamicSceneGraph& graph) {
+  auto blocks = graph.meshBlocks();
+  // meshes that are shared with anyone else are never modified in place
+  const auto& current = graph.mesh();
+  auto mesh = !current                  ? std::make_shared<Mesh>()
+              : current.use_count() > 1 ? std::make_shared<Mesh>(*current)
+                                        : current;
+
+  // the mesh is sized by the block layouts, the sizes of the sender only check them
+  size_t num_vertices;
+  deserializer.read(num_vertices);
+  size_t num_faces;
+  deserializer.read(num_faces);
+
+  deserializer.checkDynamicArray();
+  while (!deserializer.isDynamicArrayEnd()) {
+    MeshBlocks::Index index;
+    deserializer.checkFixedArrayLength(3);
+    deserializer.read(index[0]);
+    deserializer.read(index[1]);
+    deserializer.read(index[2]);
+    blocks.remove(*mesh, index);
+  }
+
+  std::vector<std::tuple<MeshBlocks::Index, MeshBlockInfo, Mesh::Ptr>> updated;
+  deserializer.checkDynamicArray();
+  while (!deserializer.isDynamicArrayEnd()) {
+    MeshBlockInfo info;
+    const auto index = readBlockInfo(deserializer, info);
+    if (info.vertex_capacity > num_vertices ||
+        info.vertex_offset > num_vertices - info.vertex_capacity ||
+        info.face_capacity > num_faces ||
+        info.face_offset > num_faces - info.face_capacity) {
+      throw std::domain_error("mesh block layout is outside of the mesh");
+    }
+
+    updated.emplace_back(index, info, readMesh(deserializer));
+  }
+
+  // free every updated range first as blocks may have moved into each other's ranges
+  for (const auto& [index, info, block] : updated) {
+    blocks.remove(*mesh, index);
+  }
+
+  for (const auto& [index, info, block] : updated) {
+    blocks.upsert(*mesh, index, *block, &info);
+  }
+
+  if (mesh->numVertices() != num_vertices || mesh->numFaces() != num_faces) {
+    throw std::domain_error("mesh size does not match the mesh block layout");
+  }
+
+  graph.setMesh(mesh, blocks, false);
+}
+
+void writeHeaderSection(const DynamicSceneGraph& graph, BinarySerializer& serializer) {
   serializer.write(graph.layer_ids);
   serializer.write(graph.mesh_layer_id);
+}
 
+void writeNodeSection(const DynamicSceneGraph& graph, BinarySerializer& serializer) {
   serializer.writeArrayStart();
   for (const auto& id_layer_pair : graph.layers()) {
     for (const auto& id_node_pair : id_layer_pair.second->nodes()) {
@@ -222,82 +394,118 @@ void writeGraph(const DynamicSceneGraph& graph,
     }
   }
   serializer.writeArrayEnd();
+}
 
+void writeEdgeSection(const DynamicSceneGraph& graph, BinarySerializer& serializer) {
   serializer.writeArrayStart();
   for (const auto& id_layer_pair : graph.layers()) {
-    for (const auto& id_edge_pair : id_layer_pair.second->edges()) {
-      serializer.write(id_edge_pair.second);
+    for (const auto& id_edge_pair : id_layer_pair.second->edges().sorted()) {
+      serializer.write(*id_edge_pair.second);
     }
   }
 
   for (const auto& id_layer_group_pair : graph.dynamicLayers()) {
     for (const auto& prefix_layer_pair : id_layer_group_pair.second) {
-      for (const auto& id_edge_pair : prefix_layer_pair.second->edges()) {
-        serializer.write(id_edge_pair.second);
+      for (const auto& id_edge_pair : prefix_layer_pair.second->edges().sorted()) {
+        serializer.write(*id_edge_pair.second);
       }
     }
   }
 
-  for (const auto& id_edge_pair : graph.interlayer_edges()) {
-    serializer.write(id_edge_pair.second);
+  for (const auto& id_edge_pair : graph.interlayer_edges().sorted()) {
+    serializer.write(*id_edge_pair.second);
   }
 
-  for (const auto& id_edge_pair : graph.dynamic_interlayer_edges()) {
-    serializer.write(id_edge_pair.second);
+  for (const auto& id_edge_pair : graph.dynamic_interlayer_edges().sorted()) {
+    serializer.write(*id_edge_pair.second);
   }
   serializer.writeArrayEnd();
 
   serializer.writeArrayStart();
   for (const auto& edge : graph.getMeshEdges()) {
-    serializer.write(edge.second);
+    serializer.write(edge);
   }
   serializer.writeArrayEnd();
+}
 
+void writeMeshSection(const DynamicSceneGraph& graph,
+                      BinarySerializer& serializer,
+                      bool include_mesh,
+                      const MeshEncoding& mesh_encoding) {
   if (!include_mesh || !graph.hasMesh()) {
     serializer.write(false);
     return;
   }
 
   serializer.write(true);
-  serializer.write(*graph.getMeshVertices());
-  serializer.write(*graph.getMeshFaces());
+  writeMeshValue(serializer, graph, mesh_encoding);
 }
 
-DynamicSceneGraph::Ptr readGraph(const uint8_t* const buffer, size_t length) {
-  BinaryDeserializer deserializer(buffer, length);
+void writeGraph(const DynamicSceneGraph& graph,
+                std::vector<uint8_t>& buffer,
+                bool include_mesh,
+                const MeshEncoding& mesh_encoding) {
+  BinarySerializer serializer(&buffer);
+  writeHeaderSection(graph, serializer);
+  writeNodeSection(graph, serializer);
+  writeEdgeSection(graph, serializer);
+  writeMeshSection(graph, serializer, include_mesh, mesh_encoding);
+}
+
+void writeGraphSections(const DynamicSceneGraph& graph,
+                        GraphSectionBuffers& sections,
+                        bool include_mesh,
+                        const MeshEncoding& mesh_encoding) {
+  BinarySerializer header(&sections[static_cast<size_t>(GraphSection::HEADER)]);
+  writeHeaderSection(graph, header);
+  BinarySerializer nodes(&sections[static_cast<size_t>(GraphSection::NODES)]);
+  writeNodeSection(graph, nodes);
+  BinarySerializer edges(&sections[static_cast<size_t>(GraphSection::EDGES)]);
+  writeEdgeSection(graph, edges);
+  BinarySerializer mesh(&sections[static_cast<size_t>(GraphSection::MESH)]);
+  writeMeshSection(graph, mesh, include_mesh, mesh_encoding);
+}
+
+//! deserializers for every section of a graph (may all refer to the same one)
+struct SectionReaders {
+  const BinaryDeserializer& header;
+  const BinaryDeserializer& nodes;
+  const BinaryDeserializer& edges;
+  const BinaryDeserializer& mesh;
+};
 
+DynamicSceneGraph::Ptr readGraph(const SectionReaders& readers) {
   std::vector<LayerId> layer_ids;
   LayerId mesh_layer_id;
-  deserializer.read(layer_ids);
-  deserializer.read(mesh_layer_id);
+  readers.header.read(layer_ids);
+  readers.header.read(mesh_layer_id);
 
   auto graph = std::make_shared<DynamicSceneGraph>(layer_ids, mesh_layer_id);
 
-  deserializer.checkDynamicArray();
-  while (!deserializer.isDynamicArrayEnd()) {
-    insertNode(deserializer, *graph);
+  GraphBuilder builder(*graph);
+  readers.nodes.checkDynamicArray();
+  while (!readers.nodes.isDynamicArrayEnd()) {
+    insertNode(readers.nodes, builder);
   }
 
-  deserializer.checkDynamicArray();
-  while (!deserializer.isDynamicArrayEnd()) {
-    insertDynamicNode(deserializer, *graph);
+  readers.nodes.checkDynamicArray();
+  while (!readers.nodes.isDynamicArrayEnd()) {
+    insertDynamicNode(readers.nodes, builder);
   }
 
-  deserializer.checkDynamicArray();
-  while (!deserializer.isDynamicArrayEnd()) {
-    insertEdge(deserializer, *graph);
+  readers.edges.checkDynamicArray();
+  while (!readers.edges.isDynamicArrayEnd()) {
+    insertEdge(readers.edges, builder);
   }
+  builder.commit();
 
-  deserializer.checkDynamicArray();
-  while (!deserializer.isDynamicArrayEnd()) {
-    insertMeshEdge(deserializer, *graph);
-  }
+  insertMeshEdges(readers.edges, *graph);
 
   serialization::PackType type;
   try {
     // TODO(nathan) this is ugly
-    type = deserializer.getCurrType();
-    deserializer.checkType(type);
+    type = readers.mesh.getCurrType();
+    readers.mesh.checkType(type);
   } catch (const std::out_of_range&) {
     std::cerr << "serialized data does not contain mesh flag!" << std::endl;
     return graph;
@@ -307,16 +515,43 @@ DynamicSceneGraph::Ptr readGraph(const uint8_t* const buffer, size_t length) {
     return graph;
   }
 
-  insertMesh(deserializer, *graph);
+  insertMesh(readers.mesh, *graph);
   return graph;
 }
 
-bool updateGraphNormal(DynamicSceneGraph& graph,
-                       const BinaryDeserializer& deserializer) {
+DynamicSceneGraph::Ptr readGraph(const uint8_t* const buffer, size_t length) {
+  BinaryDeserializer deserializer(buffer, length);
+  return readGraph({deserializer, deserializer, deserializer, deserializer});
+}
+
+DynamicSceneGraph::Ptr readGraph(const serialization::ChunkReader& reader) {
+  BinaryDeserializer deserializer(reader);
+  return readGraph({deserializer, deserializer, deserializer, deserializer});
+}
+
+DynamicSceneGraph::Ptr readGraphFromFile(const std::string& filepath) {
+  std::ifstream infile(filepath, std::ios::binary);
+  if (!infile) {
+    throw std::runtime_error("failed to open " + filepath);
+  }
+
+  return readGraph(serialization::streamChunkReader(infile));
+}
+
+DynamicSceneGraph::Ptr readGraphSections(const GraphSectionViews& sections) {
+  const auto& [header_view, nodes_view, edges_view, mesh_view] = sections;
+  BinaryDeserializer header(header_view.data, header_view.length);
+  BinaryDeserializer nodes(nodes_view.data, nodes_view.length);
+  BinaryDeserializer edges(edges_view.data, edges_view.length);
+  BinaryDeserializer mesh(mesh_view.data, mesh_view.length);
+  return readGraph({header, nodes, edges, mesh});
+}
+
+bool checkHeader(const DynamicSceneGraph& graph, const BinaryDeserializer& header) {
   std::vector<LayerId> layer_ids;
   LayerId mesh_layer_id;
-  deserializer.read(layer_ids);
-  deserializer.read(mesh_layer_id);
+  header.read(layer_ids);
+  header.read(mesh_layer_id);
 
   if (graph.layer_ids != layer_ids) {
     // TODO(nathan) maybe throw exception
@@ -328,52 +563,420 @@ bool updateGraphNormal(DynamicSceneGraph& graph,
     return false;
   }
 
-  deserializer.checkDynamicArray();
-  while (!deserializer.isDynamicArrayEnd()) {
-    updateNode(deserializer, graph);
+  return true;
+}
+
+bool updateGraphNormal(DynamicSceneGraph& graph, const SectionReaders& readers) {
+  if (!checkHeader(graph, readers.header)) {
+    return false;
   }
 
-  deserializer.checkDynamicArray();
-  while (!deserializer.isDynamicArrayEnd()) {
-    updateDynamicNode(deserializer, graph);
+  readers.nodes.checkDynamicArray();
+  while (!readers.nodes.isDynamicArrayEnd()) {
+    updateNode(readers.nodes, graph);
   }
 
-  deserializer.checkDynamicArray();
-  while (!deserializer.isDynamicArrayEnd()) {
-    updateEdge(deserializer, graph);
+  readers.nodes.checkDynamicArray();
+  while (!readers.nodes.isDynamicArrayEnd()) {
+    updateDynamicNode(readers.nodes, graph);
+  }
+
+  readers.edges.checkDynamicArray();
+  while (!readers.edges.isDynamicArrayEnd()) {
+    updateEdge(readers.edges, graph);
   }
 
   // TODO(nathan) we might want to not do this
   graph.clearMeshEdges();
-  deserializer.checkDynamicArray();
-  while (!deserializer.isDynamicArrayEnd()) {
-    // okay to directly insert, internal checks will prevent duplicates
-    insertMeshEdge(deserializer, graph);
+  // okay to directly insert, internal checks will prevent duplicates
+  insertMeshEdges(readers.edges, graph);
+
+  return true;
+}
+
+bool updateGraphRemoveStale(DynamicSceneGraph& graph, const SectionReaders& readers) {
+  if (!checkHeader(graph, readers.header)) {
+    return false;
+  }
+
+  std::unordered_set<NodeId> stale_nodes;
+  for (const auto& id_key_pair : graph.node_lookup()) {
+    stale_nodes.insert(id_key_pair.first);
   }
 
+  readers.nodes.checkDynamicArray();
+  while (!readers.nodes.isDynamicArrayEnd()) {
+    const auto node_id = updateNode(readers.nodes, graph);
+    if (node_id) {
+      stale_nodes.erase(*node_id);
+    }
+  }
+
+  readers.nodes.checkDynamicArray();
+  while (!readers.nodes.isDynamicArrayEnd()) {
+    const auto node_id = updateDynamicNode(readers.nodes, graph);
+    if (node_id) {
+      stale_nodes.erase(*node_id);
+    }
+  }
+
+  for (const auto& node_id : stale_nodes) {
+    graph.removeNode(node_id);
+  }
+
+  graph.markEdgesAsStale();
+  readers.edges.checkDynamicArray();
+  while (!readers.edges.isDynamicArrayEnd()) {
+    updateEdge(readers.edges, graph);
+  }
+  graph.removeAllStaleEdges();
+
+  // TODO(nathan) we might want to not do this
+  graph.clearMeshEdges();
+  // okay to directly insert, internal checks will prevent duplicates
+  insertMeshEdges(readers.edges, graph);
+
   return true;
 }
 
-bool updateGraphRemoveStale(DynamicSceneGraph& graph,
-                            const BinaryDeserializer& deserializer) {
-  std::vector<LayerId> layer_ids;
-  LayerId mesh_layer_id;
-  deserializer.read(layer_ids);
-  deserializer.read(mesh_layer_id);
+bool updateGraph(DynamicSceneGraph& graph,
+                 const SectionReaders& readers,
+                 bool remove_stale) {
+  if (remove_stale) {
+    return updateGraphRemoveStale(graph, readers);
+  }
 
-  if (graph.layer_ids != layer_ids) {
-    // TODO(nathan) maybe throw exception
+  graph.clear();
+  return updateGraphNormal(graph, readers);
+}
+
+bool updateGraph(DynamicSceneGraph& graph,
+                 const uint8_t* const buffer,
+                 size_t length,
+                 bool remove_stale) {
+  BinaryDeserializer deserializer(buffer, length);
+  return updateGraph(
+      graph, {deserializer, deserializer, deserializer, deserializer}, remove_stale);
+}
+
+bool updateGraphSections(DynamicSceneGraph& graph,
+                         const GraphSectionViews& sections,
+                         bool remove_stale) {
+  const auto& [header_view, nodes_view, edges_view, mesh_view] = sections;
+  BinaryDeserializer header(header_view.data, header_view.length);
+  BinaryDeserializer nodes(nodes_view.data, nodes_view.length);
+  BinaryDeserializer edges(edges_view.data, edges_view.length);
+  BinaryDeserializer mesh(mesh_view.data, mesh_view.length);
+  return updateGraph(graph, {header, nodes, edges, mesh}, remove_stale);
+}
+
+enum class DeltaType : uint8_t { DELTA = 0, KEYFRAME = 1 };
+
+inline uint64_t hashBytes(const std::vector<uint8_t>& bytes) {
+  const auto data = reinterpret_cast<const char*>(bytes.data());
+  return std::hash<std::string_view>()(std::string_view(data, bytes.size()));
+}
+
+GraphDeltaEncoder::GraphDeltaEncoder(size_t keyframe_interval)
+    : keyframe_interval_(keyframe_interval) {}
+
+bool GraphDeltaEncoder::encode(const DynamicSceneGraph& graph,
+                               std::vector<uint8_t>& buffer,
+                               bool include_mesh) {
+  ++sequence_;
+  // deltas only contain the journal entries after the last message
+  const auto changes = graph.getChangesSince(sent_epoch_);
+  const bool keyframe =
+      force_keyframe_ || graph_ != &graph || !changes.complete ||
+      (keyframe_interval_ > 0 && sequence_ - last_keyframe_ >= keyframe_interval_);
+  // also turns the journals of the graph on if nothing else did
+  sent_epoch_ = graph.getChangeCursor();
+  if (keyframe) {
+    force_keyframe_ = false;
+    graph_ = &graph;
+    last_keyframe_ = sequence_;
+  }
+
+  BinarySerializer serializer(&buffer);
+  const auto type = keyframe ? DeltaType::KEYFRAME : DeltaType::DELTA;
+  serializer.write(static_cast<uint8_t>(type));
+  serializer.write(sequence_);
+  serializer.write(graph.layer_ids);
+  serializer.write(graph.mesh_layer_id);
+
+  // removals (keyframes replace everything instead)
+  serializer.writeArrayStart();
+  if (!keyframe) {
+    for (const auto& key : changes.removed_edges) {
+      serializer.startFixedArray(2);
+      serializer.write(key.k1);
+      serializer.write(key.k2);
+    }
+  }
+  serializer.writeArrayEnd();
+
+  serializer.writeArrayStart();
+  if (!keyframe) {
+    for (const auto node_id : changes.removed_nodes) {
+      serializer.write(node_id);
+    }
+  }
+  serializer.writeArrayEnd();
+
+  const auto write_changed_nodes = [&](bool dynamic) {
+    for (const auto* nodes : {&changes.new_nodes, &changes.updated_nodes}) {
+      for (const auto node_id : *nodes) {
+        const auto key = graph.getLayerForNode(node_id);
+        if (!key || key->dynamic != dynamic) {
+          continue;
+        }
+
+        if (dynamic) {
+          serializer.write(graph.getDynamicNode(node_id)->get());
+        } else {
+          serializer.write(graph.getNode(node_id)->get());
+        }
+      }
+    }
+  };
+
+  serializer.writeArrayStart();
+  if (keyframe) {
+    for (const auto& id_layer_pair : graph.layers()) {
+      for (const auto& id_node_pair : id_layer_pair.second->nodes()) {
+        serializer.write(*id_node_pair.second);
+      }
+    }
+  } else {
+    write_changed_nodes(false);
+  }
+  serializer.writeArrayEnd();
+
+  serializer.writeArrayStart();
+  if (keyframe) {
+    for (const auto& id_layer_group_pair : graph.dynamicLayers()) {
+      for (const auto& prefix_layer_pair : id_layer_group_pair.second) {
+        for (const auto& node : prefix_layer_pair.second->nodes()) {
+          if (node) {
+            serializer.write(*node);
+          }
+        }
+      }
+    }
+  } else {
+    write_changed_nodes(true);
+  }
+  serializer.writeArrayEnd();
+
+  const auto write_edges = [&](const DynamicSceneGraph::Edges& edges) {
+    for (const auto& id_edge_pair : edges) {
+      serializer.write(*id_edge_pair.second);
+    }
+  };
+
+  serializer.writeArrayStart();
+  if (keyframe) {
+    for (const auto& id_layer_pair : graph.layers()) {
+      write_edges(id_layer_pair.second->edges());
+    }
+
+    for (const auto& id_layer_group_pair : graph.dynamicLayers()) {
+      for (const auto& prefix_layer_pair : id_layer_group_pair.second) {
+        write_edges(prefix_layer_pair.second->edges());
+      }
+    }
+
+    write_edges(graph.interlayer_edges());
+    write_edges(graph.dynamic_interlayer_edges());
+  } else {
+    for (const auto* edges : {&changes.new_edges, &changes.updated_edges}) {
+      for (const auto& key : *edges) {
+        const auto edge = graph.getEdge(key.k1, key.k2);
+        if (edge) {
+          serializer.write(edge->get());
+        }
+      }
+    }
+  }
+  serializer.writeArrayEnd();
+
+  // mesh edges: whether to replace every edge, then removed and added edges
+  serializer.write(keyframe);
+  serializer.writeArrayStart();
+  if (!keyframe) {
+    for (const auto& edge : changes.removed_mesh_edges) {
+      serializer.write(edge);
+    }
+  }
+  serializer.writeArrayEnd();
+
+  serializer.writeArrayStart();
+  for (const auto& edge : keyframe ? graph.getMeshEdges() : changes.new_mesh_edges) {
+    serializer.write(edge);
+  }
+  serializer.writeArrayEnd();
+
+  if (!include_mesh || !graph.hasMesh()) {
+    mesh_block_versions_.reset();
+    serializer.write(false);
+    serializer.write(false);
+    return keyframe;
+  }
+
+  // block meshes only send the blocks that changed once receivers have the layout
+  const auto& blocks = graph.meshBlocks();
+  const bool send_patch = !keyframe && !blocks.empty() && mesh_block_versions_ &&
+                          blocks.id() == mesh_layout_;
+  if (send_patch) {
+    serializer.write(false);
+    writeMeshPatch(graph, serializer);
+    return keyframe;
+  }
+
+  scratch_.clear();
+  BinarySerializer mesh_serializer(&scratch_);
+  writeMeshValue(mesh_serializer, graph, COMPACT_MESH);
+
+  const auto mesh_hash = hashBytes(scratch_);
+  const bool send_mesh = keyframe || mesh_hash != mesh_hash_;
+  serializer.write(send_mesh);
+  if (send_mesh) {
+    mesh_hash_ = mesh_hash;
+    buffer.insert(buffer.end(), scratch_.begin(), scratch_.end());
+  }
+
+  serializer.write(false);
+  if (blocks.empty()) {
+    mesh_block_versions_.reset();
+    return keyframe;
+  }
+
+  mesh_layout_ = blocks.id();
+  mesh_block_versions_.emplace();
+  for (const auto& [index, info] : blocks.blocks()) {
+    mesh_block_versions_->emplace(index, info.version);
+  }
+
+  return keyframe;
+}
+
+void GraphDeltaEncoder::writeMeshPatch(const DynamicSceneGraph& graph,
+                                       BinarySerializer& serializer) {
+  const auto& blocks = graph.meshBlocks().blocks();
+  auto& versions = *mesh_block_versions_;
+  std::vector<MeshBlocks::Index> removed;
+  for (const auto& [index, version] : versions) {
+    if (!blocks.count(index)) {
+      removed.push_back(index);
+    }
+  }
+
+  std::vector<MeshBlocks::Index> updated;
+  for (const auto& [index, info] : blocks) {
+    auto iter = versions.find(index);
+    if (iter == versions.end() || iter->second != info.version) {
+      updated.push_back(index);
+    }
+  }
+
+  const bool changed = !removed.empty() || !updated.empty();
+  serializer.write(changed);
+  if (!changed) {
+    return;
+  }
+
+  // the last full mesh that was sent is out of date on the receivers
+  mesh_hash_ = 0;
+  serializer.write(graph.mesh()->numVertices());
+  serializer.write(graph.mesh()->numFaces());
+
+  serializer.writeArrayStart();
+  for (const auto& index : removed) {
+    versions.erase(index);
+    serializer.startFixedArray(3);
+    serializer.write(index[0]);
+    serializer.write(index[1]);
+    serializer.write(index[2]);
+  }
+  serializer.writeArrayEnd();
+
+  serializer.writeArrayStart();
+  for (const auto& index : updated) {
+    const auto& info = blocks.at(index);
+    versions[index] = info.version;
+    writeBlockInfo(serializer, index, info);
+    serialization::writeMesh(
+        serializer, graph.meshBlocks().extract(*graph.mesh(), index), COMPACT_MESH);
+  }
+  serializer.writeArrayEnd();
+}
+
+std::optional<GraphDeltaHeader> readDeltaHeader(
+    const BinaryDeserializer& deserializer) {
+  // full graphs start with the layer ids instead
+  if (deserializer.atEnd() ||
+      deserializer.getCurrType() != serialization::PackType::UINT8) {
+    return std::nullopt;
+  }
+
+  uint8_t type;
+  deserializer.read(type);
+
+  GraphDeltaHeader header;
+  header.keyframe = type == static_cast<uint8_t>(DeltaType::KEYFRAME);
+  deserializer.read(header.sequence);
+  deserializer.read(header.layer_ids);
+  deserializer.read(header.mesh_layer_id);
+  return header;
+}
+
+std::optional<GraphDeltaHeader> readDeltaHeader(const uint8_t* const buffer,
+                                                size_t length) {
+  BinaryDeserializer deserializer(buffer, length);
+  return readDeltaHeader(deserializer);
+}
+
+bool applyDelta(DynamicSceneGraph& graph,
+                const uint8_t* const buffer,
+                size_t length,
+                uint64_t& sequence) {
+  BinaryDeserializer deserializer(buffer, length);
+  const auto header = readDeltaHeader(deserializer);
+  if (!header) {
     return false;
   }
 
-  if (graph.mesh_layer_id != mesh_layer_id) {
-    // TODO(nathan) maybe throw exception
+  if (graph.layer_ids != header->layer_ids ||
+      graph.mesh_layer_id != header->mesh_layer_id) {
     return false;
   }
 
+  if (!header->keyframe && header->sequence != sequence + 1) {
+    return false;  // missed a message
+  }
+
+  deserializer.checkDynamicArray();
+  while (!deserializer.isDynamicArrayEnd()) {
+    deserializer.checkFixedArrayLength(2);
+    NodeId source;
+    deserializer.read(source);
+    NodeId target;
+    deserializer.read(target);
+    graph.removeEdge(source, target);
+  }
+
+  deserializer.checkDynamicArray();
+  while (!deserializer.isDynamicArrayEnd()) {
+    NodeId node;
+    deserializer.read(node);
+    graph.removeNode(node);
+  }
+
   std::unordered_set<NodeId> stale_nodes;
-  for (const auto& id_key_pair : graph.node_lookup()) {
-    stale_nodes.insert(id_key_pair.first);
+  if (header->keyframe) {
+    for (const auto& id_key_pair : graph.node_lookup()) {
+      stale_nodes.insert(id_key_pair.first);
+    }
   }
 
   deserializer.checkDynamicArray();
@@ -396,35 +999,486 @@ bool updateGraphRemoveStale(DynamicSceneGraph& graph,
     graph.removeNode(node_id);
   }
 
-  graph.markEdgesAsStale();
+  if (header->keyframe) {
+    graph.markEdgesAsStale();
+  }
+
   deserializer.checkDynamicArray();
   while (!deserializer.isDynamicArrayEnd()) {
     updateEdge(deserializer, graph);
   }
-  graph.removeAllStaleEdges();
 
-  // TODO(nathan) we might want to not do this
-  graph.clearMeshEdges();
+  if (header->keyframe) {
+    graph.removeAllStaleEdges();
+  }
+
+  bool replace_mesh_edges;
+  deserializer.read(replace_mesh_edges);
+  if (replace_mesh_edges) {
+    graph.clearMeshEdges();
+  }
+
   deserializer.checkDynamicArray();
   while (!deserializer.isDynamicArrayEnd()) {
-    // okay to directly insert, internal checks will prevent duplicates
-    insertMeshEdge(deserializer, graph);
+    const auto edge = readMeshEdgeRecord(deserializer);
+    graph.removeMeshEdge(edge.source_node, edge.mesh_vertex);
+  }
+
+  insertMeshEdges(deserializer, graph);
+
+  bool has_mesh;
+  deserializer.read(has_mesh);
+  if (has_mesh) {
+    insertMesh(deserializer, graph);
+  }
+
+  bool has_mesh_patch;
+  deserializer.read(has_mesh_patch);
+  if (has_mesh_patch) {
+    applyMeshPatch(deserializer, graph);
   }
 
+  sequence = header->sequence;
   return true;
 }
 
-bool updateGraph(DynamicSceneGraph& graph,
-                 const uint8_t* const buffer,
-                 size_t length,
-                 bool remove_stale) {
-  BinaryDeserializer deserializer(buffer, length);
-  if (remove_stale) {
-    return updateGraphRemoveStale(graph, deserializer);
+const std::string_view GRAPH_ARCHIVE_MAGIC("SPARKDSG");
+
+void GraphArchive::write(const DynamicSceneGraph& graph,
+                         const std::string& filepath,
+                         bool include_mesh) {
+  std::vector<Section> sections;
+  std::vector<uint8_t> body;
+  BinarySerializer serializer(&body);
+  const auto add_section =
+      [&](SectionType type, LayerId layer, LayerId other, size_t start) {
+        sections.push_back({type, layer, other, start, body.size() - start});
+      };
+
+  for (const auto& [layer_id, layer] : graph.layers()) {
+    const auto start = body.size();
+    serializer.writeArrayStart();
+    for (const auto& id_node_pair : layer->nodes()) {
+      serializer.write(*id_node_pair.second);
+    }
+    serializer.writeArrayEnd();
+
+    serializer.writeArrayStart();
+    for (const auto& id_edge_pair : layer->edges().sorted()) {
+      serializer.write(*id_edge_pair.second);
+    }
+    serializer.writeArrayEnd();
+    add_section(SectionType::LAYER, layer_id, 0, start);
   }
 
-  graph.clear();
-  return updateGraphNormal(graph, deserializer);
+  for (const auto& [layer_id, layer_group] : graph.dynamicLayers()) {
+    for (const auto& [prefix, layer] : layer_group) {
+      const auto start = body.size();
+      serializer.writeArrayStart();
+      for (const auto& node : layer->nodes()) {
+        serializer.write(*node);
+      }
+      serializer.writeArrayEnd();
+
+      serializer.writeArrayStart();
+      for (const auto& id_edge_pair : layer->edges().sorted()) {
+        serializer.write(*id_edge_pair.second);
+      }
+      serializer.writeArrayEnd();
+      add_section(SectionType::DYNAMIC_LAYER, layer_id, prefix, start);
+    }
+  }
+
+  // group interlayer edges by the (unordered) pair of layers they connect
+  std::map<std::pair<LayerId, LayerId>, std::vector<const SceneGraphEdge*>> interlayer;
+  const auto group_edges = [&](const DynamicSceneGraph::Edges& edges) {
+    for (const auto& id_edge_pair : edges.sorted()) {
+      const auto& edge = *id_edge_pair.second;
+      const auto source = graph.getLayerForNode(edge.source)->layer;
+      const auto target = graph.getLayerForNode(edge.target)->layer;
+      interlayer[std::minmax(source, target)].push_back(&edge);
+    }
+  };
+  group_edges(graph.interlayer_edges());
+  group_edges(graph.dynamic_interlayer_edges());
+
+  for (const auto& [layers, edges] : interlayer) {
+    const auto start = body.size();
+    serializer.writeArrayStart();
+    for (const auto edge : edges) {
+      serializer.write(*edge);
+    }
+    serializer.writeArrayEnd();
+    add_section(SectionType::INTERLAYER_EDGES, layers.first, layers.second, start);
+  }
+
+  std::map<LayerId, std::vector<const MeshEdge*>> mesh_edges;
+  for (const auto& edge : graph.getMeshEdges()) {
+    mesh_edges[graph.getLayerForNode(edge.source_node)->layer].push_back(&edge);
+  }
+
+  for (const auto& [layer_id, edges] : mesh_edges) {
+    const auto start = body.size();
+    serializer.writeArrayStart();
+    for (const auto edge : edges) {
+      serializer.write(*edge);
+    }
+    serializer.writeArrayEnd();
+    add_section(SectionType::MESH_EDGES, layer_id, 0, start);
+  }
+
+  if (include_mesh && graph.hasMesh()) {
+    const auto start = body.size();
+    writeMeshValue(serializer, graph, COMPACT_MESH);
+    add_section(SectionType::MESH, 0, 0, start);
+  }
+
+  std::vector<uint8_t> header;
+  BinarySerializer header_serializer(&header);
+  header_serializer.write(VERSION);
+  header_serializer.write(graph.layer_ids);
+  header_serializer.write(graph.mesh_layer_id);
+  header_serializer.startFixedArray(sections.size());
+  for (const auto& section : sections) {
+    header_serializer.startFixedArray(5);
+    header_serializer.write(static_cast<uint8_t>(section.type));
+    header_serializer.write(section.layer);
+    header_serializer.write(section.other);
+    header_serializer.write(section.offset);
+    header_serializer.write(section.length);
+  }
+
+  std::ofstream outfile(filepath, std::ios::binary);
+  if (!outfile) {
+    throw std::runtime_error("failed to open " + filepath);
+  }
+
+  outfile.write(GRAPH_ARCHIVE_MAGIC.data(), GRAPH_ARCHIVE_MAGIC.size());
+  outfile.write(reinterpret_cast<const char*>(header.data()), header.size());
+  outfile.write(reinterpret_cast<const char*>(body.data()), body.size());
+}
+
+bool GraphArchive::isArchive(const std::string& filepath) {
+  std::ifstream infile(filepath, std::ios::binary);
+  std::string magic(GRAPH_ARCHIVE_MAGIC.size(), '\0');
+  infile.read(magic.data(), magic.size());
+  return infile && magic == GRAPH_ARCHIVE_MAGIC;
+}
+
+GraphArchive::GraphArchive(const std::string& filepath) {
+  const int fd = open(filepath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("failed to open " + filepath);
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    close(fd);
+    throw std::runtime_error("failed to read " + filepath);
+  }
+
+  // the mapping stays valid after the descriptor is closed
+  length_ = info.st_size;
+  void* mapped = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error("failed to map " + filepath);
+  }
+
+  data_ = static_cast<const uint8_t*>(mapped);
+  if (length_ < GRAPH_ARCHIVE_MAGIC.size() ||
+      std::memcmp(data_, GRAPH_ARCHIVE_MAGIC.data(), GRAPH_ARCHIVE_MAGIC.size())) {
+    munmap(const_cast<uint8_t*>(data_), length_);
+    throw std::runtime_error(filepath + " is not a graph archive");
+  }
+
+  const auto header_start = GRAPH_ARCHIVE_MAGIC.size();
+  BinaryDeserializer header(data_ + header_start, length_ - header_start);
+  try {
+    uint32_t version;
+    header.read(version);
+    if (version != VERSION) {
+      throw std::runtime_error("unsupported graph archive version " +
+                               std::to_string(version));
+    }
+
+    std::vector<LayerId> layer_ids;
+    LayerId mesh_layer_id;
+    header.read(layer_ids);
+    header.read(mesh_layer_id);
+    graph_ = std::make_shared<DynamicSceneGraph>(layer_ids, mesh_layer_id);
+
+    sections_.resize(header.readFixedArrayLength());
+    for (auto& section : sections_) {
+      header.checkFixedArrayLength(5);
+      uint8_t type;
+      header.read(type);
+      section.type = static_cast<SectionType>(type);
+      header.read(section.layer);
+      header.read(section.other);
+      header.read(section.offset);
+      header.read(section.length);
+    }
+  } catch (const std::exception& e) {
+    munmap(const_cast<uint8_t*>(data_), length_);
+    throw std::runtime_error("invalid graph archive header in " + filepath + ": " +
+                             e.what());
+  }
+
+  data_offset_ = header_start + header.pos;
+  const auto data_length = length_ - data_offset_;
+  for (const auto& section : sections_) {
+    // compare against the remaining length so untrusted offsets cannot overflow
+    if (section.offset > data_length || section.length > data_length - section.offset) {
+      munmap(const_cast<uint8_t*>(data_), length_);
+      throw std::runtime_error("truncated graph archive " + filepath);
+    }
+  }
+}
+
+GraphArchive::~GraphArchive() { munmap(const_cast<uint8_t*>(data_), length_); }
+
+std::vector<LayerId> GraphArchive::layers() const {
+  std::set<LayerId> layers;
+  for (const auto& section : sections_) {
+    if (section.type == SectionType::LAYER ||
+        section.type == SectionType::DYNAMIC_LAYER) {
+      layers.insert(section.layer);
+    }
+  }
+
+  return std::vector<LayerId>(layers.begin(), layers.end());
+}
+
+bool GraphArchive::hasLayer(LayerId layer) const {
+  for (const auto& section : sections_) {
+    if ((section.type == SectionType::LAYER ||
+         section.type == SectionType::DYNAMIC_LAYER) &&
+        section.layer == layer) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool GraphArchive::isLoaded(LayerId layer) const { return loaded_.count(layer); }
+
+bool GraphArchive::hasMesh() const {
+  for (const auto& section : sections_) {
+    if (section.type == SectionType::MESH) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+struct GraphArchive::DecodedSection {
+  std::vector<NodeRecord> nodes;
+  std::vector<EdgeRecord> edges;
+  std::vector<MeshEdge> mesh_edges;
+  Mesh::Ptr mesh;
+  MeshBlocks mesh_blocks;
+
+  void addNodes(GraphBuilder& builder) {
+    for (auto& node : nodes) {
+      addNode(builder, std::move(node));
+    }
+  }
+
+  void addEdges(GraphBuilder& builder) {
+    for (auto& edge : edges) {
+      addEdge(builder, std::move(edge));
+    }
+  }
+
+  void insertMesh(DynamicSceneGraph& graph) {
+    graph.insertMeshEdges(mesh_edges, true);
+
+    if (mesh) {
+      graph.setMesh(mesh, mesh_blocks, false);
+    }
+  }
+};
+
+bool GraphArchive::loadLayer(LayerId layer) {
+  if (loaded_.count(layer)) {
+    return true;
+  }
+
+  if (!hasLayer(layer)) {
+    return false;
+  }
+
+  for (const auto& section : sections_) {
+    if ((section.type == SectionType::LAYER ||
+         section.type == SectionType::DYNAMIC_LAYER) &&
+        section.layer == layer) {
+      loadSection(section);
+    }
+  }
+
+  loaded_.insert(layer);
+  for (const auto& section : sections_) {
+    if (section.type == SectionType::INTERLAYER_EDGES &&
+        (section.layer == layer || section.other == layer) &&
+        loaded_.count(section.layer) && loaded_.count(section.other)) {
+      loadSection(section);
+    }
+
+    if (section.type == SectionType::MESH_EDGES && section.layer == layer) {
+      loadSection(section);
+    }
+  }
+
+  return true;
+}
+
+const SceneGraphLayer& GraphArchive::getLayer(LayerId layer) {
+  loadLayer(layer);
+  return graph_->getLayer(layer);
+}
+
+bool GraphArchive::loadMesh() {
+  if (mesh_loaded_) {
+    return true;
+  }
+
+  for (const auto& section : sections_) {
+    if (section.type == SectionType::MESH) {
+      loadSection(section);
+      mesh_loaded_ = true;
+    }
+  }
+
+  return mesh_loaded_;
+}
+
+DynamicSceneGraph::Ptr GraphArchive::load(bool include_mesh,
+                                          size_t num_threads,
+                                          DynamicSceneGraph::LoadTimings* timings) {
+  DynamicSceneGraph::LoadTimings local_timings;
+  auto& result = timings ? *timings : local_timings;
+  auto last = std::chrono::steady_clock::now();
+  const auto lap = [&last](double& phase) {
+    const auto now = std::chrono::steady_clock::now();
+    phase += std::chrono::duration<double>(now - last).count();
+    last = now;
+  };
+
+  // every section that isn't loaded yet (interlayer edges to loaded layers included)
+  std::vector<const Section*> to_load;
+  for (const auto& section : sections_) {
+    switch (section.type) {
+      case SectionType::LAYER:
+      case SectionType::DYNAMIC_LAYER:
+      case SectionType::MESH_EDGES:
+        if (!loaded_.count(section.layer)) {
+          to_load.push_back(&section);
+        }
+        break;
+      case SectionType::INTERLAYER_EDGES:
+        if (!loaded_.count(section.layer) || !loaded_.count(section.other)) {
+          to_load.push_back(&section);
+        }
+        break;
+      case SectionType::MESH:
+        if (include_mesh && !mesh_loaded_) {
+          to_load.push_back(&section);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  // sections are independent and decode in parallel (factories are fetched first so
+  // that workers only ever read them)
+  BinaryNodeFactory::get_default();
+  BinaryEdgeFactory::get_default();
+  std::vector<DecodedSection> decoded(to_load.size());
+  graph_utilities::parallelFor(
+      to_load.size(),
+      num_threads,
+      [&](size_t start, size_t end) {
+        for (size_t i = start; i < end; ++i) {
+          decoded[i] = decodeSection(*to_load[i]);
+        }
+      },
+      1);
+  lap(result.decode);
+
+  GraphBuilder builder(*graph_);
+  for (auto& section : decoded) {
+    section.addNodes(builder);
+  }
+  builder.commit();
+  lap(result.nodes);
+
+  for (auto& section : decoded) {
+    section.addEdges(builder);
+  }
+  builder.commit();
+  lap(result.edges);
+
+  for (auto& section : decoded) {
+    section.insertMesh(*graph_);
+  }
+  lap(result.mesh);
+
+  for (const auto layer : layers()) {
+    loaded_.insert(layer);
+  }
+
+  mesh_loaded_ |= include_mesh && hasMesh();
+  return graph_;
+}
+
+GraphArchive::DecodedSection GraphArchive::decodeSection(const Section& section) const {
+  BinaryDeserializer deserializer(data_ + data_offset_ + section.offset,
+                                  section.length);
+  DecodedSection result;
+  switch (section.type) {
+    case SectionType::LAYER:
+    case SectionType::DYNAMIC_LAYER: {
+      const bool is_dynamic = section.type == SectionType::DYNAMIC_LAYER;
+      deserializer.checkDynamicArray();
+      while (!deserializer.isDynamicArrayEnd()) {
+        result.nodes.push_back(readNodeRecord(deserializer, is_dynamic));
+      }
+    }
+      [[fallthrough]];
+    case SectionType::INTERLAYER_EDGES:
+      deserializer.checkDynamicArray();
+      while (!deserializer.isDynamicArrayEnd()) {
+        result.edges.push_back(readEdgeRecord(deserializer));
+      }
+      break;
+    case SectionType::MESH_EDGES:
+      deserializer.checkDynamicArray();
+      while (!deserializer.isDynamicArrayEnd()) {
+        result.mesh_edges.push_back(readMeshEdgeRecord(deserializer));
+      }
+      break;
+    case SectionType::MESH:
+      result.mesh = readMeshValue(deserializer, result.mesh_blocks);
+      break;
+    default:
+      // sections added by newer versions are skipped
+      break;
+  }
+
+  return result;
+}
+
+void GraphArchive::loadSection(const Section& section) {
+  auto decoded = decodeSection(section);
+  GraphBuilder builder(*graph_);
+  decoded.addNodes(builder);
+  decoded.addEdges(builder);
+  builder.commit();
+  decoded.insertMesh(*graph_);
 }
 
 }  // namespace spark_dsg
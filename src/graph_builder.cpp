@@ -0,0 +1,197 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/graph_builder.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#include "spark_dsg/node_symbol.h"
+
+namespace spark_dsg {
+
+GraphBuilder::GraphBuilder(DynamicSceneGraph& graph) : graph_(graph) {}
+
+void GraphBuilder::reserve(size_t num_nodes, size_t num_edges) {
+  nodes_.reserve(num_nodes);
+  edges_.reserve(num_edges);
+}
+
+void GraphBuilder::addNode(LayerId layer, NodeId node, NodeAttributes::Ptr&& attrs) {
+  nodes_.push_back(
+      {LayerKey(layer), node, std::chrono::nanoseconds(0), std::move(attrs)});
+}
+
+void GraphBuilder::addDynamicNode(LayerId layer,
+                                  NodeId node,
+                                  std::chrono::nanoseconds timestamp,
+                                  NodeAttributes::Ptr&& attrs) {
+  const auto prefix = LayerPrefix::fromId(node);
+  nodes_.push_back({LayerKey(layer, prefix), node, timestamp, std::move(attrs)});
+}
+
+void GraphBuilder::addEdge(NodeId source, NodeId target, EdgeAttributes::Ptr&& attrs) {
+  edges_.push_back({source, target, std::move(attrs)});
+}
+
+void GraphBuilder::commit() {
+  check();
+  insertNodes();
+  insertEdges();
+  nodes_.clear();
+  edges_.clear();
+}
+
+void GraphBuilder::check() const {
+  NodeLookup new_nodes;
+  new_nodes.reserve(nodes_.size());
+  for (const auto& node : nodes_) {
+    if (!node.key.dynamic && (node.key.layer == graph_.mesh_layer_id ||
+                              !graph_.hasLayer(node.key.layer))) {
+      std::stringstream ss;
+      ss << "failed to add " << NodeSymbol(node.id).getLabel() << ": invalid layer "
+         << node.key.layer;
+      throw std::runtime_error(ss.str());
+    }
+
+    if (graph_.hasNode(node.id) ||
+        !new_nodes.emplace(node.id, node.key).second) {
+      std::stringstream ss;
+      ss << "failed to add " << NodeSymbol(node.id).getLabel() << ": node exists";
+      throw std::runtime_error(ss.str());
+    }
+  }
+
+  const auto get_key = [&](NodeId node) {
+    const auto new_iter = new_nodes.find(node);
+    if (new_iter != new_nodes.end()) {
+      return new_iter->second;
+    }
+
+    return graph_.getLayerForNode(node).value_or(LayerKey());
+  };
+
+  FlatMap<EdgeKey, bool> new_edges;
+  new_edges.reserve(edges_.size());
+  FlatMap<NodeId, NodeId> new_parents;
+  for (const auto& edge : edges_) {
+    std::string error;
+    const auto source_key = get_key(edge.source);
+    const auto target_key = get_key(edge.target);
+    if (edge.source == edge.target) {
+      error = "self-edge";
+    } else if (!source_key || !target_key) {
+      error = "missing node";
+    } else if (!new_edges.emplace(EdgeKey(edge.source, edge.target), true).second ||
+               graph_.hasEdge(edge.source, edge.target)) {
+      error = "edge exists";
+    } else if (source_key.isParent(target_key) || target_key.isParent(source_key)) {
+      const bool source_is_parent = source_key.isParent(target_key);
+      const auto child = source_is_parent ? edge.target : edge.source;
+      const auto parent = source_is_parent ? edge.source : edge.target;
+      const bool had_parent =
+          !new_nodes.contains(child) && graph_.getNode(child)->get().hasParent();
+      if (had_parent || !new_parents.emplace(child, parent).second) {
+        error = "multiple parents";
+      }
+    }
+
+    if (!error.empty()) {
+      std::stringstream ss;
+      ss << "failed to add " << NodeSymbol(edge.source).getLabel() << " →  "
+         << NodeSymbol(edge.target).getLabel() << ": " << error;
+      throw std::runtime_error(ss.str());
+    }
+  }
+}
+
+void GraphBuilder::insertNodes() {
+  std::map<LayerId, size_t> num_new_nodes;
+  for (const auto& node : nodes_) {
+    if (!node.key.dynamic) {
+      ++num_new_nodes[node.key.layer];
+    }
+  }
+
+  for (const auto& [layer_id, num_nodes] : num_new_nodes) {
+    graph_.reserveNodes(layer_id, num_nodes);
+  }
+
+  std::vector<PendingNode*> dynamic_nodes;
+  for (auto& node : nodes_) {
+    if (node.key.dynamic) {
+      dynamic_nodes.push_back(&node);
+      continue;
+    }
+
+    if (!graph_.emplaceNode(node.key.layer, node.id, std::move(node.attrs))) {
+      throw std::runtime_error("failed to insert " + NodeSymbol(node.id).getLabel());
+    }
+  }
+
+  // dynamic layers are filled in order of node index
+  std::sort(dynamic_nodes.begin(),
+            dynamic_nodes.end(),
+            [](const PendingNode* lhs, const PendingNode* rhs) {
+              return lhs->id < rhs->id;
+            });
+  for (const auto node : dynamic_nodes) {
+    if (!graph_.emplacePrevDynamicNode(
+            node->key.layer, node->id, node->timestamp, std::move(node->attrs))) {
+      throw std::runtime_error("failed to insert " + NodeSymbol(node->id).getLabel());
+    }
+  }
+}
+
+void GraphBuilder::insertEdges() {
+  std::vector<EdgeKey> keys;
+  keys.reserve(edges_.size());
+  for (const auto& edge : edges_) {
+    keys.emplace_back(edge.source, edge.target);
+  }
+
+  // every edge container grows at most once
+  graph_.reserveEdges(keys);
+  for (auto& edge : edges_) {
+    if (!graph_.insertEdge(edge.source, edge.target, std::move(edge.attrs))) {
+      std::stringstream ss;
+      ss << "failed to insert " << NodeSymbol(edge.source).getLabel() << " →  "
+         << NodeSymbol(edge.target).getLabel();
+      throw std::runtime_error(ss.str());
+    }
+  }
+}
+
+}  // namespace spark_dsg
@@ -34,10 +34,15 @@
  * -------------------------------------------------------------------------- */
 #include "spark_dsg/graph_json_serialization.h"
 
+#include <chrono>
+#include <filesystem>
 #include <fstream>
 
 #include "spark_dsg/dynamic_scene_graph.h"
+#include "spark_dsg/graph_binary_serialization.h"
+#include "spark_dsg/graph_builder.h"
 #include "spark_dsg/logging.h"
+#include "spark_dsg/parallel_components.h"
 #include "spark_dsg/scene_graph_layer.h"
 #include "spark_dsg/serialization_helpers.h"
 
@@ -122,7 +127,7 @@ std::string SceneGraphLayer::serializeLayer(const NodeSet& nodes) const {
       continue;
     }
 
-    const auto& node = *nodes_.at(node_id);
+    const auto& node = nodes_.at(node_id);
     record["nodes"].push_back(node);
 
     if (node.siblings().empty()) {
@@ -147,8 +152,8 @@ std::string SceneGraphLayer::toBson() const {
     record["nodes"].push_back(*id_node_pair.second);
   }
 
-  for (const auto& id_edge_pair : edges()) {
-    record["edges"].push_back(id_edge_pair.second);
+  for (const auto& id_edge_pair : edges().sorted()) {
+    record["edges"].push_back(*id_edge_pair.second);
   }
 
   std::string output;
@@ -207,20 +212,25 @@ EdgesPtr SceneGraphLayer::deserializeLayer(const std::string& info) {
         });
   }
 
-  auto new_edges = std::make_unique<Edges>();
+  EdgeContainer new_edges;
   for (const auto& edge : record.at("edges")) {
     read_edge_from_json(
         edge, [&](NodeId source, NodeId target, EdgeAttributes::Ptr&& attrs) {
-          new_edges->emplace(std::piecewise_construct,
-                             std::forward_as_tuple(source, target),
-                             std::forward_as_tuple(source, target, std::move(attrs)));
+          if (!new_edges.contains(source, target)) {
+            new_edges.insert(source, target, std::move(attrs));
+          }
         });
   }
 
-  return new_edges;
+  return std::make_unique<Edges>(std::move(new_edges.edges));
 }
 
 void DynamicSceneGraph::save(const std::string& filepath, bool include_mesh) const {
+  if (std::filesystem::path(filepath).extension() == GraphArchive::EXTENSION) {
+    GraphArchive::write(*this, filepath, include_mesh);
+    return;
+  }
+
   std::ofstream outfile(filepath);
   outfile << this->serialize(include_mesh);
 }
@@ -239,17 +249,17 @@ std::string DynamicSceneGraph::serialize(bool include_mesh) const {
       record["nodes"].push_back(*id_node_pair.second);
     }
 
-    for (const auto& id_edge_pair : id_layer_pair.second->edges()) {
-      record["edges"].push_back(id_edge_pair.second);
+    for (const auto& id_edge_pair : id_layer_pair.second->edges().sorted()) {
+      record["edges"].push_back(*id_edge_pair.second);
     }
   }
 
-  for (const auto& id_edge_pair : interlayer_edges()) {
-    record["edges"].push_back(id_edge_pair.second);
+  for (const auto& id_edge_pair : interlayer_edges().sorted()) {
+    record["edges"].push_back(*id_edge_pair.second);
   }
 
-  for (const auto& id_edge_pair : dynamic_interlayer_edges()) {
-    record["edges"].push_back(id_edge_pair.second);
+  for (const auto& id_edge_pair : dynamic_interlayer_edges().sorted()) {
+    record["edges"].push_back(*id_edge_pair.second);
   }
 
   for (const auto& id_layer_group_pair : dynamic_layers_) {
@@ -268,103 +278,162 @@ std::string DynamicSceneGraph::serialize(bool include_mesh) const {
         record["nodes"].push_back(*layer.nodes_.at(i));
       }
 
-      for (const auto& id_edge_pair : layer.edges_.edges) {
-        record["edges"].push_back(id_edge_pair.second);
+      for (const auto& id_edge_pair : layer.edges_.edges.sorted()) {
+        record["edges"].push_back(*id_edge_pair.second);
       }
     }
   }
 
   record["mesh_edges"] = json::array();
-  for (const auto& id_edge_pair : mesh_edges_) {
-    record.at("mesh_edges").push_back(id_edge_pair.second);
+  for (const auto& edge : mesh_edges_.edges()) {
+    record.at("mesh_edges").push_back(edge);
   }
 
-  if (!mesh_vertices_ || !mesh_faces_ || !include_mesh) {
+  if (!mesh_ || !include_mesh) {
     return record.dump();
   }
 
-  record["mesh"]["vertices"] = *mesh_vertices_;
-  record["mesh"]["faces"] = *mesh_faces_;
+  // the layout isn't stored, so the faces that pad it are dropped
+  record["mesh"] = mesh_blocks_.empty() ? *mesh_ : mesh_blocks_.exportMesh(*mesh_);
   return record.dump();
 }
 
+using LoadTimings = DynamicSceneGraph::LoadTimings;
+
+DynamicSceneGraph::Ptr graphFromJson(const json& record,
+                                     size_t num_threads,
+                                     LoadTimings& timings);
+
 DynamicSceneGraph::Ptr DynamicSceneGraph::load(const std::string& filepath) {
-  std::stringstream ss;
+  return load(filepath, 1);
+}
 
-  std::ifstream infile(filepath);
-  ss << infile.rdbuf();
+DynamicSceneGraph::Ptr DynamicSceneGraph::load(const std::string& filepath,
+                                               size_t num_threads,
+                                               LoadTimings* timings) {
+  LoadTimings local_timings;
+  auto& result = timings ? *timings : local_timings;
+  result = LoadTimings();
+
+  const auto start = std::chrono::steady_clock::now();
+  if (GraphArchive::isArchive(filepath)) {
+    GraphArchive archive(filepath);
+    const auto end = std::chrono::steady_clock::now();
+    result.parse = std::chrono::duration<double>(end - start).count();
+    return archive.load(true, num_threads, &result);
+  }
 
-  return deserialize(ss.str());
+  // parse directly from the file instead of copying the contents first
+  std::ifstream infile(filepath);
+  const auto record = json::parse(infile);
+  const auto end = std::chrono::steady_clock::now();
+  result.parse = std::chrono::duration<double>(end - start).count();
+  return graphFromJson(record, num_threads, result);
 }
 
 DynamicSceneGraph::Ptr DynamicSceneGraph::deserialize(const std::string& contents) {
+  return deserialize(contents, 1);
+}
+
+DynamicSceneGraph::Ptr DynamicSceneGraph::deserialize(const std::string& contents,
+                                                      size_t num_threads,
+                                                      LoadTimings* timings) {
+  LoadTimings local_timings;
+  auto& result = timings ? *timings : local_timings;
+  result = LoadTimings();
+
+  const auto start = std::chrono::steady_clock::now();
   const auto record = json::parse(contents);
+  const auto end = std::chrono::steady_clock::now();
+  result.parse = std::chrono::duration<double>(end - start).count();
+  return graphFromJson(record, num_threads, result);
+}
+
+DynamicSceneGraph::Ptr graphFromJson(const json& record,
+                                     size_t num_threads,
+                                     LoadTimings& timings) {
+  auto last = std::chrono::steady_clock::now();
+  const auto lap = [&last](double& phase) {
+    const auto now = std::chrono::steady_clock::now();
+    phase += std::chrono::duration<double>(now - last).count();
+    last = now;
+  };
+
   const auto mesh_layer_id = record.at("mesh_layer_id").get<LayerId>();
-  const auto layer_ids = record.at("layer_ids").get<LayerIds>();
+  const auto layer_ids = record.at("layer_ids").get<DynamicSceneGraph::LayerIds>();
 
   auto graph = std::make_shared<DynamicSceneGraph>(layer_ids, mesh_layer_id);
 
-  std::map<NodeId, json> dynamic_contents;
-  for (const auto& node : record.at("nodes")) {
+  // attributes don't depend on the graph structure and can be built in parallel
+  // (factories are fetched first so that workers only ever read them)
+  const auto& node_factory = JsonNodeFactory::get_default();
+  const auto& edge_factory = JsonEdgeFactory::get_default();
+  const auto& nodes = record.at("nodes");
+  const auto& edges = record.at("edges");
+  std::vector<NodeAttributes::Ptr> node_attrs(nodes.size());
+  const auto create_node_attrs = [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; ++i) {
+      JsonConverter converter(&nodes[i].at("attributes"));
+      node_attrs[i] = node_factory.create(converter);
+    }
+  };
+  graph_utilities::parallelFor(nodes.size(), num_threads, create_node_attrs);
+
+  std::vector<EdgeAttributes::Ptr> edge_attrs(edges.size());
+  const auto create_edge_attrs = [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; ++i) {
+      JsonConverter converter(&edges[i].at("info"));
+      edge_attrs[i] = edge_factory.create(converter);
+    }
+  };
+  graph_utilities::parallelFor(edges.size(), num_threads, create_edge_attrs);
+  lap(timings.decode);
+
+  // the builder checks the nodes and edges once per batch (and throws if invalid)
+  GraphBuilder builder(*graph);
+  builder.reserve(nodes.size(), edges.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const auto& node = nodes[i];
+    const auto node_id = node.at("id").get<NodeId>();
+    const auto layer = node.at("layer").get<LayerId>();
     if (node.contains("timestamp")) {
-      dynamic_contents[node.at("id").get<NodeId>()] = node;
+      const std::chrono::nanoseconds time(node.at("timestamp").get<uint64_t>());
+      builder.addDynamicNode(layer, node_id, time, std::move(node_attrs[i]));
     } else {
-      read_node_from_json(
-          node, [graph](NodeId id, LayerId layer, NodeAttributes::Ptr&& attrs) {
-            graph->emplaceNode(layer, id, std::move(attrs));
-          });
+      builder.addNode(layer, node_id, std::move(node_attrs[i]));
     }
   }
+  builder.commit();
+  lap(timings.nodes);
 
-  for (const auto& id_content_pair : dynamic_contents) {
-    read_node_from_json(
-        id_content_pair.second,
-        [graph](LayerId layer,
-                NodeId node,
-                std::chrono::nanoseconds time,
-                NodeAttributes::Ptr&& attrs) {
-          if (!graph->emplacePrevDynamicNode(layer, node, time, std::move(attrs))) {
-            std::stringstream ss;
-            ss << "failed to add " << NodeSymbol(node).getLabel();
-            throw std::runtime_error(ss.str());
-          }
-        });
-  }
-
-  for (const auto& edge : record.at("edges")) {
-    read_edge_from_json(
-        edge, [graph](NodeId source, NodeId target, EdgeAttributes::Ptr&& attrs) {
-          if (!graph->insertEdge(source, target, std::move(attrs))) {
-            std::stringstream ss;
-            ss << "failed to add " << NodeSymbol(source).getLabel() << " →  "
-               << NodeSymbol(target).getLabel();
-            throw std::runtime_error(ss.str());
-          }
-        });
+  for (size_t i = 0; i < edges.size(); ++i) {
+    const auto source = edges[i].at("source").get<NodeId>();
+    const auto target = edges[i].at("target").get<NodeId>();
+    builder.addEdge(source, target, std::move(edge_attrs[i]));
   }
+  builder.commit();
+  lap(timings.edges);
 
   if (record.contains("mesh")) {
-    MeshVertices::Ptr new_vertices(new MeshVertices());
-    *new_vertices = record.at("mesh").at("vertices").get<MeshVertices>();
-
-    auto faces = record.at("mesh").at("faces").get<MeshFaces>();
-    auto new_faces = std::make_shared<MeshFaces>(faces.begin(), faces.end());
-
+    auto mesh = std::make_shared<Mesh>(record.at("mesh").get<Mesh>());
     // clear all previous edges
-    graph->setMesh(new_vertices, new_faces, true);
+    graph->setMesh(mesh, true);
   }
 
   if (record.contains("mesh_edges")) {
-    size_t num_inserted = 0;
+    DynamicSceneGraph::MeshEdges edges;
     for (const auto& edge : record.at("mesh_edges")) {
       auto source = edge.at("source").get<NodeId>();
       auto target = edge.at("target").get<size_t>();
-      num_inserted += graph->insertMeshEdge(source, target, true) ? 1 : 0;
+      edges.emplace_back(source, target);
     }
 
+    const auto num_inserted = graph->insertMeshEdges(edges, true);
+
     SG_LOG(INFO) << "Loaded " << num_inserted << " mesh edges" << std::endl;
   }
 
+  lap(timings.mesh);
   return graph;
 }
 
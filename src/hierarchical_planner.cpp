@@ -0,0 +1,153 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/hierarchical_planner.h"
+
+#include "spark_dsg/scene_graph_utilities.h"
+
+namespace spark_dsg {
+
+using graph_utilities::ShortestPath;
+
+HierarchicalPlanner::HierarchicalPlanner(const Config& config) : config(config) {}
+
+std::optional<NodeId> HierarchicalPlanner::getRoom(const DynamicSceneGraph& graph,
+                                                   NodeId place) const {
+  const auto node_opt = graph.getNode(place);
+  if (!node_opt) {
+    return std::nullopt;
+  }
+
+  const auto parent = node_opt->get().getParent();
+  if (!parent) {
+    return std::nullopt;
+  }
+
+  const auto parent_layer = graph.getLayerForNode(*parent);
+  if (!parent_layer || *parent_layer != LayerKey(config.room_layer)) {
+    return std::nullopt;
+  }
+
+  return parent;
+}
+
+HierarchicalPath HierarchicalPlanner::plan(const DynamicSceneGraph& graph,
+                                           NodeId start,
+                                           NodeId goal) {
+  HierarchicalPath result;
+  if (!graph.hasLayer(config.place_layer)) {
+    return result;
+  }
+
+  const auto& places = graph.getLayer(config.place_layer);
+  if (!places.hasNode(start) || !places.hasNode(goal)) {
+    return result;
+  }
+
+  const auto start_room = getRoom(graph, start);
+  const auto goal_room = getRoom(graph, goal);
+  if (start_room && goal_room) {
+    const RestrictedLayer rooms{
+        graph.getLayer(config.room_layer), nullptr, config.metric_room_weights};
+    const auto room_path = graph_utilities::shortestPath(
+        rooms, std::vector<NodeId>{*start_room}, *goal_room, room_workspace_);
+
+    if (!room_path.empty()) {
+      corridor_.clear();
+      corridor_.insert(room_path.nodes.begin(), room_path.nodes.end());
+      if (config.room_dilation > 0) {
+        graph_utilities::breadthFirstSearch<SceneGraphLayer, std::vector<NodeId>>(
+            rooms.layer,
+            room_path.nodes,
+            config.room_dilation,
+            [&](const SceneGraphLayer&, NodeId room) { corridor_.insert(room); });
+      }
+
+      collectPlaces(graph, places);
+      result.places = searchPlaces(places, &allowed_places_, start, goal);
+      if (!result.empty()) {
+        result.rooms = room_path.nodes;
+        return result;
+      }
+    }
+  }
+
+  if (config.fallback_to_flat) {
+    result.places = searchPlaces(places, nullptr, start, goal);
+    result.used_fallback = true;
+  }
+
+  return result;
+}
+
+ShortestPath HierarchicalPlanner::searchPlaces(
+    const SceneGraphLayer& places,
+    const std::unordered_set<NodeId>* allowed,
+    NodeId start,
+    NodeId goal) {
+  const RestrictedLayer view{places, allowed, config.metric_place_weights};
+  graph_utilities::SearchHeuristic heuristic;
+  if (config.metric_place_weights) {
+    // consistent since metric edge weights are the straight-line distance
+    heuristic = graph_utilities::euclideanHeuristic(view, goal);
+  }
+
+  return graph_utilities::shortestPath(
+      view, std::vector<NodeId>{start}, goal, place_workspace_, heuristic);
+}
+
+void HierarchicalPlanner::collectPlaces(const DynamicSceneGraph& graph,
+                                        const SceneGraphLayer& places) {
+  allowed_places_.clear();
+  for (const auto room : corridor_) {
+    getAncestorsOfLayer(
+        graph, room, config.place_layer, [&](const DynamicSceneGraph&, NodeId place) {
+          allowed_places_.insert(place);
+        });
+  }
+
+  // places without a room (e.g. in doorways) often connect rooms
+  std::vector<NodeId> unassigned;
+  for (const auto place : allowed_places_) {
+    for (const auto sibling : places.nodes().at(place).siblings()) {
+      if (!allowed_places_.count(sibling) && !places.nodes().at(sibling).hasParent()) {
+        unassigned.push_back(sibling);
+      }
+    }
+  }
+
+  allowed_places_.insert(unassigned.begin(), unassigned.end());
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,199 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/mesh.h"
+
+#include <pcl/conversions.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace spark_dsg {
+
+bool Mesh::Color::operator==(const Color& other) const {
+  return r == other.r && g == other.g && b == other.b && a == other.a;
+}
+
+Mesh::Mesh(std::vector<float> x,
+           std::vector<float> y,
+           std::vector<float> z,
+           std::vector<Color> colors,
+           std::vector<uint32_t> indices)
+    : x_(std::move(x)),
+      y_(std::move(y)),
+      z_(std::move(z)),
+      colors_(std::move(colors)),
+      indices_(std::move(indices)) {
+  if (y_.size() != x_.size() || z_.size() != x_.size() ||
+      colors_.size() != x_.size()) {
+    throw std::invalid_argument("mesh vertex arrays have inconsistent sizes");
+  }
+
+  if (indices_.size() % 3 != 0) {
+    throw std::invalid_argument("mesh face indices are not a multiple of three");
+  }
+}
+
+bool Mesh::empty() const { return x_.empty() && indices_.empty(); }
+
+void Mesh::clear() {
+  x_.clear();
+  y_.clear();
+  z_.clear();
+  colors_.clear();
+  indices_.clear();
+}
+
+void Mesh::reserve(size_t num_vertices, size_t num_faces) {
+  x_.reserve(num_vertices);
+  y_.reserve(num_vertices);
+  z_.reserve(num_vertices);
+  colors_.reserve(num_vertices);
+  indices_.reserve(3 * num_faces);
+}
+
+void Mesh::resizeVertices(size_t num_vertices) {
+  x_.resize(num_vertices, 0.0f);
+  y_.resize(num_vertices, 0.0f);
+  z_.resize(num_vertices, 0.0f);
+  colors_.resize(num_vertices);
+}
+
+void Mesh::resizeFaces(size_t num_faces) { indices_.resize(3 * num_faces, 0); }
+
+size_t Mesh::addVertex(const Pos& pos, const Color& color) {
+  x_.push_back(pos.x());
+  y_.push_back(pos.y());
+  z_.push_back(pos.z());
+  colors_.push_back(color);
+  return x_.size() - 1;
+}
+
+size_t Mesh::addFace(const Face& face) {
+  indices_.insert(indices_.end(), face.begin(), face.end());
+  return numFaces() - 1;
+}
+
+void Mesh::setPos(size_t index, const Pos& pos) {
+  x_[index] = pos.x();
+  y_[index] = pos.y();
+  z_[index] = pos.z();
+}
+
+Mesh::Face Mesh::face(size_t index) const {
+  const auto offset = 3 * index;
+  return {indices_[offset], indices_[offset + 1], indices_[offset + 2]};
+}
+
+void Mesh::setFace(size_t index, const Face& face) {
+  std::copy(face.begin(), face.end(), indices_.begin() + 3 * index);
+}
+
+bool Mesh::operator==(const Mesh& other) const {
+  return x_ == other.x_ && y_ == other.y_ && z_ == other.z_ &&
+         colors_ == other.colors_ && indices_ == other.indices_;
+}
+
+Mesh Mesh::fromPcl(const PclVertices& vertices, const PclFaces* faces) {
+  Mesh mesh;
+  mesh.resizeVertices(vertices.size());
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    const auto& point = vertices[i];
+    mesh.x_[i] = point.x;
+    mesh.y_[i] = point.y;
+    mesh.z_[i] = point.z;
+    mesh.colors_[i] = {point.r, point.g, point.b, point.a};
+  }
+
+  if (!faces) {
+    return mesh;
+  }
+
+  size_t num_triangles = 0;
+  for (const auto& polygon : *faces) {
+    num_triangles += polygon.vertices.size() < 3 ? 0 : polygon.vertices.size() - 2;
+  }
+
+  mesh.indices_.reserve(3 * num_triangles);
+  for (const auto& polygon : *faces) {
+    const auto& indices = polygon.vertices;
+    for (size_t i = 2; i < indices.size(); ++i) {
+      mesh.addFace({indices[0], indices[i - 1], indices[i]});
+    }
+  }
+
+  return mesh;
+}
+
+Mesh Mesh::fromPcl(const pcl::PolygonMesh& mesh) {
+  PclVertices vertices;
+  pcl::fromPCLPointCloud2(mesh.cloud, vertices);
+  return fromPcl(vertices, &mesh.polygons);
+}
+
+Mesh::PclVertices::Ptr Mesh::toPclVertices() const {
+  PclVertices::Ptr vertices(new PclVertices());
+  vertices->resize(numVertices());
+  for (size_t i = 0; i < numVertices(); ++i) {
+    auto& point = (*vertices)[i];
+    point.x = x_[i];
+    point.y = y_[i];
+    point.z = z_[i];
+    point.r = colors_[i].r;
+    point.g = colors_[i].g;
+    point.b = colors_[i].b;
+    point.a = colors_[i].a;
+  }
+
+  return vertices;
+}
+
+std::shared_ptr<Mesh::PclFaces> Mesh::toPclFaces() const {
+  auto faces = std::make_shared<PclFaces>(numFaces());
+  for (size_t i = 0; i < numFaces(); ++i) {
+    const auto offset = indices_.begin() + 3 * i;
+    (*faces)[i].vertices.assign(offset, offset + 3);
+  }
+
+  return faces;
+}
+
+pcl::PolygonMesh Mesh::toPcl() const {
+  pcl::PolygonMesh mesh;
+  pcl::toPCLPointCloud2(*toPclVertices(), mesh.cloud);
+  mesh.polygons = *toPclFaces();
+  return mesh;
+}
+
+}  // namespace spark_dsg
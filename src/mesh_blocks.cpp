@@ -0,0 +1,278 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/mesh_blocks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace spark_dsg {
+
+namespace {
+
+using Range = std::pair<size_t, size_t>;
+
+// first gap of at least length items after the start that no range overlaps
+size_t findFreeRange(std::vector<Range>& occupied, size_t start, size_t length) {
+  std::sort(occupied.begin(), occupied.end());
+  size_t cursor = start;
+  for (const auto& [offset, range_length] : occupied) {
+    if (offset >= cursor && offset - cursor >= length) {
+      return cursor;
+    }
+
+    cursor = std::max(cursor, offset + range_length);
+  }
+
+  return cursor;
+}
+
+}  // namespace
+
+bool MeshBlockInfo::operator==(const MeshBlockInfo& other) const {
+  return version == other.version && vertex_offset == other.vertex_offset &&
+         vertex_capacity == other.vertex_capacity &&
+         num_vertices == other.num_vertices && face_offset == other.face_offset &&
+         face_capacity == other.face_capacity && num_faces == other.num_faces;
+}
+
+uint64_t MeshBlocks::nextId() {
+  static std::atomic<uint64_t> next_id{0};
+  return ++next_id;
+}
+
+MeshBlocks::MeshBlocks(size_t base_vertices, size_t base_faces)
+    : base_vertices_(base_vertices), base_faces_(base_faces) {}
+
+std::optional<MeshBlockInfo> MeshBlocks::getBlock(const Index& index) const {
+  auto iter = blocks_.find(index);
+  if (iter == blocks_.end()) {
+    return std::nullopt;
+  }
+
+  return iter->second;
+}
+
+MeshBlockInfo MeshBlocks::upsert(Mesh& mesh,
+                                 const Index& index,
+                                 const Mesh& block,
+                                 const MeshBlockInfo* layout) {
+  for (const auto vertex : block.indices()) {
+    if (vertex >= block.numVertices()) {
+      throw std::invalid_argument("block face refers to vertex " +
+                                  std::to_string(vertex) + " outside of the block");
+    }
+  }
+
+  if (layout && (layout->vertex_capacity < block.numVertices() ||
+                 layout->face_capacity < block.numFaces())) {
+    throw std::invalid_argument("block does not fit into the requested layout");
+  }
+
+  std::optional<MeshBlockInfo> previous;
+  auto iter = blocks_.find(index);
+  if (iter != blocks_.end()) {
+    previous = iter->second;
+    blocks_.erase(iter);
+  }
+
+  MeshBlockInfo info;
+  if (layout) {
+    info = *layout;
+    last_version_ = std::max(last_version_, info.version);
+  } else {
+    info.version = ++last_version_;
+    if (previous && previous->vertex_capacity >= block.numVertices()) {
+      info.vertex_offset = previous->vertex_offset;
+      info.vertex_capacity = previous->vertex_capacity;
+    } else {
+      std::vector<Range> occupied;
+      for (const auto& [other_index, other] : blocks_) {
+        occupied.emplace_back(other.vertex_offset, other.vertex_capacity);
+      }
+
+      info.vertex_offset = findFreeRange(occupied, base_vertices_, block.numVertices());
+      info.vertex_capacity = block.numVertices();
+    }
+
+    if (previous && previous->face_capacity >= block.numFaces()) {
+      info.face_offset = previous->face_offset;
+      info.face_capacity = previous->face_capacity;
+    } else {
+      std::vector<Range> occupied;
+      for (const auto& [other_index, other] : blocks_) {
+        occupied.emplace_back(other.face_offset, other.face_capacity);
+      }
+
+      info.face_offset = findFreeRange(occupied, base_faces_, block.numFaces());
+      info.face_capacity = block.numFaces();
+    }
+  }
+
+  info.num_vertices = block.numVertices();
+  info.num_faces = block.numFaces();
+
+  if (previous) {
+    clearRanges(mesh, *previous);
+  }
+
+  const auto vertex_end = info.vertex_offset + info.vertex_capacity;
+  if (mesh.numVertices() < vertex_end) {
+    mesh.resizeVertices(vertex_end);
+  }
+
+  const auto face_end = info.face_offset + info.face_capacity;
+  if (mesh.numFaces() < face_end) {
+    mesh.resizeFaces(face_end);
+  }
+
+  // the ranges are cleared, so only the contents of the block need to be written
+  for (size_t i = 0; i < block.numVertices(); ++i) {
+    mesh.setPos(info.vertex_offset + i, block.pos(i));
+    mesh.setColor(info.vertex_offset + i, block.color(i));
+  }
+
+  const auto offset = static_cast<uint32_t>(info.vertex_offset);
+  for (size_t i = 0; i < block.numFaces(); ++i) {
+    auto face = block.face(i);
+    face[0] += offset;
+    face[1] += offset;
+    face[2] += offset;
+    mesh.setFace(info.face_offset + i, face);
+  }
+
+  blocks_[index] = info;
+  trim(mesh);
+  return info;
+}
+
+std::optional<MeshBlockInfo> MeshBlocks::remove(Mesh& mesh, const Index& index) {
+  auto iter = blocks_.find(index);
+  if (iter == blocks_.end()) {
+    return std::nullopt;
+  }
+
+  const auto info = iter->second;
+  blocks_.erase(iter);
+  clearRanges(mesh, info);
+  trim(mesh);
+  return info;
+}
+
+void MeshBlocks::restore(const Index& index, const MeshBlockInfo& info) {
+  blocks_[index] = info;
+  last_version_ = std::max(last_version_, info.version);
+}
+
+Mesh MeshBlocks::extract(const Mesh& mesh, const Index& index) const {
+  Mesh block;
+  auto iter = blocks_.find(index);
+  if (iter == blocks_.end()) {
+    return block;
+  }
+
+  const auto& info = iter->second;
+  block.reserve(info.num_vertices, info.num_faces);
+  for (size_t i = 0; i < info.num_vertices; ++i) {
+    block.addVertex(mesh.pos(info.vertex_offset + i),
+                    mesh.color(info.vertex_offset + i));
+  }
+
+  const auto offset = static_cast<uint32_t>(info.vertex_offset);
+  for (size_t i = 0; i < info.num_faces; ++i) {
+    auto face = mesh.face(info.face_offset + i);
+    face[0] -= offset;
+    face[1] -= offset;
+    face[2] -= offset;
+    block.addFace(face);
+  }
+
+  return block;
+}
+
+Mesh MeshBlocks::exportMesh(const Mesh& mesh) const {
+  std::vector<Range> used{{0, base_faces_}};
+  for (const auto& [index, info] : blocks_) {
+    used.emplace_back(info.face_offset, info.num_faces);
+  }
+
+  std::sort(used.begin(), used.end());
+  const auto& source = mesh.indices();
+  std::vector<uint32_t> indices;
+  indices.reserve(source.size());
+  for (const auto& [offset, length] : used) {
+    const auto end = std::min(offset + length, mesh.numFaces());
+    if (offset < end) {
+      indices.insert(indices.end(), source.begin() + 3 * offset, source.begin() + 3 * end);
+    }
+  }
+
+  return Mesh(mesh.xs(), mesh.ys(), mesh.zs(), mesh.colors(), std::move(indices));
+}
+
+void MeshBlocks::clearRanges(Mesh& mesh, const MeshBlockInfo& info) const {
+  const auto vertex_end =
+      std::min(info.vertex_offset + info.vertex_capacity, mesh.numVertices());
+  for (size_t i = info.vertex_offset; i < vertex_end; ++i) {
+    mesh.setPos(i, Mesh::Pos::Zero());
+    mesh.setColor(i, Mesh::Color());
+  }
+
+  const auto face_end =
+      std::min(info.face_offset + info.face_capacity, mesh.numFaces());
+  for (size_t i = info.face_offset; i < face_end; ++i) {
+    mesh.setFace(i, {0, 0, 0});
+  }
+}
+
+void MeshBlocks::trim(Mesh& mesh) const {
+  size_t vertex_end = base_vertices_;
+  size_t face_end = base_faces_;
+  for (const auto& [index, info] : blocks_) {
+    vertex_end = std::max(vertex_end, info.vertex_offset + info.vertex_capacity);
+    face_end = std::max(face_end, info.face_offset + info.face_capacity);
+  }
+
+  if (mesh.numVertices() > vertex_end) {
+    mesh.resizeVertices(vertex_end);
+  }
+
+  if (mesh.numFaces() > face_end) {
+    mesh.resizeFaces(face_end);
+  }
+}
+
+}  // namespace spark_dsg
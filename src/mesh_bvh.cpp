@@ -0,0 +1,658 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/mesh_bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+namespace spark_dsg {
+
+namespace {
+
+using Vec = Eigen::Vector3f;
+using Arr = Eigen::Array3f;
+
+constexpr size_t NUM_BINS = 16;
+
+inline float halfArea(const Arr& min, const Arr& max) {
+  const Arr extent = (max - min).max(0.0f);
+  return extent.x() * extent.y() + extent.y() * extent.z() + extent.z() * extent.x();
+}
+
+inline float boxDistanceSquared(const Arr& min, const Arr& max, const Arr& point) {
+  return (min - point).max(point - max).max(0.0f).matrix().squaredNorm();
+}
+
+uint64_t hashFaces(const std::vector<uint32_t>& indices) {
+  uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+  for (const auto index : indices) {
+    hash = (hash ^ index) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+Vec closestOnSegment(const Vec& point, const Vec& a, const Vec& b) {
+  const Vec ab = b - a;
+  const float length_sq = ab.squaredNorm();
+  if (length_sq <= 0.0f) {
+    return a;
+  }
+
+  const float t = std::clamp((point - a).dot(ab) / length_sq, 0.0f, 1.0f);
+  return a + t * ab;
+}
+
+// from "Real-Time Collision Detection" (Ericson), section 5.1.5
+Vec closestOnTriangle(const Vec& p, const Vec& a, const Vec& b, const Vec& c) {
+  const Vec ab = b - a;
+  const Vec ac = c - a;
+  const Vec ap = p - a;
+  const float d1 = ab.dot(ap);
+  const float d2 = ac.dot(ap);
+  if (d1 <= 0.0f && d2 <= 0.0f) {
+    return a;
+  }
+
+  const Vec bp = p - b;
+  const float d3 = ab.dot(bp);
+  const float d4 = ac.dot(bp);
+  if (d3 >= 0.0f && d4 <= d3) {
+    return b;
+  }
+
+  const float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+    return a + (d1 / (d1 - d3)) * ab;
+  }
+
+  const Vec cp = p - c;
+  const float d5 = ab.dot(cp);
+  const float d6 = ac.dot(cp);
+  if (d6 >= 0.0f && d5 <= d6) {
+    return c;
+  }
+
+  const float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+    return a + (d2 / (d2 - d6)) * ac;
+  }
+
+  const float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+    return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+  }
+
+  const float total = va + vb + vc;
+  if (!(total > 0.0f)) {
+    // zero area triangle: closest point is on one of the edges
+    const std::array<Vec, 3> candidates{closestOnSegment(p, a, b),
+                                        closestOnSegment(p, b, c),
+                                        closestOnSegment(p, c, a)};
+    return *std::min_element(
+        candidates.begin(), candidates.end(), [&p](const Vec& lhs, const Vec& rhs) {
+          return (lhs - p).squaredNorm() < (rhs - p).squaredNorm();
+        });
+  }
+
+  return a + ab * (vb / total) + ac * (vc / total);
+}
+
+// Moller-Trumbore (two-sided)
+std::optional<float> intersect(const Vec& origin,
+                               const Vec& direction,
+                               const Vec& a,
+                               const Vec& b,
+                               const Vec& c) {
+  const Vec ab = b - a;
+  const Vec ac = c - a;
+  const Vec p = direction.cross(ac);
+  const float det = ab.dot(p);
+  if (std::abs(det) < 1.0e-12f) {
+    return std::nullopt;
+  }
+
+  const float inv_det = 1.0f / det;
+  const Vec s = origin - a;
+  const float u = s.dot(p) * inv_det;
+  if (u < 0.0f || u > 1.0f) {
+    return std::nullopt;
+  }
+
+  const Vec q = s.cross(ab);
+  const float v = direction.dot(q) * inv_det;
+  if (v < 0.0f || u + v > 1.0f) {
+    return std::nullopt;
+  }
+
+  const float t = ac.dot(q) * inv_det;
+  if (t < 0.0f) {
+    return std::nullopt;
+  }
+
+  return t;
+}
+
+}  // namespace
+
+MeshBvh::MeshBvh(size_t max_leaf_size)
+    : max_leaf_size_(std::max<size_t>(max_leaf_size, 1)) {}
+
+MeshBvh::MeshBvh(const Mesh& mesh, size_t max_leaf_size) : MeshBvh(max_leaf_size) {
+  build(mesh);
+}
+
+void MeshBvh::build(const Mesh& mesh) {
+  nodes_.clear();
+  parents_.clear();
+  order_.clear();
+  indices_.clear();
+  triangles_.clear();
+  leaves_.clear();
+  num_faces_ = mesh.numFaces();
+  faces_hash_ = hashFaces(mesh.indices());
+
+  const auto num_vertices = mesh.numVertices();
+  for (size_t i = 0; i < mesh.numFaces(); ++i) {
+    const auto face = mesh.face(i);
+    const bool degenerate =
+        face[0] == face[1] || face[1] == face[2] || face[2] == face[0];
+    const bool valid = face[0] < num_vertices && face[1] < num_vertices &&
+                       face[2] < num_vertices;
+    if (!degenerate && valid) {
+      order_.push_back(i);
+    }
+  }
+
+  const auto num_triangles = order_.size();
+  vertex_offsets_.assign(num_vertices + 1, 0);
+  vertex_triangles_.clear();
+  if (order_.empty()) {
+    return;
+  }
+
+  // bounds and centroids of every triangle for the split heuristic
+  std::vector<Arr> mins(num_triangles);
+  std::vector<Arr> maxs(num_triangles);
+  std::vector<Arr> centroids(num_triangles);
+  for (size_t i = 0; i < num_triangles; ++i) {
+    const auto face = mesh.face(order_[i]);
+    const Arr a = mesh.pos(face[0]).array();
+    const Arr b = mesh.pos(face[1]).array();
+    const Arr c = mesh.pos(face[2]).array();
+    mins[i] = a.min(b).min(c);
+    maxs[i] = a.max(b).max(c);
+    centroids[i] = 0.5f * (mins[i] + maxs[i]);
+  }
+
+  std::vector<uint32_t> items(num_triangles);
+  std::iota(items.begin(), items.end(), 0);
+
+  struct Task {
+    uint32_t node;
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  nodes_.reserve(2 * num_triangles / max_leaf_size_ + 1);
+  nodes_.push_back({});
+  parents_.push_back(npos);
+  std::vector<Task> tasks{{0, 0, static_cast<uint32_t>(num_triangles)}};
+  while (!tasks.empty()) {
+    const auto task = tasks.back();
+    tasks.pop_back();
+
+    Arr node_min = Arr::Constant(std::numeric_limits<float>::max());
+    Arr node_max = Arr::Constant(std::numeric_limits<float>::lowest());
+    Arr centroid_min = node_min;
+    Arr centroid_max = node_max;
+    for (auto i = task.begin; i < task.end; ++i) {
+      node_min = node_min.min(mins[items[i]]);
+      node_max = node_max.max(maxs[items[i]]);
+      centroid_min = centroid_min.min(centroids[items[i]]);
+      centroid_max = centroid_max.max(centroids[items[i]]);
+    }
+
+    auto& node = nodes_[task.node];
+    node.min = node_min;
+    node.max = node_max;
+    const auto count = task.end - task.begin;
+    if (count <= max_leaf_size_) {
+      node.start = task.begin;
+      node.count = count;
+      continue;
+    }
+
+    // pick the binned split with the lowest surface area heuristic cost
+    int best_axis = -1;
+    size_t best_bin = 0;
+    float best_cost = std::numeric_limits<float>::max();
+    const Arr extent = centroid_max - centroid_min;
+    for (int axis = 0; axis < 3; ++axis) {
+      if (!(extent[axis] > 0.0f)) {
+        continue;
+      }
+
+      std::array<size_t, NUM_BINS> counts{};
+      std::array<Arr, NUM_BINS> bin_mins;
+      std::array<Arr, NUM_BINS> bin_maxs;
+      bin_mins.fill(Arr::Constant(std::numeric_limits<float>::max()));
+      bin_maxs.fill(Arr::Constant(std::numeric_limits<float>::lowest()));
+      const float scale = NUM_BINS / extent[axis];
+      for (auto i = task.begin; i < task.end; ++i) {
+        const auto item = items[i];
+        const auto bin = std::min<size_t>(
+            (centroids[item][axis] - centroid_min[axis]) * scale, NUM_BINS - 1);
+        ++counts[bin];
+        bin_mins[bin] = bin_mins[bin].min(mins[item]);
+        bin_maxs[bin] = bin_maxs[bin].max(maxs[item]);
+      }
+
+      // cost of the right side of every split from a sweep in reverse
+      std::array<float, NUM_BINS> right_costs{};
+      Arr right_min = Arr::Constant(std::numeric_limits<float>::max());
+      Arr right_max = Arr::Constant(std::numeric_limits<float>::lowest());
+      size_t right_count = 0;
+      for (size_t bin = NUM_BINS - 1; bin > 0; --bin) {
+        right_min = right_min.min(bin_mins[bin]);
+        right_max = right_max.max(bin_maxs[bin]);
+        right_count += counts[bin];
+        right_costs[bin] = right_count * halfArea(right_min, right_max);
+      }
+
+      Arr left_min = Arr::Constant(std::numeric_limits<float>::max());
+      Arr left_max = Arr::Constant(std::numeric_limits<float>::lowest());
+      size_t left_count = 0;
+      for (size_t bin = 1; bin < NUM_BINS; ++bin) {
+        left_min = left_min.min(bin_mins[bin - 1]);
+        left_max = left_max.max(bin_maxs[bin - 1]);
+        left_count += counts[bin - 1];
+        if (left_count == 0 || left_count == count) {
+          continue;
+        }
+
+        const float cost = left_count * halfArea(left_min, left_max) + right_costs[bin];
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = axis;
+          best_bin = bin;
+        }
+      }
+    }
+
+    uint32_t middle;
+    if (best_axis < 0) {
+      // all centroids coincide, so any partition is as good as another
+      middle = task.begin + count / 2;
+    } else {
+      const float scale = NUM_BINS / extent[best_axis];
+      const auto split = std::partition(
+          items.begin() + task.begin, items.begin() + task.end, [&](uint32_t item) {
+            const auto bin = std::min<size_t>(
+                (centroids[item][best_axis] - centroid_min[best_axis]) * scale,
+                NUM_BINS - 1);
+            return bin < best_bin;
+          });
+      middle = split - items.begin();
+    }
+
+    const auto left = static_cast<uint32_t>(nodes_.size());
+    node.start = left;
+    node.count = 0;
+    nodes_.push_back({});
+    nodes_.push_back({});
+    parents_.push_back(task.node);
+    parents_.push_back(task.node);
+    tasks.push_back({left, task.begin, middle});
+    tasks.push_back({left + 1, middle, task.end});
+  }
+
+  // store the triangles in leaf order so leaves refer to contiguous ranges
+  std::vector<uint32_t> faces(num_triangles);
+  for (size_t i = 0; i < num_triangles; ++i) {
+    faces[i] = order_[items[i]];
+  }
+  order_ = std::move(faces);
+
+  indices_.resize(num_triangles);
+  triangles_.resize(num_triangles);
+  leaves_.resize(num_triangles);
+  for (uint32_t slot = 0; slot < num_triangles; ++slot) {
+    indices_[slot] = mesh.face(order_[slot]);
+    loadTriangle(mesh, slot);
+  }
+
+  for (uint32_t node = 0; node < nodes_.size(); ++node) {
+    const auto& info = nodes_[node];
+    if (!info.count) {
+      continue;
+    }
+
+    std::fill_n(leaves_.begin() + info.start, info.count, node);
+  }
+
+  for (const auto& face : indices_) {
+    for (const auto vertex : face) {
+      ++vertex_offsets_[vertex + 1];
+    }
+  }
+
+  for (size_t i = 0; i < num_vertices; ++i) {
+    vertex_offsets_[i + 1] += vertex_offsets_[i];
+  }
+
+  vertex_triangles_.resize(vertex_offsets_.back());
+  std::vector<uint32_t> cursors(vertex_offsets_.begin(), vertex_offsets_.end() - 1);
+  for (uint32_t slot = 0; slot < num_triangles; ++slot) {
+    for (const auto vertex : indices_[slot]) {
+      vertex_triangles_[cursors[vertex]++] = slot;
+    }
+  }
+}
+
+void MeshBvh::refit(const Mesh& mesh) {
+  for (uint32_t slot = 0; slot < triangles_.size(); ++slot) {
+    loadTriangle(mesh, slot);
+  }
+
+  // children always come after their parents
+  for (auto node = static_cast<uint32_t>(nodes_.size()); node-- > 0;) {
+    if (nodes_[node].count) {
+      fitLeaf(node);
+    } else {
+      fitInner(node);
+    }
+  }
+}
+
+void MeshBvh::refit(const Mesh& mesh, const std::vector<size_t>& vertices) {
+  std::vector<uint32_t> dirty;
+  for (const auto vertex : vertices) {
+    if (vertex + 1 >= vertex_offsets_.size()) {
+      continue;
+    }
+
+    for (auto i = vertex_offsets_[vertex]; i < vertex_offsets_[vertex + 1]; ++i) {
+      const auto slot = vertex_triangles_[i];
+      loadTriangle(mesh, slot);
+      dirty.push_back(leaves_[slot]);
+    }
+  }
+
+  std::sort(dirty.begin(), dirty.end());
+  dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+  for (const auto leaf : dirty) {
+    fitLeaf(leaf);
+  }
+
+  // parents have lower indices than their children, so walk up from the back
+  std::vector<uint32_t> parents;
+  for (const auto leaf : dirty) {
+    if (parents_[leaf] != npos) {
+      parents.push_back(parents_[leaf]);
+    }
+  }
+
+  while (!parents.empty()) {
+    std::sort(parents.begin(), parents.end());
+    parents.erase(std::unique(parents.begin(), parents.end()), parents.end());
+    std::vector<uint32_t> next;
+    for (const auto node : parents) {
+      fitInner(node);
+      if (parents_[node] != npos) {
+        next.push_back(parents_[node]);
+      }
+    }
+
+    parents = std::move(next);
+  }
+}
+
+bool MeshBvh::update(const Mesh& mesh) {
+  if (mesh.numFaces() == num_faces_ && hashFaces(mesh.indices()) == faces_hash_ &&
+      mesh.numVertices() + 1 >= vertex_offsets_.size()) {
+    refit(mesh);
+    return false;
+  }
+
+  build(mesh);
+  return true;
+}
+
+std::optional<MeshBvh::Hit> MeshBvh::closestPoint(const Eigen::Vector3d& point,
+                                                  double max_distance) const {
+  if (nodes_.empty()) {
+    return std::nullopt;
+  }
+
+  const Vec query = point.cast<float>();
+  const Arr query_arr = query.array();
+  float best_sq = std::isinf(max_distance)
+                      ? std::numeric_limits<float>::infinity()
+                      : static_cast<float>(max_distance * max_distance);
+  uint32_t best_slot = npos;
+  Vec best_point;
+
+  std::vector<uint32_t> stack{0};
+  while (!stack.empty()) {
+    const auto& node = nodes_[stack.back()];
+    stack.pop_back();
+    if (boxDistanceSquared(node.min, node.max, query_arr) > best_sq) {
+      continue;
+    }
+
+    if (node.count) {
+      for (auto slot = node.start; slot < node.start + node.count; ++slot) {
+        const auto& tri = triangles_[slot];
+        const Vec closest = closestOnTriangle(query, tri.a, tri.b, tri.c);
+        const float distance_sq = (closest - query).squaredNorm();
+        if (distance_sq <= best_sq) {
+          best_sq = distance_sq;
+          best_slot = slot;
+          best_point = closest;
+        }
+      }
+      continue;
+    }
+
+    // visit the closer child first (it is pushed last)
+    const auto& left = nodes_[node.start];
+    const auto& right = nodes_[node.start + 1];
+    const float left_sq = boxDistanceSquared(left.min, left.max, query_arr);
+    const float right_sq = boxDistanceSquared(right.min, right.max, query_arr);
+    if (left_sq < right_sq) {
+      stack.push_back(node.start + 1);
+      stack.push_back(node.start);
+    } else {
+      stack.push_back(node.start);
+      stack.push_back(node.start + 1);
+    }
+  }
+
+  if (best_slot == npos) {
+    return std::nullopt;
+  }
+
+  return makeHit(best_slot, best_point, std::sqrt(best_sq));
+}
+
+std::optional<MeshBvh::Hit> MeshBvh::raycast(const Eigen::Vector3d& origin,
+                                             const Eigen::Vector3d& direction,
+                                             double max_distance) const {
+  const double norm = direction.norm();
+  if (nodes_.empty() || !(norm > 0.0)) {
+    return std::nullopt;
+  }
+
+  const Vec ray_origin = origin.cast<float>();
+  const Vec ray_dir = (direction / norm).cast<float>();
+  // avoid 0 * inf in the slab test for axis-aligned rays
+  const Arr safe_dir = ray_dir.array().unaryExpr([](float value) {
+    return std::abs(value) < 1.0e-20f ? std::copysign(1.0e-20f, value) : value;
+  });
+  const Arr inv_dir = safe_dir.inverse();
+  const Arr origin_arr = ray_origin.array();
+
+  float best_t = std::isinf(max_distance) ? std::numeric_limits<float>::infinity()
+                                          : static_cast<float>(max_distance);
+  uint32_t best_slot = npos;
+
+  // entry distance of the ray into a box (if it hits the box before the best hit)
+  const auto enter = [&](const Node& node) -> std::optional<float> {
+    const Arr t0 = (node.min - origin_arr) * inv_dir;
+    const Arr t1 = (node.max - origin_arr) * inv_dir;
+    const float t_near = std::max(t0.min(t1).maxCoeff(), 0.0f);
+    const float t_far = t0.max(t1).minCoeff();
+    if (t_near > t_far || t_near > best_t) {
+      return std::nullopt;
+    }
+    return t_near;
+  };
+
+  std::vector<uint32_t> stack;
+  if (enter(nodes_[0])) {
+    stack.push_back(0);
+  }
+
+  while (!stack.empty()) {
+    const auto& node = nodes_[stack.back()];
+    stack.pop_back();
+    if (node.count) {
+      for (auto slot = node.start; slot < node.start + node.count; ++slot) {
+        const auto& tri = triangles_[slot];
+        const auto t = intersect(ray_origin, ray_dir, tri.a, tri.b, tri.c);
+        if (t && *t <= best_t) {
+          best_t = *t;
+          best_slot = slot;
+        }
+      }
+      continue;
+    }
+
+    const auto left_t = enter(nodes_[node.start]);
+    const auto right_t = enter(nodes_[node.start + 1]);
+    if (left_t && right_t) {
+      const bool left_first = *left_t < *right_t;
+      stack.push_back(left_first ? node.start + 1 : node.start);
+      stack.push_back(left_first ? node.start : node.start + 1);
+    } else if (left_t) {
+      stack.push_back(node.start);
+    } else if (right_t) {
+      stack.push_back(node.start + 1);
+    }
+  }
+
+  if (best_slot == npos) {
+    return std::nullopt;
+  }
+
+  return makeHit(best_slot, ray_origin + best_t * ray_dir, best_t);
+}
+
+void MeshBvh::sphereQuery(const Eigen::Vector3d& center,
+                          double radius,
+                          std::vector<Hit>& result) const {
+  if (nodes_.empty() || radius < 0.0) {
+    return;
+  }
+
+  const Vec query = center.cast<float>();
+  const Arr query_arr = query.array();
+  const float radius_sq = static_cast<float>(radius * radius);
+  std::vector<uint32_t> stack{0};
+  while (!stack.empty()) {
+    const auto& node = nodes_[stack.back()];
+    stack.pop_back();
+    if (boxDistanceSquared(node.min, node.max, query_arr) > radius_sq) {
+      continue;
+    }
+
+    if (!node.count) {
+      stack.push_back(node.start);
+      stack.push_back(node.start + 1);
+      continue;
+    }
+
+    for (auto slot = node.start; slot < node.start + node.count; ++slot) {
+      const auto& tri = triangles_[slot];
+      const Vec closest = closestOnTriangle(query, tri.a, tri.b, tri.c);
+      const float distance_sq = (closest - query).squaredNorm();
+      if (distance_sq <= radius_sq) {
+        result.push_back(makeHit(slot, closest, std::sqrt(distance_sq)));
+      }
+    }
+  }
+}
+
+void MeshBvh::loadTriangle(const Mesh& mesh, uint32_t slot) {
+  const auto& face = indices_[slot];
+  triangles_[slot] = {mesh.pos(face[0]), mesh.pos(face[1]), mesh.pos(face[2])};
+}
+
+void MeshBvh::fitLeaf(uint32_t node) {
+  auto& info = nodes_[node];
+  info.min = Arr::Constant(std::numeric_limits<float>::max());
+  info.max = Arr::Constant(std::numeric_limits<float>::lowest());
+  for (auto slot = info.start; slot < info.start + info.count; ++slot) {
+    const auto& tri = triangles_[slot];
+    info.min = info.min.min(tri.a.array()).min(tri.b.array()).min(tri.c.array());
+    info.max = info.max.max(tri.a.array()).max(tri.b.array()).max(tri.c.array());
+  }
+}
+
+void MeshBvh::fitInner(uint32_t node) {
+  auto& info = nodes_[node];
+  const auto& left = nodes_[info.start];
+  const auto& right = nodes_[info.start + 1];
+  info.min = left.min.min(right.min);
+  info.max = left.max.max(right.max);
+}
+
+MeshBvh::Hit MeshBvh::makeHit(uint32_t slot, const Vec& point, float distance) const {
+  const auto& face = indices_[slot];
+  const auto& tri = triangles_[slot];
+  const std::array<float, 3> distances{(tri.a - point).squaredNorm(),
+                                       (tri.b - point).squaredNorm(),
+                                       (tri.c - point).squaredNorm()};
+  const auto closest = std::min_element(distances.begin(), distances.end());
+  return {order_[slot],
+          face,
+          face[closest - distances.begin()],
+          point.cast<double>(),
+          static_cast<double>(distance)};
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,362 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/mesh_edge_index.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "spark_dsg/change_journal.h"
+
+namespace spark_dsg {
+
+namespace {
+
+inline bool vertexLess(const std::pair<size_t, size_t>& entry, size_t vertex) {
+  return entry.first < vertex;
+}
+
+}  // namespace
+
+bool MeshEdgeIndex::contains(NodeId node, size_t vertex) const {
+  auto iter = node_edges_.find(node);
+  if (iter == node_edges_.end()) {
+    return false;
+  }
+
+  const auto& entries = iter->second;
+  auto entry = std::lower_bound(entries.begin(), entries.end(), vertex, vertexLess);
+  return entry != entries.end() && entry->first == vertex;
+}
+
+bool MeshEdgeIndex::insert(NodeId node, size_t vertex) {
+  auto& entries = node_edges_[node];
+  auto entry = std::lower_bound(entries.begin(), entries.end(), vertex, vertexLess);
+  if (entry != entries.end() && entry->first == vertex) {
+    return false;
+  }
+
+  entries.emplace(entry, vertex, append(node, vertex));
+  return true;
+}
+
+size_t MeshEdgeIndex::insert(Edges edges) {
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  reserve(edges_.size() + edges.size());
+
+  size_t num_added = 0;
+  auto group_start = edges.begin();
+  while (group_start != edges.end()) {
+    const auto node = group_start->source_node;
+    auto group_end = std::find_if(group_start, edges.end(), [node](const auto& edge) {
+      return edge.source_node != node;
+    });
+
+    auto& entries = node_edges_[node];
+    const auto num_previous = entries.size();
+    for (auto edge = group_start; edge != group_end; ++edge) {
+      const auto previous_end = entries.begin() + num_previous;
+      auto entry = std::lower_bound(
+          entries.begin(), previous_end, edge->mesh_vertex, vertexLess);
+      if (entry != previous_end && entry->first == edge->mesh_vertex) {
+        continue;
+      }
+
+      entries.emplace_back(edge->mesh_vertex, append(node, edge->mesh_vertex));
+      ++num_added;
+    }
+
+    // new vertices are sorted, so only the two runs need to be merged
+    std::inplace_merge(entries.begin(), entries.begin() + num_previous, entries.end());
+    group_start = group_end;
+  }
+
+  return num_added;
+}
+
+bool MeshEdgeIndex::erase(NodeId node, size_t vertex) {
+  auto iter = node_edges_.find(node);
+  if (iter == node_edges_.end()) {
+    return false;
+  }
+
+  auto& entries = iter->second;
+  auto entry = std::lower_bound(entries.begin(), entries.end(), vertex, vertexLess);
+  if (entry == entries.end() || entry->first != vertex) {
+    return false;
+  }
+
+  const auto slot = entry->second;
+  entries.erase(entry);
+  if (entries.empty()) {
+    node_edges_.erase(iter);
+  }
+
+  removeSlot(slot, false);
+  return true;
+}
+
+size_t MeshEdgeIndex::eraseNode(NodeId node) {
+  auto iter = node_edges_.find(node);
+  if (iter == node_edges_.end()) {
+    return 0;
+  }
+
+  std::vector<size_t> slots;
+  slots.reserve(iter->second.size());
+  for (const auto& entry : iter->second) {
+    slots.push_back(entry.second);
+  }
+  node_edges_.erase(iter);
+
+  // removing the highest slot first only ever moves edges that are kept
+  std::sort(slots.begin(), slots.end(), std::greater<size_t>());
+  for (const auto slot : slots) {
+    removeSlot(slot, false);
+  }
+
+  return slots.size();
+}
+
+size_t MeshEdgeIndex::eraseVertices(size_t begin, size_t end) {
+  std::vector<size_t> slots;
+  const auto dense_end = std::min(end, vertex_heads_.size());
+  for (size_t vertex = begin; vertex < dense_end; ++vertex) {
+    for (auto slot = vertex_heads_[vertex]; slot != npos; slot = next_[slot]) {
+      slots.push_back(slot);
+    }
+  }
+
+  for (auto iter = sparse_heads_.lower_bound(begin);
+       iter != sparse_heads_.end() && iter->first < end;
+       ++iter) {
+    for (auto slot = iter->second; slot != npos; slot = next_[slot]) {
+      slots.push_back(slot);
+    }
+  }
+
+  std::sort(slots.begin(), slots.end(), std::greater<size_t>());
+  for (const auto slot : slots) {
+    removeSlot(slot, true);
+  }
+
+  if (begin < dense_end && dense_end == vertex_heads_.size()) {
+    vertex_heads_.resize(begin);
+  }
+
+  return slots.size();
+}
+
+std::vector<size_t> MeshEdgeIndex::vertices(NodeId node) const {
+  std::vector<size_t> result;
+  auto iter = node_edges_.find(node);
+  if (iter == node_edges_.end()) {
+    return result;
+  }
+
+  result.reserve(iter->second.size());
+  for (const auto& entry : iter->second) {
+    result.push_back(entry.first);
+  }
+
+  return result;
+}
+
+std::vector<NodeId> MeshEdgeIndex::nodes(size_t vertex) const {
+  std::vector<NodeId> result;
+  const auto vertex_head = findHead(vertex);
+  if (!vertex_head) {
+    return result;
+  }
+
+  for (auto slot = *vertex_head; slot != npos; slot = next_[slot]) {
+    result.push_back(edges_[slot].source_node);
+  }
+
+  return result;
+}
+
+MeshEdgeIndex::Edges MeshEdgeIndex::edgesInRange(size_t begin, size_t end) const {
+  Edges result;
+  const auto dense_end = std::min(end, vertex_heads_.size());
+  for (size_t vertex = begin; vertex < dense_end; ++vertex) {
+    for (auto slot = vertex_heads_[vertex]; slot != npos; slot = next_[slot]) {
+      result.push_back(edges_[slot]);
+    }
+  }
+
+  for (auto iter = sparse_heads_.lower_bound(begin);
+       iter != sparse_heads_.end() && iter->first < end;
+       ++iter) {
+    for (auto slot = iter->second; slot != npos; slot = next_[slot]) {
+      result.push_back(edges_[slot]);
+    }
+  }
+
+  return result;
+}
+
+void MeshEdgeIndex::reserve(size_t num_edges) {
+  edges_.reserve(num_edges);
+  next_.reserve(num_edges);
+}
+
+void MeshEdgeIndex::clear() {
+  if (journal_) {
+    for (const auto& edge : edges_) {
+      journal_->recordEdge(
+          ChangeType::MESH_EDGE_REMOVED, edge.source_node, edge.mesh_vertex);
+    }
+  }
+
+  edges_.clear();
+  next_.clear();
+  vertex_heads_.clear();
+  sparse_heads_.clear();
+  node_edges_.clear();
+}
+
+void MeshEdgeIndex::setNumVertices(size_t num_vertices) {
+  num_vertices_ = num_vertices;
+  if (vertex_heads_.size() > num_vertices_) {
+    for (size_t vertex = num_vertices_; vertex < vertex_heads_.size(); ++vertex) {
+      if (vertex_heads_[vertex] != npos) {
+        sparse_heads_.emplace(vertex, vertex_heads_[vertex]);
+      }
+    }
+
+    vertex_heads_.resize(num_vertices_);
+    return;
+  }
+
+  // sparse vertices are all past the vertex table, so they can be appended in order
+  const auto last = sparse_heads_.lower_bound(num_vertices_);
+  for (auto iter = sparse_heads_.begin(); iter != last; ++iter) {
+    vertex_heads_.resize(iter->first + 1, npos);
+    vertex_heads_[iter->first] = iter->second;
+  }
+
+  sparse_heads_.erase(sparse_heads_.begin(), last);
+}
+
+size_t MeshEdgeIndex::append(NodeId node, size_t vertex) {
+  auto& vertex_head = head(vertex);
+  if (journal_) {
+    journal_->recordEdge(ChangeType::MESH_EDGE_ADDED, node, vertex);
+  }
+
+  const auto slot = edges_.size();
+  edges_.emplace_back(node, vertex);
+  next_.push_back(vertex_head);
+  vertex_head = slot;
+  return slot;
+}
+
+const size_t* MeshEdgeIndex::findHead(size_t vertex) const {
+  if (vertex < vertex_heads_.size()) {
+    return &vertex_heads_[vertex];
+  }
+
+  auto iter = sparse_heads_.find(vertex);
+  return iter == sparse_heads_.end() ? nullptr : &iter->second;
+}
+
+size_t& MeshEdgeIndex::head(size_t vertex) {
+  if (vertex < vertex_heads_.size()) {
+    return vertex_heads_[vertex];
+  }
+
+  if (vertex < num_vertices_) {
+    vertex_heads_.resize(vertex + 1, npos);
+    return vertex_heads_[vertex];
+  }
+
+  return sparse_heads_.emplace(vertex, npos).first->second;
+}
+
+void MeshEdgeIndex::unlinkVertex(size_t slot) {
+  const auto vertex = edges_[slot].mesh_vertex;
+  auto* link = &head(vertex);
+  while (*link != slot) {
+    link = &next_[*link];
+  }
+
+  *link = next_[slot];
+  if (vertex >= vertex_heads_.size() && sparse_heads_.at(vertex) == npos) {
+    sparse_heads_.erase(vertex);
+  }
+}
+
+void MeshEdgeIndex::removeSlot(size_t slot, bool update_node) {
+  const auto edge = edges_[slot];
+  if (journal_) {
+    journal_->recordEdge(
+        ChangeType::MESH_EDGE_REMOVED, edge.source_node, edge.mesh_vertex);
+  }
+
+  unlinkVertex(slot);
+  if (update_node) {
+    auto iter = node_edges_.find(edge.source_node);
+    auto& entries = iter->second;
+    entries.erase(std::lower_bound(
+        entries.begin(), entries.end(), edge.mesh_vertex, vertexLess));
+    if (entries.empty()) {
+      node_edges_.erase(iter);
+    }
+  }
+
+  const auto last = edges_.size() - 1;
+  if (slot != last) {
+    // move the last edge into the free slot and point everything at the new slot
+    const auto moved = edges_[last];
+    unlinkVertex(last);
+    edges_[slot] = moved;
+    auto& moved_head = head(moved.mesh_vertex);
+    next_[slot] = moved_head;
+    moved_head = slot;
+
+    auto iter = node_edges_.find(moved.source_node);
+    if (iter != node_edges_.end()) {
+      auto& entries = iter->second;
+      std::lower_bound(entries.begin(), entries.end(), moved.mesh_vertex, vertexLess)
+          ->second = slot;
+    }
+  }
+
+  edges_.pop_back();
+  next_.pop_back();
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,224 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/node_store.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "spark_dsg/node_symbol.h"
+
+namespace spark_dsg {
+
+namespace {
+
+template <typename Order>
+inline auto lowerBound(Order& order, NodeId node_id) {
+  return std::lower_bound(
+      order.begin(), order.end(), node_id, [](const auto& entry, NodeId id) {
+        return entry.first < id;
+      });
+}
+
+}  // namespace
+
+NodeStore::const_iterator::const_iterator(const NodeStore* store, size_t position)
+    : store_(store), position_(position) {
+  update();
+}
+
+NodeStore::const_iterator& NodeStore::const_iterator::operator++() {
+  ++position_;
+  update();
+  return *this;
+}
+
+void NodeStore::const_iterator::update() {
+  value_.reset();
+  const auto& order = store_->order_;
+  while (position_ < order.size()) {
+    const auto& [node_id, handle] = order[position_];
+    if (handle != INVALID_HANDLE) {
+      value_.emplace(node_id, &(*store_->slot(handle)));
+      return;
+    }
+
+    ++position_;
+  }
+}
+
+void NodeStore::reserve(size_t num_nodes) {
+  index_.reserve(num_nodes);
+  order_.reserve(num_nodes);
+  while (capacity() < num_nodes) {
+    chunks_.push_back(std::make_unique<Chunk>());
+  }
+}
+
+void NodeStore::clear() {
+  chunks_.clear();
+  index_.clear();
+  free_slots_.clear();
+  order_.clear();
+  num_removed_ = 0;
+  end_slot_ = 0;
+}
+
+NodeStore::Handle NodeStore::nextSlot() {
+  if (!free_slots_.empty()) {
+    const auto handle = free_slots_.back();
+    free_slots_.pop_back();
+    return handle;
+  }
+
+  if (end_slot_ == capacity()) {
+    chunks_.push_back(std::make_unique<Chunk>());
+  }
+
+  return end_slot_++;
+}
+
+void NodeStore::addToOrder(NodeId node_id, Handle handle) {
+  if (num_removed_ > order_.size() / 2) {
+    // drop removed entries (inserting already invalidates iterators)
+    order_.erase(std::remove_if(order_.begin(),
+                                order_.end(),
+                                [](const auto& entry) {
+                                  return entry.second == INVALID_HANDLE;
+                                }),
+                 order_.end());
+    num_removed_ = 0;
+  }
+
+  if (order_.empty() || order_.back().first < node_id) {
+    order_.emplace_back(node_id, handle);
+    return;
+  }
+
+  auto iter = lowerBound(order_, node_id);
+  if (iter != order_.end() && iter->first == node_id) {
+    // reuse the entry of a previously removed node with the same id
+    iter->second = handle;
+    --num_removed_;
+    return;
+  }
+
+  order_.emplace(iter, node_id, handle);
+}
+
+void NodeStore::removeFromOrder(NodeId node_id) {
+  auto iter = lowerBound(order_, node_id);
+  if (iter == order_.end() || iter->first != node_id) {
+    return;
+  }
+
+  iter->second = INVALID_HANDLE;
+  ++num_removed_;
+}
+
+std::pair<NodeStore::Node*, bool> NodeStore::emplace(NodeId node_id,
+                                                     LayerId layer_id,
+                                                     Node::AttributesPtr&& attrs) {
+  auto iter = index_.find(node_id);
+  if (iter != index_.end()) {
+    return {&(*slot(iter->second)), false};
+  }
+
+  const auto handle = nextSlot();
+  auto& node = slot(handle);
+  node.emplace(node_id, layer_id, std::move(attrs));
+  index_.emplace(node_id, handle);
+  addToOrder(node_id, handle);
+  return {&(*node), true};
+}
+
+std::pair<NodeStore::Node*, bool> NodeStore::insert(Node&& node) {
+  auto iter = index_.find(node.id);
+  if (iter != index_.end()) {
+    return {&(*slot(iter->second)), false};
+  }
+
+  const auto handle = nextSlot();
+  auto& new_node = slot(handle);
+  new_node.emplace(std::move(node));
+  index_.emplace(new_node->id, handle);
+  addToOrder(new_node->id, handle);
+  return {&(*new_node), true};
+}
+
+size_t NodeStore::erase(NodeId node_id) {
+  auto iter = index_.find(node_id);
+  if (iter == index_.end()) {
+    return 0;
+  }
+
+  const auto handle = iter->second;
+  index_.erase(iter);
+  removeFromOrder(node_id);
+  slot(handle).reset();
+  free_slots_.push_back(handle);
+  return 1;
+}
+
+NodeStore::Handle NodeStore::handle(NodeId node_id) const {
+  auto iter = index_.find(node_id);
+  return iter == index_.end() ? INVALID_HANDLE : iter->second;
+}
+
+NodeStore::Node* NodeStore::get(Handle handle) const {
+  if (handle >= end_slot_) {
+    return nullptr;
+  }
+
+  auto& node = slot(handle);
+  return node ? &(*node) : nullptr;
+}
+
+NodeStore::Node* NodeStore::find(NodeId node_id) const {
+  auto iter = index_.find(node_id);
+  return iter == index_.end() ? nullptr : &(*slot(iter->second));
+}
+
+NodeStore::Node& NodeStore::at(NodeId node_id) const {
+  auto node = find(node_id);
+  if (!node) {
+    std::stringstream ss;
+    ss << "node " << NodeSymbol(node_id).getLabel() << " not in store";
+    throw std::out_of_range(ss.str());
+  }
+
+  return *node;
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,165 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/position_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace spark_dsg {
+
+namespace {
+
+// number of slots tested before collecting the matching ids
+constexpr size_t QUERY_BLOCK_SIZE = 256;
+
+inline constexpr double invalidCoordinate() {
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+template <typename Test>
+void collectMatches(size_t num_slots,
+                    const std::vector<NodeId>& ids,
+                    const Test& test,
+                    std::vector<NodeId>& result) {
+  uint8_t mask[QUERY_BLOCK_SIZE];
+  for (size_t start = 0; start < num_slots; start += QUERY_BLOCK_SIZE) {
+    const size_t block_size = std::min(QUERY_BLOCK_SIZE, num_slots - start);
+    test(start, block_size, mask);
+    for (size_t i = 0; i < block_size; ++i) {
+      if (mask[i]) {
+        result.push_back(ids[start + i]);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+PositionCache::PositionCache(const NodeStore& nodes) {
+  for (const auto& id_node_pair : nodes) {
+    update(nodes.handle(id_node_pair.first),
+           id_node_pair.first,
+           id_node_pair.second->attributes().position);
+  }
+}
+
+void PositionCache::update(Handle handle, NodeId node, const Eigen::Vector3d& pos) {
+  if (handle >= ids_.size()) {
+    const size_t num_slots = handle + 1;
+    x_.resize(num_slots, invalidCoordinate());
+    y_.resize(num_slots, invalidCoordinate());
+    z_.resize(num_slots, invalidCoordinate());
+    ids_.resize(num_slots, 0);
+  }
+
+  x_[handle] = pos.x();
+  y_[handle] = pos.y();
+  z_[handle] = pos.z();
+  ids_[handle] = node;
+}
+
+void PositionCache::remove(Handle handle) {
+  if (handle >= ids_.size()) {
+    return;
+  }
+
+  x_[handle] = invalidCoordinate();
+  y_[handle] = invalidCoordinate();
+  z_[handle] = invalidCoordinate();
+}
+
+void PositionCache::clear() {
+  x_.clear();
+  y_.clear();
+  z_.clear();
+  ids_.clear();
+}
+
+Eigen::Vector3d PositionCache::position(Handle handle) const {
+  if (handle >= ids_.size()) {
+    return Eigen::Vector3d::Constant(invalidCoordinate());
+  }
+
+  return Eigen::Vector3d(x_[handle], y_[handle], z_[handle]);
+}
+
+void PositionCache::radiusQuery(const Eigen::Vector3d& center,
+                                double radius,
+                                std::vector<NodeId>& result) const {
+  const double cx = center.x();
+  const double cy = center.y();
+  const double cz = center.z();
+  const double radius_sq = radius * radius;
+  const double* x = x_.data();
+  const double* y = y_.data();
+  const double* z = z_.data();
+  collectMatches(
+      ids_.size(), ids_, [&](size_t start, size_t size, uint8_t* mask) {
+        for (size_t i = 0; i < size; ++i) {
+          const double dx = x[start + i] - cx;
+          const double dy = y[start + i] - cy;
+          const double dz = z[start + i] - cz;
+          mask[i] = (dx * dx + dy * dy + dz * dz) <= radius_sq;
+        }
+      },
+      result);
+}
+
+void PositionCache::boxQuery(const Eigen::Vector3d& min,
+                             const Eigen::Vector3d& max,
+                             std::vector<NodeId>& result) const {
+  const double min_x = min.x();
+  const double min_y = min.y();
+  const double min_z = min.z();
+  const double max_x = max.x();
+  const double max_y = max.y();
+  const double max_z = max.z();
+  const double* x = x_.data();
+  const double* y = y_.data();
+  const double* z = z_.data();
+  collectMatches(
+      ids_.size(), ids_, [&](size_t start, size_t size, uint8_t* mask) {
+        for (size_t i = 0; i < size; ++i) {
+          const size_t j = start + i;
+          // bitwise and keeps the loop free of branches
+          mask[i] = (x[j] >= min_x) & (x[j] <= max_x) & (y[j] >= min_y) &
+                    (y[j] <= max_y) & (z[j] >= min_z) & (z[j] <= max_z);
+        }
+      },
+      result);
+}
+
+}  // namespace spark_dsg
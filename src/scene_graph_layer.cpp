@@ -34,6 +34,7 @@
  * -------------------------------------------------------------------------- */
 #include "spark_dsg/scene_graph_layer.h"
 
+#include <algorithm>
 #include <queue>
 #include <sstream>
 
@@ -45,12 +46,19 @@ namespace spark_dsg {
 using EdgeRef = SceneGraphLayer::EdgeRef;
 using NodeRef = SceneGraphLayer::NodeRef;
 
-SceneGraphLayer::SceneGraphLayer(LayerId layer_id) : id(layer_id) {}
+SceneGraphLayer::SceneGraphLayer(LayerId layer_id) : id(layer_id) {
+  edges_.journal = &journal_;
+}
 
 bool SceneGraphLayer::emplaceNode(NodeId node_id, NodeAttributes::Ptr&& attrs) {
   nodes_status_[node_id] = NodeStatus::NEW;
-  return nodes_.emplace(node_id, std::make_unique<Node>(node_id, id, std::move(attrs)))
-      .second;
+  if (!nodes_.emplace(node_id, id, std::move(attrs)).second) {
+    return false;
+  }
+
+  journal_.recordNode(ChangeType::NODE_ADDED, node_id);
+  refreshPosition(node_id);
+  return true;
 }
 
 bool SceneGraphLayer::insertNode(SceneGraphNode::Ptr&& node) {
@@ -70,9 +78,24 @@ bool SceneGraphLayer::insertNode(SceneGraphNode::Ptr&& node) {
     return false;
   }
 
-  NodeId to_insert = node->id;
-  nodes_status_[to_insert] = NodeStatus::NEW;
-  nodes_[to_insert] = std::move(node);
+  const NodeId node_id = node->id;
+  nodes_status_[node_id] = NodeStatus::NEW;
+  nodes_.insert(std::move(*node));
+  node.reset();
+  journal_.recordNode(ChangeType::NODE_ADDED, node_id);
+  refreshPosition(node_id);
+  return true;
+}
+
+bool SceneGraphLayer::setNodeAttributes(NodeId node_id, NodeAttributes::Ptr&& attrs) {
+  auto node = nodes_.find(node_id);
+  if (!node) {
+    return false;
+  }
+
+  node->attributes_ = std::move(attrs);
+  journal_.recordNode(ChangeType::NODE_UPDATED, node_id);
+  refreshPosition(node_id);
   return true;
 }
 
@@ -98,8 +121,8 @@ bool SceneGraphLayer::insertEdge(NodeId source,
     return false;
   }
 
-  nodes_[source]->siblings_.insert(target);
-  nodes_[target]->siblings_.insert(source);
+  nodes_.at(source).siblings_.insert(target);
+  nodes_.at(target).siblings_.insert(source);
 
   edges_.insert(source, target, std::move(edge_info));
   return true;
@@ -125,8 +148,7 @@ std::optional<NodeRef> SceneGraphLayer::getNode(NodeId node_id) const {
     return std::nullopt;
   }
 
-  assert(nodes_.at(node_id) != nullptr);
-  return std::cref(*(nodes_.at(node_id)));
+  return std::cref(nodes_.at(node_id));
 }
 
 std::optional<EdgeRef> SceneGraphLayer::getEdge(NodeId source, NodeId target) const {
@@ -143,14 +165,16 @@ bool SceneGraphLayer::removeNode(NodeId node_id) {
   }
 
   // remove all edges connecting to node
-  std::set<NodeId> targets_to_erase = nodes_.at(node_id)->siblings_;
+  std::set<NodeId> targets_to_erase = nodes_.at(node_id).siblings_;
   for (const auto& target : targets_to_erase) {
     removeEdge(node_id, target);
   }
 
   // remove the actual node
+  untrackNode(node_id);
   nodes_.erase(node_id);
   nodes_status_[node_id] = NodeStatus::DELETED;
+  journal_.recordNode(ChangeType::NODE_REMOVED, node_id);
   return true;
 }
 
@@ -164,14 +188,16 @@ bool SceneGraphLayer::mergeNodes(NodeId node_from, NodeId node_to) {
   }
 
   // rewire all edges connecting to merged node
-  std::set<NodeId> targets_to_rewire = nodes_.at(node_from)->siblings_;
+  std::set<NodeId> targets_to_rewire = nodes_.at(node_from).siblings_;
   for (const auto& target : targets_to_rewire) {
     rewireEdge(node_from, target, node_to, target);
   }
 
   // remove the actual node
+  untrackNode(node_from);
   nodes_.erase(node_from);
   nodes_status_[node_from] = NodeStatus::MERGED;
+  journal_.recordNode(ChangeType::NODE_REMOVED, node_from);
   return true;
 }
 
@@ -180,8 +206,8 @@ bool SceneGraphLayer::removeEdge(NodeId source, NodeId target) {
     return false;
   }
 
-  nodes_[source]->siblings_.erase(target);
-  nodes_[target]->siblings_.erase(source);
+  nodes_.at(source).siblings_.erase(target);
+  nodes_.at(target).siblings_.erase(source);
 
   edges_.remove(source, target);
   return true;
@@ -211,10 +237,10 @@ bool SceneGraphLayer::rewireEdge(NodeId source,
   edges_.rewire(source, target, new_source, new_target);
 
   // rewire siblings
-  nodes_[source]->siblings_.erase(target);
-  nodes_[target]->siblings_.erase(source);
-  nodes_[new_source]->siblings_.insert(new_target);
-  nodes_[new_target]->siblings_.insert(new_source);
+  nodes_.at(source).siblings_.erase(target);
+  nodes_.at(target).siblings_.erase(source);
+  nodes_.at(new_source).siblings_.insert(new_target);
+  nodes_.at(new_target).siblings_.insert(new_source);
   return true;
 }
 
@@ -225,7 +251,7 @@ inline NodeId getMergedId(NodeId original,
 
 bool SceneGraphLayer::mergeLayer(const SceneGraphLayer& other_layer,
                                  const std::map<NodeId, NodeId>& previous_merges,
-                                 std::map<NodeId, LayerKey>* layer_lookup,
+                                 NodeLookup* layer_lookup,
                                  bool update_attributes) {
   for (const auto& id_node_pair : other_layer.nodes_) {
     const auto siter = nodes_status_.find(id_node_pair.first);
@@ -234,19 +260,20 @@ bool SceneGraphLayer::mergeLayer(const SceneGraphLayer& other_layer,
     }
 
     const auto& other = *id_node_pair.second;
-    auto iter = nodes_.find(id_node_pair.first);
-    if (iter != nodes_.end()) {
+    auto node = nodes_.find(id_node_pair.first);
+    if (node) {
       if (!update_attributes) {
         continue;
       }
 
-      iter->second->attributes_ = other.attributes_->clone();
+      setNodeAttributes(other.id, other.attributes_->clone());
       continue;
     }
 
-    auto attrs = other.attributes_->clone();
-    nodes_[other.id] = Node::Ptr(new Node(other.id, id, std::move(attrs)));
+    nodes_.emplace(other.id, id, other.attributes_->clone());
     nodes_status_[other.id] = NodeStatus::NEW;
+    journal_.recordNode(ChangeType::NODE_ADDED, other.id);
+    refreshPosition(other.id);
 
     if (layer_lookup) {
       layer_lookup->insert({other.id, id});
@@ -254,7 +281,7 @@ bool SceneGraphLayer::mergeLayer(const SceneGraphLayer& other_layer,
   }
 
   for (const auto& id_edge_pair : other_layer.edges_.edges) {
-    const auto& edge = id_edge_pair.second;
+    const auto& edge = *id_edge_pair.second;
     if (hasEdge(edge.source, edge.target)) {
       // TODO(nathan) clone attributes
       continue;
@@ -279,7 +306,143 @@ Eigen::Vector3d SceneGraphLayer::getPosition(NodeId node) const {
     throw std::out_of_range(ss.str());
   }
 
-  return nodes_.at(node)->attributes().position;
+  return nodes_.at(node).attributes().position;
+}
+
+void SceneGraphLayer::enablePositionCache(bool enable) {
+  if (!enable) {
+    position_cache_.reset();
+  } else if (!position_cache_) {
+    position_cache_ = std::make_unique<PositionCache>(nodes_);
+  }
+}
+
+bool SceneGraphLayer::refreshPosition(NodeId node_id) {
+  const auto handle = nodes_.handle(node_id);
+  if (handle == NodeStore::INVALID_HANDLE) {
+    return false;
+  }
+
+  const auto& position = nodes_[handle].attributes().position;
+  if (position_cache_) {
+    position_cache_->update(handle, node_id, position);
+  }
+
+  if (spatial_index_) {
+    spatial_index_->update(node_id, position);
+  }
+
+  return true;
+}
+
+void SceneGraphLayer::untrackNode(NodeId node_id) {
+  if (position_cache_) {
+    position_cache_->remove(nodes_.handle(node_id));
+  }
+
+  if (spatial_index_) {
+    spatial_index_->remove(node_id);
+  }
+}
+
+void SceneGraphLayer::enableSpatialIndex(bool enable, double cell_size) {
+  if (!enable) {
+    spatial_index_.reset();
+    return;
+  }
+
+  if (spatial_index_ && spatial_index_->cellSize() == cell_size) {
+    return;
+  }
+
+  spatial_index_ = std::make_unique<SpatialIndex>(cell_size);
+  for (const auto& id_node_pair : nodes_) {
+    spatial_index_->update(id_node_pair.first,
+                           id_node_pair.second->attributes().position);
+  }
+}
+
+std::vector<NodeId> SceneGraphLayer::getNearestNodes(const Eigen::Vector3d& point,
+                                                     size_t k) const {
+  if (spatial_index_) {
+    return spatial_index_->knnQuery(point, k);
+  }
+
+  std::vector<std::pair<double, NodeId>> candidates;
+  candidates.reserve(nodes_.size());
+  for (const auto& id_node_pair : nodes_) {
+    const auto& pos = id_node_pair.second->attributes().position;
+    candidates.emplace_back((pos - point).squaredNorm(), id_node_pair.first);
+  }
+
+  const size_t num_to_return = std::min(k, candidates.size());
+  std::partial_sort(candidates.begin(),
+                    candidates.begin() + num_to_return,
+                    candidates.end());
+
+  std::vector<NodeId> result;
+  result.reserve(num_to_return);
+  for (size_t i = 0; i < num_to_return; ++i) {
+    result.push_back(candidates[i].second);
+  }
+
+  return result;
+}
+
+std::optional<NodeId> SceneGraphLayer::getNearestNode(
+    const Eigen::Vector3d& point) const {
+  const auto result = getNearestNodes(point, 1);
+  if (result.empty()) {
+    return std::nullopt;
+  }
+
+  return result.front();
+}
+
+std::vector<NodeId> SceneGraphLayer::getNodesInRadius(const Eigen::Vector3d& center,
+                                                      double radius) const {
+  std::vector<NodeId> result;
+  if (spatial_index_) {
+    spatial_index_->radiusQuery(center, radius, result);
+    return result;
+  }
+
+  if (position_cache_) {
+    position_cache_->radiusQuery(center, radius, result);
+    return result;
+  }
+
+  for (const auto& id_node_pair : nodes_) {
+    const auto& pos = id_node_pair.second->attributes().position;
+    if ((pos - center).norm() <= radius) {
+      result.push_back(id_node_pair.first);
+    }
+  }
+
+  return result;
+}
+
+std::vector<NodeId> SceneGraphLayer::getNodesInBox(const Eigen::Vector3d& min,
+                                                   const Eigen::Vector3d& max) const {
+  std::vector<NodeId> result;
+  if (spatial_index_) {
+    spatial_index_->boxQuery(min, max, result);
+    return result;
+  }
+
+  if (position_cache_) {
+    position_cache_->boxQuery(min, max, result);
+    return result;
+  }
+
+  for (const auto& id_node_pair : nodes_) {
+    const auto& pos = id_node_pair.second->attributes().position;
+    if ((pos.array() >= min.array()).all() && (pos.array() <= max.array()).all()) {
+      result.push_back(id_node_pair.first);
+    }
+  }
+
+  return result;
 }
 
 void SceneGraphLayer::getNewNodes(std::vector<NodeId>& new_nodes, bool clear_new) {
@@ -334,7 +497,18 @@ void SceneGraphLayer::getRemovedEdges(std::vector<EdgeKey>& removed_edges,
 }
 
 void SceneGraphLayer::reset() {
+  for (const auto& id_node_pair : nodes_) {
+    journal_.recordNode(ChangeType::NODE_REMOVED, id_node_pair.first);
+  }
+
   nodes_.clear();
+  if (position_cache_) {
+    position_cache_->clear();
+  }
+
+  if (spatial_index_) {
+    spatial_index_->clear();
+  }
   nodes_status_.clear();
   edges_.reset();
 }
@@ -342,36 +516,79 @@ void SceneGraphLayer::reset() {
 using NodeSet = std::unordered_set<NodeId>;
 
 NodeSet SceneGraphLayer::getNeighborhood(NodeId node, size_t num_hops) const {
-  NodeSet result;
-  graph_utilities::breadthFirstSearch(
-      *this, node, num_hops, [&](const SceneGraphLayer&, NodeId visited) {
-        result.insert(visited);
-      });
-  return result;
+  const auto neighborhood = searchNeighborhood({node}, num_hops);
+  return NodeSet(neighborhood.nodes.begin(), neighborhood.nodes.end());
 }
 
 NodeSet SceneGraphLayer::getNeighborhood(const NodeSet& nodes, size_t num_hops) const {
-  NodeSet result;
-  graph_utilities::breadthFirstSearch(
-      *this, nodes, num_hops, [&](const SceneGraphLayer&, NodeId visited) {
-        result.insert(visited);
-      });
+  const auto neighborhood =
+      searchNeighborhood(std::vector<NodeId>(nodes.begin(), nodes.end()), num_hops);
+  return NodeSet(neighborhood.nodes.begin(), neighborhood.nodes.end());
+}
+
+LayerNeighborhood SceneGraphLayer::searchNeighborhood(const std::vector<NodeId>& seeds,
+                                                      size_t num_hops) const {
+  LayerNeighborhood result;
+
+  // visited flags are indexed by node slot, so no hashing is needed to check them
+  std::vector<uint64_t> visited((nodes_.capacity() + 63) / 64, 0);
+  std::vector<Nodes::Handle> handles;
+  auto visit = [&](NodeId node, Nodes::Handle handle, uint32_t hops, NodeId source) {
+    uint64_t& word = visited[handle / 64];
+    const uint64_t mask = uint64_t(1) << (handle % 64);
+    if (word & mask) {
+      return;
+    }
+
+    word |= mask;
+    handles.push_back(handle);
+    result.nodes.push_back(node);
+    result.hops.push_back(hops);
+    result.sources.push_back(source);
+  };
+
+  for (const auto seed : seeds) {
+    const auto handle = nodes_.handle(seed);
+    if (handle != Nodes::INVALID_HANDLE) {
+      visit(seed, handle, 0, seed);
+    }
+  }
+
+  // the result doubles as the queue: nodes are appended in order of hop distance
+  for (size_t i = 0; i < handles.size(); ++i) {
+    const uint32_t hops = result.hops[i];
+    if (hops >= num_hops) {
+      break;
+    }
+
+    const NodeId source = result.sources[i];
+    for (const auto sibling : nodes_[handles[i]].siblings()) {
+      visit(sibling, nodes_.handle(sibling), hops + 1, source);
+    }
+  }
+
   return result;
 }
 
 void SceneGraphLayer::cloneImpl(SceneGraphLayer& other) const {
+  other.enablePositionCache(hasPositionCache());
+  if (spatial_index_) {
+    other.enableSpatialIndex(true, spatial_index_->cellSize());
+  }
   for (auto&& [id, node] : nodes_) {
     other.emplaceNode(id, node->attributes().clone());
   }
 
   for (const auto& id_edge_pair : edges_.edges) {
-    const auto& edge = id_edge_pair.second;
+    const auto& edge = *id_edge_pair.second;
     other.insertEdge(edge.source, edge.target, edge.info->clone());
   }
 
   other.nodes_status_ = nodes_status_;
 }
 
+FrozenLayer SceneGraphLayer::freeze() const { return FrozenLayer(*this); }
+
 SceneGraphLayer::Ptr SceneGraphLayer::clone() const {
   SceneGraphLayer::Ptr new_layer(new SceneGraphLayer(id));
   cloneImpl(*new_layer);
@@ -136,4 +136,52 @@ void from_json(const json& j, NearestVertexInfo& info) {
   info.vertex = j.at("vertex");
 }
 
+void to_json(json& j, const Mesh& mesh) {
+  j = json{{"vertices", json::array()}, {"faces", json::array()}};
+  auto& vertices = j.at("vertices");
+  for (size_t i = 0; i < mesh.numVertices(); ++i) {
+    const auto& color = mesh.color(i);
+    vertices.push_back(json{{"x", mesh.xs()[i]},
+                            {"y", mesh.ys()[i]},
+                            {"z", mesh.zs()[i]},
+                            {"r", color.r},
+                            {"g", color.g},
+                            {"b", color.b}});
+  }
+
+  auto& faces = j.at("faces");
+  for (size_t i = 0; i < mesh.numFaces(); ++i) {
+    faces.push_back(mesh.face(i));
+  }
+}
+
+void from_json(const json& j, Mesh& mesh) {
+  const auto& vertices = j.at("vertices");
+  const auto& faces = j.at("faces");
+  mesh.clear();
+  mesh.reserve(vertices.size(), faces.size());
+
+  const auto read_coordinate = [](const json& value) {
+    return value.is_null() ? std::numeric_limits<float>::quiet_NaN()
+                           : value.get<float>();
+  };
+
+  for (const auto& vertex : vertices) {
+    const Mesh::Pos pos(read_coordinate(vertex.at("x")),
+                        read_coordinate(vertex.at("y")),
+                        read_coordinate(vertex.at("z")));
+    mesh.addVertex(pos,
+                   {vertex.at("r").get<uint8_t>(),
+                    vertex.at("g").get<uint8_t>(),
+                    vertex.at("b").get<uint8_t>()});
+  }
+
+  for (const auto& face : faces) {
+    const auto indices = face.get<std::vector<uint32_t>>();
+    for (size_t i = 2; i < indices.size(); ++i) {
+      mesh.addFace({indices[0], indices[i - 1], indices[i]});
+    }
+  }
+}
+
 }  // namespace spark_dsg
@@ -0,0 +1,265 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "spark_dsg/spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <stdexcept>
+
+namespace spark_dsg {
+
+namespace {
+
+using Candidate = std::pair<double, NodeId>;
+// max-heap on distance so that the worst candidate is on top
+using CandidateQueue = std::priority_queue<Candidate>;
+
+inline double squaredDistance(double x, double y, double z, const Eigen::Vector3d& p) {
+  const double dx = x - p.x();
+  const double dy = y - p.y();
+  const double dz = z - p.z();
+  return dx * dx + dy * dy + dz * dz;
+}
+
+}  // namespace
+
+SpatialIndex::SpatialIndex(double cell_size) : cell_size_(cell_size) {
+  if (!(cell_size_ > 0.0)) {
+    throw std::invalid_argument("spatial index cell size must be positive");
+  }
+}
+
+SpatialIndex::CellIndex SpatialIndex::cellIndex(const Eigen::Vector3d& point) const {
+  return (point.array() / cell_size_).floor().cast<int>();
+}
+
+SpatialIndex::CellKey SpatialIndex::cellKey(const CellIndex& index) {
+  // 21 bits per axis (distinct cells only collide if they are 2^21 cells apart, and
+  // colliding cells only cost extra distance checks)
+  constexpr uint64_t mask = (1ULL << 21) - 1;
+  return ((static_cast<uint64_t>(index.x()) & mask) << 42) |
+         ((static_cast<uint64_t>(index.y()) & mask) << 21) |
+         (static_cast<uint64_t>(index.z()) & mask);
+}
+
+void SpatialIndex::update(NodeId node, const Eigen::Vector3d& position) {
+  const auto key = cellKey(cellIndex(position));
+  auto iter = node_cells_.find(node);
+  if (iter != node_cells_.end()) {
+    if (iter->second == key) {
+      // same cell, just update the position
+      for (auto& entry : cells_.at(key)) {
+        if (entry.node == node) {
+          entry.x = position.x();
+          entry.y = position.y();
+          entry.z = position.z();
+          return;
+        }
+      }
+    }
+
+    remove(node);
+  }
+
+  cells_[key].push_back({node, position.x(), position.y(), position.z()});
+  node_cells_[node] = key;
+}
+
+bool SpatialIndex::remove(NodeId node) {
+  auto iter = node_cells_.find(node);
+  if (iter == node_cells_.end()) {
+    return false;
+  }
+
+  const auto key = iter->second;
+  node_cells_.erase(iter);
+
+  auto& cell = cells_.at(key);
+  auto entry = std::find_if(
+      cell.begin(), cell.end(), [&](const Entry& e) { return e.node == node; });
+  if (entry != cell.end()) {
+    *entry = cell.back();
+    cell.pop_back();
+  }
+
+  if (cell.empty()) {
+    cells_.erase(key);
+  }
+
+  return true;
+}
+
+void SpatialIndex::clear() {
+  cells_.clear();
+  node_cells_.clear();
+}
+
+template <typename Visitor>
+void SpatialIndex::visitCells(const CellIndex& min,
+                              const CellIndex& max,
+                              Visitor&& visitor) const {
+  const Eigen::Array3d extent = (max - min + 1).cast<double>();
+  if (extent.prod() > static_cast<double>(cells_.size())) {
+    // cheaper to check every occupied cell than to enumerate the range
+    for (const auto& key_cell_pair : cells_) {
+      visitor(key_cell_pair.second);
+    }
+    return;
+  }
+
+  for (int x = min.x(); x <= max.x(); ++x) {
+    for (int y = min.y(); y <= max.y(); ++y) {
+      for (int z = min.z(); z <= max.z(); ++z) {
+        auto iter = cells_.find(cellKey(CellIndex(x, y, z)));
+        if (iter != cells_.end()) {
+          visitor(iter->second);
+        }
+      }
+    }
+  }
+}
+
+void SpatialIndex::radiusQuery(const Eigen::Vector3d& center,
+                               double radius,
+                               std::vector<NodeId>& result) const {
+  if (radius < 0.0) {
+    return;
+  }
+
+  const double radius_sq = radius * radius;
+  const Eigen::Vector3d offset = Eigen::Vector3d::Constant(radius);
+  const auto min = cellIndex(center - offset);
+  const auto max = cellIndex(center + offset);
+  visitCells(min, max, [&](const Cell& cell) {
+    for (const auto& entry : cell) {
+      if (squaredDistance(entry.x, entry.y, entry.z, center) <= radius_sq) {
+        result.push_back(entry.node);
+      }
+    }
+  });
+}
+
+void SpatialIndex::boxQuery(const Eigen::Vector3d& min,
+                            const Eigen::Vector3d& max,
+                            std::vector<NodeId>& result) const {
+  if ((min.array() > max.array()).any()) {
+    return;
+  }
+
+  visitCells(cellIndex(min), cellIndex(max), [&](const Cell& cell) {
+    for (const auto& entry : cell) {
+      if (entry.x >= min.x() && entry.x <= max.x() && entry.y >= min.y() &&
+          entry.y <= max.y() && entry.z >= min.z() && entry.z <= max.z()) {
+        result.push_back(entry.node);
+      }
+    }
+  });
+}
+
+std::vector<NodeId> SpatialIndex::knnQuery(const Eigen::Vector3d& point,
+                                           size_t k) const {
+  std::vector<NodeId> result;
+  if (k == 0 || cells_.empty()) {
+    return result;
+  }
+
+  CandidateQueue candidates;
+  auto add_cell = [&](const Cell& cell) {
+    for (const auto& entry : cell) {
+      const double dist_sq = squaredDistance(entry.x, entry.y, entry.z, point);
+      if (candidates.size() < k) {
+        candidates.emplace(dist_sq, entry.node);
+      } else if (dist_sq < candidates.top().first) {
+        candidates.pop();
+        candidates.emplace(dist_sq, entry.node);
+      }
+    }
+  };
+
+  // search shells of cells around the cell containing the point. Every node outside
+  // of shell r is at least r cell sizes away from the point
+  const CellIndex center = cellIndex(point);
+  for (int r = 0;; ++r) {
+    const double side = 2.0 * r + 1.0;
+    if (side * side * side >= static_cast<double>(cells_.size())) {
+      // the shells cover more cells than are occupied: finish with a full scan
+      candidates = CandidateQueue();
+      for (const auto& key_cell_pair : cells_) {
+        add_cell(key_cell_pair.second);
+      }
+      break;
+    }
+
+    for (int x = -r; x <= r; ++x) {
+      for (int y = -r; y <= r; ++y) {
+        const bool on_face = std::abs(x) == r || std::abs(y) == r;
+        // interior columns only contribute the two cells on the shell
+        const int z_step = on_face ? 1 : std::max(2 * r, 1);
+        for (int z = -r; z <= r; z += z_step) {
+          auto iter = cells_.find(cellKey(center + CellIndex(x, y, z)));
+          if (iter != cells_.end()) {
+            add_cell(iter->second);
+          }
+        }
+      }
+    }
+
+    const double min_outside_dist = r * cell_size_;
+    if (candidates.size() == k &&
+        candidates.top().first <= min_outside_dist * min_outside_dist) {
+      break;
+    }
+  }
+
+  result.resize(candidates.size());
+  for (size_t i = result.size(); i > 0; --i) {
+    result[i - 1] = candidates.top().second;
+    candidates.pop();
+  }
+
+  return result;
+}
+
+std::optional<NodeId> SpatialIndex::nearest(const Eigen::Vector3d& point) const {
+  const auto result = knnQuery(point, 1);
+  if (result.empty()) {
+    return std::nullopt;
+  }
+
+  return result.front();
+}
+
+}  // namespace spark_dsg
@@ -36,6 +36,12 @@
 
 #include <zmq.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
 #include "spark_dsg/dynamic_scene_graph.h"
 #include "spark_dsg/graph_binary_serialization.h"
 
@@ -65,88 +71,374 @@ class ZmqContextHolder {
 
 std::unique_ptr<ZmqContextHolder> ZmqContextHolder::instance_;
 
+using Buffer = std::vector<uint8_t>;
+
+void freeBuffer(void*, void* hint) { delete static_cast<Buffer*>(hint); }
+
+// hands ownership of the buffer to zmq (which frees it once the message is sent)
+zmq::message_t toMessage(std::unique_ptr<Buffer>&& buffer) {
+  if (buffer->empty()) {
+    return zmq::message_t();
+  }
+
+  auto raw = buffer.release();
+  return zmq::message_t(raw->data(), raw->size(), freeBuffer, raw);
+}
+
 struct ZmqSender::Detail {
-  Detail(const std::string& url, size_t) {
+  Detail(const std::string& url, size_t, size_t keyframe_interval, bool multipart)
+      : multipart(multipart) {
+    if (multipart && keyframe_interval > 0) {
+      throw std::invalid_argument("multipart messages do not support delta updates");
+    }
+
     socket.reset(new zmq::socket_t(ZmqContextHolder::instance().context(), ZMQ_PUB));
     socket->bind(url);
+    if (keyframe_interval > 0) {
+      encoder.reset(new GraphDeltaEncoder(keyframe_interval));
+    }
   }
 
   ~Detail() = default;
 
-  void send(const DynamicSceneGraph& graph) {
-    std::vector<uint8_t> buffer;
-    writeGraph(graph, buffer);
+  void send(const DynamicSceneGraph& graph, bool include_mesh) {
+    if (encoder || !multipart) {
+      auto buffer = std::make_unique<Buffer>();
+      if (encoder) {
+        encoder->encode(graph, *buffer, include_mesh);
+      } else {
+        writeGraph(graph, *buffer, include_mesh);
+      }
+
+      sendFrame(toMessage(std::move(buffer)), false);
+      return;
+    }
 
-    // TODO(nathan) it'd be nice if we could avoid the memcpy
-    zmq::message_t msg(buffer.data(), buffer.size());
+    // one frame per section to avoid copying the sections into a single buffer
+    GraphSectionBuffers sections;
+    writeGraphSections(graph, sections, include_mesh);
+    for (size_t i = 0; i < sections.size(); ++i) {
+      auto buffer = std::make_unique<Buffer>(std::move(sections[i]));
+      sendFrame(toMessage(std::move(buffer)), i + 1 < sections.size());
+    }
+  }
+
+  void sendFrame(zmq::message_t&& msg, bool more) {
 #if ZMQ_VERSION < ZMQ_MAKE_VERSION(4, 3, 1)
-    socket->send(msg, 0);
+    socket->send(msg, more ? ZMQ_SNDMORE : 0);
 #else
-    socket->send(msg, zmq::send_flags::none);
+    socket->send(msg, more ? zmq::send_flags::sndmore : zmq::send_flags::none);
 #endif
   }
 
+  const bool multipart;
   std::unique_ptr<zmq::socket_t> socket;
+  std::unique_ptr<GraphDeltaEncoder> encoder;
 };
 
-ZmqSender::ZmqSender(const std::string& url, size_t num_threads)
-    : internals_(new ZmqSender::Detail(url, num_threads)) {}
+ZmqSender::ZmqSender(const std::string& url,
+                     size_t num_threads,
+                     size_t keyframe_interval,
+                     bool multipart)
+    : internals_(
+          new ZmqSender::Detail(url, num_threads, keyframe_interval, multipart)) {}
 
 ZmqSender::~ZmqSender() {}
 
-void ZmqSender::send(const DynamicSceneGraph& graph) { internals_->send(graph); }
+void ZmqSender::send(const DynamicSceneGraph& graph, bool include_mesh) {
+  internals_->send(graph, include_mesh);
+}
+
+//! all frames of a received message
+using Frames = std::vector<zmq::message_t>;
+
+// whether or not the message replaces the graph instead of updating it
+bool isFullGraph(Frames& frames) {
+  if (frames.size() == NUM_GRAPH_SECTIONS) {
+    return true;
+  }
+
+  auto& msg = frames.front();
+  const auto header = readDeltaHeader(static_cast<uint8_t*>(msg.data()), msg.size());
+  return !header || header->keyframe;
+}
 
 struct ZmqReceiver::Detail {
-  Detail(const std::string& url, size_t) {
+  using Clock = std::chrono::steady_clock;
+
+  //! graph that messages are applied to and the sequence number of its last delta
+  struct Buffer {
+    DynamicSceneGraph::Ptr graph;
+    uint64_t sequence = 0;
+  };
+
+  Detail(const std::string& url, size_t, bool async) : async(async) {
     socket.reset(new zmq::socket_t(ZmqContextHolder::instance().context(), ZMQ_SUB));
     socket->connect(url);
     socket->setsockopt(ZMQ_SUBSCRIBE, "", 0);
+    if (async) {
+      thread = std::thread(&Detail::spin, this);
+    }
   }
 
-  ~Detail() = default;
+  ~Detail() {
+    should_shutdown = true;
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
 
-  bool recv(size_t timeout_ms) {
+  bool poll(size_t timeout_ms) {
     if (!socket->connected()) {
       return false;
     }
 
     zmq::pollitem_t items[] = {{socket->operator void*(), 0, ZMQ_POLLIN, 0}};
     zmq::poll(&items[0], 1, std::chrono::milliseconds(timeout_ms));
+    return items[0].revents & ZMQ_POLLIN;
+  }
 
-    if (!(items[0].revents & ZMQ_POLLIN)) {
-      return false;
-    }
-
-    zmq::message_t msg;
+  bool receive(Frames& frames, bool wait) {
+    frames.clear();
+    do {
+      frames.emplace_back();
+      // only the first frame can be missing (the rest arrive with it)
+      const bool block = wait || frames.size() > 1;
 #if ZMQ_VERSION < ZMQ_MAKE_VERSION(4, 3, 1)
-    socket->recv(&msg);
+      if (!socket->recv(&frames.back(), block ? 0 : ZMQ_DONTWAIT)) {
 #else
-    const auto ret = socket->recv(msg, zmq::recv_flags::none);
-    if (!ret) {
-      throw std::runtime_error("zmq internal error: no data received");
-    }
+      const auto flags = block ? zmq::recv_flags::none : zmq::recv_flags::dontwait;
+      if (!socket->recv(frames.back(), flags)) {
 #endif
+        if (block) {
+          throw std::runtime_error("zmq internal error: no data received");
+        }
+
+        frames.clear();
+        return false;
+      }
+    } while (frames.back().more());
+
+    return true;
+  }
+
+  bool process(Buffer& buffer, Frames& frames, bool replace) {
+    auto& graph = buffer.graph;
+    if (frames.size() == NUM_GRAPH_SECTIONS) {
+      GraphSectionViews sections;
+      for (size_t i = 0; i < frames.size(); ++i) {
+        sections[i] = {static_cast<uint8_t*>(frames[i].data()), frames[i].size()};
+      }
+
+      if (!graph || replace) {
+        graph = readGraphSections(sections);
+      } else {
+        updateGraphSections(*graph, sections, true);
+      }
+
+      return true;
+    }
+
+    auto& msg = frames.front();
+    const auto data = static_cast<uint8_t*>(msg.data());
+    const auto header = readDeltaHeader(data, msg.size());
+    if (header) {
+      if (!graph || (replace && header->keyframe)) {
+        if (!header->keyframe) {
+          return false;  // wait for a keyframe to join
+        }
+
+        graph = std::make_shared<DynamicSceneGraph>(header->layer_ids,
+                                                    header->mesh_layer_id);
+      }
+
+      return applyDelta(*graph, data, msg.size(), buffer.sequence);
+    }
 
-    if (!graph) {
-      graph = readGraph(static_cast<uint8_t*>(msg.data()), msg.size());
+    if (!graph || replace) {
+      graph = readGraph(data, msg.size());
     } else {
-      updateGraph(*graph, static_cast<uint8_t*>(msg.data()), msg.size(), true);
+      updateGraph(*graph, data, msg.size(), true);
     }
 
     return true;
   }
 
+  bool tryProcess(Buffer& buffer, Frames& frames, bool replace) {
+    try {
+      return process(buffer, frames, replace);
+    } catch (...) {
+      // a partially applied message leaves the graph in an unknown state
+      buffer.graph.reset();
+      throw;
+    }
+  }
+
+  bool recv(size_t timeout_ms) {
+    if (async) {
+      return waitForGraph(timeout_ms);
+    }
+
+    if (!poll(timeout_ms)) {
+      return false;
+    }
+
+    Frames frames;
+    receive(frames, true);
+    return tryProcess(back, frames, false);
+  }
+
+  void spin() {
+    std::vector<Frames> pending;
+    while (!should_shutdown) {
+      if (!poll(100)) {
+        continue;
+      }
+
+      const auto start = Clock::now();
+      try {
+        receivePending(pending);
+      } catch (const std::exception& e) {
+        recordFailure(e);
+        continue;
+      }
+
+      // conflate: everything before the last message that replaces the graph is stale
+      size_t first = 0;
+      bool replaced = false;
+      for (size_t i = 0; i < pending.size(); ++i) {
+        if (isFullGraph(pending[i])) {
+          first = i;
+          replaced = true;
+        }
+      }
+
+      if (replaced) {
+        lagging.clear();
+      }
+
+      bool updated = false;
+      for (size_t i = first; i < pending.size(); ++i) {
+        try {
+          updated |= tryProcess(back, pending[i], true);
+        } catch (const std::exception& e) {
+          recordFailure(e);
+        }
+
+        lagging.push_back(std::move(pending[i]));
+      }
+
+      if (!back.graph) {
+        lagging.clear();  // nothing is published until the next full graph arrives
+      }
+
+      const bool publish = updated && back.graph;
+      const auto latency = Clock::now() - start;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.num_received += pending.size();
+        stats.num_dropped += first;
+        if (publish) {
+          std::atomic_store(&front, back.graph);
+          ++stats.num_published;
+          stats.last_latency = latency;
+          stats.max_latency = std::max(stats.max_latency, latency);
+          stats.total_latency += latency;
+          cv.notify_all();
+        }
+      }
+
+      if (publish) {
+        std::swap(back, spare);
+        catchUp();
+      }
+    }
+  }
+
+  void catchUp() {
+    // front no longer points at the previous graph, so nobody else can start using it
+    if (!back.graph || back.graph.use_count() > 1) {
+      back = {spare.graph->clone(), spare.sequence};
+      lagging.clear();
+      return;
+    }
+
+    // replaying the same messages leaves the previous graph in the published state
+    for (auto& frames : lagging) {
+      try {
+        tryProcess(back, frames, true);
+      } catch (const std::exception&) {
+        // already recorded when the message was first applied
+      }
+    }
+
+    lagging.clear();
+  }
+
+  void receivePending(std::vector<Frames>& pending) {
+    pending.resize(1);
+    receive(pending.front(), true);
+    while (true) {
+      pending.emplace_back();
+      if (!receive(pending.back(), false)) {
+        pending.pop_back();
+        break;
+      }
+    }
+  }
+
+  void recordFailure(const std::exception& e) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++stats.num_failed;
+    stats.last_error = e.what();
+  }
+
+  bool waitForGraph(size_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex);
+    const bool published = cv.wait_for(lock,
+                                       std::chrono::milliseconds(timeout_ms),
+                                       [&] { return stats.num_published > num_seen; });
+    num_seen = stats.num_published;
+    return published;
+  }
+
+  DynamicSceneGraph::Ptr getGraph() const {
+    return async ? std::atomic_load(&front) : back.graph;
+  }
+
+  Stats getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+  }
+
+  const bool async;
   std::unique_ptr<zmq::socket_t> socket;
-  DynamicSceneGraph::Ptr graph;
+  //! graph that messages are applied to (only touched by the receive thread)
+  Buffer back;
+  //! most recently published graph (async mode only)
+  Buffer spare;
+  //! messages applied to the working graph since the spare graph was published
+  std::vector<Frames> lagging;
+
+  //! latest complete graph (async mode only)
+  DynamicSceneGraph::Ptr front;
+  std::atomic<bool> should_shutdown{false};
+  std::thread thread;
+  mutable std::mutex mutex;
+  std::condition_variable cv;
+  Stats stats;
+  size_t num_seen = 0;
 };
 
-ZmqReceiver::ZmqReceiver(const std::string& url, size_t num_threads)
-    : internals_(new ZmqReceiver::Detail(url, num_threads)) {}
+ZmqReceiver::ZmqReceiver(const std::string& url, size_t num_threads, bool async)
+    : internals_(new ZmqReceiver::Detail(url, num_threads, async)) {}
 
 ZmqReceiver::~ZmqReceiver() {}
 
 bool ZmqReceiver::recv(size_t timeout_ms) { return internals_->recv(timeout_ms); }
 
-DynamicSceneGraph::Ptr ZmqReceiver::graph() const { return internals_->graph; }
+DynamicSceneGraph::Ptr ZmqReceiver::graph() const { return internals_->getGraph(); }
+
+ZmqReceiver::Stats ZmqReceiver::stats() const { return internals_->getStats(); }
 
 }  // namespace spark_dsg
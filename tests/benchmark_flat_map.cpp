@@ -0,0 +1,88 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/flat_map.h>
+#include <spark_dsg/node_symbol.h>
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+
+namespace spark_dsg {
+
+// node lookup latency of the flat index against the std::map it replaced
+TEST(FlatMapBenchmarks, Lookup) {
+  const size_t num_nodes = 500000;
+  const size_t num_queries = 5000000;
+
+  std::vector<NodeId> queries;
+  queries.reserve(num_queries);
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<size_t> index_dist(0, num_nodes - 1);
+  for (size_t i = 0; i < num_queries; ++i) {
+    queries.push_back(NodeSymbol('p', index_dist(gen)));
+  }
+
+  std::map<NodeId, LayerKey> tree_lookup;
+  NodeLookup flat_lookup;
+  for (size_t i = 0; i < num_nodes; ++i) {
+    tree_lookup[NodeSymbol('p', i)] = LayerKey(3);
+    flat_lookup[NodeSymbol('p', i)] = LayerKey(3);
+  }
+
+  size_t tree_hits = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto query : queries) {
+    tree_hits += tree_lookup.find(query)->second.layer;
+  }
+  auto tree_time = std::chrono::steady_clock::now() - start;
+
+  size_t flat_hits = 0;
+  start = std::chrono::steady_clock::now();
+  for (const auto query : queries) {
+    flat_hits += flat_lookup.find(query)->second.layer;
+  }
+  auto flat_time = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(tree_hits, flat_hits);
+
+  using Nanoseconds = std::chrono::duration<double, std::nano>;
+  std::cout << "std::map lookup: " << Nanoseconds(tree_time).count() / num_queries
+            << " ns/query" << std::endl;
+  std::cout << "FlatMap lookup: " << Nanoseconds(flat_time).count() / num_queries
+            << " ns/query" << std::endl;
+}
+
+}  // namespace spark_dsg
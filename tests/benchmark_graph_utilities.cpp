@@ -0,0 +1,113 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/graph_utilities.h>
+#include <spark_dsg/scene_graph_layer.h>
+
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <unordered_set>
+
+namespace spark_dsg {
+
+// bfs over a 100k node layer with copied neighbors, neighbor views and a frozen layer
+TEST(BreadthFirstSearchBenchmarks, LargeLayer) {
+  // 4-connected grid with 100k nodes
+  const size_t side = 317;
+  IsolatedSceneGraphLayer layer(1);
+  for (size_t i = 0; i < side * side; ++i) {
+    layer.emplaceNode(i, std::make_unique<NodeAttributes>());
+  }
+
+  for (size_t r = 0; r < side; ++r) {
+    for (size_t c = 0; c < side; ++c) {
+      const size_t i = r * side + c;
+      if (c + 1 < side) {
+        layer.insertEdge(i, i + 1);
+      }
+      if (r + 1 < side) {
+        layer.insertEdge(i, i + side);
+      }
+    }
+  }
+
+  using Clock = std::chrono::steady_clock;
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+
+  // previous traits behavior: copy the sibling set of every expanded node
+  size_t copy_visited = 0;
+  auto start = Clock::now();
+  {
+    std::deque<NodeId> frontier{0};
+    std::unordered_set<NodeId> seen{0};
+    while (!frontier.empty()) {
+      const NodeId curr = frontier.front();
+      frontier.pop_front();
+      ++copy_visited;
+      std::set<NodeId> neighbors = layer.getNode(curr)->get().siblings();
+      for (const auto neighbor : neighbors) {
+        if (seen.insert(neighbor).second) {
+          frontier.push_back(neighbor);
+        }
+      }
+    }
+  }
+  const Milliseconds copy_time = Clock::now() - start;
+
+  size_t view_visited = 0;
+  start = Clock::now();
+  graph_utilities::breadthFirstSearch<SceneGraphLayer>(
+      layer, NodeId(0), [&](const SceneGraphLayer&, NodeId) { ++view_visited; });
+  const Milliseconds view_time = Clock::now() - start;
+
+  const auto frozen = layer.freeze();
+  std::vector<uint8_t> visited;
+  std::vector<FrozenLayer::Index> frontier;
+  size_t frozen_visited = 0;
+  start = Clock::now();
+  const auto count_visit = [&](FrozenLayer::Index) { ++frozen_visited; };
+  frozen.breadthFirstSearch(frozen.index(0), count_visit, visited, frontier);
+  const Milliseconds frozen_time = Clock::now() - start;
+
+  EXPECT_EQ(side * side, copy_visited);
+  EXPECT_EQ(side * side, view_visited);
+  EXPECT_EQ(side * side, frozen_visited);
+  std::cout << "bfs (copied neighbors): " << copy_time.count() << " ms" << std::endl;
+  std::cout << "bfs (neighbor view): " << view_time.count() << " ms" << std::endl;
+  std::cout << "bfs (frozen layer): " << frozen_time.count() << " ms" << std::endl;
+}
+
+}  // namespace spark_dsg
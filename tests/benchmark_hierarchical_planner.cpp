@@ -0,0 +1,79 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/hierarchical_planner.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "spark_dsg_tests/building.h"
+
+namespace spark_dsg {
+
+using graph_utilities::ShortestPathWorkspace;
+
+// long-range query through the places layer against the room-then-places planner
+TEST(HierarchicalPlannerBenchmarks, LongRange) {
+  using Clock = std::chrono::steady_clock;
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+
+  Building building(20, 20, 10);
+  const NodeId start = building.place(0, 0);
+  const NodeId goal = building.place(building.globalX(19, 9), building.globalY(19, 9));
+
+  const auto& layer = building.graph.getLayer(DsgLayers::PLACES);
+  const RestrictedLayer places{layer, nullptr, true};
+  ShortestPathWorkspace workspace;
+  auto start_time = Clock::now();
+  const auto flat = graph_utilities::shortestPath(
+      places, std::vector<NodeId>{start}, goal, workspace);
+  const Milliseconds flat_time = Clock::now() - start_time;
+
+  HierarchicalPlanner::Config config;
+  config.metric_place_weights = true;
+  HierarchicalPlanner planner(config);
+  start_time = Clock::now();
+  const auto result = planner.plan(building.graph, start, goal);
+  const Milliseconds hierarchical_time = Clock::now() - start_time;
+
+  ASSERT_FALSE(result.empty());
+  EXPECT_FALSE(result.used_fallback);
+  std::cout << "places: " << places.layer.numNodes() << ", flat: " << flat_time.count()
+            << " ms (cost " << flat.cost << "), hierarchical: "
+            << hierarchical_time.count() << " ms (cost " << result.places.cost << ")"
+            << std::endl;
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,86 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/graph_utilities.h>
+#include <spark_dsg/scene_graph_layer.h>
+
+#include <chrono>
+#include <iostream>
+#include <unordered_set>
+
+namespace spark_dsg {
+
+// neighborhood of many seeds with one cost-map bfs against the multi-source search
+TEST(SceneGraphLayerBenchmarks, SearchNeighborhood) {
+  using Clock = std::chrono::steady_clock;
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+
+  // 4-connected grid with 100k nodes and 5k seeds
+  const size_t side = 317;
+  IsolatedSceneGraphLayer layer(1);
+  for (size_t i = 0; i < side * side; ++i) {
+    layer.emplaceNode(i, std::make_unique<NodeAttributes>());
+    if (i % side) {
+      layer.insertEdge(i - 1, i);
+    }
+    if (i >= side) {
+      layer.insertEdge(i - side, i);
+    }
+  }
+
+  std::vector<NodeId> seeds;
+  for (size_t i = 0; i < side * side; i += 20) {
+    seeds.push_back(i);
+  }
+
+  auto start = Clock::now();
+  std::unordered_set<NodeId> expected;
+  graph_utilities::breadthFirstSearch<SceneGraphLayer, std::vector<NodeId>>(
+      layer, seeds, 3, [&](const SceneGraphLayer&, NodeId node) {
+        expected.insert(node);
+      });
+  const Milliseconds bfs_time = Clock::now() - start;
+
+  start = Clock::now();
+  const auto result = layer.searchNeighborhood(seeds, 3);
+  const Milliseconds search_time = Clock::now() - start;
+
+  EXPECT_EQ(expected.size(), result.size());
+  std::cout << "cost map bfs: " << bfs_time.count()
+            << " ms, multi-source search: " << search_time.count() << " ms"
+            << std::endl;
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,80 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/shortest_paths.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "spark_dsg_tests/weighted_grid.h"
+
+namespace spark_dsg {
+
+using graph_utilities::ShortestPathWorkspace;
+
+// repeated dijkstra and a* queries that share a workspace
+TEST(ShortestPathBenchmarks, RepeatedQuery) {
+  using Clock = std::chrono::steady_clock;
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+
+  const size_t side = 200;
+  const auto layer_ptr = makeGrid(side, 1.0);
+  const auto& layer = *layer_ptr;
+  const NodeId target = side * side - 1;
+
+  ShortestPathWorkspace workspace;
+  auto start = Clock::now();
+  double total = 0.0;
+  for (size_t i = 0; i < 10; ++i) {
+    total += graph_utilities::shortestPath<SceneGraphLayer>(
+                 layer, std::vector<NodeId>{i}, target, workspace)
+                 .cost;
+  }
+  const Milliseconds dijkstra_time = Clock::now() - start;
+
+  start = Clock::now();
+  double astar_total = 0.0;
+  for (size_t i = 0; i < 10; ++i) {
+    astar_total +=
+        graph_utilities::aStar<SceneGraphLayer>(layer, i, target, workspace).cost;
+  }
+  const Milliseconds astar_time = Clock::now() - start;
+
+  EXPECT_NEAR(total, astar_total, 1.0e-6);
+  std::cout << "dijkstra: " << dijkstra_time.count() / 10 << " ms/query, a*: "
+            << astar_time.count() / 10 << " ms/query" << std::endl;
+}
+
+}  // namespace spark_dsg
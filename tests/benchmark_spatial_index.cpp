@@ -0,0 +1,100 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/scene_graph_layer.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+namespace spark_dsg {
+
+namespace {
+
+std::vector<Eigen::Vector3d> randomPoints(size_t num_points, double scale, int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dist(-scale, scale);
+  std::vector<Eigen::Vector3d> points;
+  for (size_t i = 0; i < num_points; ++i) {
+    points.emplace_back(dist(gen), dist(gen), dist(gen));
+  }
+  return points;
+}
+
+}  // namespace
+
+// nearest node lookups with the spatial index against a linear scan of the layer
+TEST(SpatialIndexBenchmarks, Nearest) {
+  const size_t num_nodes = 200000;
+  const size_t num_queries = 10000;
+  const auto points = randomPoints(num_nodes, 100.0, 3);
+  const auto queries = randomPoints(num_queries, 100.0, 4);
+
+  IsolatedSceneGraphLayer layer(1);
+  for (size_t i = 0; i < points.size(); ++i) {
+    layer.emplaceNode(i, std::make_unique<NodeAttributes>(points[i]));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  layer.enableSpatialIndex(true, 1.0);
+  auto build_time = std::chrono::steady_clock::now() - start;
+
+  size_t checksum = 0;
+  start = std::chrono::steady_clock::now();
+  for (const auto& query : queries) {
+    checksum += *layer.getNearestNode(query);
+  }
+  auto index_time = std::chrono::steady_clock::now() - start;
+
+  layer.enableSpatialIndex(false);
+  size_t scan_checksum = 0;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < 100; ++i) {
+    scan_checksum += *layer.getNearestNode(queries[i]);
+  }
+  auto scan_time = (std::chrono::steady_clock::now() - start) * (num_queries / 100);
+  EXPECT_GT(checksum, 0u);
+  EXPECT_GT(scan_checksum, 0u);
+
+  using Microseconds = std::chrono::duration<double, std::micro>;
+  std::cout << "index build: " << Microseconds(build_time).count() << " us"
+            << std::endl;
+  std::cout << "indexed nearest: " << Microseconds(index_time).count() / num_queries
+            << " us/query" << std::endl;
+  std::cout << "linear nearest: " << Microseconds(scan_time).count() / num_queries
+            << " us/query" << std::endl;
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,123 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <spark_dsg/dynamic_scene_graph.h>
+#include <spark_dsg/node_symbol.h>
+
+namespace spark_dsg {
+
+// grid of square rooms (each a 4-connected grid of places) connected by doorway places
+// that don't belong to any room
+struct Building {
+  Building(size_t rooms_x, size_t rooms_y, size_t room_size)
+      : rooms_x(rooms_x), rooms_y(rooms_y), room_size(room_size) {
+    for (size_t rx = 0; rx < rooms_x; ++rx) {
+      for (size_t ry = 0; ry < rooms_y; ++ry) {
+        addRoom(rx, ry);
+      }
+    }
+
+    const size_t mid = room_size / 2;
+    for (size_t rx = 0; rx < rooms_x; ++rx) {
+      for (size_t ry = 0; ry < rooms_y; ++ry) {
+        if (rx + 1 < rooms_x) {
+          addDoor(globalX(rx, room_size - 1),
+                  globalY(ry, mid),
+                  globalX(rx + 1, 0),
+                  globalY(ry, mid));
+          graph.insertEdge(room(rx, ry), room(rx + 1, ry));
+        }
+
+        if (ry + 1 < rooms_y) {
+          addDoor(globalX(rx, mid),
+                  globalY(ry, room_size - 1),
+                  globalX(rx, mid),
+                  globalY(ry + 1, 0));
+          graph.insertEdge(room(rx, ry), room(rx, ry + 1));
+        }
+      }
+    }
+  }
+
+  size_t globalX(size_t rx, size_t px) const { return rx * (room_size + 1) + px; }
+  size_t globalY(size_t ry, size_t py) const { return ry * (room_size + 1) + py; }
+
+  NodeId place(size_t x, size_t y) const { return NodeSymbol('p', x * 100000 + y); }
+
+  NodeId room(size_t rx, size_t ry) const { return NodeSymbol('R', rx * rooms_y + ry); }
+
+  void addPlace(size_t x, size_t y) {
+    graph.emplaceNode(DsgLayers::PLACES,
+                      place(x, y),
+                      std::make_unique<NodeAttributes>(Eigen::Vector3d(x, y, 0.0)));
+  }
+
+  void addRoom(size_t rx, size_t ry) {
+    const double center = (room_size - 1) / 2.0;
+    const Eigen::Vector3d pos(globalX(rx, 0) + center, globalY(ry, 0) + center, 0.0);
+    graph.emplaceNode(
+        DsgLayers::ROOMS, room(rx, ry), std::make_unique<NodeAttributes>(pos));
+
+    for (size_t px = 0; px < room_size; ++px) {
+      for (size_t py = 0; py < room_size; ++py) {
+        const size_t x = globalX(rx, px);
+        const size_t y = globalY(ry, py);
+        addPlace(x, y);
+        graph.insertEdge(room(rx, ry), place(x, y));
+        if (px > 0) {
+          graph.insertEdge(place(x - 1, y), place(x, y));
+        }
+        if (py > 0) {
+          graph.insertEdge(place(x, y - 1), place(x, y));
+        }
+      }
+    }
+  }
+
+  void addDoor(size_t x1, size_t y1, size_t x2, size_t y2) {
+    const size_t x = (x1 + x2) / 2;
+    const size_t y = (y1 + y2) / 2;
+    addPlace(x, y);
+    graph.insertEdge(place(x1, y1), place(x, y));
+    graph.insertEdge(place(x, y), place(x2, y2));
+  }
+
+  const size_t rooms_x;
+  const size_t rooms_y;
+  const size_t room_size;
+  DynamicSceneGraph graph;
+};
+
+}  // namespace spark_dsg
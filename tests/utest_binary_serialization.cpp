@@ -38,6 +38,11 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+#include "spark_dsg_tests/temp_file.h"
 #include "spark_dsg_tests/type_comparisons.h"
 
 namespace spark_dsg {
@@ -326,6 +331,121 @@ TEST(BinarySerializationTests, SerializeEdgeInfo) {
   }
 }
 
+Mesh makeGridMesh(size_t size) {
+  Mesh mesh;
+  for (size_t r = 0; r < size; ++r) {
+    for (size_t c = 0; c < size; ++c) {
+      const auto value = static_cast<uint8_t>(r * size + c);
+      mesh.addVertex({0.1f * r, 0.2f * c, 0.01f * r * c}, {value, 255, 0, 128});
+    }
+  }
+
+  for (uint32_t r = 0; r + 1 < size; ++r) {
+    for (uint32_t c = 0; c + 1 < size; ++c) {
+      const uint32_t corner = r * size + c;
+      mesh.addFace({corner, corner + 1, corner + static_cast<uint32_t>(size)});
+      mesh.addFace({corner + 1,
+                    corner + static_cast<uint32_t>(size) + 1,
+                    corner + static_cast<uint32_t>(size)});
+    }
+  }
+
+  return mesh;
+}
+
+TEST(BinarySerializationTests, SerializeMeshCompact) {
+  const auto expected = makeGridMesh(20);
+
+  std::vector<uint8_t> buffer;
+  serialization::BinarySerializer serializer(&buffer);
+  serializer.write(expected);
+
+  std::vector<uint8_t> legacy_buffer;
+  serialization::BinarySerializer legacy_serializer(&legacy_buffer);
+  legacy_serializer.write(*expected.toPclVertices());
+  legacy_serializer.write(*expected.toPclFaces());
+  EXPECT_LT(2 * buffer.size(), legacy_buffer.size());
+
+  serialization::BinaryDeserializer deserializer(buffer);
+  const auto result = serialization::readMesh(deserializer);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(expected, *result);
+  EXPECT_TRUE(deserializer.atEnd());
+
+  // truncated data is rejected
+  serialization::BinaryDeserializer truncated(buffer.data(), buffer.size() - 1);
+  EXPECT_THROW(serialization::readMesh(truncated), std::out_of_range);
+}
+
+TEST(BinarySerializationTests, SerializeMeshLegacyLayout) {
+  auto expected = makeGridMesh(5);
+  for (size_t i = 0; i < expected.numVertices(); ++i) {
+    auto color = expected.color(i);
+    color.a = 255;  // the legacy layout doesn't store alpha
+    expected.setColor(i, color);
+  }
+
+  std::vector<uint8_t> buffer;
+  serialization::BinarySerializer serializer(&buffer);
+  serializer.write(*expected.toPclVertices());
+  serializer.write(*expected.toPclFaces());
+
+  serialization::BinaryDeserializer deserializer(buffer);
+  const auto result = serialization::readMesh(deserializer);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(expected, *result);
+  EXPECT_TRUE(deserializer.atEnd());
+
+  // the compact layout is opt-in so that older readers can parse meshes by default
+  std::vector<uint8_t> default_buffer;
+  serialization::BinarySerializer default_serializer(&default_buffer);
+  serialization::writeMesh(default_serializer, expected);
+  EXPECT_EQ(buffer, default_buffer);
+}
+
+TEST(BinarySerializationTests, SerializeMeshQuantized) {
+  auto expected = makeGridMesh(10);
+
+  // invalid vertices are marked by the origin, which doesn't fall on a quantized value
+  for (size_t i = 0; i < expected.numVertices(); ++i) {
+    expected.setPos(i, expected.pos(i) - Mesh::Pos::Constant(0.0123f));
+  }
+  expected.setPos(5, Mesh::Pos::Zero());
+
+  std::vector<uint8_t> raw_buffer;
+  serialization::BinarySerializer raw_serializer(&raw_buffer);
+  serialization::writeMesh(raw_serializer, expected, {0, true});
+
+  std::vector<uint8_t> buffer;
+  serialization::BinarySerializer serializer(&buffer);
+  serialization::writeMesh(serializer, expected, {12});
+  EXPECT_LT(buffer.size(), raw_buffer.size());
+
+  serialization::BinaryDeserializer deserializer(buffer);
+  const auto result = serialization::readMesh(deserializer);
+  ASSERT_TRUE(result);
+  ASSERT_EQ(expected.numVertices(), result->numVertices());
+  EXPECT_EQ(expected.colors(), result->colors());
+  EXPECT_EQ(expected.indices(), result->indices());
+  for (size_t i = 0; i < expected.numVertices(); ++i) {
+    // bounds are at most 1.8 wide, so 12 bits are accurate to under a millimeter
+    EXPECT_NEAR(0.0f, (expected.pos(i) - result->pos(i)).norm(), 1.0e-3f);
+  }
+  EXPECT_EQ(Mesh::Pos::Zero(), result->pos(5));
+
+  // meshes with invalid coordinates fall back to the lossless encoding
+  expected.setPos(3, Mesh::Pos::Constant(std::numeric_limits<float>::quiet_NaN()));
+  buffer.clear();
+  serialization::writeMesh(serializer, expected, {12});
+  serialization::BinaryDeserializer nan_deserializer(buffer);
+  const auto nan_result = serialization::readMesh(nan_deserializer);
+  EXPECT_TRUE(std::isnan(nan_result->pos(3).x()));
+  EXPECT_EQ(expected.pos(4), nan_result->pos(4));
+
+  EXPECT_THROW(serialization::writeMesh(serializer, expected, {17}),
+               std::invalid_argument);
+}
+
 TEST(BinarySerializationTests, SerializeDsgBasic) {
   DynamicSceneGraph expected({1, 2, 3}, 0);
   expected.emplaceNode(1, 0, std::make_unique<NodeAttributes>());
@@ -464,4 +584,463 @@ TEST(BinarySerializationTests, UpdateDsgFromBinaryWithCorrection) {
   EXPECT_FALSE(updated.getNode(0)->get().hasParent());
 }
 
+TEST(BinarySerializationTests, StreamingDeserializationCorrect) {
+  using namespace std::chrono_literals;
+  DynamicSceneGraph original;
+  for (NodeId node = 0; node < 50; ++node) {
+    original.emplaceNode(3, node, std::make_unique<NodeAttributes>());
+  }
+  original.emplaceNode(4, 50, std::make_unique<NodeAttributes>());
+  original.emplaceNode(2, 'a', 10ns, std::make_unique<NodeAttributes>());
+  original.emplaceNode(2, 'a', 20ns, std::make_unique<NodeAttributes>());
+  original.insertEdge(0, 1);
+  original.insertEdge(0, 50);
+
+  std::vector<uint8_t> buffer;
+  writeGraph(original, buffer);
+
+  // reader that only hands out a few bytes at a time
+  size_t offset = 0;
+  const auto reader = [&](uint8_t* data, size_t max_bytes) {
+    const auto to_copy = std::min({max_bytes, buffer.size() - offset, size_t(7)});
+    std::copy_n(buffer.begin() + offset, to_copy, data);
+    offset += to_copy;
+    return to_copy;
+  };
+
+  serialization::BinaryDeserializer deserializer(reader, 16);
+  std::vector<LayerId> layer_ids;
+  deserializer.read(layer_ids);
+  EXPECT_EQ(original.layer_ids, layer_ids);
+  EXPECT_FALSE(deserializer.atEnd());
+
+  offset = 0;
+  auto result = readGraph(reader);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(original.numNodes(), result->numNodes());
+  EXPECT_EQ(original.numDynamicNodes(), result->numDynamicNodes());
+  EXPECT_EQ(original.numEdges(), result->numEdges());
+  EXPECT_TRUE(result->hasEdge(0, 50));
+
+  // split buffers read as one
+  const size_t split = buffer.size() / 3;
+  result = readGraph(serialization::bufferChunkReader(
+      {{buffer.data(), split}, {buffer.data() + split, buffer.size() - split}}));
+  EXPECT_EQ(original.numNodes(), result->numNodes());
+  EXPECT_EQ(original.numEdges(), result->numEdges());
+
+  // reading past the end still fails
+  offset = buffer.size();
+  EXPECT_THROW(readGraph(reader), std::out_of_range);
+}
+
+TEST(BinarySerializationTests, SectionSerializationCorrect) {
+  using namespace std::chrono_literals;
+  DynamicSceneGraph original;
+  original.emplaceNode(3, 0, std::make_unique<NodeAttributes>());
+  original.emplaceNode(3, 1, std::make_unique<NodeAttributes>());
+  original.emplaceNode(4, 2, std::make_unique<NodeAttributes>());
+  original.emplaceNode(2, 'a', 10ns, std::make_unique<NodeAttributes>());
+  original.insertEdge(0, 1);
+  original.insertEdge(0, 2);
+  original.insertMeshEdge(2, 5, true);
+
+  GraphSectionBuffers sections;
+  writeGraphSections(original, sections);
+
+  // sections are the full serialization split up
+  std::vector<uint8_t> buffer;
+  writeGraph(original, buffer);
+  std::vector<uint8_t> combined;
+  GraphSectionViews views;
+  for (size_t i = 0; i < sections.size(); ++i) {
+    EXPECT_FALSE(sections[i].empty());
+    combined.insert(combined.end(), sections[i].begin(), sections[i].end());
+    views[i] = {sections[i].data(), sections[i].size()};
+  }
+  EXPECT_EQ(buffer, combined);
+
+  auto result = readGraphSections(views);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(original.numNodes(), result->numNodes());
+  EXPECT_EQ(original.numEdges(), result->numEdges());
+  EXPECT_EQ(original.getMeshEdges().size(), result->getMeshEdges().size());
+
+  original.removeNode(1);
+  sections = GraphSectionBuffers();
+  writeGraphSections(original, sections);
+  for (size_t i = 0; i < sections.size(); ++i) {
+    views[i] = {sections[i].data(), sections[i].size()};
+  }
+
+  EXPECT_TRUE(updateGraphSections(*result, views, true));
+  EXPECT_EQ(original.numNodes(), result->numNodes());
+  EXPECT_FALSE(result->hasNode(1));
+}
+
+TEST(BinarySerializationTests, DeltaSerializationCorrect) {
+  using namespace std::chrono_literals;
+  DynamicSceneGraph original;
+  for (NodeId node = 0; node < 20; ++node) {
+    original.emplaceNode(3, node, std::make_unique<NodeAttributes>());
+  }
+  original.emplaceNode(4, 20, std::make_unique<NodeAttributes>());
+  original.emplaceNode(2, 'a', 10ns, std::make_unique<NodeAttributes>());
+  original.emplaceNode(2, 'a', 20ns, std::make_unique<NodeAttributes>());
+  original.insertEdge(0, 1);
+  original.insertEdge(1, 2);
+  original.insertEdge(0, 20);
+  original.insertMeshEdge(0, 3, true);
+  original.insertMeshEdge(1, 4, true);
+
+  GraphDeltaEncoder encoder(3);
+  std::vector<uint8_t> buffer;
+  EXPECT_TRUE(encoder.encode(original, buffer));
+
+  const auto header = readDeltaHeader(buffer.data(), buffer.size());
+  ASSERT_TRUE(header);
+  EXPECT_TRUE(header->keyframe);
+  EXPECT_EQ(1u, header->sequence);
+  EXPECT_EQ(original.layer_ids, header->layer_ids);
+
+  DynamicSceneGraph result(header->layer_ids, header->mesh_layer_id);
+  result.emplaceNode(3, 30, std::make_unique<NodeAttributes>());
+  uint64_t sequence = 0;
+  EXPECT_TRUE(applyDelta(result, buffer, sequence));
+  EXPECT_EQ(1u, sequence);
+  EXPECT_EQ(original.numNodes(), result.numNodes());
+  EXPECT_EQ(original.numEdges(), result.numEdges());
+  EXPECT_FALSE(result.hasNode(30));
+  EXPECT_EQ(2u, result.getMeshEdges().size());
+
+  // full graphs aren't deltas
+  std::vector<uint8_t> full_buffer;
+  writeGraph(original, full_buffer);
+  EXPECT_FALSE(readDeltaHeader(full_buffer.data(), full_buffer.size()));
+
+  // only changes are sent (in-place modifications have to be reported)
+  original.getNode(5)->get().attributes().position << 1.0, 2.0, 3.0;
+  original.markNodeUpdated(5);
+  original.getNode(6)->get().attributes().position << 4.0, 5.0, 6.0;
+  original.removeMeshEdge(1, 4);
+  original.emplaceNode(3, 21, std::make_unique<NodeAttributes>());
+  original.insertMeshEdge(21, 5, true);
+  original.emplaceNode(2, 'a', 30ns, std::make_unique<NodeAttributes>());
+  original.removeNode(2);
+  original.removeEdge(0, 20);
+  original.insertEdge(5, 21);
+
+  buffer.clear();
+  EXPECT_FALSE(encoder.encode(original, buffer));
+  EXPECT_LT(buffer.size(), full_buffer.size() / 2);
+  EXPECT_TRUE(applyDelta(result, buffer, sequence));
+  EXPECT_EQ(2u, sequence);
+
+  EXPECT_EQ(original.numNodes(), result.numNodes());
+  EXPECT_EQ(original.numEdges(), result.numEdges());
+  EXPECT_FALSE(result.hasNode(2));
+  EXPECT_FALSE(result.hasEdge(1, 2));
+  EXPECT_FALSE(result.hasEdge(0, 20));
+  EXPECT_TRUE(result.hasEdge(5, 21));
+  EXPECT_TRUE(result.hasEdge("a1"_id, "a2"_id));
+  EXPECT_EQ(Eigen::Vector3d(1.0, 2.0, 3.0), result.getPosition(5));
+  EXPECT_EQ(Eigen::Vector3d::Zero(), result.getPosition(6));
+  EXPECT_TRUE(result.hasMeshEdge(0, 3));
+  EXPECT_FALSE(result.hasMeshEdge(1, 4));
+  EXPECT_TRUE(result.hasMeshEdge(21, 5));
+
+  // deltas after a missed message are rejected until the next keyframe
+  original.insertEdge(6, 7);
+  buffer.clear();
+  EXPECT_FALSE(encoder.encode(original, buffer));
+  original.removeEdge(6, 7);
+  buffer.clear();
+  EXPECT_TRUE(encoder.encode(original, buffer));
+  original.insertEdge(7, 8);
+  buffer.clear();
+  EXPECT_FALSE(encoder.encode(original, buffer));
+  EXPECT_FALSE(applyDelta(result, buffer, sequence));
+  EXPECT_EQ(2u, sequence);
+
+  encoder.requestKeyframe();
+  buffer.clear();
+  EXPECT_TRUE(encoder.encode(original, buffer));
+  EXPECT_TRUE(applyDelta(result, buffer, sequence));
+  EXPECT_EQ(6u, sequence);
+  EXPECT_EQ(original.numNodes(), result.numNodes());
+  EXPECT_EQ(original.numEdges(), result.numEdges());
+  EXPECT_TRUE(result.hasEdge(7, 8));
+  // keyframes pick up unreported modifications
+  EXPECT_EQ(Eigen::Vector3d(4.0, 5.0, 6.0), result.getPosition(6));
+}
+
+TEST(BinarySerializationTests, SerializeMeshBlocks) {
+  DynamicSceneGraph expected;
+  expected.setMesh(std::make_shared<Mesh>(makeGridMesh(3)));
+  expected.upsertMeshBlock({0, 0, 0}, makeGridMesh(4));
+  expected.upsertMeshBlock({0, 0, 1}, makeGridMesh(2));
+  expected.upsertMeshBlock({-1, 2, 0}, makeGridMesh(3));
+  expected.removeMeshBlock({0, 0, 1});
+
+  // the compact layout keeps the alpha channel
+  const serialization::MeshEncoding compact{0, true};
+  std::vector<uint8_t> buffer;
+  writeGraph(expected, buffer, true, compact);
+  auto result = readGraph(buffer);
+  ASSERT_TRUE(result->hasMesh());
+  EXPECT_EQ(*expected.mesh(), *result->mesh());
+  EXPECT_EQ(expected.meshBlocks().blocks(), result->meshBlocks().blocks());
+  EXPECT_EQ(9u, result->meshBlocks().baseVertices());
+  EXPECT_EQ(8u, result->meshBlocks().baseFaces());
+
+  TempFile tmp_file;
+  GraphArchive::write(expected, tmp_file.path);
+  result = GraphArchive(tmp_file.path).load();
+  ASSERT_TRUE(result->hasMesh());
+  EXPECT_EQ(*expected.mesh(), *result->mesh());
+  EXPECT_EQ(expected.meshBlocks().blocks(), result->meshBlocks().blocks());
+
+  // meshes without blocks have no layout
+  expected.setMesh(std::make_shared<Mesh>(makeGridMesh(3)));
+  buffer.clear();
+  writeGraph(expected, buffer, true, compact);
+  result = readGraph(buffer);
+  ASSERT_TRUE(result->hasMesh());
+  EXPECT_EQ(*expected.mesh(), *result->mesh());
+  EXPECT_TRUE(result->meshBlocks().empty());
+  EXPECT_EQ(9u, result->meshBlocks().baseVertices());
+}
+
+TEST(BinarySerializationTests, DeltaSerializationMeshBlocks) {
+  DynamicSceneGraph original;
+  original.emplaceNode(2, 0, std::make_unique<NodeAttributes>());
+  for (int32_t i = 0; i < 8; ++i) {
+    original.upsertMeshBlock({i, 0, 0}, makeGridMesh(6));
+  }
+  original.insertMeshEdge(0, 40);
+
+  GraphDeltaEncoder encoder(0);
+  std::vector<uint8_t> buffer;
+  EXPECT_TRUE(encoder.encode(original, buffer, true));
+  const auto keyframe_size = buffer.size();
+
+  DynamicSceneGraph result;
+  uint64_t sequence = 0;
+  EXPECT_TRUE(applyDelta(result, buffer, sequence));
+  ASSERT_TRUE(result.hasMesh());
+  EXPECT_EQ(*original.mesh(), *result.mesh());
+  EXPECT_EQ(original.meshBlocks().blocks(), result.meshBlocks().blocks());
+
+  // only changed blocks are sent
+  original.upsertMeshBlock({1, 0, 0}, makeGridMesh(7));
+  original.upsertMeshBlock({2, 0, 0}, makeGridMesh(4));
+  original.removeMeshBlock({3, 0, 0});
+  original.upsertMeshBlock({0, 1, 0}, makeGridMesh(5));
+  original.upsertMeshBlock({0, 2, 0}, makeGridMesh(2));
+  original.removeMeshBlock({0, 2, 0});
+  buffer.clear();
+  EXPECT_FALSE(encoder.encode(original, buffer, true));
+  EXPECT_LT(buffer.size(), keyframe_size / 2);
+  EXPECT_TRUE(applyDelta(result, buffer, sequence));
+  EXPECT_EQ(*original.mesh(), *result.mesh());
+  EXPECT_EQ(original.meshBlocks().blocks(), result.meshBlocks().blocks());
+  EXPECT_EQ(original.getMeshConnectionIndices(0), result.getMeshConnectionIndices(0));
+
+  // unchanged blocks aren't sent at all
+  buffer.clear();
+  EXPECT_FALSE(encoder.encode(original, buffer, true));
+  EXPECT_LT(buffer.size(), 128u);
+  EXPECT_TRUE(applyDelta(result, buffer, sequence));
+  EXPECT_EQ(*original.mesh(), *result.mesh());
+
+  // replacing the mesh sends it in full
+  original.setMesh(std::make_shared<Mesh>(makeGridMesh(3)));
+  buffer.clear();
+  EXPECT_FALSE(encoder.encode(original, buffer, true));
+  EXPECT_TRUE(applyDelta(result, buffer, sequence));
+  EXPECT_EQ(*original.mesh(), *result.mesh());
+  EXPECT_TRUE(result.meshBlocks().empty());
+
+  for (int32_t i = 0; i < 2; ++i) {
+    original.upsertMeshBlock({i, 0, 0}, makeGridMesh(4 + i));
+    buffer.clear();
+    EXPECT_FALSE(encoder.encode(original, buffer, true));
+    EXPECT_TRUE(applyDelta(result, buffer, sequence));
+    EXPECT_EQ(*original.mesh(), *result.mesh());
+    EXPECT_EQ(original.meshBlocks().blocks(), result.meshBlocks().blocks());
+    EXPECT_EQ(9u, result.meshBlocks().baseVertices());
+  }
+}
+
+TEST(BinarySerializationTests, DeltaRejectsInvalidMeshPatch) {
+  DynamicSceneGraph original;
+  original.upsertMeshBlock({0, 0, 0}, makeGridMesh(4));
+
+  GraphDeltaEncoder encoder(0);
+  std::vector<uint8_t> buffer;
+  encoder.encode(original, buffer, true);
+  DynamicSceneGraph result;
+  uint64_t sequence = 0;
+  EXPECT_TRUE(applyDelta(result, buffer, sequence));
+
+  original.upsertMeshBlock({1, 0, 0}, makeGridMesh(3));
+  buffer.clear();
+  encoder.encode(original, buffer, true);
+
+  // find the mesh size at the start of the patch
+  std::vector<uint8_t> sizes;
+  serialization::BinarySerializer serializer(&sizes);
+  serializer.write(original.mesh()->numVertices());
+  serializer.write(original.mesh()->numFaces());
+  auto iter = std::search(buffer.begin(), buffer.end(), sizes.begin(), sizes.end());
+  ASSERT_NE(iter, buffer.end());
+  const auto offset = iter - buffer.begin();
+
+  // sizes that the block layouts don't need are never allocated
+  for (const auto num_vertices : {std::numeric_limits<size_t>::max(), size_t(100)}) {
+    std::vector<uint8_t> corrupt;
+    serialization::BinarySerializer corrupt_serializer(&corrupt);
+    corrupt_serializer.write(num_vertices);
+    auto modified = buffer;
+    std::copy(corrupt.begin(), corrupt.end(), modified.begin() + offset);
+
+    auto copy = result.clone();
+    auto copy_sequence = sequence;
+    EXPECT_THROW(applyDelta(*copy, modified, copy_sequence), std::domain_error);
+  }
+
+  EXPECT_TRUE(applyDelta(result, buffer, sequence));
+  EXPECT_EQ(*original.mesh(), *result.mesh());
+}
+
+TEST(BinarySerializationTests, GraphArchiveLoadsLazily) {
+  using namespace std::chrono_literals;
+  DynamicSceneGraph original;
+  original.emplaceNode(3, 0, std::make_unique<NodeAttributes>());
+  original.emplaceNode(3, 1, std::make_unique<NodeAttributes>());
+  original.emplaceNode(4, 2, std::make_unique<NodeAttributes>());
+  original.emplaceNode(5, 3, std::make_unique<NodeAttributes>());
+  original.emplaceNode(2, 'a', 10ns, std::make_unique<NodeAttributes>());
+  original.insertEdge(0, 1);
+  original.insertEdge(0, 2);
+  original.insertEdge(2, 3);
+  original.insertEdge(NodeSymbol('a', 0), 2);
+  original.insertMeshEdge(0, 5, true);
+  original.insertMeshEdge(3, 6, true);
+
+  TempFile tmp_file;
+  GraphArchive::write(original, tmp_file.path);
+  EXPECT_TRUE(GraphArchive::isArchive(tmp_file.path));
+
+  GraphArchive archive(tmp_file.path);
+  EXPECT_EQ((std::vector<LayerId>{2, 3, 4, 5}), archive.layers());
+  EXPECT_FALSE(archive.hasMesh());
+  EXPECT_FALSE(archive.hasLayer(7));
+  EXPECT_FALSE(archive.loadLayer(7));
+
+  // nothing is loaded until requested
+  const auto& graph = *archive.graph();
+  EXPECT_EQ(original.layer_ids, graph.layer_ids);
+  EXPECT_EQ(0u, graph.numNodes());
+
+  const auto& layer = archive.getLayer(3);
+  EXPECT_TRUE(archive.isLoaded(3));
+  EXPECT_FALSE(archive.isLoaded(4));
+  EXPECT_EQ(2u, layer.numNodes());
+  EXPECT_TRUE(layer.hasEdge(0, 1));
+  EXPECT_EQ(2u, graph.numNodes());
+  EXPECT_TRUE(graph.hasMeshEdge(0, 5));
+  EXPECT_FALSE(graph.hasMeshEdge(3, 6));
+
+  // interlayer edges show up once both layers are loaded
+  EXPECT_TRUE(archive.loadLayer(4));
+  EXPECT_TRUE(graph.hasEdge(0, 2));
+  EXPECT_FALSE(graph.hasNode(3));
+  EXPECT_TRUE(archive.loadLayer(2));
+  EXPECT_TRUE(graph.hasEdge(NodeSymbol('a', 0), 2));
+
+  const auto result = archive.load();
+  EXPECT_EQ(original.numNodes(), result->numNodes());
+  EXPECT_EQ(original.numDynamicNodes(), result->numDynamicNodes());
+  EXPECT_EQ(original.numEdges(), result->numEdges());
+  EXPECT_TRUE(result->hasEdge(2, 3));
+  EXPECT_TRUE(result->hasMeshEdge(3, 6));
+
+  // graphs load through the usual interface
+  const auto loaded = DynamicSceneGraph::load(tmp_file.path);
+  EXPECT_EQ(original.numNodes(), loaded->numNodes());
+  EXPECT_EQ(original.numEdges(), loaded->numEdges());
+
+  // saving with the archive extension picks the binary format
+  const std::string archive_path = std::string(tmp_file.path.c_str()) + ".sparkdsg";
+  original.save(archive_path);
+  EXPECT_TRUE(GraphArchive::isArchive(archive_path));
+  std::remove(archive_path.c_str());
+}
+
+TEST(BinarySerializationTests, GraphArchiveParallelLoad) {
+  using namespace std::chrono_literals;
+  DynamicSceneGraph original;
+  for (NodeId node = 0; node < 100; ++node) {
+    original.emplaceNode(3 + node % 3, node, std::make_unique<NodeAttributes>());
+    if (node >= 3) {
+      original.insertEdge(node - 3, node);
+    }
+  }
+  original.emplaceNode(2, 'a', 10ns, std::make_unique<NodeAttributes>());
+  original.insertEdge(0, 1);
+  original.insertEdge(NodeSymbol('a', 0), 2);
+  original.insertMeshEdge(4, 2, true);
+
+  TempFile tmp_file;
+  GraphArchive::write(original, tmp_file.path);
+
+  // layers loaded before the rest of the graph aren't loaded twice
+  GraphArchive archive(tmp_file.path);
+  archive.loadLayer(4);
+  DynamicSceneGraph::LoadTimings timings;
+  const auto result = archive.load(true, 4, &timings);
+  EXPECT_EQ(original.numNodes(), result->numNodes());
+  EXPECT_EQ(original.numDynamicNodes(), result->numDynamicNodes());
+  EXPECT_EQ(original.numEdges(), result->numEdges());
+  EXPECT_TRUE(result->hasEdge(NodeSymbol('a', 0), 2));
+  EXPECT_TRUE(result->hasMeshEdge(4, 2));
+  EXPECT_GT(timings.decode, 0.0);
+
+  const auto loaded = DynamicSceneGraph::load(tmp_file.path, 4, &timings);
+  EXPECT_EQ(original.numEdges(), loaded->numEdges());
+  EXPECT_GT(timings.parse, 0.0);
+}
+
+TEST(BinarySerializationTests, GraphArchiveRejectsInvalidFiles) {
+  TempFile tmp_file;
+  EXPECT_THROW(GraphArchive{tmp_file.path}, std::runtime_error);
+
+  DynamicSceneGraph original;
+  original.save(tmp_file.path);
+  EXPECT_FALSE(GraphArchive::isArchive(tmp_file.path));
+  EXPECT_THROW(GraphArchive{tmp_file.path}, std::runtime_error);
+
+  // section offsets that would wrap around the file length are rejected
+  std::vector<uint8_t> header;
+  serialization::BinarySerializer serializer(&header);
+  serializer.write(GraphArchive::VERSION);
+  serializer.write(original.layer_ids);
+  serializer.write(original.mesh_layer_id);
+  serializer.startFixedArray(1);
+  serializer.startFixedArray(5);
+  serializer.write(static_cast<uint8_t>(0));
+  serializer.write(LayerId(2));
+  serializer.write(LayerId(0));
+  serializer.write(std::numeric_limits<uint64_t>::max());
+  serializer.write(uint64_t(1));
+
+  std::ofstream outfile(tmp_file.path, std::ios::binary | std::ios::trunc);
+  outfile.write("SPARKDSG", 8);
+  outfile.write(reinterpret_cast<const char*>(header.data()), header.size());
+  outfile.close();
+  EXPECT_TRUE(GraphArchive::isArchive(tmp_file.path));
+  EXPECT_THROW(GraphArchive{tmp_file.path}, std::runtime_error);
+}
+
 }  // namespace spark_dsg
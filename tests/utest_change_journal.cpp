@@ -0,0 +1,225 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/change_journal.h>
+#include <spark_dsg/scene_graph_layer.h>
+
+namespace spark_dsg {
+
+TEST(ChangeJournalTests, ReadAdvancesCursor) {
+  ChangeJournal journal(ChangeJournal::DEFAULT_CAPACITY);
+  ChangeJournal::Cursor first = journal.begin();
+  journal.recordNode(ChangeType::NODE_ADDED, 1);
+  journal.recordEdge(ChangeType::EDGE_ADDED, 1, 2);
+
+  ChangeJournal::Cursor second = journal.end();
+  journal.recordNode(ChangeType::NODE_REMOVED, 1);
+
+  std::vector<Change> changes;
+  EXPECT_TRUE(journal.read(first, changes));
+  EXPECT_EQ(3u, changes.size());
+  EXPECT_EQ(journal.end(), first);
+  EXPECT_TRUE(changes[0].isNode());
+  EXPECT_FALSE(changes[1].isNode());
+
+  changes.clear();
+  EXPECT_TRUE(journal.read(second, changes));
+  ASSERT_EQ(1u, changes.size());
+  EXPECT_EQ(ChangeType::NODE_REMOVED, changes[0].type);
+
+  // nothing new since the last read
+  changes.clear();
+  EXPECT_TRUE(journal.read(first, changes));
+  EXPECT_TRUE(changes.empty());
+}
+
+TEST(ChangeJournalTests, DroppedChangesReported) {
+  ChangeJournal journal(2);
+  ChangeJournal::Cursor cursor = journal.begin();
+  for (NodeId node = 0; node < 5; ++node) {
+    journal.recordNode(ChangeType::NODE_ADDED, node);
+  }
+
+  EXPECT_EQ(2u, journal.size());
+  EXPECT_EQ(3u, journal.begin());
+  EXPECT_EQ(5u, journal.end());
+
+  std::vector<Change> changes;
+  EXPECT_FALSE(journal.read(cursor, changes));
+  EXPECT_EQ(2u, changes.size());
+  EXPECT_EQ(5u, cursor);
+
+  journal.clear();
+  EXPECT_EQ(0u, journal.size());
+  EXPECT_EQ(5u, journal.end());
+
+  // cursors from a different journal are not trusted
+  cursor = 10;
+  changes.clear();
+  EXPECT_FALSE(journal.read(cursor, changes));
+  EXPECT_EQ(5u, cursor);
+}
+
+TEST(ChangeJournalTests, RecordingIsOptIn) {
+  ChangeJournal journal;
+  EXPECT_FALSE(journal.enabled());
+  ChangeJournal::Cursor cursor = journal.end();
+  journal.recordNode(ChangeType::NODE_ADDED, 1);
+  EXPECT_EQ(0u, journal.size());
+
+  // consumers are told that they missed changes made while recording was off
+  std::vector<Change> changes;
+  journal.setCapacity(4);
+  EXPECT_TRUE(journal.enabled());
+  EXPECT_FALSE(journal.read(cursor, changes));
+  EXPECT_TRUE(changes.empty());
+
+  for (NodeId node = 0; node < 3; ++node) {
+    journal.recordNode(ChangeType::NODE_ADDED, node);
+  }
+  EXPECT_EQ(3u, journal.size());
+
+  // shrinking drops the oldest changes
+  journal.setCapacity(1);
+  EXPECT_EQ(1u, journal.size());
+  EXPECT_FALSE(journal.read(cursor, changes));
+  ASSERT_EQ(1u, changes.size());
+  EXPECT_EQ(2u, changes[0].source);
+
+  journal.setCapacity(0);
+  EXPECT_EQ(0u, journal.size());
+  EXPECT_EQ(cursor, journal.end());
+}
+
+TEST(ChangeJournalTests, ChangeSetKeepsLastChange) {
+  const std::vector<Change> changes{{ChangeType::NODE_ADDED, 3, 3},
+                                    {ChangeType::NODE_ADDED, 1, 1},
+                                    {ChangeType::EDGE_ADDED, 3, 1},
+                                    {ChangeType::NODE_REMOVED, 3, 3},
+                                    {ChangeType::EDGE_REMOVED, 1, 3},
+                                    {ChangeType::EDGE_ADDED, 2, 1}};
+  ChangeSet result;
+  result.merge(changes);
+  EXPECT_EQ(std::vector<NodeId>{1}, result.new_nodes);
+  EXPECT_EQ(std::vector<NodeId>{3}, result.removed_nodes);
+  EXPECT_EQ(std::vector<EdgeKey>{EdgeKey(1, 2)}, result.new_edges);
+  EXPECT_EQ(std::vector<EdgeKey>{EdgeKey(1, 3)}, result.removed_edges);
+
+  // later changes override earlier results
+  result.merge({{ChangeType::NODE_ADDED, 3, 3}, {ChangeType::EDGE_REMOVED, 1, 2}});
+  EXPECT_EQ((std::vector<NodeId>{1, 3}), result.new_nodes);
+  EXPECT_TRUE(result.removed_nodes.empty());
+  EXPECT_TRUE(result.new_edges.empty());
+  EXPECT_EQ((std::vector<EdgeKey>{EdgeKey(1, 2), EdgeKey(1, 3)}), result.removed_edges);
+}
+
+TEST(ChangeJournalTests, ChangeSetTracksUpdates) {
+  ChangeSet result;
+  result.merge({{ChangeType::NODE_ADDED, 1, 1},
+                {ChangeType::NODE_UPDATED, 1, 1},
+                {ChangeType::NODE_UPDATED, 2, 2},
+                {ChangeType::EDGE_UPDATED, 2, 1},
+                {ChangeType::MESH_EDGE_ADDED, 2, 7},
+                {ChangeType::MESH_EDGE_REMOVED, 1, 3}});
+  EXPECT_EQ(std::vector<NodeId>{1}, result.new_nodes);
+  EXPECT_EQ(std::vector<NodeId>{2}, result.updated_nodes);
+  EXPECT_EQ(std::vector<EdgeKey>{EdgeKey(1, 2)}, result.updated_edges);
+  EXPECT_EQ(std::vector<MeshEdge>{MeshEdge(2, 7)}, result.new_mesh_edges);
+  EXPECT_EQ(std::vector<MeshEdge>{MeshEdge(1, 3)}, result.removed_mesh_edges);
+
+  // nodes that are still new to the consumer stay new
+  result.merge({{ChangeType::NODE_UPDATED, 1, 1},
+                {ChangeType::NODE_REMOVED, 2, 2},
+                {ChangeType::MESH_EDGE_ADDED, 1, 3}});
+  EXPECT_EQ(std::vector<NodeId>{1}, result.new_nodes);
+  EXPECT_TRUE(result.updated_nodes.empty());
+  EXPECT_EQ(std::vector<NodeId>{2}, result.removed_nodes);
+  EXPECT_EQ((std::vector<MeshEdge>{{1, 3}, {2, 7}}), result.new_mesh_edges);
+  EXPECT_TRUE(result.removed_mesh_edges.empty());
+}
+
+TEST(ChangeJournalTests, LayerChangesCorrect) {
+  IsolatedSceneGraphLayer layer(1);
+  layer.setJournalCapacity(ChangeJournal::DEFAULT_CAPACITY);
+  ChangeJournal::Cursor cursor = layer.journal().begin();
+  layer.emplaceNode(0, std::make_unique<NodeAttributes>());
+  layer.emplaceNode(1, std::make_unique<NodeAttributes>());
+  layer.emplaceNode(2, std::make_unique<NodeAttributes>());
+  layer.insertEdge(0, 1);
+  layer.insertEdge(1, 2);
+
+  // failed operations are not recorded
+  EXPECT_FALSE(layer.emplaceNode(0, std::make_unique<NodeAttributes>()));
+  EXPECT_FALSE(layer.insertEdge(0, 1));
+  layer.setNodeAttributes(1, std::make_unique<NodeAttributes>());
+
+  auto changes = layer.getChanges(cursor);
+  EXPECT_TRUE(changes.complete);
+  EXPECT_EQ((std::vector<NodeId>{0, 1, 2}), changes.new_nodes);
+  EXPECT_EQ((std::vector<EdgeKey>{{0, 1}, {1, 2}}), changes.new_edges);
+  EXPECT_TRUE(changes.updated_nodes.empty());
+  EXPECT_TRUE(changes.removed_nodes.empty());
+  EXPECT_TRUE(changes.removed_edges.empty());
+
+  layer.setNodeAttributes(1, std::make_unique<NodeAttributes>());
+  changes = layer.getChanges(cursor);
+  EXPECT_EQ(std::vector<NodeId>{1}, changes.updated_nodes);
+  EXPECT_TRUE(changes.new_nodes.empty());
+
+  // independent consumer that starts from here
+  ChangeJournal::Cursor other = layer.journal().end();
+  layer.mergeNodes(2, 0);
+  layer.removeNode(1);
+
+  changes = layer.getChanges(cursor);
+  EXPECT_TRUE(changes.new_nodes.empty());
+  EXPECT_EQ((std::vector<NodeId>{1, 2}), changes.removed_nodes);
+  EXPECT_EQ((std::vector<EdgeKey>{{0, 1}, {1, 2}}), changes.removed_edges);
+  // edge 1 -> 2 was rewired onto the existing edge 0 -> 1
+  EXPECT_TRUE(changes.new_edges.empty());
+
+  const auto other_changes = layer.getChanges(other);
+  EXPECT_EQ(changes.removed_nodes, other_changes.removed_nodes);
+  EXPECT_EQ(changes.removed_edges, other_changes.removed_edges);
+
+  EXPECT_TRUE(layer.getChanges(cursor).empty());
+
+  // status tracking is unaffected by reading changes
+  std::vector<NodeId> removed;
+  layer.getRemovedNodes(removed);
+  EXPECT_EQ(2u, removed.size());
+}
+
+}  // namespace spark_dsg
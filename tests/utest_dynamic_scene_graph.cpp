@@ -186,6 +186,33 @@ TEST(DynamicSceneGraphTests, AddAndUpdateNode) {
   }
 }
 
+// Test that updating nodes through the graph keeps the layer position cache in sync
+TEST(DynamicSceneGraphTests, PositionCacheSynced) {
+  DynamicSceneGraph graph({1, 2}, 0);
+  EXPECT_FALSE(graph.enablePositionCache(5));
+  EXPECT_TRUE(graph.enablePositionCache(1));
+  EXPECT_TRUE(graph.getLayer(1).hasPositionCache());
+
+  const Eigen::Vector3d pos1(1.0, 2.0, 3.0);
+  const Eigen::Vector3d pos2(2.0, 3.0, 4.0);
+  graph.emplaceNode(1, 0, std::make_unique<NodeAttributes>(pos1));
+  graph.emplaceNode(1, 1, std::make_unique<NodeAttributes>(pos1));
+  EXPECT_EQ(2u, graph.getLayer(1).getNodesInRadius(pos1, 0.1).size());
+
+  EXPECT_TRUE(graph.addOrUpdateNode(1, 0, std::make_unique<NodeAttributes>(pos2)));
+  EXPECT_EQ(std::vector<NodeId>{1}, graph.getLayer(1).getNodesInRadius(pos1, 0.1));
+
+  EXPECT_TRUE(graph.setNodeAttributes(1, std::make_unique<NodeAttributes>(pos2)));
+  EXPECT_TRUE(graph.getLayer(1).getNodesInRadius(pos1, 0.1).empty());
+
+  graph.getNode(0)->get().attributes().position = pos1;
+  EXPECT_TRUE(graph.refreshPosition(0));
+  EXPECT_EQ(std::vector<NodeId>{0}, graph.getLayer(1).getNodesInRadius(pos1, 0.1));
+
+  graph.removeNode(0);
+  EXPECT_TRUE(graph.getLayer(1).getNodesInRadius(pos1, 0.1).empty());
+}
+
 // Test that we only have nodes that we add, and we can't add the same node
 TEST(DynamicSceneGraphTests, InsertNodeInvariants) {
   DynamicSceneGraph graph({1, 2}, 0);
@@ -592,6 +619,33 @@ TEST(DynamicSceneGraphTests, InvalidMeshEdgeInvariantsCorrect) {
   EXPECT_EQ(3u, graph.numEdges());
 }
 
+TEST(DynamicSceneGraphTests, BatchMeshEdgeInsertionCorrect) {
+  DynamicSceneGraph graph;
+  EXPECT_TRUE(graph.emplaceNode(2, 0, std::make_unique<NodeAttributes>()));
+  EXPECT_TRUE(graph.emplaceNode(2, 1, std::make_unique<NodeAttributes>()));
+
+  TestMesh mesh = makeMesh(5);
+  graph.setMesh(mesh.vertices, mesh.faces);
+  EXPECT_TRUE(graph.insertMeshEdge(0, 1));
+
+  // repeated edges, invalid nodes and invalid mesh vertices are skipped
+  const DynamicSceneGraph::MeshEdges edges{
+      {0, 1}, {0, 2}, {1, 4}, {1, 4}, {3, 1}, {1, 8}};
+  EXPECT_EQ(2u, graph.insertMeshEdges(edges));
+  EXPECT_EQ(3u, graph.getMeshEdges().size());
+  EXPECT_EQ((std::vector<size_t>{1, 2}), graph.getMeshConnectionIndices(0));
+  EXPECT_EQ(std::vector<size_t>{4}, graph.getMeshConnectionIndices(1));
+
+  EXPECT_EQ(1u, graph.insertMeshEdges(edges, true));
+  EXPECT_TRUE(graph.hasMeshEdge(1, 8));
+
+  // bulk invalidation through the mesh
+  mesh = makeMesh(2);
+  graph.setMesh(mesh.vertices, mesh.faces);
+  EXPECT_EQ(1u, graph.getMeshEdges().size());
+  EXPECT_TRUE(graph.hasMeshEdge(0, 1));
+}
+
 TEST(DynamicSceneGraphTests, UpdateMeshEdgesCorrect) {
   DynamicSceneGraph graph;
   EXPECT_TRUE(graph.emplaceNode(2, 0, std::make_unique<NodeAttributes>()));
@@ -759,6 +813,35 @@ TEST(DynamicSceneGraphTests, updateFromEmptyLayerCorrect) {
   EXPECT_EQ(0u, separate_layer.numEdges());
 }
 
+TEST(DynamicSceneGraphTests, RemoveStaleEdgesCorrect) {
+  DynamicSceneGraph graph({1, 2}, 0);
+  graph.emplaceNode(1, 1, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(1, 2, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(1, 3, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(2, 4, std::make_unique<NodeAttributes>());
+  graph.insertEdge(1, 2);
+  graph.insertEdge(2, 3);
+  graph.insertEdge(4, 1);
+  graph.insertEdge(4, 3);
+
+  graph.markEdgesAsStale();
+  EXPECT_TRUE(graph.getEdge(1, 2));
+  EXPECT_TRUE(graph.getEdge(4, 3));
+  graph.insertEdge(1, 3);
+  graph.removeAllStaleEdges();
+
+  EXPECT_EQ(3u, graph.numEdges());
+  EXPECT_TRUE(graph.hasEdge(1, 2));
+  EXPECT_TRUE(graph.hasEdge(1, 3));
+  EXPECT_TRUE(graph.hasEdge(4, 3));
+  EXPECT_FALSE(graph.hasEdge(2, 3));
+  EXPECT_FALSE(graph.hasEdge(4, 1));
+
+  // nothing is stale until the edges are marked again
+  graph.removeAllStaleEdges();
+  EXPECT_EQ(3u, graph.numEdges());
+}
+
 TEST(DynamicSceneGraphTests, updateFromLayerCorrect) {
   DynamicSceneGraph graph({1, 2}, 0);
   graph.emplaceNode(1, 1, std::make_unique<NodeAttributes>());
@@ -771,12 +854,8 @@ TEST(DynamicSceneGraphTests, updateFromLayerCorrect) {
   separate_layer.emplaceNode(1, std::make_unique<NodeAttributes>());
   separate_layer.emplaceNode(5, std::make_unique<NodeAttributes>());
   std::unique_ptr<Edges> edges(new Edges);
-  edges->emplace(std::piecewise_construct,
-                 std::forward_as_tuple(5, 2),
-                 std::forward_as_tuple(5, 2, std::make_unique<EdgeAttributes>()));
-  edges->emplace(std::piecewise_construct,
-                 std::forward_as_tuple(1, 2),
-                 std::forward_as_tuple(1, 2, std::make_unique<EdgeAttributes>()));
+  edges->emplace(5, 2, std::make_unique<EdgeAttributes>());
+  edges->emplace(1, 2, std::make_unique<EdgeAttributes>());
 
   EXPECT_TRUE(graph.updateFromLayer(separate_layer, std::move(edges)));
   EXPECT_EQ(4u, graph.numNodes());
@@ -1134,6 +1213,83 @@ TEST(DynamicSceneGraphTests, RemovedAndNewEdgesCorrect) {
   }
 }
 
+TEST(DynamicSceneGraphTests, ChangeCursorsIndependent) {
+  using namespace std::chrono_literals;
+  DynamicSceneGraph graph;
+  EXPECT_EQ(0u, graph.journalCapacity());
+  auto first = graph.getChangeCursor();
+  EXPECT_EQ(ChangeJournal::DEFAULT_CAPACITY, graph.journalCapacity());
+  graph.emplaceNode(2, 'a', 10ns, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(2, 'a', 11ns, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(3, "x0"_id, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(4, "y1"_id, std::make_unique<NodeAttributes>());
+  graph.insertEdge("x0"_id, "y1"_id);
+  graph.insertEdge("a1"_id, "x0"_id);
+
+  {
+    const auto changes = graph.getChanges(first);
+    EXPECT_TRUE(changes.complete);
+    std::vector<NodeId> nodes_expected{"a0"_id, "a1"_id, "x0"_id, "y1"_id};
+    EXPECT_EQ(nodes_expected, changes.new_nodes);
+    std::vector<EdgeKey> edges_expected{
+        {"a0"_id, "a1"_id}, {"a1"_id, "x0"_id}, {"x0"_id, "y1"_id}};
+    EXPECT_EQ(edges_expected, changes.new_edges);
+    EXPECT_TRUE(changes.removed_nodes.empty());
+    EXPECT_TRUE(changes.removed_edges.empty());
+  }
+
+  auto second = graph.getChangeCursor();
+  EXPECT_TRUE(graph.getChanges(second).empty());
+
+  graph.removeEdge("x0"_id, "y1"_id);
+  graph.removeNode("a0"_id);
+  graph.emplaceNode(3, "x5"_id, std::make_unique<NodeAttributes>());
+  graph.removeNode("x5"_id);
+
+  for (auto cursor : {&first, &second}) {
+    const auto changes = graph.getChanges(*cursor);
+    EXPECT_TRUE(changes.complete);
+    EXPECT_TRUE(changes.new_nodes.empty());
+    EXPECT_TRUE(changes.new_edges.empty());
+    std::vector<NodeId> nodes_expected{"a0"_id, "x5"_id};
+    EXPECT_EQ(nodes_expected, changes.removed_nodes);
+    std::vector<EdgeKey> edges_expected{{"a0"_id, "a1"_id}, {"x0"_id, "y1"_id}};
+    EXPECT_EQ(edges_expected, changes.removed_edges);
+  }
+
+  EXPECT_TRUE(graph.getChanges(first).empty());
+
+  // reading changes doesn't affect the status tracking
+  EXPECT_EQ(3u, graph.getNewNodes(true).size());
+
+  // clearing the graph invalidates every cursor
+  graph.clear();
+  EXPECT_FALSE(graph.getChanges(first).complete);
+  EXPECT_TRUE(graph.getChanges(first).complete);
+
+  // turning the journals off invalidates cursors once something changes
+  graph.setJournalCapacity(0);
+  graph.emplaceNode(3, "x0"_id, std::make_unique<NodeAttributes>());
+  EXPECT_FALSE(graph.getChanges(first).complete);
+}
+
+TEST(DynamicSceneGraphTests, CloneChangesNotJournaledInSource) {
+  DynamicSceneGraph graph;
+  graph.emplaceNode(3, "x0"_id, std::make_unique<NodeAttributes>());
+  graph.insertMeshEdge("x0"_id, 1, true);
+  auto cursor = graph.getChangeCursor();
+
+  auto clone = graph.clone();
+  auto clone_cursor = clone->getChangeCursor();
+  EXPECT_TRUE(clone->insertMeshEdge("x0"_id, 2, true));
+  EXPECT_TRUE(clone->removeMeshEdge("x0"_id, 1));
+  EXPECT_TRUE(graph.getChanges(cursor).empty());
+
+  const auto changes = clone->getChanges(clone_cursor);
+  EXPECT_EQ((std::vector<MeshEdge>{{"x0"_id, 2}}), changes.new_mesh_edges);
+  EXPECT_EQ((std::vector<MeshEdge>{{"x0"_id, 1}}), changes.removed_mesh_edges);
+}
+
 TEST(DynamicSceneGraphTests, MergeGraphCorrectWithPrevMerges) {
   // graph 1: merged version of graph 2 (where 2 is merged into 1)
   std::map<NodeId, NodeId> prev_merges{{2, 1}};
@@ -223,7 +223,7 @@ TEST(DynamicSceneGraphLayerTests, BasicEdgeIterationCorrect) {
   // nodes may be stored unordered in the future
   std::set<NodeId> actual_targets;
   for (const auto& id_edge_pair : layer.edges()) {
-    const Edge& edge = id_edge_pair.second;
+    const Edge& edge = *id_edge_pair.second;
     ASSERT_TRUE(edge.info != nullptr);
     EXPECT_EQ(edge.source + 1, edge.target);
     actual_targets.insert(edge.target);
@@ -285,7 +285,7 @@ TEST(DynamicSceneGraphLayerTests, MergeLayerCorrect) {
                                     std::make_unique<NodeAttributes>(node_pos)));
   }
 
-  std::map<NodeId, LayerKey> node_to_layer;
+  NodeLookup node_to_layer;
   layer_1.mergeLayer(layer_2, &node_to_layer);
 
   EXPECT_EQ(2u, node_to_layer.size());
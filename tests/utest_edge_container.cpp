@@ -151,22 +151,110 @@ TEST(EdgeContainerTests, StaleInvariants) {
   EXPECT_EQ(container.size(), 10u);
 
   container.setStale();
-  for (const auto& key_info_pair : container.stale_edges) {
-    EXPECT_TRUE(key_info_pair.second);
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_TRUE(container.isStale(0, i));
   }
 
   for (size_t i = 0; i < 3; ++i) {
     container.get(0, i);
   }
-  for (const auto& key_info_pair : container.stale_edges) {
-    EXPECT_EQ(key_info_pair.first.k2 >= 3, key_info_pair.second);
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(i >= 3, container.isStale(0, i));
   }
 
   for (size_t i = 3; i < 6; ++i) {
     const_cast<const EdgeContainer*>(&container)->get(0, i);
   }
-  for (const auto& key_info_pair : container.stale_edges) {
-    EXPECT_EQ(key_info_pair.first.k2 >= 6, key_info_pair.second);
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(i >= 6, container.isStale(0, i));
+  }
+
+  std::vector<EdgeKey> stale;
+  container.getStale(stale);
+  EXPECT_EQ(4u, stale.size());
+
+  // removed and new edges are never stale
+  container.remove(0, 7);
+  container.insert(0, 10, nullptr);
+  EXPECT_FALSE(container.isStale(0, 7));
+  EXPECT_FALSE(container.isStale(0, 10));
+}
+
+TEST(EdgeContainerTests, StaleEpochs) {
+  EdgeContainer container;
+  for (size_t i = 0; i < 6; ++i) {
+    container.insert(0, i, nullptr);
+  }
+
+  container.setStale();
+  container.get(0, 4);
+  container.get(0, 1);
+
+  // stale edges are reported in order of last access
+  std::vector<EdgeKey> stale;
+  container.getStale(stale);
+  EXPECT_EQ((std::vector<EdgeKey>{{0, 0}, {0, 2}, {0, 3}, {0, 5}}), stale);
+
+  // touching again in the same epoch doesn't change anything
+  container.get(0, 4);
+  EXPECT_FALSE(container.isStale(0, 4));
+
+  // a second epoch makes everything stale again
+  container.setStale();
+  container.get(0, 2);
+  stale.clear();
+  container.getStale(stale);
+  EXPECT_EQ((std::vector<EdgeKey>{{0, 0}, {0, 3}, {0, 5}, {0, 4}, {0, 1}}), stale);
+
+  container.remove(0, 0);
+  container.remove(0, 3);
+  stale.clear();
+  container.getStale(stale);
+  EXPECT_EQ((std::vector<EdgeKey>{{0, 5}, {0, 4}, {0, 1}}), stale);
+
+  container.reset();
+  stale.clear();
+  container.getStale(stale);
+  EXPECT_TRUE(stale.empty());
+}
+
+TEST(EdgeContainerTests, IterationAndLookup) {
+  EdgeContainer container;
+  container.insert(3, 1, std::make_unique<EdgeAttributes>(2.0));
+  container.insert(0, 2, nullptr);
+  container.insert(1, 2, nullptr);
+  container.remove(2, 0);
+
+  EXPECT_EQ(2u, container.size());
+  EXPECT_FALSE(container.edges.contains(EdgeKey(0, 2)));
+  EXPECT_EQ(EdgeStatus::DELETED, container.getStatus(0, 2));
+  EXPECT_THROW(container.get(0, 2), std::out_of_range);
+  EXPECT_THROW(container.edges.at(EdgeKey(0, 2)), std::out_of_range);
+  EXPECT_EQ(nullptr, container.edges.find(EdgeKey(0, 2)));
+  EXPECT_EQ(2.0, container.edges.at(EdgeKey(1, 3)).info->weight);
+
+  // edges stay at the same address while other edges change
+  const auto* edge = &container.get(1, 2);
+  for (size_t i = 10; i < 1000; ++i) {
+    container.insert(0, i, nullptr);
+  }
+  EXPECT_EQ(edge, &container.get(2, 1));
+
+  std::vector<EdgeKey> removed;
+  container.getRemoved(removed, true);
+  EXPECT_EQ(EdgeStatus::NONEXISTENT, container.getStatus(0, 2));
+
+  size_t num_iterated = 0;
+  for (const auto& [key, edge] : container.edges) {
+    EXPECT_EQ(key, EdgeKey(edge->source, edge->target));
+    ++num_iterated;
+  }
+  EXPECT_EQ(container.size(), num_iterated);
+
+  const auto sorted = container.edges.sorted();
+  ASSERT_EQ(container.size(), sorted.size());
+  for (size_t i = 1; i < sorted.size(); ++i) {
+    EXPECT_TRUE(sorted[i - 1].first < sorted[i].first);
   }
 }
 
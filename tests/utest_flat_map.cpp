@@ -0,0 +1,176 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/flat_map.h>
+#include <spark_dsg/node_symbol.h>
+
+#include <map>
+#include <random>
+
+namespace spark_dsg {
+
+TEST(FlatMapTests, InsertAndFind) {
+  FlatMap<NodeId, LayerKey> lookup;
+  EXPECT_TRUE(lookup.empty());
+  EXPECT_EQ(lookup.end(), lookup.find(0));
+
+  EXPECT_TRUE(lookup.insert({NodeSymbol('a', 0), LayerKey(2)}).second);
+  EXPECT_TRUE(lookup.emplace(NodeSymbol('b', 1), 3, 1).second);
+  EXPECT_FALSE(lookup.insert({NodeSymbol('a', 0), LayerKey(5)}).second);
+  EXPECT_EQ(2u, lookup.size());
+
+  EXPECT_TRUE(lookup.contains(NodeSymbol('a', 0)));
+  EXPECT_EQ(1u, lookup.count(NodeSymbol('b', 1)));
+  EXPECT_EQ(0u, lookup.count(NodeSymbol('b', 2)));
+  EXPECT_EQ(LayerKey(2), lookup.at(NodeSymbol('a', 0)));
+  EXPECT_EQ(LayerKey(3, 1), lookup.at(NodeSymbol('b', 1)));
+  EXPECT_THROW(lookup.at(NodeSymbol('c', 0)), std::out_of_range);
+
+  lookup[NodeSymbol('a', 0)] = LayerKey(4);
+  EXPECT_EQ(LayerKey(4), lookup.at(NodeSymbol('a', 0)));
+
+  lookup[NodeSymbol('c', 0)] = LayerKey(1);
+  EXPECT_EQ(3u, lookup.size());
+  auto iter = lookup.find(NodeSymbol('c', 0));
+  ASSERT_NE(lookup.end(), iter);
+  EXPECT_EQ(NodeSymbol('c', 0), iter->first);
+  EXPECT_EQ(LayerKey(1), iter->second);
+}
+
+TEST(FlatMapTests, EraseAndIterationOrder) {
+  FlatMap<NodeId, size_t> lookup;
+  for (size_t i = 0; i < 1000; ++i) {
+    lookup[1000 - i] = i;
+  }
+
+  for (size_t i = 0; i < 1000; i += 2) {
+    EXPECT_EQ(1u, lookup.erase(1000 - i));
+  }
+  EXPECT_EQ(0u, lookup.erase(1000));
+  EXPECT_EQ(500u, lookup.size());
+
+  // iteration follows insertion order and skips erased entries
+  size_t expected = 1;
+  for (const auto& [key, value] : lookup) {
+    EXPECT_EQ(expected, value);
+    EXPECT_EQ(1000 - expected, key);
+    expected += 2;
+  }
+  EXPECT_EQ(1001u, expected);
+
+  for (size_t i = 0; i < 1000; ++i) {
+    EXPECT_EQ(i % 2 == 1, lookup.contains(1000 - i)) << "key: " << 1000 - i;
+  }
+
+  // erasing via iterator returns the next valid entry
+  auto iter = lookup.begin();
+  while (iter != lookup.end()) {
+    iter = lookup.erase(iter);
+  }
+  EXPECT_TRUE(lookup.empty());
+  EXPECT_EQ(lookup.begin(), lookup.end());
+
+  // reinserting into a map with holes still works
+  for (size_t i = 0; i < 2000; ++i) {
+    lookup[i] = i;
+  }
+  EXPECT_EQ(2000u, lookup.size());
+  for (size_t i = 0; i < 2000; ++i) {
+    EXPECT_EQ(i, lookup.at(i));
+  }
+}
+
+TEST(FlatMapTests, RandomOperationsMatchMap) {
+  std::mt19937 gen(12345);
+  std::uniform_int_distribution<NodeId> key_dist(0, 5000);
+  std::uniform_int_distribution<int> op_dist(0, 2);
+
+  std::map<NodeId, int> expected;
+  FlatMap<NodeId, int> lookup;
+  for (int i = 0; i < 50000; ++i) {
+    const NodeId key = NodeSymbol('p', key_dist(gen));
+    switch (op_dist(gen)) {
+      case 0:
+        expected[key] = i;
+        lookup[key] = i;
+        break;
+      case 1:
+        EXPECT_EQ(expected.erase(key), lookup.erase(key));
+        break;
+      default:
+        EXPECT_EQ(expected.count(key), lookup.count(key));
+        break;
+    }
+  }
+
+  ASSERT_EQ(expected.size(), lookup.size());
+  for (const auto& [key, value] : expected) {
+    EXPECT_EQ(value, lookup.at(key));
+  }
+
+  std::map<NodeId, int> result(lookup.begin(), lookup.end());
+  EXPECT_EQ(expected, result);
+
+  FlatMap<NodeId, int> copy;
+  copy = lookup;
+  EXPECT_EQ(lookup, copy);
+  copy.erase(copy.begin());
+  EXPECT_NE(lookup, copy);
+}
+
+TEST(FlatMapTests, MoveLeavesSourceEmpty) {
+  FlatMap<NodeId, int> lookup{{1, 2}, {3, 4}};
+
+  FlatMap<NodeId, int> moved(std::move(lookup));
+  EXPECT_EQ(2u, moved.size());
+  EXPECT_EQ(4, moved.at(3));
+  EXPECT_TRUE(lookup.empty());
+  EXPECT_EQ(lookup.begin(), lookup.end());
+  EXPECT_FALSE(lookup.contains(1));
+
+  FlatMap<NodeId, int> assigned{{5, 6}};
+  assigned = std::move(moved);
+  EXPECT_EQ(2u, assigned.size());
+  EXPECT_FALSE(assigned.contains(5));
+  EXPECT_TRUE(moved.empty());
+  EXPECT_FALSE(moved.contains(1));
+
+  // moved-from maps are still usable
+  moved[7] = 8;
+  EXPECT_EQ(1u, moved.size());
+  EXPECT_EQ(8, moved.at(7));
+}
+
+}  // namespace spark_dsg
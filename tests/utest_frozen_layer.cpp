@@ -0,0 +1,162 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/frozen_layer.h>
+#include <spark_dsg/scene_graph_layer.h>
+
+namespace spark_dsg {
+
+using graph_utilities::FrozenEdge;
+using NodeSet = std::set<NodeId>;
+
+std::set<NodeSet> toSets(const std::vector<std::vector<NodeId>>& components) {
+  std::set<NodeSet> result;
+  for (const auto& component : components) {
+    result.insert(NodeSet(component.begin(), component.end()));
+  }
+  return result;
+}
+
+struct FrozenLayerFixture : public testing::Test {
+  FrozenLayerFixture() : layer(1) {}
+
+  void SetUp() override {
+    for (size_t i = 0; i < 7; ++i) {
+      layer.emplaceNode(i, std::make_unique<NodeAttributes>());
+    }
+
+    layer.insertEdge(0, 1, std::make_unique<EdgeAttributes>(0.5));
+    layer.insertEdge(0, 2);
+    layer.insertEdge(1, 2);
+    layer.insertEdge(3, 4, std::make_unique<EdgeAttributes>(2.0));
+    layer.insertEdge(3, 5);
+    layer.insertEdge(4, 5);
+  }
+
+  IsolatedSceneGraphLayer layer;
+};
+
+TEST_F(FrozenLayerFixture, SnapshotInvariants) {
+  const auto frozen = layer.freeze();
+  EXPECT_EQ(1u, frozen.id);
+  EXPECT_EQ(layer.numNodes(), frozen.numNodes());
+  EXPECT_EQ(layer.numEdges(), frozen.numEdges());
+  ASSERT_EQ(frozen.numNodes() + 1, frozen.offsets().size());
+
+  for (const auto& id_node_pair : layer.nodes()) {
+    ASSERT_TRUE(frozen.hasNode(id_node_pair.first));
+    const auto index = frozen.index(id_node_pair.first);
+    EXPECT_EQ(id_node_pair.first, frozen.nodeId(index));
+
+    const auto& siblings = id_node_pair.second->siblings();
+    EXPECT_EQ(siblings.size(), frozen.degree(index));
+    const auto neighbor_ids = frozen.neighborIds(index);
+    EXPECT_EQ(siblings, NodeSet(neighbor_ids.begin(), neighbor_ids.end()));
+    for (const auto neighbor : frozen.neighbors(index)) {
+      EXPECT_TRUE(siblings.count(frozen.nodeId(neighbor)));
+    }
+
+    // weights are stored at the same position as their neighbor
+    const auto weights = frozen.weights(index);
+    ASSERT_EQ(neighbor_ids.size(), weights.size());
+    for (size_t i = 0; i < neighbor_ids.size(); ++i) {
+      EXPECT_EQ(frozen.getWeight(id_node_pair.first, neighbor_ids[i]), weights[i]);
+    }
+  }
+
+  EXPECT_FALSE(frozen.hasNode(10));
+  EXPECT_THROW(frozen.index(10), std::out_of_range);
+  EXPECT_EQ(0u, frozen.degree(frozen.index(6)));
+  EXPECT_EQ(0.5, frozen.getWeight(1, 0));
+  EXPECT_EQ(2.0, frozen.getWeight(3, 4));
+  EXPECT_EQ(1.0, frozen.getWeight(0, 2));
+  EXPECT_FALSE(frozen.getWeight(0, 3));
+
+  // snapshot is unaffected by later changes
+  layer.insertEdge(2, 3);
+  EXPECT_EQ(6u, frozen.numEdges());
+}
+
+TEST_F(FrozenLayerFixture, ComponentsCorrect) {
+  const auto frozen = layer.freeze();
+  const std::set<NodeSet> expected{{0, 1, 2}, {3, 4, 5}, {6}};
+  EXPECT_EQ(expected, toSets(frozen.getConnectedComponents()));
+
+  // graph utilities run on the snapshot
+  const std::unordered_set<NodeId> roots{0, 3};
+  const auto components = graph_utilities::getConnectedComponents(frozen, roots);
+  EXPECT_EQ((std::set<NodeSet>{{0, 1, 2}, {3, 4, 5}}), toSets(components));
+
+  std::function<bool(NodeId)> node_valid = [](NodeId node) { return node != 6; };
+  std::function<bool(const FrozenEdge&)> edge_valid = [](const FrozenEdge& edge) {
+    return edge.weight >= 1.0;
+  };
+  const auto filtered = graph_utilities::getConnectedComponents<FrozenLayer>(
+      frozen, node_valid, edge_valid);
+  EXPECT_EQ((std::set<NodeSet>{{0, 1, 2}, {3, 4, 5}}), toSets(filtered));
+
+  std::vector<NodeId> visited;
+  graph_utilities::breadthFirstSearch<FrozenLayer>(
+      frozen, NodeId(0), 1, [&](const FrozenLayer&, NodeId node) {
+        visited.push_back(node);
+      });
+  EXPECT_EQ((NodeSet{0, 1, 2}), NodeSet(visited.begin(), visited.end()));
+}
+
+TEST_F(FrozenLayerFixture, BreadthFirstSearchReusesBuffers) {
+  const auto frozen = layer.freeze();
+  std::vector<uint8_t> visited;
+  std::vector<FrozenLayer::Index> frontier;
+
+  NodeSet reached;
+  frozen.breadthFirstSearch(
+      frozen.index(4),
+      [&](FrozenLayer::Index index) { reached.insert(frozen.nodeId(index)); },
+      visited,
+      frontier);
+  EXPECT_EQ((NodeSet{3, 4, 5}), reached);
+  EXPECT_EQ(3u, frontier.size());
+
+  // previously visited nodes are skipped
+  reached.clear();
+  frozen.breadthFirstSearch(
+      frozen.index(0),
+      [&](FrozenLayer::Index index) { reached.insert(frozen.nodeId(index)); },
+      visited,
+      frontier);
+  EXPECT_EQ((NodeSet{0, 1, 2}), reached);
+}
+
+}  // namespace spark_dsg
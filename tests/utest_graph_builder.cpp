@@ -0,0 +1,168 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/graph_builder.h>
+
+namespace spark_dsg {
+
+TEST(GraphBuilderTests, CommitMatchesIncrementalInsert) {
+  using namespace std::chrono_literals;
+  DynamicSceneGraph expected;
+  DynamicSceneGraph graph;
+  expected.emplaceNode(
+      DsgLayers::ROOMS, NodeSymbol('R', 0), std::make_unique<NodeAttributes>());
+  graph.emplaceNode(
+      DsgLayers::ROOMS, NodeSymbol('R', 0), std::make_unique<NodeAttributes>());
+
+  GraphBuilder builder(graph);
+  builder.reserve(12, 12);
+  for (size_t i = 0; i < 10; ++i) {
+    const NodeSymbol node('p', i);
+    expected.emplaceNode(DsgLayers::PLACES, node, std::make_unique<NodeAttributes>());
+    builder.addNode(DsgLayers::PLACES, node, std::make_unique<NodeAttributes>());
+  }
+
+  // dynamic nodes are ordered by index when inserted
+  builder.addDynamicNode(
+      2, NodeSymbol('a', 1), 20ns, std::make_unique<NodeAttributes>());
+  builder.addDynamicNode(
+      2, NodeSymbol('a', 0), 10ns, std::make_unique<NodeAttributes>());
+  expected.emplacePrevDynamicNode(
+      2, NodeSymbol('a', 0), 10ns, std::make_unique<NodeAttributes>());
+  expected.emplacePrevDynamicNode(
+      2, NodeSymbol('a', 1), 20ns, std::make_unique<NodeAttributes>());
+
+  for (size_t i = 1; i < 10; ++i) {
+    expected.insertEdge(NodeSymbol('p', i - 1), NodeSymbol('p', i));
+    builder.addEdge(NodeSymbol('p', i - 1),
+                    NodeSymbol('p', i),
+                    std::make_unique<EdgeAttributes>(0.5));
+  }
+
+  expected.insertEdge(NodeSymbol('R', 0), NodeSymbol('p', 0));
+  builder.addEdge(NodeSymbol('R', 0), NodeSymbol('p', 0));
+  expected.insertEdge(NodeSymbol('a', 0), NodeSymbol('a', 1));
+  builder.addEdge(NodeSymbol('a', 0), NodeSymbol('a', 1));
+  expected.insertEdge(NodeSymbol('a', 0), NodeSymbol('p', 3));
+  builder.addEdge(NodeSymbol('a', 0), NodeSymbol('p', 3));
+  EXPECT_EQ(12u, builder.numNodes());
+  EXPECT_EQ(12u, builder.numEdges());
+
+  builder.commit();
+  EXPECT_EQ(0u, builder.numNodes());
+  EXPECT_EQ(0u, builder.numEdges());
+  EXPECT_EQ(expected.numNodes(), graph.numNodes());
+  EXPECT_EQ(expected.numDynamicNodes(), graph.numDynamicNodes());
+  EXPECT_EQ(expected.numEdges(), graph.numEdges());
+  EXPECT_EQ(expected.numDynamicEdges(), graph.numDynamicEdges());
+  EXPECT_EQ(10ns, graph.getDynamicNode(NodeSymbol('a', 0))->get().timestamp);
+
+  // ancestry and bookkeeping match individual inserts
+  const auto& place = graph.getNode(NodeSymbol('p', 0))->get();
+  EXPECT_EQ(NodeSymbol('R', 0), *place.getParent());
+  EXPECT_EQ((std::set<NodeId>{NodeSymbol('p', 1)}), place.siblings());
+  EXPECT_EQ((std::set<NodeId>{NodeSymbol('p', 0)}),
+            graph.getNode(NodeSymbol('R', 0))->get().children());
+  EXPECT_EQ(0.5,
+            graph.getEdge(NodeSymbol('p', 0), NodeSymbol('p', 1))->get().info->weight);
+  EXPECT_EQ(expected.getNewNodes(true).size(), graph.getNewNodes(true).size());
+  EXPECT_EQ(expected.getNewEdges(true).size(), graph.getNewEdges(true).size());
+
+  // later batches can refer to nodes that are already in the graph
+  builder.addNode(DsgLayers::PLACES, NodeSymbol('p', 10), nullptr);
+  builder.addEdge(NodeSymbol('p', 9), NodeSymbol('p', 10));
+  builder.commit();
+  EXPECT_TRUE(graph.hasEdge(NodeSymbol('p', 9), NodeSymbol('p', 10)));
+}
+
+TEST(GraphBuilderTests, InvalidBatchesRejected) {
+  DynamicSceneGraph graph;
+  graph.emplaceNode(DsgLayers::PLACES, 0, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(DsgLayers::PLACES, 1, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(DsgLayers::ROOMS, 2, std::make_unique<NodeAttributes>());
+  graph.insertEdge(0, 1);
+  graph.insertEdge(2, 0);
+
+  const auto rejected = [&](const std::function<void(GraphBuilder&)>& add) {
+    GraphBuilder builder(graph);
+    add(builder);
+    const auto num_nodes = builder.numNodes();
+    const auto num_edges = builder.numEdges();
+    try {
+      builder.commit();
+    } catch (const std::runtime_error&) {
+      // neither the graph nor the batch change
+      EXPECT_EQ(3u, graph.numNodes());
+      EXPECT_EQ(2u, graph.numEdges());
+      EXPECT_EQ(num_nodes, builder.numNodes());
+      EXPECT_EQ(num_edges, builder.numEdges());
+      return true;
+    }
+
+    return false;
+  };
+
+  const auto make_attrs = []() { return std::make_unique<NodeAttributes>(); };
+  EXPECT_TRUE(rejected([&](auto& builder) { builder.addNode(20, 3, make_attrs()); }));
+  EXPECT_TRUE(rejected([&](auto& builder) {
+    builder.addNode(DsgLayers::PLACES, 1, make_attrs());
+  }));
+  EXPECT_TRUE(rejected([&](auto& builder) {
+    builder.addNode(DsgLayers::PLACES, 3, make_attrs());
+    builder.addNode(DsgLayers::OBJECTS, 3, make_attrs());
+  }));
+  EXPECT_TRUE(rejected([&](auto& builder) { builder.addEdge(0, 0); }));
+  EXPECT_TRUE(rejected([&](auto& builder) { builder.addEdge(0, 5); }));
+  EXPECT_TRUE(rejected([&](auto& builder) { builder.addEdge(1, 0); }));
+  EXPECT_TRUE(rejected([&](auto& builder) {
+    builder.addNode(DsgLayers::PLACES, 3, make_attrs());
+    builder.addEdge(1, 3);
+    builder.addEdge(3, 1);
+  }));
+
+  // nodes can only have one parent
+  EXPECT_TRUE(rejected([&](auto& builder) {
+    builder.addNode(DsgLayers::ROOMS, 3, make_attrs());
+    builder.addEdge(3, 0);
+  }));
+  EXPECT_TRUE(rejected([&](auto& builder) {
+    builder.addNode(DsgLayers::ROOMS, 3, make_attrs());
+    builder.addEdge(3, 1);
+    builder.addEdge(2, 1);
+  }));
+  EXPECT_FALSE(rejected([&](auto& builder) { builder.addEdge(2, 1); }));
+}
+
+}  // namespace spark_dsg
@@ -34,8 +34,11 @@
  * -------------------------------------------------------------------------- */
 #include <gtest/gtest.h>
 #include <spark_dsg/graph_utilities.h>
+#include <spark_dsg/parallel_components.h>
 #include <spark_dsg/scene_graph_layer.h>
 
+#include <random>
+
 namespace spark_dsg {
 
 using NodeSet = std::set<NodeId>;
@@ -294,4 +297,80 @@ TEST(ConnectedComponentTests, FilteredEmptyCorrect) {
   EXPECT_TRUE(result.empty());
 }
 
+std::set<NodeSet> componentSets(const Components& components) {
+  std::set<NodeSet> result;
+  for (const auto& component : components) {
+    result.insert(NodeSet(component.begin(), component.end()));
+  }
+  return result;
+}
+
+TEST(ConnectedComponentTests, MergedComponentsTransitive) {
+  // {0, 1} and {2, 3} only merge through the last component
+  const std::vector<NodeSet> unmerged{{0, 1}, {2, 3}, {4}, {1, 5, 2}};
+  const auto result = graph_utilities::getMergedComponents(unmerged);
+  EXPECT_EQ((std::set<NodeSet>{{0, 1, 2, 3, 5}, {4}}), componentSets(result));
+}
+
+TEST(ConnectedComponentTests, ParallelMatchesSerial) {
+  IsolatedSceneGraphLayer layer(1);
+  const size_t num_nodes = 20000;
+  for (size_t i = 0; i < num_nodes; ++i) {
+    layer.emplaceNode(i, std::make_unique<NodeAttributes>());
+  }
+
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<NodeId> node_dist(0, num_nodes - 1);
+  std::uniform_real_distribution<double> weight_dist(0.0, 1.0);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    const NodeId source = node_dist(gen);
+    const NodeId target = node_dist(gen);
+    const double weight = weight_dist(gen);
+    layer.insertEdge(source, target, std::make_unique<EdgeAttributes>(weight));
+  }
+
+  NodeSet all_nodes;
+  for (size_t i = 0; i < num_nodes; ++i) {
+    all_nodes.insert(i);
+  }
+
+  const auto expected = getConnectedComponents<SceneGraphLayer>(layer, all_nodes);
+  using graph_utilities::getConnectedComponentsParallel;
+  const auto result = getConnectedComponentsParallel<SceneGraphLayer>(layer, 4);
+  EXPECT_EQ(expected.size(), result.size());
+  EXPECT_EQ(componentSets(expected), componentSets(result));
+
+  std::function<bool(const SceneGraphNode&)> node_valid =
+      [](const SceneGraphNode& node) { return node.id % 5 != 0; };
+  std::function<bool(const SceneGraphEdge&)> edge_valid =
+      [](const SceneGraphEdge& edge) { return edge.info->weight > 0.3; };
+  const auto expected_filtered =
+      getConnectedComponents<SceneGraphLayer>(layer, node_valid, edge_valid);
+  const auto result_filtered =
+      getConnectedComponentsParallel<SceneGraphLayer>(layer, node_valid, edge_valid, 4);
+  EXPECT_EQ(componentSets(expected_filtered), componentSets(result_filtered));
+  EXPECT_EQ(componentSets(expected_filtered),
+            componentSets(getConnectedComponentsParallel<SceneGraphLayer>(
+                layer, node_valid, edge_valid, 1)));
+}
+
+TEST(ConnectedComponentTests, ParallelForCoversRange) {
+  using graph_utilities::parallelFor;
+  std::vector<int> counts(5000, 0);
+  parallelFor(counts.size(), 4, [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; ++i) {
+      ++counts[i];
+    }
+  });
+  EXPECT_EQ(std::vector<int>(5000, 1), counts);
+
+  // tiny blocks can still be split up and errors reach the caller
+  const auto throw_at_end = [](size_t, size_t end) {
+    if (end == 3) {
+      throw std::runtime_error("failed block");
+    }
+  };
+  EXPECT_THROW(parallelFor(3, 3, throw_at_end, 1), std::runtime_error);
+}
+
 }  // namespace spark_dsg
@@ -0,0 +1,160 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/hierarchical_planner.h>
+#include <spark_dsg/node_symbol.h>
+
+#include "spark_dsg_tests/building.h"
+
+namespace spark_dsg {
+
+using graph_utilities::ShortestPathWorkspace;
+
+HierarchicalPlanner::Config metricConfig() {
+  HierarchicalPlanner::Config config;
+  config.metric_place_weights = true;
+  return config;
+}
+
+void checkPathValid(const DynamicSceneGraph& graph,
+                    const HierarchicalPath& path,
+                    NodeId start,
+                    NodeId goal) {
+  ASSERT_FALSE(path.empty());
+  EXPECT_EQ(start, path.places.nodes.front());
+  EXPECT_EQ(goal, path.places.nodes.back());
+  for (size_t i = 1; i < path.places.nodes.size(); ++i) {
+    EXPECT_TRUE(graph.hasEdge(path.places.nodes[i - 1], path.places.nodes[i]));
+  }
+}
+
+TEST(HierarchicalPlannerTests, PlanThroughRowOfRooms) {
+  Building building(4, 1, 5);
+  HierarchicalPlanner planner(metricConfig());
+
+  const NodeId start = building.place(0, 2);
+  const NodeId goal = building.place(building.globalX(3, 4), 2);
+  const auto result = planner.plan(building.graph, start, goal);
+  checkPathValid(building.graph, result, start, goal);
+  EXPECT_FALSE(result.used_fallback);
+  EXPECT_EQ((std::vector<NodeId>{building.room(0, 0),
+                                 building.room(1, 0),
+                                 building.room(2, 0),
+                                 building.room(3, 0)}),
+            result.rooms);
+  EXPECT_NEAR(22.0, result.places.cost, 1.0e-9);
+}
+
+TEST(HierarchicalPlannerTests, RestrictedToRoomPath) {
+  Building building(3, 3, 5);
+  HierarchicalPlanner planner(metricConfig());
+
+  const NodeId start = building.place(building.globalX(0, 2), building.globalY(0, 2));
+  const NodeId goal = building.place(building.globalX(2, 2), building.globalY(0, 2));
+  const auto result = planner.plan(building.graph, start, goal);
+  checkPathValid(building.graph, result, start, goal);
+  EXPECT_FALSE(result.used_fallback);
+  ASSERT_EQ(3u, result.rooms.size());
+
+  const std::set<NodeId> rooms(result.rooms.begin(), result.rooms.end());
+  for (const auto place : result.places.nodes) {
+    const auto room = planner.getRoom(building.graph, place);
+    if (room) {
+      EXPECT_TRUE(rooms.count(*room)) << NodeSymbol(place).getLabel();
+    }
+  }
+
+  // the path along the row of rooms is optimal over the full layer as well
+  const auto& layer = building.graph.getLayer(DsgLayers::PLACES);
+  const RestrictedLayer places{layer, nullptr, true};
+  const auto flat = graph_utilities::shortestPath(places, start, goal);
+  EXPECT_NEAR(flat.cost, result.places.cost, 1.0e-9);
+}
+
+TEST(HierarchicalPlannerTests, RoomDilation) {
+  Building building(3, 3, 5);
+  auto config = metricConfig();
+  config.room_dilation = 1;
+  HierarchicalPlanner planner(config);
+
+  const NodeId start = building.place(0, 0);
+  const NodeId goal = building.place(building.globalX(2, 4), building.globalY(2, 4));
+  const auto result = planner.plan(building.graph, start, goal);
+  checkPathValid(building.graph, result, start, goal);
+  EXPECT_FALSE(result.used_fallback);
+  EXPECT_EQ(5u, result.rooms.size());
+}
+
+TEST(HierarchicalPlannerTests, FallbackToFlatSearch) {
+  Building building(2, 1, 3);
+  // a place that isn't part of any room
+  const size_t x = building.globalX(1, 2) + 1;
+  building.addPlace(x, 0);
+  building.graph.insertEdge(building.place(x - 1, 0), building.place(x, 0));
+
+  HierarchicalPlanner planner;
+  const NodeId start = building.place(0, 0);
+  const auto result = planner.plan(building.graph, start, building.place(x, 0));
+  checkPathValid(building.graph, result, start, building.place(x, 0));
+  EXPECT_TRUE(result.used_fallback);
+  EXPECT_TRUE(result.rooms.empty());
+
+  // disconnected rooms but connected places
+  building.graph.removeEdge(building.room(0, 0), building.room(1, 0));
+  const NodeId goal = building.place(building.globalX(1, 0), 0);
+  const auto disconnected = planner.plan(building.graph, start, goal);
+  checkPathValid(building.graph, disconnected, start, goal);
+  EXPECT_TRUE(disconnected.used_fallback);
+
+  HierarchicalPlanner::Config config;
+  config.fallback_to_flat = false;
+  HierarchicalPlanner strict_planner(config);
+  EXPECT_TRUE(strict_planner.plan(building.graph, start, goal).empty());
+}
+
+TEST(HierarchicalPlannerTests, InvalidQueries) {
+  Building building(2, 1, 3);
+  HierarchicalPlanner planner;
+  const NodeId start = building.place(0, 0);
+  EXPECT_TRUE(planner.plan(building.graph, start, NodeSymbol('p', 1234567)).empty());
+  EXPECT_TRUE(planner.plan(building.graph, start, building.room(1, 0)).empty());
+  EXPECT_TRUE(planner.plan(DynamicSceneGraph(), start, start).empty());
+
+  const auto trivial = planner.plan(building.graph, start, start);
+  EXPECT_EQ((std::vector<NodeId>{start}), trivial.places.nodes);
+  EXPECT_EQ((std::vector<NodeId>{building.room(0, 0)}), trivial.rooms);
+}
+
+}  // namespace spark_dsg
@@ -153,4 +153,48 @@ TEST(SceneGraphSerializationTests, SaveAndLoadGraph) {
   EXPECT_EQ(graph.hasMesh(), other->hasMesh());
 }
 
+TEST(SceneGraphSerializationTests, ParallelLoadMatchesSerial) {
+  using namespace std::chrono_literals;
+  DynamicSceneGraph expected;
+  for (size_t i = 0; i < 3000; ++i) {
+    expected.emplaceNode(DsgLayers::PLACES,
+                         NodeSymbol('p', i),
+                         std::make_unique<NodeAttributes>(Eigen::Vector3d(i, 0, 0)));
+    if (i > 0) {
+      expected.insertEdge(NodeSymbol('p', i - 1),
+                          NodeSymbol('p', i),
+                          std::make_unique<EdgeAttributes>(i));
+    }
+  }
+
+  expected.emplaceNode(
+      DsgLayers::ROOMS, NodeSymbol('R', 0), std::make_unique<NodeAttributes>());
+  expected.insertEdge(NodeSymbol('R', 0), NodeSymbol('p', 0));
+  expected.emplaceNode(2, 'a', 10ns, std::make_unique<NodeAttributes>());
+  expected.emplaceNode(2, 'a', 20ns, std::make_unique<NodeAttributes>());
+
+  const auto contents = expected.serialize();
+  DynamicSceneGraph::LoadTimings timings;
+  const auto result = DynamicSceneGraph::deserialize(contents, 4, &timings);
+  EXPECT_EQ(expected.numNodes(), result->numNodes());
+  EXPECT_EQ(expected.numDynamicNodes(), result->numDynamicNodes());
+  EXPECT_EQ(expected.numEdges(), result->numEdges());
+  EXPECT_TRUE(result->hasEdge(NodeSymbol('R', 0), NodeSymbol('p', 0)));
+  EXPECT_TRUE(result->hasNode(NodeSymbol('a', 1)));
+  EXPECT_EQ(1000.0, result->getEdge(NodeSymbol('p', 999), NodeSymbol('p', 1000))
+                        ->get()
+                        .info->weight);
+  EXPECT_EQ(Eigen::Vector3d(2999, 0, 0), result->getPosition(NodeSymbol('p', 2999)));
+  EXPECT_GT(timings.parse, 0.0);
+  EXPECT_GT(timings.decode, 0.0);
+  EXPECT_GT(timings.nodes, 0.0);
+  EXPECT_GT(timings.edges, 0.0);
+
+  // errors from the attribute workers reach the caller
+  auto bad_contents = contents;
+  const std::string type_name = "\"NodeAttributes\"";
+  bad_contents.replace(bad_contents.rfind(type_name), type_name.size(), "\"NotAType\"");
+  EXPECT_THROW(DynamicSceneGraph::deserialize(bad_contents, 4), std::domain_error);
+}
+
 }  // namespace spark_dsg
@@ -0,0 +1,164 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/dynamic_scene_graph.h>
+#include <spark_dsg/graph_binary_serialization.h>
+#include <spark_dsg/mesh.h>
+
+namespace spark_dsg {
+
+Mesh makeQuadMesh() {
+  Mesh mesh;
+  mesh.addVertex({0.0f, 0.0f, 0.0f}, {255, 0, 0});
+  mesh.addVertex({1.0f, 0.0f, 0.0f}, {0, 255, 0});
+  mesh.addVertex({1.0f, 1.0f, 0.0f}, {0, 0, 255});
+  mesh.addVertex({0.0f, 1.0f, 0.5f}, {10, 20, 30});
+  mesh.addFace({0, 1, 2});
+  mesh.addFace({0, 2, 3});
+  return mesh;
+}
+
+TEST(MeshTests, LayoutInvariants) {
+  Mesh mesh;
+  EXPECT_TRUE(mesh.empty());
+
+  mesh = makeQuadMesh();
+  EXPECT_FALSE(mesh.empty());
+  EXPECT_EQ(4u, mesh.numVertices());
+  EXPECT_EQ(2u, mesh.numFaces());
+  EXPECT_EQ(6u, mesh.indices().size());
+  EXPECT_EQ(4u, mesh.colors().size());
+  EXPECT_EQ(4u * sizeof(uint8_t), sizeof(Mesh::Color));
+
+  EXPECT_EQ(Mesh::Pos(0.0f, 1.0f, 0.5f), mesh.pos(3));
+  EXPECT_EQ((Mesh::Color{10, 20, 30, 255}), mesh.color(3));
+  EXPECT_EQ((Mesh::Face{0, 2, 3}), mesh.face(1));
+
+  mesh.setPos(3, {2.0f, 3.0f, 4.0f});
+  mesh.setFace(1, {1, 2, 3});
+  EXPECT_EQ(2.0f, mesh.xs()[3]);
+  EXPECT_EQ(3.0f, mesh.ys()[3]);
+  EXPECT_EQ(4.0f, mesh.zs()[3]);
+  EXPECT_EQ((Mesh::Face{1, 2, 3}), mesh.face(1));
+
+  mesh.resizeVertices(2);
+  EXPECT_EQ(2u, mesh.numVertices());
+  EXPECT_EQ(2u, mesh.colors().size());
+
+  mesh.clear();
+  EXPECT_TRUE(mesh.empty());
+}
+
+TEST(MeshTests, PclConversion) {
+  const auto expected = makeQuadMesh();
+  const auto vertices = expected.toPclVertices();
+  const auto faces = expected.toPclFaces();
+  ASSERT_EQ(4u, vertices->size());
+  ASSERT_EQ(2u, faces->size());
+  EXPECT_EQ(0.5f, vertices->at(3).z);
+  EXPECT_EQ(20, vertices->at(3).g);
+  EXPECT_EQ((std::vector<uint32_t>{0, 2, 3}), faces->at(1).vertices);
+
+  EXPECT_EQ(expected, Mesh::fromPcl(*vertices, faces.get()));
+  EXPECT_EQ(expected, Mesh::fromPcl(expected.toPcl()));
+
+  // polygons are split into triangle fans and degenerate polygons are dropped
+  Mesh::PclFaces polygons(2);
+  polygons[0].vertices = {0, 1, 2, 3};
+  polygons[1].vertices = {1, 2};
+  EXPECT_EQ(expected, Mesh::fromPcl(*vertices, &polygons));
+
+  const auto no_faces = Mesh::fromPcl(*vertices);
+  EXPECT_EQ(4u, no_faces.numVertices());
+  EXPECT_EQ(0u, no_faces.numFaces());
+}
+
+TEST(MeshTests, GraphSharesMesh) {
+  DynamicSceneGraph graph;
+  graph.emplaceNode(2, 0, std::make_unique<NodeAttributes>());
+  EXPECT_FALSE(graph.hasMesh());
+  EXPECT_TRUE(graph.isMeshEmpty());
+  EXPECT_EQ(nullptr, graph.mesh());
+
+  auto mesh = std::make_shared<Mesh>(makeQuadMesh());
+  graph.setMesh(mesh);
+  EXPECT_EQ(mesh, graph.mesh());
+  EXPECT_TRUE(graph.hasMesh());
+  EXPECT_FALSE(graph.isMeshEmpty());
+  EXPECT_EQ(5u, graph.numNodes());
+  EXPECT_EQ(Eigen::Vector3d(0.0, 1.0, 0.5), graph.getMeshPosition(3));
+  EXPECT_FALSE(graph.getMeshPosition(0));
+  EXPECT_FALSE(graph.getMeshPosition(4));
+
+  // pcl conversions are copies
+  EXPECT_EQ(*mesh, Mesh::fromPcl(graph.getMesh()));
+
+  EXPECT_TRUE(graph.insertMeshEdge(0, 1));
+  EXPECT_TRUE(graph.insertMeshEdge(0, 3));
+  auto smaller = std::make_shared<Mesh>(*mesh);
+  smaller->resizeVertices(3);
+  graph.setMesh(smaller);
+  EXPECT_TRUE(graph.hasMeshEdge(0, 1));
+  EXPECT_FALSE(graph.hasMeshEdge(0, 3));
+
+  const auto clone = graph.clone();
+  ASSERT_TRUE(clone->mesh());
+  EXPECT_EQ(graph.mesh(), clone->mesh());
+
+  graph.setMesh(Mesh::Ptr());
+  EXPECT_FALSE(graph.hasMesh());
+  EXPECT_EQ(0u, graph.getMeshEdges().size());
+}
+
+TEST(MeshTests, SerializationRoundTrip) {
+  DynamicSceneGraph graph;
+  graph.emplaceNode(2, 0, std::make_unique<NodeAttributes>());
+  graph.setMesh(std::make_shared<Mesh>(makeQuadMesh()));
+  graph.insertMeshEdge(0, 2);
+
+  std::vector<uint8_t> buffer;
+  writeGraph(graph, buffer, true);
+  const auto binary = readGraph(buffer);
+  ASSERT_TRUE(binary->mesh());
+  EXPECT_EQ(*graph.mesh(), *binary->mesh());
+  EXPECT_TRUE(binary->hasMeshEdge(0, 2));
+
+  const auto json = DynamicSceneGraph::deserialize(graph.serialize(true));
+  ASSERT_TRUE(json->mesh());
+  EXPECT_EQ(*graph.mesh(), *json->mesh());
+  EXPECT_TRUE(json->hasMeshEdge(0, 2));
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,262 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/dynamic_scene_graph.h>
+#include <spark_dsg/graph_binary_serialization.h>
+#include <spark_dsg/mesh_blocks.h>
+
+namespace spark_dsg {
+
+// strip of triangles along the x-axis starting at x = offset
+Mesh makeStripMesh(size_t num_faces, float offset) {
+  Mesh mesh;
+  for (size_t i = 0; i < num_faces + 2; ++i) {
+    const auto value = static_cast<uint8_t>(i);
+    mesh.addVertex({offset + 0.5f * i, (i % 2) ? 1.0f : 0.0f, 0.0f}, {value, 0, 0});
+  }
+
+  for (uint32_t i = 0; i < num_faces; ++i) {
+    mesh.addFace({i, i + 1, i + 2});
+  }
+
+  return mesh;
+}
+
+TEST(MeshBlocksTests, UpsertLayoutCorrect) {
+  Mesh mesh = makeStripMesh(2, 0.0f);
+  MeshBlocks blocks(mesh.numVertices(), mesh.numFaces());
+  EXPECT_TRUE(blocks.empty());
+
+  const auto first = blocks.upsert(mesh, {0, 0, 0}, makeStripMesh(3, 1.0f));
+  EXPECT_EQ(1u, first.version);
+  EXPECT_EQ(4u, first.vertex_offset);
+  EXPECT_EQ(5u, first.num_vertices);
+  EXPECT_EQ(2u, first.face_offset);
+  EXPECT_EQ(3u, first.num_faces);
+
+  const auto second = blocks.upsert(mesh, {1, 0, 0}, makeStripMesh(1, 2.0f));
+  EXPECT_EQ(2u, second.version);
+  EXPECT_EQ(9u, second.vertex_offset);
+  EXPECT_EQ(5u, second.face_offset);
+  EXPECT_EQ(12u, mesh.numVertices());
+  EXPECT_EQ(6u, mesh.numFaces());
+
+  // faces refer to the vertices of the flat mesh
+  EXPECT_EQ((Mesh::Face{4, 5, 6}), mesh.face(2));
+  EXPECT_EQ((Mesh::Face{9, 10, 11}), mesh.face(5));
+  EXPECT_EQ(makeStripMesh(3, 1.0f), blocks.extract(mesh, {0, 0, 0}));
+  EXPECT_EQ(makeStripMesh(1, 2.0f), blocks.extract(mesh, {1, 0, 0}));
+
+  // smaller blocks stay in place and clear the rest of their ranges
+  const auto shrunk = blocks.upsert(mesh, {0, 0, 0}, makeStripMesh(1, 3.0f));
+  EXPECT_EQ(3u, shrunk.version);
+  EXPECT_EQ(4u, shrunk.vertex_offset);
+  EXPECT_EQ(5u, shrunk.vertex_capacity);
+  EXPECT_EQ(3u, shrunk.num_vertices);
+  EXPECT_EQ(3u, shrunk.face_capacity);
+  EXPECT_EQ(Mesh::Pos::Zero(), mesh.pos(7));
+  EXPECT_EQ((Mesh::Face{0, 0, 0}), mesh.face(3));
+  EXPECT_EQ(makeStripMesh(1, 3.0f), blocks.extract(mesh, {0, 0, 0}));
+
+  // larger blocks move to the first free ranges and free their previous ranges
+  const auto grown = blocks.upsert(mesh, {0, 0, 0}, makeStripMesh(4, 1.0f));
+  EXPECT_EQ(12u, grown.vertex_offset);
+  EXPECT_EQ(6u, grown.face_offset);
+  EXPECT_EQ(18u, mesh.numVertices());
+  EXPECT_EQ(10u, mesh.numFaces());
+  EXPECT_EQ(Mesh::Pos::Zero(), mesh.pos(4));
+  EXPECT_EQ(makeStripMesh(4, 1.0f), blocks.extract(mesh, {0, 0, 0}));
+
+  // freed ranges are reused
+  const auto third = blocks.upsert(mesh, {2, 0, 0}, makeStripMesh(1, 5.0f));
+  EXPECT_EQ(4u, third.vertex_offset);
+  EXPECT_EQ(2u, third.face_offset);
+  EXPECT_EQ(18u, mesh.numVertices());
+
+  // base vertices are untouched
+  EXPECT_EQ(makeStripMesh(2, 0.0f).pos(3), mesh.pos(3));
+  EXPECT_EQ((Mesh::Face{1, 2, 3}), mesh.face(1));
+
+  // faces must refer to vertices of the block
+  Mesh invalid = makeStripMesh(1, 0.0f);
+  invalid.addFace({0, 1, 3});
+  EXPECT_THROW(blocks.upsert(mesh, {3, 0, 0}, invalid), std::invalid_argument);
+
+  const auto removed = blocks.remove(mesh, {2, 0, 0});
+  ASSERT_TRUE(removed);
+  EXPECT_EQ(third, *removed);
+  EXPECT_FALSE(blocks.remove(mesh, {2, 0, 0}));
+  EXPECT_FALSE(blocks.getBlock({2, 0, 0}));
+  EXPECT_EQ((Mesh::Face{0, 0, 0}), mesh.face(2));
+  EXPECT_EQ(2u, blocks.size());
+
+  // free space at the end of the mesh is released
+  EXPECT_TRUE(blocks.remove(mesh, {0, 0, 0}));
+  EXPECT_EQ(12u, mesh.numVertices());
+  EXPECT_EQ(6u, mesh.numFaces());
+  EXPECT_EQ(makeStripMesh(1, 2.0f), blocks.extract(mesh, {1, 0, 0}));
+}
+
+TEST(MeshBlocksTests, UpsertAtLayout) {
+  Mesh source;
+  MeshBlocks source_blocks;
+  source_blocks.upsert(source, {0, 0, 0}, makeStripMesh(2, 0.0f));
+  source_blocks.upsert(source, {0, 1, 0}, makeStripMesh(3, 1.0f));
+
+  // writing blocks at the layout of another mesh reproduces it
+  Mesh mesh;
+  MeshBlocks blocks;
+  for (const auto& [index, info] : source_blocks.blocks()) {
+    blocks.upsert(mesh, index, source_blocks.extract(source, index), &info);
+  }
+
+  EXPECT_EQ(source, mesh);
+  EXPECT_EQ(source_blocks.blocks(), blocks.blocks());
+
+  // versions continue after the restored versions
+  const auto info = blocks.upsert(mesh, {0, 0, 0}, makeStripMesh(1, 0.0f));
+  EXPECT_EQ(3u, info.version);
+
+  const auto layout = *blocks.getBlock({0, 0, 0});
+  EXPECT_THROW(blocks.upsert(mesh, {0, 0, 0}, makeStripMesh(3, 0.0f), &layout),
+               std::invalid_argument);
+}
+
+TEST(MeshBlocksTests, ExportDropsPaddingFaces) {
+  DynamicSceneGraph graph;
+  graph.setMesh(std::make_shared<Mesh>(makeStripMesh(2, 0.0f)));
+  graph.upsertMeshBlock({0, 0, 0}, makeStripMesh(3, 1.0f));
+  graph.upsertMeshBlock({1, 0, 0}, makeStripMesh(2, 2.0f));
+  graph.upsertMeshBlock({1, 0, 0}, makeStripMesh(1, 2.0f));
+  graph.removeMeshBlock({0, 0, 0});
+
+  // the freed and unused faces pad the layout
+  const auto& mesh = *graph.mesh();
+  EXPECT_EQ(7u, mesh.numFaces());
+  EXPECT_EQ((Mesh::Face{0, 0, 0}), mesh.face(2));
+
+  Mesh expected = makeStripMesh(2, 0.0f);
+  expected.resizeVertices(mesh.numVertices());
+  for (size_t i = 4; i < mesh.numVertices(); ++i) {
+    expected.setPos(i, mesh.pos(i));
+    expected.setColor(i, mesh.color(i));
+  }
+  expected.addFace({9, 10, 11});
+
+  const auto exported = graph.meshBlocks().exportMesh(mesh);
+  EXPECT_EQ(expected, exported);
+  EXPECT_EQ(3u, graph.getMesh().polygons.size());
+
+  // formats without the layout only get the used faces
+  const auto from_json = DynamicSceneGraph::deserialize(graph.serialize(true));
+  ASSERT_TRUE(from_json->hasMesh());
+  EXPECT_EQ(3u, from_json->mesh()->numFaces());
+
+  std::vector<uint8_t> buffer;
+  writeGraph(graph, buffer, true);
+  const auto from_binary = readGraph(buffer);
+  ASSERT_TRUE(from_binary->hasMesh());
+  EXPECT_EQ(expected.indices(), from_binary->mesh()->indices());
+  EXPECT_EQ(expected.xs(), from_binary->mesh()->xs());
+}
+
+TEST(MeshBlocksTests, GraphBlocksKeepMeshEdges) {
+  DynamicSceneGraph graph;
+  graph.emplaceNode(2, 0, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(2, 1, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(2, 2, std::make_unique<NodeAttributes>());
+
+  EXPECT_EQ(1u, graph.upsertMeshBlock({0, 0, 0}, makeStripMesh(2, 0.0f)));
+  EXPECT_EQ(2u, graph.upsertMeshBlock({1, 0, 0}, makeStripMesh(2, 2.0f)));
+  EXPECT_EQ(3u, graph.upsertMeshBlock({2, 0, 0}, makeStripMesh(1, 4.0f)));
+  ASSERT_TRUE(graph.hasMesh());
+  EXPECT_EQ(11u, graph.mesh()->numVertices());
+  EXPECT_EQ(3u, graph.meshBlocks().size());
+
+  graph.insertMeshEdge(0, 1);
+  graph.insertMeshEdge(1, 3);
+  graph.insertMeshEdge(1, 5);
+  graph.insertMeshEdge(2, 6);
+
+  // blocks that fit keep their vertices and drop edges to vertices that are gone
+  graph.upsertMeshBlock({0, 0, 0}, makeStripMesh(1, 0.0f));
+  EXPECT_EQ(std::vector<size_t>{1}, graph.getMeshConnectionIndices(0));
+  EXPECT_EQ(std::vector<size_t>{5}, graph.getMeshConnectionIndices(1));
+  EXPECT_EQ(std::vector<size_t>{6}, graph.getMeshConnectionIndices(2));
+
+  // blocks that grow move their edges along with their vertices
+  graph.upsertMeshBlock({1, 0, 0}, makeStripMesh(4, 2.0f));
+  const auto info = *graph.meshBlocks().getBlock({1, 0, 0});
+  EXPECT_EQ(11u, info.vertex_offset);
+  EXPECT_EQ(std::vector<size_t>{1}, graph.getMeshConnectionIndices(0));
+  EXPECT_EQ(std::vector<size_t>{12}, graph.getMeshConnectionIndices(1));
+  EXPECT_EQ(std::vector<size_t>{13}, graph.getMeshConnectionIndices(2));
+  EXPECT_EQ(graph.mesh()->pos(13), makeStripMesh(4, 2.0f).pos(2));
+
+  // meshes held elsewhere are copied instead of being modified
+  const auto held = graph.mesh();
+  const auto snapshot = *held;
+
+  // removed blocks take their edges with them
+  EXPECT_TRUE(graph.removeMeshBlock({1, 0, 0}));
+  EXPECT_EQ(snapshot, *held);
+  EXPECT_NE(held, graph.mesh());
+  EXPECT_EQ(11u, graph.mesh()->numVertices());
+  EXPECT_FALSE(graph.removeMeshBlock({1, 0, 0}));
+  EXPECT_TRUE(graph.getMeshConnectionIndices(1).empty());
+  EXPECT_TRUE(graph.getMeshConnectionIndices(2).empty());
+  EXPECT_EQ(std::vector<size_t>{1}, graph.getMeshConnectionIndices(0));
+
+  // meshes that aren't shared are modified in place
+  const auto mesh = graph.mesh().get();
+  graph.upsertMeshBlock({2, 0, 0}, makeStripMesh(1, 5.0f));
+  EXPECT_EQ(mesh, graph.mesh().get());
+
+  // clones keep the layout and share the mesh until one of them changes it
+  const auto clone = graph.clone();
+  EXPECT_EQ(graph.meshBlocks().blocks(), clone->meshBlocks().blocks());
+  EXPECT_EQ(graph.mesh(), clone->mesh());
+  const auto original = *graph.mesh();
+  clone->upsertMeshBlock({2, 0, 0}, makeStripMesh(2, 5.0f));
+  EXPECT_NE(graph.mesh(), clone->mesh());
+  EXPECT_EQ(original, *graph.mesh());
+
+  // setting a flat mesh drops the layout
+  graph.setMesh(std::make_shared<Mesh>(makeStripMesh(2, 0.0f)));
+  EXPECT_TRUE(graph.meshBlocks().empty());
+  EXPECT_EQ(4u, graph.meshBlocks().baseVertices());
+}
+
+}  // namespace spark_dsg
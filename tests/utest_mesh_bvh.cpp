@@ -0,0 +1,253 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/dynamic_scene_graph.h>
+#include <spark_dsg/mesh_bvh.h>
+#include <spark_dsg/mesh_blocks.h>
+
+#include <cmath>
+#include <random>
+#include <set>
+
+namespace spark_dsg {
+
+// height field z = f(x, y) over a size x size grid with unit spacing
+Mesh makeWavyMesh(size_t size) {
+  Mesh mesh;
+  for (size_t r = 0; r < size; ++r) {
+    for (size_t c = 0; c < size; ++c) {
+      const float x = r;
+      const float y = c;
+      mesh.addVertex({x, y, 0.5f * std::sin(0.7f * x) * std::cos(0.5f * y)}, {});
+    }
+  }
+
+  for (uint32_t r = 0; r + 1 < size; ++r) {
+    for (uint32_t c = 0; c + 1 < size; ++c) {
+      const uint32_t corner = r * size + c;
+      const uint32_t next_row = corner + static_cast<uint32_t>(size);
+      mesh.addFace({corner, corner + 1, next_row});
+      mesh.addFace({corner + 1, next_row + 1, next_row});
+    }
+  }
+
+  return mesh;
+}
+
+std::set<size_t> toFaceSet(const std::vector<MeshBvh::Hit>& hits) {
+  std::set<size_t> faces;
+  for (const auto& hit : hits) {
+    faces.insert(hit.face);
+  }
+  return faces;
+}
+
+struct MeshBvhFixture : public testing::Test {
+  MeshBvhFixture()
+      : mesh(makeWavyMesh(20)),
+        bvh(mesh),
+        // a single leaf checks every triangle
+        brute_force(mesh, mesh.numFaces()),
+        gen(42),
+        dist(-2.0, 22.0) {}
+
+  Eigen::Vector3d randomPoint() { return {dist(gen), dist(gen), 0.3 * dist(gen)}; }
+
+  Mesh mesh;
+  MeshBvh bvh;
+  MeshBvh brute_force;
+  std::mt19937 gen;
+  std::uniform_real_distribution<double> dist;
+};
+
+TEST_F(MeshBvhFixture, BuildInvariants) {
+  EXPECT_EQ(mesh.numFaces(), bvh.numTriangles());
+  EXPECT_GT(bvh.numNodes(), 1u);
+  EXPECT_EQ(1u, brute_force.numNodes());
+
+  MeshBvh empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_FALSE(empty.closestPoint(Eigen::Vector3d::Zero()));
+  EXPECT_FALSE(empty.raycast(Eigen::Vector3d::Zero(), Eigen::Vector3d::UnitZ()));
+}
+
+TEST_F(MeshBvhFixture, ClosestPointMatchesBruteForce) {
+  for (size_t i = 0; i < 200; ++i) {
+    const auto point = randomPoint();
+    const auto expected = brute_force.closestPoint(point);
+    const auto result = bvh.closestPoint(point);
+    ASSERT_TRUE(expected);
+    ASSERT_TRUE(result);
+    EXPECT_NEAR(expected->distance, result->distance, 1.0e-5);
+    EXPECT_NEAR(result->distance, (result->point - point).norm(), 1.0e-5);
+
+    const auto face = mesh.face(result->face);
+    EXPECT_EQ(face, result->vertices);
+    EXPECT_TRUE(result->vertex == face[0] || result->vertex == face[1] ||
+                result->vertex == face[2]);
+  }
+
+  // points on the surface are their own closest point
+  const Eigen::Vector3d on_surface = mesh.pos(47).cast<double>();
+  const auto result = bvh.closestPoint(on_surface);
+  ASSERT_TRUE(result);
+  EXPECT_NEAR(0.0, result->distance, 1.0e-6);
+  EXPECT_EQ(47u, result->vertex);
+
+  EXPECT_FALSE(bvh.closestPoint({10.0, 10.0, 50.0}, 1.0));
+}
+
+TEST_F(MeshBvhFixture, RaycastMatchesBruteForce) {
+  for (size_t i = 0; i < 200; ++i) {
+    const Eigen::Vector3d origin = randomPoint() + Eigen::Vector3d(0.0, 0.0, 5.0);
+    const Eigen::Vector3d direction = randomPoint() - origin;
+    const auto expected = brute_force.raycast(origin, direction);
+    const auto result = bvh.raycast(origin, direction);
+    ASSERT_EQ(expected.has_value(), result.has_value());
+    if (result) {
+      EXPECT_EQ(expected->face, result->face);
+      EXPECT_NEAR(expected->distance, result->distance, 1.0e-5);
+    }
+  }
+
+  // straight down onto the surface (and from below)
+  const auto down = bvh.raycast({5.5, 5.2, 10.0}, -Eigen::Vector3d::UnitZ());
+  ASSERT_TRUE(down);
+  const auto closest = bvh.closestPoint(down->point);
+  ASSERT_TRUE(closest);
+  EXPECT_NEAR(0.0, closest->distance, 1.0e-5);
+  EXPECT_NEAR(5.5, down->point.x(), 1.0e-5);
+  EXPECT_NEAR(5.2, down->point.y(), 1.0e-5);
+  EXPECT_NEAR(10.0 - down->point.z(), down->distance, 1.0e-5);
+
+  const auto up = bvh.raycast({5.5, 5.2, -10.0}, Eigen::Vector3d::UnitZ());
+  ASSERT_TRUE(up);
+  EXPECT_EQ(down->face, up->face);
+
+  // misses
+  EXPECT_FALSE(bvh.raycast({5.5, 5.2, 10.0}, Eigen::Vector3d::UnitZ()));
+  EXPECT_FALSE(bvh.raycast({5.5, 5.2, 10.0}, -Eigen::Vector3d::UnitZ(), 5.0));
+  EXPECT_FALSE(bvh.raycast({30.0, 5.2, 10.0}, -Eigen::Vector3d::UnitZ()));
+}
+
+TEST_F(MeshBvhFixture, SphereQueryMatchesBruteForce) {
+  for (size_t i = 0; i < 100; ++i) {
+    const auto center = randomPoint();
+    std::vector<MeshBvh::Hit> expected;
+    brute_force.sphereQuery(center, 1.5, expected);
+    std::vector<MeshBvh::Hit> result;
+    bvh.sphereQuery(center, 1.5, result);
+    EXPECT_EQ(toFaceSet(expected), toFaceSet(result));
+    for (const auto& hit : result) {
+      EXPECT_LE(hit.distance, 1.5);
+    }
+  }
+}
+
+TEST_F(MeshBvhFixture, RefitAndRebuildCorrect) {
+  // move a patch of vertices up
+  std::vector<size_t> moved;
+  for (size_t r = 5; r < 8; ++r) {
+    for (size_t c = 5; c < 8; ++c) {
+      const auto vertex = r * 20 + c;
+      mesh.setPos(vertex, mesh.pos(vertex) + Mesh::Pos(0.0f, 0.0f, 3.0f));
+      moved.push_back(vertex);
+    }
+  }
+
+  bvh.refit(mesh, moved);
+  MeshBvh fully_refit(makeWavyMesh(20));
+  EXPECT_FALSE(fully_refit.update(mesh));
+  const MeshBvh expected(mesh, mesh.numFaces());
+  for (size_t i = 0; i < 100; ++i) {
+    const Eigen::Vector3d point = randomPoint() + Eigen::Vector3d(0.0, 0.0, 2.0);
+    const auto truth = expected.closestPoint(point);
+    ASSERT_TRUE(truth);
+    EXPECT_NEAR(truth->distance, bvh.closestPoint(point)->distance, 1.0e-5);
+    EXPECT_NEAR(truth->distance, fully_refit.closestPoint(point)->distance, 1.0e-5);
+  }
+
+  const auto hit = bvh.raycast({6.0, 6.0, 10.0}, -Eigen::Vector3d::UnitZ());
+  ASSERT_TRUE(hit);
+  EXPECT_NEAR(10.0 - mesh.pos(6 * 20 + 6).z(), hit->distance, 1.0e-5);
+
+  // changing faces triggers a rebuild
+  mesh.addVertex({0.0f, 0.0f, 10.0f}, {});
+  mesh.addVertex({1.0f, 0.0f, 10.0f}, {});
+  mesh.addVertex({0.0f, 1.0f, 10.0f}, {});
+  mesh.addFace({400, 401, 402});
+  EXPECT_TRUE(bvh.update(mesh));
+  EXPECT_EQ(mesh.numFaces(), bvh.numTriangles());
+  const auto top = bvh.raycast({0.2, 0.2, 20.0}, -Eigen::Vector3d::UnitZ());
+  ASSERT_TRUE(top);
+  EXPECT_EQ(mesh.numFaces() - 1, top->face);
+}
+
+TEST(MeshBvhTests, DegenerateFacesSkipped) {
+  // removed blocks leave degenerate faces behind
+  Mesh mesh;
+  MeshBlocks blocks;
+  blocks.upsert(mesh, {0, 0, 0}, makeWavyMesh(3));
+  blocks.upsert(mesh, {1, 0, 0}, makeWavyMesh(4));
+  blocks.remove(mesh, {0, 0, 0});
+
+  const MeshBvh bvh(mesh);
+  EXPECT_EQ(18u, bvh.numTriangles());
+  const auto hit = bvh.closestPoint({0.0, 0.0, 1.0});
+  ASSERT_TRUE(hit);
+  EXPECT_GE(hit->face, 8u);
+}
+
+TEST(MeshBvhTests, HitsMatchMeshEdges) {
+  DynamicSceneGraph graph;
+  graph.emplaceNode(2, 0, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(2, 1, std::make_unique<NodeAttributes>());
+  graph.setMesh(std::make_shared<Mesh>(makeWavyMesh(10)));
+  for (size_t vertex = 0; vertex < 50; ++vertex) {
+    graph.insertMeshEdge(0, vertex);
+  }
+  for (size_t vertex = 50; vertex < 100; ++vertex) {
+    graph.insertMeshEdge(1, vertex);
+  }
+
+  const MeshBvh bvh(*graph.mesh());
+  const auto hit = bvh.raycast({7.2, 3.1, 5.0}, -Eigen::Vector3d::UnitZ());
+  ASSERT_TRUE(hit);
+  const auto vertices = graph.getMeshConnectionIndices(1);
+  EXPECT_TRUE(std::binary_search(vertices.begin(), vertices.end(), hit->vertex));
+  EXPECT_EQ(73u, hit->vertex);
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,225 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/mesh_edge_index.h>
+
+#include <map>
+#include <random>
+#include <set>
+
+namespace spark_dsg {
+
+using EdgeSet = std::set<std::pair<NodeId, size_t>>;
+
+EdgeSet toEdgeSet(const MeshEdgeIndex::Edges& edges) {
+  EdgeSet result;
+  for (const auto& edge : edges) {
+    result.emplace(edge.source_node, edge.mesh_vertex);
+  }
+  return result;
+}
+
+// checks both directions of the index against the expected edges
+void expectIndexMatches(const MeshEdgeIndex& index, const EdgeSet& expected) {
+  EXPECT_EQ(expected.size(), index.size());
+  EXPECT_EQ(expected, toEdgeSet(index.edges()));
+
+  std::map<NodeId, std::vector<size_t>> node_vertices;
+  std::map<size_t, std::set<NodeId>> vertex_nodes;
+  for (const auto& [node, vertex] : expected) {
+    node_vertices[node].push_back(vertex);
+    vertex_nodes[vertex].insert(node);
+  }
+
+  for (const auto& [node, vertices] : node_vertices) {
+    EXPECT_EQ(vertices, index.vertices(node));
+  }
+
+  for (const auto& [vertex, nodes] : vertex_nodes) {
+    const auto result = index.nodes(vertex);
+    EXPECT_EQ(nodes, std::set<NodeId>(result.begin(), result.end()));
+  }
+}
+
+TEST(MeshEdgeIndexTests, InsertAndEraseCorrect) {
+  MeshEdgeIndex index;
+  EXPECT_TRUE(index.empty());
+  EXPECT_TRUE(index.insert(1, 5));
+  EXPECT_TRUE(index.insert(1, 2));
+  EXPECT_TRUE(index.insert(2, 5));
+  EXPECT_FALSE(index.insert(1, 5));
+  EXPECT_EQ(3u, index.size());
+
+  EXPECT_TRUE(index.contains(1, 2));
+  EXPECT_FALSE(index.contains(2, 2));
+  EXPECT_FALSE(index.contains(3, 5));
+  EXPECT_EQ((std::vector<size_t>{2, 5}), index.vertices(1));
+  EXPECT_TRUE(index.vertices(3).empty());
+  EXPECT_TRUE(index.nodes(100).empty());
+
+  EXPECT_TRUE(index.erase(1, 5));
+  EXPECT_FALSE(index.erase(1, 5));
+  EXPECT_FALSE(index.erase(3, 5));
+  expectIndexMatches(index, {{1, 2}, {2, 5}});
+
+  EXPECT_EQ(1u, index.eraseNode(1));
+  EXPECT_EQ(0u, index.eraseNode(1));
+  expectIndexMatches(index, {{2, 5}});
+
+  index.clear();
+  EXPECT_TRUE(index.empty());
+  EXPECT_FALSE(index.contains(2, 5));
+}
+
+TEST(MeshEdgeIndexTests, BatchInsertCorrect) {
+  MeshEdgeIndex index;
+  index.insert(1, 4);
+  index.insert(2, 1);
+
+  // duplicates and existing edges are skipped
+  MeshEdgeIndex::Edges edges{{3, 7}, {1, 9}, {1, 0}, {3, 7}, {1, 4}, {2, 3}};
+  EXPECT_EQ(4u, index.insert(edges));
+  expectIndexMatches(index, {{1, 0}, {1, 4}, {1, 9}, {2, 1}, {2, 3}, {3, 7}});
+  EXPECT_EQ(0u, index.insert(edges));
+}
+
+TEST(MeshEdgeIndexTests, EraseVerticesCorrect) {
+  MeshEdgeIndex index;
+  index.insert({{1, 0}, {1, 3}, {2, 3}, {2, 4}, {3, 8}, {3, 9}});
+
+  EXPECT_EQ(2u, index.eraseVertices(3, 4));
+  expectIndexMatches(index, {{1, 0}, {2, 4}, {3, 8}, {3, 9}});
+
+  // removing everything past a vertex
+  EXPECT_EQ(2u, index.eraseVertices(5));
+  expectIndexMatches(index, {{1, 0}, {2, 4}});
+  EXPECT_EQ((MeshEdgeIndex::Edges{{2, 4}}), index.edgesInRange(1));
+
+  EXPECT_EQ(0u, index.eraseVertices(100, 200));
+  EXPECT_TRUE(index.insert(3, 9));
+  expectIndexMatches(index, {{1, 0}, {2, 4}, {3, 9}});
+}
+
+TEST(MeshEdgeIndexTests, VerticesOutsideMeshCorrect) {
+  MeshEdgeIndex index;
+  index.setNumVertices(4);
+
+  // vertices past the end of the mesh don't size any allocation
+  const size_t far_vertex = MeshEdgeIndex::npos - 1;
+  index.insert({{1, 2}, {1, far_vertex}, {2, far_vertex}, {2, 6}});
+  expectIndexMatches(index, {{1, 2}, {1, far_vertex}, {2, 6}, {2, far_vertex}});
+  EXPECT_EQ((MeshEdgeIndex::Edges{{2, 6}}), index.edgesInRange(3, 10));
+
+  // edges move between the sparse and dense storage when the mesh changes
+  index.setNumVertices(8);
+  expectIndexMatches(index, {{1, 2}, {1, far_vertex}, {2, 6}, {2, far_vertex}});
+  index.setNumVertices(1);
+  expectIndexMatches(index, {{1, 2}, {1, far_vertex}, {2, 6}, {2, far_vertex}});
+
+  EXPECT_EQ(2u, index.eraseVertices(far_vertex - 1, far_vertex + 1));
+  expectIndexMatches(index, {{1, 2}, {2, 6}});
+  EXPECT_TRUE(index.nodes(far_vertex).empty());
+  EXPECT_EQ(1u, index.eraseVertices(1, 3));
+  expectIndexMatches(index, {{2, 6}});
+}
+
+TEST(MeshEdgeIndexTests, RandomOperationsConsistent) {
+  std::mt19937 gen(12345);
+  std::uniform_int_distribution<int> op_dist(0, 6);
+  std::uniform_int_distribution<NodeId> node_dist(0, 20);
+  std::uniform_int_distribution<size_t> vertex_dist(0, 50);
+
+  MeshEdgeIndex index;
+  EdgeSet expected;
+  for (size_t i = 0; i < 2000; ++i) {
+    const auto node = node_dist(gen);
+    const auto vertex = vertex_dist(gen);
+    switch (op_dist(gen)) {
+      case 0:
+      case 1:
+        EXPECT_EQ(expected.emplace(node, vertex).second, index.insert(node, vertex));
+        break;
+      case 2:
+        EXPECT_EQ(expected.erase({node, vertex}) > 0, index.erase(node, vertex));
+        break;
+      case 3: {
+        MeshEdgeIndex::Edges edges;
+        for (size_t j = 0; j < 5; ++j) {
+          edges.emplace_back(node_dist(gen), vertex_dist(gen));
+        }
+
+        size_t num_added = 0;
+        for (const auto& edge : edges) {
+          num_added += expected.emplace(edge.source_node, edge.mesh_vertex).second;
+        }
+        EXPECT_EQ(num_added, index.insert(edges));
+        break;
+      }
+      case 4: {
+        size_t num_removed = 0;
+        for (auto iter = expected.begin(); iter != expected.end();) {
+          const bool remove = iter->first == node;
+          num_removed += remove;
+          iter = remove ? expected.erase(iter) : std::next(iter);
+        }
+        EXPECT_EQ(num_removed, index.eraseNode(node));
+        break;
+      }
+      case 5:
+        // only changes where edges are stored
+        index.setNumVertices(vertex);
+        break;
+      default: {
+        const auto end = vertex + 3;
+        size_t num_removed = 0;
+        for (auto iter = expected.begin(); iter != expected.end();) {
+          const bool remove = iter->second >= vertex && iter->second < end;
+          num_removed += remove;
+          iter = remove ? expected.erase(iter) : std::next(iter);
+        }
+        EXPECT_EQ(num_removed, index.eraseVertices(vertex, end));
+        break;
+      }
+    }
+
+    if (i % 100 == 0) {
+      expectIndexMatches(index, expected);
+    }
+  }
+
+  expectIndexMatches(index, expected);
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,157 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/node_store.h>
+
+#include <set>
+
+namespace spark_dsg {
+
+TEST(NodeStoreTests, EmplaceAndFind) {
+  NodeStore store;
+  EXPECT_TRUE(store.empty());
+  EXPECT_EQ(nullptr, store.find(0));
+  EXPECT_THROW(store.at(0), std::out_of_range);
+  EXPECT_EQ(NodeStore::INVALID_HANDLE, store.handle(0));
+
+  auto result = store.emplace(5, 2, std::make_unique<NodeAttributes>());
+  EXPECT_TRUE(result.second);
+  ASSERT_TRUE(result.first != nullptr);
+  EXPECT_EQ(5u, result.first->id);
+  EXPECT_EQ(2u, result.first->layer);
+
+  // duplicate nodes are rejected and return the original node
+  auto duplicate = store.emplace(5, 3, std::make_unique<NodeAttributes>());
+  EXPECT_FALSE(duplicate.second);
+  EXPECT_EQ(result.first, duplicate.first);
+
+  EXPECT_EQ(1u, store.size());
+  EXPECT_TRUE(store.contains(5));
+  EXPECT_EQ(result.first, store.find(5));
+  EXPECT_EQ(result.first, &store.at(5));
+
+  SceneGraphNode node(6, 2, std::make_unique<NodeAttributes>(Eigen::Vector3d(1, 2, 3)));
+  result = store.insert(std::move(node));
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ(2u, store.size());
+  EXPECT_EQ(Eigen::Vector3d(1, 2, 3), store.at(6).attributes().position);
+}
+
+TEST(NodeStoreTests, HandlesAreStable) {
+  NodeStore store;
+  store.emplace(0, 1, std::make_unique<NodeAttributes>());
+  const auto handle = store.handle(0);
+  const auto* node = store.find(0);
+  ASSERT_NE(NodeStore::INVALID_HANDLE, handle);
+
+  // force the allocation of a lot of chunks
+  for (size_t i = 1; i < 10 * NodeStore::CHUNK_SIZE; ++i) {
+    store.emplace(i, 1, std::make_unique<NodeAttributes>());
+  }
+
+  for (size_t i = 1; i < 10 * NodeStore::CHUNK_SIZE; i += 2) {
+    EXPECT_EQ(1u, store.erase(i));
+  }
+  EXPECT_EQ(0u, store.erase(1));
+
+  EXPECT_EQ(handle, store.handle(0));
+  EXPECT_EQ(node, store.get(handle));
+  EXPECT_EQ(node, &store[handle]);
+  EXPECT_EQ(5 * NodeStore::CHUNK_SIZE, store.size());
+
+  // removed nodes have invalid handles and freed slots are reused
+  const auto removed = store.handle(2 * NodeStore::CHUNK_SIZE);
+  store.erase(2 * NodeStore::CHUNK_SIZE);
+  EXPECT_EQ(nullptr, store.get(removed));
+  const auto capacity = store.capacity();
+  store.emplace(20 * NodeStore::CHUNK_SIZE, 1, std::make_unique<NodeAttributes>());
+  EXPECT_EQ(removed, store.handle(20 * NodeStore::CHUNK_SIZE));
+  EXPECT_EQ(capacity, store.capacity());
+}
+
+TEST(NodeStoreTests, IterationCorrect) {
+  NodeStore store;
+  std::set<NodeId> expected;
+  for (size_t i = 0; i < 1000; ++i) {
+    store.emplace(i, 1, std::make_unique<NodeAttributes>());
+    if (i % 3 == 0) {
+      store.erase(i);
+    } else {
+      expected.insert(i);
+    }
+  }
+
+  std::set<NodeId> result;
+  for (const auto& [node_id, node] : store) {
+    ASSERT_TRUE(node != nullptr);
+    EXPECT_EQ(node_id, node->id);
+    result.insert(node_id);
+  }
+  EXPECT_EQ(expected, result);
+
+  store.clear();
+  EXPECT_TRUE(store.empty());
+  EXPECT_EQ(store.begin(), store.end());
+}
+
+TEST(NodeStoreTests, IterationOrderedById) {
+  NodeStore store;
+  for (const NodeId node_id : {5, 1, 9, 3, 7}) {
+    store.emplace(node_id, 1, std::make_unique<NodeAttributes>());
+  }
+
+  store.erase(9);
+  store.erase(3);
+  store.emplace(3, 1, std::make_unique<NodeAttributes>());
+  store.emplace(2, 1, std::make_unique<NodeAttributes>());
+  // churn removed entries at the back of the order
+  for (size_t i = 10; i < 100; ++i) {
+    store.emplace(i, 1, std::make_unique<NodeAttributes>());
+    store.erase(i);
+  }
+
+  std::vector<NodeId> result;
+  for (const auto& [node_id, node] : store) {
+    EXPECT_EQ(node_id, node->id);
+    result.push_back(node_id);
+  }
+  EXPECT_EQ(result, std::vector<NodeId>({1, 2, 3, 5, 7}));
+
+  store.clear();
+  EXPECT_TRUE(store.empty());
+  EXPECT_EQ(store.begin(), store.end());
+}
+
+}  // namespace spark_dsg
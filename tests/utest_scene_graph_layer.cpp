@@ -212,7 +212,7 @@ TEST(SceneGraphLayerTests, BasicEdgeIterationCorrect) {
   // nodes may be stored unordered in the future
   std::set<NodeId> actual_targets;
   for (const auto& id_edge_pair : layer.edges()) {
-    const Edge& edge = id_edge_pair.second;
+    const Edge& edge = *id_edge_pair.second;
     ASSERT_TRUE(edge.info != nullptr);
     EXPECT_EQ(edge.source + 1, edge.target);
     actual_targets.insert(edge.target);
@@ -357,7 +357,7 @@ TEST(SceneGraphLayerTests, MergeLayerCorrect) {
     EXPECT_TRUE(layer_2.insertEdge(i - 1, i));
   }
 
-  std::map<NodeId, LayerKey> node_to_layer;
+  NodeLookup node_to_layer;
   layer_1.mergeLayer(layer_2, {}, &node_to_layer);
 
   EXPECT_EQ(2u, node_to_layer.size());
@@ -477,6 +477,39 @@ TEST(SceneGraphLayerTests, GetNeighborhoodFromSetCorrect) {
   }
 }
 
+TEST(SceneGraphLayerTests, SearchNeighborhoodCorrect) {
+  IsolatedSceneGraphLayer layer(1);
+
+  layer.emplaceNode(0, std::make_unique<NodeAttributes>());
+  for (size_t i = 1; i < 7; ++i) {
+    layer.emplaceNode(i, std::make_unique<NodeAttributes>());
+    layer.insertEdge(i - 1, i);
+  }
+
+  {  // two seeds that overlap after two hops, missing and repeated seeds are ignored
+    const auto result = layer.searchNeighborhood({0, 10, 5, 0}, 2);
+    EXPECT_EQ((std::vector<NodeId>{0, 5, 1, 4, 6, 2, 3}), result.nodes);
+    EXPECT_EQ((std::vector<uint32_t>{0, 0, 1, 1, 1, 2, 2}), result.hops);
+    EXPECT_EQ((std::vector<NodeId>{0, 5, 0, 5, 5, 0, 5}), result.sources);
+  }
+
+  {  // zero hops only returns the seeds
+    const auto result = layer.searchNeighborhood({3, 4}, 0);
+    EXPECT_EQ((std::vector<NodeId>{3, 4}), result.nodes);
+  }
+
+  {  // removed nodes free their slot for reuse
+    layer.removeNode(3);
+    layer.emplaceNode(7, std::make_unique<NodeAttributes>());
+    layer.insertEdge(2, 7);
+    const auto result = layer.searchNeighborhood({1}, 5);
+    EXPECT_EQ((std::vector<NodeId>{1, 0, 2, 7}), result.nodes);
+    EXPECT_EQ((std::vector<uint32_t>{0, 1, 1, 2}), result.hops);
+  }
+
+  EXPECT_EQ(0u, layer.searchNeighborhood({20}, 3).size());
+}
+
 TEST(SceneGraphLayerTests, SerializeDeserializeCorrect) {
   IsolatedSceneGraphLayer layer(1);
 
@@ -668,9 +701,63 @@ TEST(SceneGraphLayerTests, CloneCorrect) {
   }
 
   for (const auto& id_edge_pair : layer.edges()) {
-    const auto& edge = id_edge_pair.second;
+    const auto& edge = *id_edge_pair.second;
     EXPECT_TRUE(result->hasEdge(edge.source, edge.target));
   }
 }
 
+// Test that spatial queries agree with and without the position cache
+TEST(SceneGraphLayerTests, PositionQueriesCorrect) {
+  IsolatedSceneGraphLayer layer(1);
+  for (size_t i = 0; i < 1000; ++i) {
+    const Eigen::Vector3d pos(0.1 * (i % 10), 0.1 * ((i / 10) % 10), 0.1 * (i / 100));
+    layer.emplaceNode(i, std::make_unique<NodeAttributes>(pos));
+  }
+
+  for (size_t i = 0; i < 1000; i += 7) {
+    layer.removeNode(i);
+  }
+  layer.mergeNodes(1, 2);
+
+  const Eigen::Vector3d center(0.45, 0.45, 0.45);
+  const Eigen::Vector3d min(0.15, 0.25, 0.35);
+  const Eigen::Vector3d max(0.55, 0.65, 0.75);
+
+  auto expected_radius = layer.getNodesInRadius(center, 0.3);
+  auto expected_box = layer.getNodesInBox(min, max);
+  std::sort(expected_radius.begin(), expected_radius.end());
+  std::sort(expected_box.begin(), expected_box.end());
+  EXPECT_FALSE(expected_radius.empty());
+  EXPECT_FALSE(expected_box.empty());
+
+  layer.enablePositionCache();
+  ASSERT_TRUE(layer.hasPositionCache());
+
+  // nodes added after the cache exists should be tracked as well
+  layer.emplaceNode(2000, std::make_unique<NodeAttributes>(center));
+  expected_radius.push_back(2000);
+  expected_box.push_back(2000);
+
+  auto result_radius = layer.getNodesInRadius(center, 0.3);
+  auto result_box = layer.getNodesInBox(min, max);
+  std::sort(result_radius.begin(), result_radius.end());
+  std::sort(result_box.begin(), result_box.end());
+  EXPECT_EQ(expected_radius, result_radius);
+  EXPECT_EQ(expected_box, result_box);
+
+  // removal and attribute updates are reflected in the cache
+  layer.removeNode(2000);
+  EXPECT_TRUE(layer.setNodeAttributes(
+      3, std::make_unique<NodeAttributes>(Eigen::Vector3d(10.0, 10.0, 10.0))));
+  result_radius = layer.getNodesInRadius(Eigen::Vector3d(10.0, 10.0, 10.0), 0.1);
+  EXPECT_EQ(std::vector<NodeId>{3}, result_radius);
+
+  layer.getNode(3)->get().attributes().position = Eigen::Vector3d(-10.0, 0.0, 0.0);
+  EXPECT_TRUE(layer.refreshPosition(3));
+  result_box = layer.getNodesInBox(Eigen::Vector3d(-11.0, -1.0, -1.0),
+                                   Eigen::Vector3d(-9.0, 1.0, 1.0));
+  EXPECT_EQ(std::vector<NodeId>{3}, result_box);
+  EXPECT_FALSE(layer.refreshPosition(2000));
+}
+
 }  // namespace spark_dsg
@@ -0,0 +1,183 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/scene_graph_layer.h>
+#include <spark_dsg/shortest_paths.h>
+
+#include <random>
+
+#include "spark_dsg_tests/weighted_grid.h"
+
+namespace spark_dsg {
+
+using graph_utilities::ShortestPathWorkspace;
+
+struct ShortestPathFixture : public testing::Test {
+  ShortestPathFixture() : layer(1) {}
+
+  void SetUp() override {
+    // 0 -- 1 -- 2 is expensive, 0 -- 3 -- 4 -- 2 is cheap, 5 is disconnected
+    for (size_t i = 0; i < 6; ++i) {
+      layer.emplaceNode(
+          i, std::make_unique<NodeAttributes>(Eigen::Vector3d(i, 0.0, 0.0)));
+    }
+
+    layer.insertEdge(0, 1, std::make_unique<EdgeAttributes>(5.0));
+    layer.insertEdge(1, 2, std::make_unique<EdgeAttributes>(5.0));
+    layer.insertEdge(0, 3, std::make_unique<EdgeAttributes>(1.0));
+    layer.insertEdge(3, 4, std::make_unique<EdgeAttributes>(1.0));
+    layer.insertEdge(4, 2, std::make_unique<EdgeAttributes>(1.0));
+  }
+
+  IsolatedSceneGraphLayer layer;
+};
+
+TEST_F(ShortestPathFixture, UsesEdgeWeights) {
+  const auto result = graph_utilities::shortestPath<SceneGraphLayer>(layer, 0, 2);
+  EXPECT_EQ((std::vector<NodeId>{0, 3, 4, 2}), result.nodes);
+  EXPECT_NEAR(3.0, result.cost, 1.0e-9);
+
+  const auto frozen = layer.freeze();
+  const auto frozen_result = graph_utilities::shortestPath<FrozenLayer>(frozen, 0, 2);
+  EXPECT_EQ(result.nodes, frozen_result.nodes);
+  EXPECT_NEAR(3.0, frozen_result.cost, 1.0e-9);
+}
+
+TEST_F(ShortestPathFixture, UnweightedEdgesMatchSnapshot) {
+  // edges without a valid weight cost 1 regardless of the stored weight
+  auto info = std::make_unique<EdgeAttributes>();
+  info->weight = 0.1;
+  layer.insertEdge(1, 5, std::move(info));
+
+  const auto result = graph_utilities::shortestPath<SceneGraphLayer>(layer, 0, 5);
+  EXPECT_EQ((std::vector<NodeId>{0, 1, 5}), result.nodes);
+  EXPECT_NEAR(6.0, result.cost, 1.0e-9);
+
+  const auto frozen = layer.freeze();
+  const auto frozen_result = graph_utilities::shortestPath<FrozenLayer>(frozen, 0, 5);
+  EXPECT_EQ(result.nodes, frozen_result.nodes);
+  EXPECT_NEAR(result.cost, frozen_result.cost, 1.0e-9);
+}
+
+TEST_F(ShortestPathFixture, NegativeWeightsRejected) {
+  layer.insertEdge(2, 5, std::make_unique<EdgeAttributes>(-1.0));
+  EXPECT_THROW(graph_utilities::shortestPath<SceneGraphLayer>(layer, 0, 5),
+               std::invalid_argument);
+
+  const auto frozen = layer.freeze();
+  EXPECT_THROW(graph_utilities::shortestPath<FrozenLayer>(frozen, 0, 5),
+               std::invalid_argument);
+}
+
+TEST_F(ShortestPathFixture, InvalidQueries) {
+  EXPECT_TRUE(graph_utilities::shortestPath<SceneGraphLayer>(layer, 0, 5).empty());
+  EXPECT_TRUE(graph_utilities::shortestPath<SceneGraphLayer>(layer, 0, 10).empty());
+  EXPECT_TRUE(graph_utilities::shortestPath<SceneGraphLayer>(layer, 10, 0).empty());
+
+  const auto trivial = graph_utilities::shortestPath<SceneGraphLayer>(layer, 1, 1);
+  EXPECT_EQ((std::vector<NodeId>{1}), trivial.nodes);
+  EXPECT_EQ(0.0, trivial.cost);
+}
+
+TEST_F(ShortestPathFixture, MultiSourceDijkstra) {
+  ShortestPathWorkspace workspace;
+  graph_utilities::dijkstra<SceneGraphLayer>(layer, {1, 3}, workspace);
+  EXPECT_NEAR(0.0, workspace.cost(1), 1.0e-9);
+  EXPECT_NEAR(1.0, workspace.cost(0), 1.0e-9);
+  EXPECT_NEAR(2.0, workspace.cost(2), 1.0e-9);
+  EXPECT_EQ((std::vector<NodeId>{3, 4, 2}), workspace.path(2));
+  EXPECT_FALSE(workspace.reached(5));
+  EXPECT_TRUE(std::isinf(workspace.cost(5)));
+  EXPECT_TRUE(workspace.path(5).empty());
+}
+
+TEST_F(ShortestPathFixture, EarlyTermination) {
+  ShortestPathWorkspace workspace;
+  std::vector<NodeId> settled;
+  graph_utilities::dijkstra<SceneGraphLayer>(
+      layer, {0}, workspace, [&](NodeId node, double) {
+        settled.push_back(node);
+        return node == 3;
+      });
+  EXPECT_EQ((std::vector<NodeId>{0, 3}), settled);
+  EXPECT_FALSE(workspace.settled(2));
+
+  // cost limit prunes everything past the cheap branch
+  graph_utilities::dijkstra<SceneGraphLayer>(layer, {0}, workspace, {}, 2.0);
+  EXPECT_TRUE(workspace.settled(4));
+  EXPECT_FALSE(workspace.reached(1));
+  EXPECT_FALSE(workspace.reached(2));
+}
+
+TEST_F(ShortestPathFixture, WorkspaceReuse) {
+  ShortestPathWorkspace workspace;
+  const auto first = graph_utilities::shortestPath<SceneGraphLayer>(
+      layer, std::vector<NodeId>{0}, 2, workspace);
+  const auto second = graph_utilities::shortestPath<SceneGraphLayer>(
+      layer, std::vector<NodeId>{1}, 4, workspace);
+  const auto third = graph_utilities::shortestPath<SceneGraphLayer>(
+      layer, std::vector<NodeId>{0}, 2, workspace);
+  EXPECT_EQ((std::vector<NodeId>{1, 2, 4}), second.nodes);
+  EXPECT_NEAR(6.0, second.cost, 1.0e-9);
+  EXPECT_EQ(first.nodes, third.nodes);
+  EXPECT_EQ(first.cost, third.cost);
+}
+
+TEST(ShortestPathTests, AStarMatchesDijkstra) {
+  const size_t side = 30;
+  const auto layer_ptr = makeGrid(side, 0.5);
+  const auto& layer = *layer_ptr;
+
+  ShortestPathWorkspace workspace;
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<NodeId> node_dist(0, side * side - 1);
+  for (size_t i = 0; i < 20; ++i) {
+    const NodeId source = node_dist(gen);
+    const NodeId target = node_dist(gen);
+    const auto expected = graph_utilities::shortestPath<SceneGraphLayer>(
+        layer, std::vector<NodeId>{source}, target, workspace);
+    const size_t dijkstra_expanded = workspace.labels.size();
+
+    const auto result =
+        graph_utilities::aStar<SceneGraphLayer>(layer, source, target, workspace);
+    EXPECT_NEAR(expected.cost, result.cost, 1.0e-9);
+    ASSERT_FALSE(result.empty());
+    EXPECT_EQ(source, result.nodes.front());
+    EXPECT_EQ(target, result.nodes.back());
+    EXPECT_LE(workspace.labels.size(), dijkstra_expanded);
+  }
+}
+
+}  // namespace spark_dsg
@@ -0,0 +1,191 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <spark_dsg/scene_graph_layer.h>
+#include <spark_dsg/spatial_index.h>
+
+#include <algorithm>
+#include <random>
+
+namespace spark_dsg {
+
+namespace {
+
+std::vector<Eigen::Vector3d> randomPoints(size_t num_points, double scale, int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dist(-scale, scale);
+  std::vector<Eigen::Vector3d> points;
+  for (size_t i = 0; i < num_points; ++i) {
+    points.emplace_back(dist(gen), dist(gen), dist(gen));
+  }
+  return points;
+}
+
+std::vector<NodeId> bruteForceKnn(const std::vector<Eigen::Vector3d>& points,
+                                  const Eigen::Vector3d& query,
+                                  size_t k) {
+  std::vector<std::pair<double, NodeId>> dists;
+  for (size_t i = 0; i < points.size(); ++i) {
+    dists.emplace_back((points[i] - query).squaredNorm(), i);
+  }
+
+  std::sort(dists.begin(), dists.end());
+  std::vector<NodeId> result;
+  for (size_t i = 0; i < std::min(k, dists.size()); ++i) {
+    result.push_back(dists[i].second);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(SpatialIndexTests, EmptyIndexCorrect) {
+  SpatialIndex index(0.5);
+  EXPECT_EQ(0u, index.size());
+  EXPECT_FALSE(index.nearest(Eigen::Vector3d::Zero()));
+  EXPECT_TRUE(index.knnQuery(Eigen::Vector3d::Zero(), 5).empty());
+
+  std::vector<NodeId> result;
+  index.radiusQuery(Eigen::Vector3d::Zero(), 10.0, result);
+  EXPECT_TRUE(result.empty());
+  EXPECT_THROW(SpatialIndex(0.0), std::invalid_argument);
+}
+
+TEST(SpatialIndexTests, UpdateAndRemoveCorrect) {
+  SpatialIndex index(1.0);
+  index.update(0, Eigen::Vector3d(0.5, 0.5, 0.5));
+  index.update(1, Eigen::Vector3d(0.6, 0.5, 0.5));
+  index.update(2, Eigen::Vector3d(-5.0, 0.0, 0.0));
+  EXPECT_EQ(3u, index.size());
+  EXPECT_EQ(2u, index.numCells());
+
+  // moving within a cell and across cells
+  index.update(1, Eigen::Vector3d(0.7, 0.5, 0.5));
+  index.update(0, Eigen::Vector3d(10.0, 0.0, 0.0));
+  EXPECT_EQ(3u, index.size());
+  EXPECT_EQ(3u, index.numCells());
+  EXPECT_EQ(NodeId(0), index.nearest(Eigen::Vector3d(9.0, 0.0, 0.0)));
+  EXPECT_EQ(NodeId(1), index.nearest(Eigen::Vector3d(0.0, 0.0, 0.0)));
+
+  EXPECT_TRUE(index.remove(0));
+  EXPECT_FALSE(index.remove(0));
+  EXPECT_EQ(2u, index.size());
+  EXPECT_EQ(2u, index.numCells());
+  EXPECT_EQ(NodeId(1), index.nearest(Eigen::Vector3d(9.0, 0.0, 0.0)));
+
+  index.clear();
+  EXPECT_EQ(0u, index.size());
+  EXPECT_FALSE(index.contains(1));
+}
+
+TEST(SpatialIndexTests, QueriesMatchBruteForce) {
+  const auto points = randomPoints(2000, 10.0, 0);
+  SpatialIndex index(0.7);
+  for (size_t i = 0; i < points.size(); ++i) {
+    index.update(i, points[i]);
+  }
+
+  const auto queries = randomPoints(50, 12.0, 1);
+  for (const auto& query : queries) {
+    EXPECT_EQ(bruteForceKnn(points, query, 7), index.knnQuery(query, 7));
+
+    std::vector<NodeId> expected;
+    for (size_t i = 0; i < points.size(); ++i) {
+      if ((points[i] - query).norm() <= 2.5) {
+        expected.push_back(i);
+      }
+    }
+
+    std::vector<NodeId> result;
+    index.radiusQuery(query, 2.5, result);
+    std::sort(result.begin(), result.end());
+    EXPECT_EQ(expected, result);
+
+    const Eigen::Vector3d min = query - Eigen::Vector3d(1.0, 2.0, 3.0);
+    const Eigen::Vector3d max = query + Eigen::Vector3d(3.0, 2.0, 1.0);
+    expected.clear();
+    for (size_t i = 0; i < points.size(); ++i) {
+      if ((points[i].array() >= min.array()).all() &&
+          (points[i].array() <= max.array()).all()) {
+        expected.push_back(i);
+      }
+    }
+
+    result.clear();
+    index.boxQuery(min, max, result);
+    std::sort(result.begin(), result.end());
+    EXPECT_EQ(expected, result);
+  }
+
+  // far away queries and k larger than the index fall back to scanning everything
+  EXPECT_EQ(bruteForceKnn(points, Eigen::Vector3d(500.0, 0.0, 0.0), 3),
+            index.knnQuery(Eigen::Vector3d(500.0, 0.0, 0.0), 3));
+  EXPECT_EQ(points.size(), index.knnQuery(Eigen::Vector3d::Zero(), 5000).size());
+}
+
+TEST(SpatialIndexTests, LayerIndexSynced) {
+  IsolatedSceneGraphLayer layer(1);
+  const auto points = randomPoints(500, 5.0, 2);
+  for (size_t i = 0; i < points.size(); ++i) {
+    layer.emplaceNode(i, std::make_unique<NodeAttributes>(points[i]));
+  }
+
+  const Eigen::Vector3d query(1.0, -1.0, 0.5);
+  const auto expected = layer.getNearestNodes(query, 10);
+  EXPECT_EQ(bruteForceKnn(points, query, 10), expected);
+
+  layer.enableSpatialIndex(true, 0.5);
+  ASSERT_TRUE(layer.hasSpatialIndex());
+  EXPECT_EQ(expected, layer.getNearestNodes(query, 10));
+
+  // removal, merging and updates are reflected in the index
+  layer.removeNode(expected[0]);
+  layer.mergeNodes(expected[1], expected[5]);
+  layer.setNodeAttributes(expected[2], std::make_unique<NodeAttributes>(query));
+  layer.emplaceNode(1000, std::make_unique<NodeAttributes>(query));
+
+  const auto result = layer.getNearestNodes(query, 4);
+  ASSERT_EQ(4u, result.size());
+  EXPECT_EQ((std::set<NodeId>{expected[2], 1000}),
+            (std::set<NodeId>{result[0], result[1]}));
+  EXPECT_EQ(expected[3], result[2]);
+  EXPECT_EQ(expected[4], result[3]);
+
+  layer.enableSpatialIndex(false);
+  EXPECT_FALSE(layer.hasSpatialIndex());
+  EXPECT_EQ(result[3], layer.getNearestNodes(query, 4)[3]);
+}
+
+}  // namespace spark_dsg
@@ -54,4 +54,83 @@ TEST(ZmqInterfaceTests, BasicSendReceiveCorrect) {
   EXPECT_TRUE(receiver.graph() != nullptr);
 }
 
+TEST(ZmqInterfaceTests, MultipartSendReceiveCorrect) {
+  ZmqSender sender("tcp://127.0.0.1:8002", 1, 0, true);
+  ZmqReceiver receiver("tcp://127.0.0.1:8002", 1);
+
+  DynamicSceneGraph graph;
+  graph.emplaceNode(3, 0, std::make_unique<NodeAttributes>());
+  graph.emplaceNode(4, 1, std::make_unique<NodeAttributes>());
+  graph.insertEdge(0, 1);
+
+  for (size_t i = 0; i < 15; ++i) {
+    sender.send(graph);
+    if (receiver.recv(100)) {
+      break;
+    }
+  }
+
+  ASSERT_TRUE(receiver.graph() != nullptr);
+  EXPECT_EQ(2u, receiver.graph()->numNodes());
+  EXPECT_TRUE(receiver.graph()->hasEdge(0, 1));
+}
+
+TEST(ZmqInterfaceTests, DeltaSendReceiveCorrect) {
+  ZmqSender sender("tcp://127.0.0.1:8003", 1, 5);
+  ZmqReceiver receiver("tcp://127.0.0.1:8003", 1);
+
+  DynamicSceneGraph graph;
+  graph.emplaceNode(3, 0, std::make_unique<NodeAttributes>());
+  for (size_t i = 0; i < 15; ++i) {
+    sender.send(graph);
+    if (receiver.recv(100)) {
+      break;
+    }
+  }
+
+  ASSERT_TRUE(receiver.graph() != nullptr);
+  graph.emplaceNode(3, 1, std::make_unique<NodeAttributes>());
+  sender.send(graph);
+  receiver.recv(100);
+  EXPECT_EQ(2u, receiver.graph()->numNodes());
+}
+
+TEST(ZmqInterfaceTests, AsyncReceiveCorrect) {
+  ZmqSender sender("tcp://127.0.0.1:8004", 1);
+  ZmqReceiver receiver("tcp://127.0.0.1:8004", 1, true);
+
+  DynamicSceneGraph graph;
+  graph.emplaceNode(3, 0, std::make_unique<NodeAttributes>());
+  for (size_t i = 0; i < 15; ++i) {
+    sender.send(graph);
+    if (receiver.recv(100)) {
+      break;
+    }
+  }
+
+  const auto first = receiver.graph();
+  ASSERT_TRUE(first != nullptr);
+  EXPECT_EQ(1u, first->numNodes());
+
+  // queued messages are conflated into the latest graph
+  for (NodeId node = 1; node < 5; ++node) {
+    graph.emplaceNode(3, node, std::make_unique<NodeAttributes>());
+    sender.send(graph);
+  }
+
+  for (size_t i = 0; i < 15; ++i) {
+    if (receiver.recv(100) && receiver.graph()->numNodes() == 5u) {
+      break;
+    }
+  }
+
+  EXPECT_EQ(5u, receiver.graph()->numNodes());
+  // published graphs are never modified
+  EXPECT_EQ(1u, first->numNodes());
+
+  const auto stats = receiver.stats();
+  EXPECT_GE(stats.num_received, stats.num_published + stats.num_dropped);
+  EXPECT_GE(stats.max_latency, stats.last_latency);
+}
+
 }  // namespace spark_dsg